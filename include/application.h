@@ -11,8 +11,17 @@
 #ifndef PLAYGROUND_INCLUDE_APPLICATION_H_
 #define PLAYGROUND_INCLUDE_APPLICATION_H_
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #define PLAYGROUND_IMGUI_
@@ -27,13 +36,44 @@
 #define PLAYGROUND_GLM_
 #include <glm/glm.hpp>
 
+#include "asset_loader.h"
+#include "benchmark.h"
+#include "bindless_table.h"
+#include "deletion_queue.h"
+#include "frame_command_pools.h"
+#include "frame_snapshot.h"
+#include "gpu_profiler.h"
+#include "gpu_timeline.h"
+#include "imgui_renderer.h"
+#include "job_system.h"
+#include "memory_allocator.h"
+#include "mesh_file.h"
+#include "options.h"
+#include "pipeline_cache.h"
+#include "post_process.h"
+#include "render_graph.h"
+#include "shader_library.h"
+#include "startup_graph.h"
+#include "transform_store.h"
+#include "triple_buffer.h"
+#include "upload_context.h"
+#include "usage_monitor.h"
+
 namespace playground {
 
 const int WIDTH = 800;
 const int HEIGHT = 600;
 const std::string TITLE{"Playground"};
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// descriptor sets ImGui may allocate: its font plus user textures
+const uint32_t IMGUI_MAX_TEXTURES = 16;
+// instances behind one indirect draw, the unit of parallel recording
+const uint32_t SCENE_CHUNK_INSTANCES = 1024;
+// --dynamic-instances: instances per transform update job, fewer are
+// updated on the render thread alone
+const uint32_t INSTANCE_UPDATE_CHUNK = 4096;
+// radians per second of animation every dynamic instance spins about z
+const float INSTANCE_SPIN_SPEED = 3.14159265f;
 
 #ifdef NDEBUG
 const bool ENABLE_VALIDATION_LAYER = false;
@@ -43,21 +83,65 @@ const bool ENABLE_VALIDATION_LAYER = true;
 
 #ifdef _WIN32
 const std::string TEXTURE_FILEPATH{"../../images/texture.jpg"};
-const std::string VERT_SHADER_FILEPATH{"../../shaders/triangle.vert.spv"};
-const std::string FRAG_SHADER_FILEPATH{"../../shaders/triangle.frag.spv"};
+const std::string TEXTURE_BC7_FILEPATH{"../../images/texture.bc7.ktx2"};
+const std::string TEXTURE_ASTC_FILEPATH{"../../images/texture.astc.ktx2"};
 #else
 const std::string TEXTURE_FILEPATH{"../images/texture.jpg"};
-const std::string VERT_SHADER_FILEPATH{"../shaders/triangle.vert.spv"};
-const std::string FRAG_SHADER_FILEPATH{"../shaders/triangle.frag.spv"};
+const std::string TEXTURE_BC7_FILEPATH{"../images/texture.bc7.ktx2"};
+const std::string TEXTURE_ASTC_FILEPATH{"../images/texture.astc.ktx2"};
 #endif
 
+// GLSL sources, their SPIR-V is looked up in SHADER_DIR
+const std::string VERT_SHADER{"triangle.vert"};
+const std::string FRAG_SHADER{"triangle.frag"};
+const std::string CULL_SHADER{"cull.comp"};
+const std::string BLOOM_DOWN_SHADER{"bloom_down.comp"};
+const std::string BLOOM_UP_SHADER{"bloom_up.comp"};
+const std::string TONEMAP_SHADER{"tonemap.comp"};
+const std::string FXAA_SHADER{"fxaa.comp"};
+const std::string IMGUI_VERT_SHADER{"imgui.vert"};
+const std::string IMGUI_FRAG_SHADER{"imgui.frag"};
+
+// written to the working directory, i.e. next to the binary
+const std::string PIPELINE_CACHE_FILEPATH{"pipeline_cache.bin"};
+
 struct QueueFamilies {
   std::optional<uint32_t> graphics_family;
   std::optional<uint32_t> present_family;
+  // transfer-only family, uploads fall back to the graphics queue without it
+  std::optional<uint32_t> transfer_family;
+  // compute family without graphics, the async compute queue comes from it
+  std::optional<uint32_t> compute_family;
 
   inline bool IsCompleted();
 };
 
+// optional device capabilities, enabled when the device has them
+struct DeviceFeatures {
+  // VK_KHR_draw_indirect_count
+  bool draw_indirect_count = false;
+  // block compressed texture formats
+  bool texture_compression_bc = false;
+  bool texture_compression_astc = false;
+  bool sampler_anisotropy = false;
+  // VK_EXT_descriptor_indexing (core in 1.2): partially bound,
+  // update-after-bind arrays
+  bool descriptor_indexing = false;
+  // VK_KHR_timeline_semaphore (core in 1.2)
+  bool timeline_semaphore = false;
+  // VK_KHR_present_id + VK_KHR_present_wait
+  bool present_wait = false;
+  // VK_KHR_dynamic_rendering: passes begin on image views, no render pass or
+  // framebuffer objects
+  bool dynamic_rendering = false;
+  // VK_KHR_synchronization2: the render graph's barriers in one call per
+  // batch with per barrier stages
+  bool synchronization2 = false;
+  // shaderStorageImageWriteWithoutFormat: the post process chain stores into
+  // the swap chain, else its shaders declare their formats and it blits
+  bool storage_image_write_without_format = false;
+};
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -66,24 +150,68 @@ struct SwapChainSupportDetails {
   inline bool IsAdequate();
 };
 
+// same layout as MeshVertex in .pgmesh files
 struct Vertex {
-  glm::vec2 pos;
+  glm::vec3 pos;
   glm::vec3 color;
 
-  static VkVertexInputBindingDescription GetBindingDescription();
-  static std::array<VkVertexInputAttributeDescription, 2>
+  // binding 0: per vertex, binding 1: per instance (InstanceData)
+  static std::array<VkVertexInputBindingDescription, 2>
+  GetBindingDescriptions();
+  static std::array<VkVertexInputAttributeDescription, 7>
   GetAttributeDescriptions();
 };
 
+struct InstanceData {
+  glm::mat4 model;
+  glm::vec4 color;
+};
+
+// written by cull.comp, one per scene chunk, consumed by the chunk's draw
+struct IndirectDraw {
+  VkDrawIndexedIndirectCommand command;
+  uint32_t draw_count;
+};
+
+// per draw, pushed instead of living in a descriptor: the model matrix for
+// the vertex stage, the bindless texture for the fragment stage
+struct DrawPushConstants {
+  glm::mat4 model;
+  uint32_t texture_index;
+};
+
+struct CullPushConstants {
+  glm::mat4 model;
+  uint32_t instance_count;
+  float bounding_radius;
+  uint32_t index_count;
+  uint32_t first_index;
+  uint32_t chunk_size;
+};
+
+// per frame, shared by every draw and the cull pass
 struct UniformBufferObject {
-  alignas(16) glm::mat4 model;
-  alignas(16) glm::mat4 view;
-  alignas(16) glm::mat4 projection;
+  alignas(16) glm::mat4 view_projection;
+};
+
+// a pipeline rebuilt on the job system once one of its shaders reloaded
+struct PipelineReload {
+  std::string name;
+  std::vector<ShaderId> shaders;
+  // runs on a worker, returns what the render thread calls between frames
+  // to swap the new pipeline in and retire the old one
+  std::function<std::function<void()>()> build;
+  std::function<void()> install;
+  std::string error;
+  JobCounter counter;
+  bool running = false;
+  // a shader changed since the running build started
+  bool dirty = false;
 };
 
 class Application {
  public:
-  Application();
+  explicit Application(const Options& options = Options{});
   Application(const Application&) = delete;
   ~Application();
 
@@ -91,34 +219,108 @@ class Application {
 
   void Run();
 
+  void ReportBenchmark();
+
   void CreateWindow();
   void CreateInstance();
   void SetupDebugMessenger();
   void CreateSurface();
   void PickPhysicalDevice();
   void CreateLogicalDevice();
+  void CreateMemoryAllocator();
+  void CreatePipelineCache();
   void CreateSwapChain();
   void CreateImageViews();
   void CreateRenderPass();
+  // worker step once the pipeline cache exists, needs neither the swap chain
+  // nor the allocator; the graphics pipeline and render graph wait for it
+  void CreatePostProcess();
   void CreateDescriptorPool();
   void CreateDescriptorSetLayout();
+  void CreateComputeDescriptorSetLayout();
   void CreateDescriptorSets();
   void CreatePipelineLayout();
   void CreateGraphicsPipeline();
+  void CreateComputePipeline();
+  // from the shader library's current code, safe from any thread once the
+  // layouts and render passes exist
+  VkPipeline BuildGraphicsPipeline();
+  VkPipeline BuildComputePipeline();
   void CreateFrameBuffers();
   void CreateCommandPool();
-  void CreateCommandBuffers();
+  void CreateFrameCommandPools();
+  void CreateGpuProfiler();
+  void CreateGpuTimeline();
+  void CreateTextureSampler();
+  void CreateBindlessTable();
+  void CreateDefaultTexture();
+  void CreateUploadContext();
+  void RequestAssets();
+  // after the logical device, the variants it can run
+  void RequestPostProcessShaders();
+  void RequestTexture();
+  // --hot-reload: rebuilds pipelines whose shaders change on disk
+  void WatchShaders();
+  void ProcessLoadedAssets();
   void CreateTextureImage();
+  void LoadMesh();
   void CreateVertexBuffer();
   void CreateIndexBuffer();
+  void CreateInstanceBuffer();
+  void CreateCullBuffers();
+  // the frame's passes for the current swap chain, the previous graph is
+  // retired
+  void CreateRenderGraph();
+  void CreateComputeDescriptorSets();
   void CreateUniformBuffers();
   void CreateSyncObjects();
-
-  void DrawFrame();
+  // --async-compute: the uploaded instances are released to the compute
+  // family once the uploads have finished, RecordAsyncCommandBuffer()
+  // acquires them
+  void HandOffInstanceBuffer();
+  // queue family ownership transfer of the instance buffer to compute, for
+  // both the release and the acquire
+  VkBufferMemoryBarrier InstanceBufferTransfer() const;
+
+  // main thread: input, ImGui and scene state of the next frame
+  void Simulate(FrameSnapshot& snapshot);
+  // present mode and frame limiter, applied by the render thread
+  void DrawLatencyControls();
+  // --on-demand: returns once the next frame is worth drawing, events are
+  // polled either way
+  void WaitForRedraw();
+  // on demand mode, animation and what the process costs meanwhile
+  void DrawOnDemandControls();
+  void RenderLoop();
+  void StopRenderThread();
+
+  // render thread
+  void DrawFrame(FrameSnapshot& snapshot);
   void RecordCommandBuffer(VkCommandBuffer command_buffer,
-                           uint32_t image_index);
+                           uint32_t image_index, ImDrawData* draw_data);
+  // the graph's async compute passes, for the compute queue
+  void RecordAsyncCommandBuffer(VkCommandBuffer command_buffer,
+                                uint32_t image_index);
+  void RecordCullPass(VkCommandBuffer command_buffer);
+  // ImGui on the swap chain image without render pass
+  void RecordDynamicImGuiPass(VkCommandBuffer command_buffer,
+                              uint32_t image_index, VkCommandBuffer secondary);
+  // allocated from the calling thread's pool of the current frame
+  VkCommandBuffer BeginSecondaryCommandBuffer(
+      const VkCommandBufferInheritanceInfo& inheritance);
+  // chunks [begin, end), safe to call from any job
+  void RecordSceneChunks(VkCommandBuffer command_buffer,
+                         VkDescriptorSet bindless_set, uint32_t begin,
+                         uint32_t end);
   void RecreateSwapChain();
   void CleanupSwapChain();
+  void AddPipelineReload(const std::string& name,
+                         const std::vector<ShaderId>& shaders,
+                         std::function<std::function<void()>()> build);
+  // polls the shader library, starts and installs rebuilds
+  void ReloadPipelines();
+  // destroyed once the frames using it have finished
+  void RetirePipeline(VkPipeline pipeline);
 
   void FindInstanceExtensions(std::vector<const char*>& required_extensions);
   void FindInstanceLayers(std::vector<const char*>& required_layers);
@@ -136,6 +338,9 @@ class Application {
 
   void FindDeviceExtensions(VkPhysicalDevice device,
                             std::vector<const char*>& required_extensions);
+  // appends the supported optional extensions and fills device_features_
+  void FindOptionalDeviceExtensions(VkPhysicalDevice device,
+                                    std::vector<const char*>& extensions);
 
   QueueFamilies FindQueueFaimilies(VkPhysicalDevice device);
 
@@ -145,6 +350,8 @@ class Application {
   VkPresentModeKHR ChooseSwapPresentMode(
       const std::vector<VkPresentModeKHR>& available_present_modes);
   VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
+  // --msaa, lowered to what color and depth attachments both support
+  VkSampleCountFlagBits ChooseSampleCount();
 
   VkShaderModule CreateShaderMoudle(const std::vector<char>& code);
 
@@ -157,38 +364,80 @@ class Application {
   VkCommandBuffer BeginSingleTimeCommands();
   void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 
-  uint32_t FindMemoryType(uint32_t type_filter,
-                          VkMemoryPropertyFlags properties);
-
+  // `concurrent`: read by the graphics and the async compute queue without
+  // ownership transfers
   void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                     VkMemoryPropertyFlags properties, VkBuffer& buffer,
-                    VkDeviceMemory& buffer_memory);
-  void CopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer, VkDeviceSize size);
-
-  void UpdateUniformBuffer(uint32_t current_image);
-
-  void CreateImage(uint32_t width, uint32_t height, VkFormat format,
-                   VkImageTiling tiling, VkImageUsageFlags usage,
-                   VkMemoryPropertyFlags properties, VkImage& image,
-                   VkDeviceMemory& image_memory);
+                    Allocation& buffer_memory, bool concurrent = false);
+  void DestroyBuffer(VkBuffer& buffer, Allocation& buffer_memory);
+
+  // view-projection into the frame's UBO, the scene model for the push
+  // constants
+  void UpdateUniformBuffer(uint32_t current_image,
+                           const FrameSnapshot& snapshot);
+  // --dynamic-instances: the transforms advanced to the snapshot's
+  // animation time and their models written to the frame's instance buffer
+  void UpdateInstanceTransforms(uint32_t current_frame,
+                                const FrameSnapshot& snapshot);
+
+  // supported with optimal tiling, e.g. SAMPLED_IMAGE for a texture
+  bool IsFormatSupported(VkFormat format, VkFormatFeatureFlags features);
+  // compressed variant of the texture the device can sample, if shipped
+  std::string ChooseTexturePath();
+
+  VkImageView CreateImageView(VkImage image, VkFormat format,
+                              uint32_t mip_levels);
+
+  void CreateImage(uint32_t width, uint32_t height, uint32_t mip_levels,
+                   VkFormat format, VkImageTiling tiling,
+                   VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
+                   VkImage& image, Allocation& image_memory);
+  void DestroyImage(VkImage& image, Allocation& image_memory);
 
   void TransitionImageLayout(VkImage image, VkImageLayout old_layout,
-                             VkImageLayout new_layout);
+                             VkImageLayout new_layout, uint32_t mip_levels);
 
-  void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width,
-                         uint32_t height);
+  // one region per level, level i at `buffer_offset + level_offsets[i]`
+  void CopyBufferToImage(VkBuffer buffer, VkDeviceSize buffer_offset,
+                         VkImage image, uint32_t width, uint32_t height,
+                         const std::vector<VkDeviceSize>& level_offsets);
 
   static void FramebufferResizeCallback(GLFWwindow* window, int width,
                                         int height);
+  static void KeyCallback(GLFWwindow* window, int key, int scancode,
+                          int action, int mods);
   static VKAPI_ATTR VkBool32 VKAPI_CALL
   DebugCallBack(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
                 VkDebugUtilsMessageTypeFlagsEXT message_type,
                 const VkDebugUtilsMessengerCallbackDataEXT* callback_data,
                 void* user_data);
 
-  static std::vector<char> ReadFile(const std::string& filename);
-
  private:
+  // declared first: workers outlive everything that schedules jobs
+  JobSystem job_system_;
+  AssetLoader asset_loader_{job_system_};
+  ShaderLibrary shader_library_{job_system_, asset_loader_};
+
+  Options options_;
+  Benchmark benchmark_;
+  // the constructor's startup graph began
+  std::chrono::steady_clock::time_point startup_time_{};
+  // render thread, 0 until the first frame was presented
+  double first_frame_ms_ = 0.0;
+
+  std::shared_ptr<Asset> texture_asset_;
+  ShaderId vert_shader_ = 0;
+  ShaderId frag_shader_ = 0;
+  ShaderId cull_shader_ = 0;
+  ShaderId bloom_down_shader_ = 0;
+  ShaderId bloom_up_shader_ = 0;
+  ShaderId tonemap_shader_ = 0;
+  ShaderId fxaa_shader_ = 0;
+  ShaderId imgui_vert_shader_ = 0;
+  ShaderId imgui_frag_shader_ = 0;
+  // render thread only once it runs
+  std::vector<std::unique_ptr<PipelineReload>> pipeline_reloads_;
+
   GLFWwindow* window_;
 
   VkInstance instance_;
@@ -196,19 +445,61 @@ class Application {
   VkSurfaceKHR surface_;
   VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
   VkDevice device_;
+  DeviceFeatures device_features_;
+  PFN_vkCmdDrawIndexedIndirectCountKHR cmd_draw_indexed_indirect_count_ =
+      nullptr;
+  PFN_vkWaitForPresentKHR wait_for_present_ = nullptr;
+  PFN_vkCmdBeginRenderingKHR cmd_begin_rendering_ = nullptr;
+  PFN_vkCmdEndRenderingKHR cmd_end_rendering_ = nullptr;
+
+  MemoryAllocator allocator_;
+  PipelineCache pipeline_cache_;
 
   QueueFamilies queue_faimlies_;
   VkQueue graphics_queue_;
   VkQueue present_queue_;
-
-  VkSwapchainKHR swap_chain_;
+  VkQueue transfer_queue_;
+  // VK_NULL_HANDLE unless --async-compute found a compute family
+  VkQueue compute_queue_ = VK_NULL_HANDLE;
+  // every submit, present and wait idle once the render thread runs, ImGui's
+  // platform windows use the graphics queue from the main thread
+  std::mutex queue_mutex_;
+
+  // handed to vkCreateSwapchainKHR as oldSwapchain on recreation
+  VkSwapchainKHR swap_chain_ = VK_NULL_HANDLE;
   std::vector<VkImage> swap_chain_images_;
   VkFormat swap_chain_image_format_;
+  VkPresentModeKHR swap_chain_present_mode_;
+  // set from the main thread's latency controls, a change recreates the
+  // swap chain before the next frame
+  std::atomic<VkPresentModeKHR> requested_present_mode_{
+      VK_PRESENT_MODE_MAILBOX_KHR};
+  std::atomic<bool> present_mode_changed_{false};
+  // bit per present mode the surface supports
+  std::atomic<uint32_t> supported_present_modes_{0};
+  // fifo modes: a frame starts once the previous one was presented
+  std::atomic<bool> frame_limiter_{false};
+  // the limiter is in effect with the current swap chain
+  std::atomic<bool> frames_paced_{false};
   VkExtent2D swap_chain_extent_;
+  // written by the post process chain as a storage image, else blitted to
+  bool swap_chain_storage_ = false;
 
   std::vector<VkImageView> swap_chain_image_views_;
 
-  VkRenderPass render_pass_;
+  // the scene renders offscreen into the chain's HDR target, this one only
+  // draws ImGui on top of the chain's output; neither it nor the swap chain
+  // framebuffers exist with dynamic rendering
+  VkRenderPass render_pass_ = VK_NULL_HANDLE;
+  PostProcessChain post_process_;
+  // cull, scene, post process and ImGui with the barriers between them;
+  // shared with the deletion queue once replaced
+  std::shared_ptr<RenderGraph> render_graph_;
+  // recorded before the graph executes, the scene and ImGui passes run them
+  std::vector<VkCommandBuffer> scene_secondaries_;
+  VkCommandBuffer imgui_secondary_ = VK_NULL_HANDLE;
+  // the main viewport, platform windows are still drawn by ImGui's backend
+  ImGuiRenderer imgui_renderer_;
 
   VkDescriptorPool descriptor_pool_;
   std::vector<VkDescriptorSet> descriptor_sets_;
@@ -216,33 +507,139 @@ class Application {
   VkPipelineLayout pipeline_layout_;
   VkPipeline graphics_pipeline_;
 
+  VkDescriptorSetLayout compute_descriptor_set_layout_;
+  std::vector<VkDescriptorSet> compute_descriptor_sets_;
+  VkPipelineLayout compute_pipeline_layout_;
+  VkPipeline compute_pipeline_;
+
   std::vector<VkFramebuffer> swap_chain_framebuffers_;
 
+  // one-off commands outside of the frame loop
   VkCommandPool command_pool_;
-  std::vector<VkCommandBuffer> command_buffers_;
-
-  VkImage texture_image_;
-  VkDeviceMemory texture_image_memory_;
+  // per recording thread (workers plus this one) and frame in flight
+  FrameCommandPools frame_command_pools_;
+  // --async-compute: the render thread's, of the compute family
+  FrameCommandPools compute_command_pools_;
+
+  GpuProfiler gpu_profiler_;
+  // timestamps of the compute queue
+  GpuProfiler async_profiler_;
+
+  // every graphics submission signals it, frames and uploads wait on it
+  GpuTimeline gpu_timeline_;
+  // resources still in use by submitted frames, e.g. across swap chain
+  // recreation
+  DeletionQueue deletion_queue_;
+  UploadContext upload_context_;
+
+  VkSampler texture_sampler_ = VK_NULL_HANDLE;
+  BindlessTable bindless_table_;
+
+  // 1x1 white, slot 0 of the table, shown until the texture streams in
+  VkImage default_texture_image_ = VK_NULL_HANDLE;
+  Allocation default_texture_image_memory_;
+  VkImageView default_texture_image_view_ = VK_NULL_HANDLE;
+
+  VkImage texture_image_ = VK_NULL_HANDLE;
+  Allocation texture_image_memory_;
+  VkImageView texture_image_view_ = VK_NULL_HANDLE;
+  uint32_t texture_mip_levels_ = 1;
+  std::string texture_path_;
+  uint32_t scene_texture_index_ = 0;
+  glm::mat4 scene_model_{1.0f};
   VkBuffer vertex_buffer_;
-  VkDeviceMemory vertex_buffer_memory_;
+  Allocation vertex_buffer_memory_;
   VkBuffer index_buffer_;
-  VkDeviceMemory index_buffer_memory_;
+  Allocation index_buffer_memory_;
+
+  // mapped only while the constructor stages its contents
+  MeshFile mesh_file_;
+  std::vector<MeshLod> mesh_lods_;
+  VkIndexType index_type_ = VK_INDEX_TYPE_UINT16;
+  float mesh_bounding_radius_ = 0.0f;
+  // device local, unless every frame writes its own
+  VkBuffer instance_buffer_ = VK_NULL_HANDLE;
+  Allocation instance_buffer_memory_;
+  // released by the graphics family, the first async compute command buffer
+  // acquires it
+  bool instance_buffer_acquire_ = false;
+  uint32_t instance_count_ = 0;
+  bool dynamic_instances_ = false;
+  TransformStore instance_transforms_;
+  // the animation time instance_transforms_ were advanced to
+  float instance_animation_time_ = 0.0f;
+  // --dynamic-instances, per frame in flight: persistently mapped, read by
+  // the cull pass on either queue, and the animation time each holds
+  std::vector<VkBuffer> instance_buffers_;
+  std::vector<Allocation> instance_buffers_memory_;
+  std::vector<float> instance_buffer_times_;
+  uint32_t scene_chunk_count_ = 0;
+
+  // per frame in flight: output of the cull pass
+  std::vector<VkBuffer> visible_instance_buffers_;
+  std::vector<Allocation> visible_instance_buffers_memory_;
+  std::vector<VkBuffer> indirect_buffers_;
+  std::vector<Allocation> indirect_buffers_memory_;
 
   std::vector<VkBuffer> uniform_buffers_;
-  std::vector<VkDeviceMemory> uniform_buffers_memory_;
+  std::vector<Allocation> uniform_buffers_memory_;
   std::vector<void*> uniform_buffers_mapped_;
 
   std::vector<VkSemaphore> image_available_semaphores_;
   std::vector<VkSemaphore> render_finished_semaphores_;
-  std::vector<VkFence> in_flight_fences_;
-
-  int current_frame = 0;
-  bool framebuffer_resized = false;
-
-  const std::vector<Vertex> vertices_ = {{{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-                                         {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-                                         {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-                                         {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}};
+  // signaled by the async compute submission, the frame's graphics one
+  // waits for it
+  std::vector<VkSemaphore> async_compute_semaphores_;
+  // timeline value of each frame slot's last submission
+  std::vector<uint64_t> frame_timeline_values_;
+
+  // from --frames-in-flight, sizes every per frame resource
+  uint32_t frames_in_flight_ = DEFAULT_FRAMES_IN_FLIGHT;
+  uint32_t current_frame = 0;
+
+  // the main thread simulates frame N + 1 into the back slot while the
+  // render thread records and submits frame N from the front one
+  TripleBuffer<FrameSnapshot> snapshots_;
+  std::thread render_thread_;
+  std::atomic<bool> rendering_{false};
+  std::exception_ptr render_error_;
+  uint64_t published_frames_ = 0;
+  std::atomic<uint64_t> consumed_frames_{0};
+  // handled by DrawFrame, presented or dropped
+  std::atomic<uint64_t> presented_frames_{0};
+  // only for sleeping, snapshots themselves are handed over lock-free
+  std::mutex frame_mutex_;
+  std::condition_variable frame_cv_;
+
+  // glfw may only be queried on the main thread, the render thread reads
+  // the size from here
+  std::atomic<int> framebuffer_width_{0};
+  std::atomic<int> framebuffer_height_{0};
+  std::atomic<bool> framebuffer_resized{false};
+  bool trace_requested_ = false;
+
+  // on demand rendering, main thread only
+  bool on_demand_ = false;
+  bool animate_ = true;
+  int min_refresh_rate_ = DEFAULT_MIN_REFRESH_RATE;
+  // frames still drawn after events, ImGui needs a few to settle
+  uint32_t redraw_frames_ = 0;
+  std::chrono::steady_clock::time_point last_redraw_time_{};
+  // the scene's rotation only advances while animating
+  float animation_time_ = 0.0f;
+  std::chrono::steady_clock::time_point last_simulate_time_{};
+  // the texture still streaming in, finishing is worth a frame
+  std::shared_ptr<Asset> streaming_texture_;
+  // pipeline reloads building, they are installed by a later frame
+  std::atomic<bool> reloads_pending_{false};
+  UsageMonitor usage_monitor_;
+
+  // built-in quad, used when no mesh file is given
+  const std::vector<Vertex> vertices_ = {
+      {{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+      {{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+      {{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+      {{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}}};
   const std::vector<uint16_t> indices_ = {0, 1, 2, 2, 3, 0};
 };
 
@@ -0,0 +1,73 @@
+/**
+ * @file asset_loader.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Reads files, decodes images and parses KTX2 textures on the job
+ * system
+ * @version 1.0
+ * @date 2023-03-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_ASSET_LOADER_H_
+#define PLAYGROUND_INCLUDE_ASSET_LOADER_H_
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+#include "ktx2.h"
+
+namespace playground {
+
+struct StbiDeleter {
+  void operator()(unsigned char* pixels) const;
+};
+
+struct Asset {
+  std::string path;
+  // raw contents for files and KTX2 textures, RGBA8 texels for images
+  std::vector<char> bytes;
+  std::unique_ptr<unsigned char, StbiDeleter> pixels;
+  int width = 0;
+  int height = 0;
+  // where the levels of a KTX2 texture sit in `bytes`
+  Ktx2Texture ktx2;
+  std::string error;
+
+  JobCounter counter;
+
+  inline bool IsReady() const;
+  inline bool Failed() const;
+};
+
+class AssetLoader {
+ public:
+  explicit AssetLoader(JobSystem& job_system);
+  AssetLoader(const AssetLoader&) = delete;
+  ~AssetLoader() = default;
+
+  AssetLoader& operator=(const AssetLoader&) = delete;
+
+  std::shared_ptr<Asset> LoadFile(const std::string& path);
+  std::shared_ptr<Asset> LoadImage(const std::string& path);
+  // .ktx2 files keep their GPU format and mip levels, anything else is
+  // decoded by LoadImage
+  std::shared_ptr<Asset> LoadTexture(const std::string& path);
+
+  // blocks until the asset is loaded, throws if loading failed
+  void Wait(const Asset& asset);
+
+  static std::vector<char> ReadFile(const std::string& filename);
+
+ private:
+  JobSystem& job_system_;
+};
+
+bool Asset::IsReady() const { return counter.IsDone(); }
+
+bool Asset::Failed() const { return IsReady() && !error.empty(); }
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_ASSET_LOADER_H_
@@ -0,0 +1,83 @@
+/**
+ * @file benchmark.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Startup phase timings and frame time statistics of a benchmark run
+ * @version 1.0
+ * @date 2023-03-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_BENCHMARK_H_
+#define PLAYGROUND_INCLUDE_BENCHMARK_H_
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace playground {
+
+struct FrameTimeStats {
+  double min = 0.0;
+  double average = 0.0;
+  double p50 = 0.0;
+  double p95 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+class Benchmark {
+ public:
+  Benchmark() = default;
+  Benchmark(const Benchmark&) = delete;
+  ~Benchmark() = default;
+
+  Benchmark& operator=(const Benchmark&) = delete;
+
+  // frames before `warmup` are dropped, 0 `frames` records forever
+  void Configure(uint32_t warmup, uint32_t frames);
+
+  // run description included in the reports, e.g. device or resolution
+  void AddConfig(const std::string& key, const std::string& value);
+  // `start_ms` since startup began; phases on workers overlap the others
+  void AddStartupPhase(const std::string& name, double start_ms, double ms,
+                       bool worker = false);
+  // wall clock, until the last phase ended
+  double GetStartupTime() const;
+  // since startup began, until the first frame was presented
+  void SetFirstFrameTime(double ms);
+
+  void AddFrame(double cpu_ms, double gpu_ms);
+  // true once warmup + frames frames were added
+  bool IsDone() const;
+
+  static FrameTimeStats ComputeStats(std::vector<double> samples);
+
+  // human readable summary
+  void Report(std::ostream& out) const;
+  void WriteJson(std::ostream& out) const;
+
+ private:
+  struct StartupPhase {
+    std::string name;
+    double start_ms;
+    double ms;
+    bool worker;
+  };
+
+  std::vector<std::pair<std::string, std::string>> config_;
+
+  uint32_t warmup_ = 0;
+  uint32_t frames_ = 0;
+  uint32_t frame_cnt_ = 0;
+
+  std::vector<StartupPhase> startup_phases_;
+  double first_frame_ms_ = 0.0;
+  std::vector<double> cpu_frame_times_;
+  std::vector<double> gpu_frame_times_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_BENCHMARK_H_
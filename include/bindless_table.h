@@ -0,0 +1,85 @@
+/**
+ * @file bindless_table.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Global descriptor arrays of sampled images and storage buffers,
+ * indexed from shaders, updated after bind when descriptor indexing is there
+ * @version 1.0
+ * @date 2023-03-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_BINDLESS_TABLE_H_
+#define PLAYGROUND_INCLUDE_BINDLESS_TABLE_H_
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+// guaranteed minimums of maxPerStageDescriptorSampledImages/StorageBuffers
+const uint32_t LEGACY_TEXTURE_SLOTS = 16;
+const uint32_t LEGACY_BUFFER_SLOTS = 4;
+
+const uint32_t BINDLESS_MAX_TEXTURES = 4096;
+const uint32_t BINDLESS_MAX_BUFFERS = 1024;
+
+// binding 0: textures[], 1: buffers[], 2: the immutable sampler
+class BindlessTable {
+ public:
+  BindlessTable() = default;
+  BindlessTable(const BindlessTable&) = delete;
+  ~BindlessTable() = default;
+
+  BindlessTable& operator=(const BindlessTable&) = delete;
+
+  // `bindless`: one partially bound, update-after-bind set, otherwise one
+  // fully written set per frame in flight
+  void Init(VkDevice device, VkSampler sampler, bool bindless,
+            uint32_t texture_capacity, uint32_t buffer_capacity,
+            uint32_t frames_in_flight);
+  void Destroy();
+
+  bool IsBindless() const;
+  uint32_t GetTextureCapacity() const;
+  uint32_t GetBufferCapacity() const;
+  VkDescriptorSetLayout GetLayout() const;
+
+  // returns the shader side index, slots are never reused so a new one can
+  // be written while older frames still read the table
+  uint32_t AddTexture(VkImageView image_view);
+  uint32_t AddBuffer(VkBuffer buffer, VkDeviceSize range = VK_WHOLE_SIZE);
+
+  // set to bind for `frame`, call once its timeline value is reached; the
+  // legacy path catches the frame's set up with slots added since
+  VkDescriptorSet Prepare(uint32_t frame);
+
+ private:
+  void WriteTexture(VkDescriptorSet set, uint32_t slot,
+                    const VkDescriptorImageInfo& info);
+  void WriteBuffer(VkDescriptorSet set, uint32_t slot,
+                   const VkDescriptorBufferInfo& info);
+  void WriteAll(VkDescriptorSet set);
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  bool bindless_ = false;
+  uint32_t texture_capacity_ = 0;
+  uint32_t buffer_capacity_ = 0;
+
+  VkDescriptorSetLayout layout_ = VK_NULL_HANDLE;
+  VkDescriptorPool pool_ = VK_NULL_HANDLE;
+  // a single set when bindless
+  std::vector<VkDescriptorSet> sets_;
+
+  std::vector<VkDescriptorImageInfo> textures_;
+  std::vector<VkDescriptorBufferInfo> buffers_;
+
+  // legacy: bumped on every add, each frame set remembers what it has seen
+  uint64_t version_ = 0;
+  std::vector<uint64_t> set_versions_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_BINDLESS_TABLE_H_
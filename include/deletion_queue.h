@@ -0,0 +1,58 @@
+/**
+ * @file deletion_queue.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Resources retired with the GPU timeline value they were last used
+ * in, destroyed once the GPU has reached it instead of after a device idle
+ * @version 1.0
+ * @date 2023-03-27
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_DELETION_QUEUE_H_
+#define PLAYGROUND_INCLUDE_DELETION_QUEUE_H_
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#include "gpu_timeline.h"
+
+namespace playground {
+
+class DeletionQueue {
+ public:
+  DeletionQueue() = default;
+  DeletionQueue(const DeletionQueue&) = delete;
+  ~DeletionQueue() = default;
+
+  DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+  void Init(GpuTimeline& timeline);
+  // waits for and destroys everything still queued
+  void Destroy();
+
+  // `destroy` runs once the GPU timeline reaches `value`
+  void Retire(uint64_t value, std::function<void()> destroy);
+  // last used by anything submitted so far
+  void Retire(std::function<void()> destroy);
+
+  // destroys what the GPU is done with, never blocks
+  void Collect();
+
+ private:
+  struct Entry {
+    uint64_t value;
+    std::function<void()> destroy;
+  };
+
+  GpuTimeline* timeline_ = nullptr;
+
+  std::mutex mutex_;
+  // sorted by value
+  std::deque<Entry> entries_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_DELETION_QUEUE_H_
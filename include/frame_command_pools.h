@@ -0,0 +1,63 @@
+/**
+ * @file frame_command_pools.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief One command pool per recording thread and frame in flight, reset
+ * whole once the frame has retired, command buffers are reused afterwards
+ * @version 1.0
+ * @date 2023-03-24
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_FRAME_COMMAND_POOLS_H_
+#define PLAYGROUND_INCLUDE_FRAME_COMMAND_POOLS_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+class FrameCommandPools {
+ public:
+  FrameCommandPools() = default;
+  FrameCommandPools(const FrameCommandPools&) = delete;
+  ~FrameCommandPools() = default;
+
+  FrameCommandPools& operator=(const FrameCommandPools&) = delete;
+
+  // `thread_count` recording threads, indexed like JobSystem::ThreadIndex()
+  void Init(VkDevice device, uint32_t queue_family, uint32_t frames_in_flight,
+            uint32_t thread_count);
+  void Destroy();
+
+  // resets every pool of `frame` at once, call once its timeline value is
+  // reached
+  void Reset(uint32_t frame);
+
+  // a command buffer of the pool owned by `thread`, only that thread may call
+  // this and record into the result until the frame's next Reset()
+  VkCommandBuffer Allocate(uint32_t frame, uint32_t thread,
+                           VkCommandBufferLevel level);
+
+ private:
+  struct Pool {
+    VkCommandPool pool = VK_NULL_HANDLE;
+    // allocated once, handed out again after every reset
+    std::vector<VkCommandBuffer> primaries;
+    std::vector<VkCommandBuffer> secondaries;
+    size_t used_primaries = 0;
+    size_t used_secondaries = 0;
+  };
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  uint32_t thread_count_ = 0;
+
+  // frame * thread_count_ + thread
+  std::vector<Pool> pools_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_FRAME_COMMAND_POOLS_H_
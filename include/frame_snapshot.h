@@ -0,0 +1,58 @@
+/**
+ * @file frame_snapshot.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief State of one simulated frame handed from the main thread to the
+ * render thread, including a deep copy of the ImGui draw data
+ * @version 1.0
+ * @date 2023-03-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_FRAME_SNAPSHOT_H_
+#define PLAYGROUND_INCLUDE_FRAME_SNAPSHOT_H_
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <imgui.h>
+
+#include <glm/glm.hpp>
+
+namespace playground {
+
+// ImGui only stays valid until the next ImGui::NewFrame(), the render thread
+// draws from this copy instead
+class DrawDataSnapshot {
+ public:
+  DrawDataSnapshot() = default;
+  DrawDataSnapshot(const DrawDataSnapshot&) = delete;
+  ~DrawDataSnapshot();
+
+  DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+
+  // call after ImGui::Render(), draw lists are reused from earlier captures
+  void Capture(const ImDrawData* source);
+  // valid until the next Capture()
+  ImDrawData* Get();
+
+ private:
+  ImDrawData draw_data_{};
+  // owned, may hold more lists than the last capture used
+  std::vector<ImDrawList*> lists_;
+};
+
+struct FrameSnapshot {
+  uint64_t index = 0;
+  // events polled, input-to-present latency starts here
+  std::chrono::steady_clock::time_point input_time{};
+  glm::mat4 scene_model{1.0f};
+  // seconds the scene was animated so far, what the instances spin with
+  float animation_time = 0.0f;
+  glm::mat4 view_projection{1.0f};
+  DrawDataSnapshot draw_data;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_FRAME_SNAPSHOT_H_
@@ -0,0 +1,128 @@
+/**
+ * @file gpu_profiler.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Per-frame GPU timestamp scopes, read back without stalling, and an
+ * ImGui overlay with rolling frame/GPU time graphs
+ * @version 1.0
+ * @date 2023-03-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_GPU_PROFILER_H_
+#define PLAYGROUND_INCLUDE_GPU_PROFILER_H_
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+const uint32_t MAX_PROFILER_SCOPES = 16;
+const uint32_t PROFILER_HISTORY_SIZE = 240;
+
+class GpuProfiler {
+ public:
+  GpuProfiler() = default;
+  GpuProfiler(const GpuProfiler&) = delete;
+  ~GpuProfiler() = default;
+
+  GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  // `queue_family` is the family the scopes are recorded on
+  void Init(VkPhysicalDevice physical_device, VkDevice device,
+            uint32_t queue_family, uint32_t frames_in_flight);
+  void Destroy();
+
+  bool IsSupported() const;
+
+  // reads back what `frame` recorded the last time it was submitted, call
+  // once its timeline value is reached so the results never block
+  void Collect(uint32_t frame);
+
+  // recording, outside of a render pass: resets the queries of `frame`
+  void BeginFrame(VkCommandBuffer command_buffer, uint32_t frame);
+  // scopes may nest, `name` must outlive the frame (string literals)
+  uint32_t BeginScope(VkCommandBuffer command_buffer, const char* name);
+  void EndScope(VkCommandBuffer command_buffer, uint32_t scope);
+
+  // for scopes spanning command buffers recorded on other threads: reserve on
+  // the recording thread of the frame, nested in whatever scope is open
+  uint32_t ReserveScope(const char* name);
+  // thread-safe, each timestamp of a reserved scope is written exactly once
+  void WriteBegin(VkCommandBuffer command_buffer, uint32_t scope) const;
+  void WriteEnd(VkCommandBuffer command_buffer, uint32_t scope) const;
+
+  // ImGui panel, call between ImGui::NewFrame() and ImGui::Render(); this
+  // and the getters may run on another thread than the recording;
+  // `async_compute` is the profiler of the compute queue, its scopes are
+  // listed below and overlap the graphics ones
+  void DrawOverlay(const GpuProfiler* async_compute = nullptr);
+
+  // input sampled to frame presented, `displayed`: up to the image
+  // reaching the display (VK_KHR_present_wait), not just vkQueuePresentKHR
+  void AddLatency(double ms, bool displayed);
+
+  double GetGpuTime() const;
+  double GetFrameTime() const;
+  double GetLatency() const;
+
+ private:
+  struct Scope {
+    const char* name;
+    uint32_t depth;
+  };
+
+  struct FrameQueries {
+    std::vector<Scope> scopes;
+    bool pending = false;
+  };
+
+  struct ScopeStats {
+    const char* name;
+    uint32_t depth;
+    double last_ms;
+    double average_ms;
+  };
+
+  // caller holds `stats_mutex_`
+  void DrawScopes(const char* table_id) const;
+  void UpdateStats(const FrameQueries& queries);
+  void PushHistory(float frame_ms, float gpu_ms);
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkQueryPool query_pool_ = VK_NULL_HANDLE;
+
+  // nanoseconds per tick
+  double timestamp_period_ = 0.0;
+  uint64_t timestamp_mask_ = 0;
+
+  std::vector<FrameQueries> frames_;
+  uint32_t recording_frame_ = 0;
+  uint32_t open_depth_ = 0;
+
+  // guards the statistics below, everything else stays on the render thread
+  mutable std::mutex stats_mutex_;
+  std::vector<ScopeStats> stats_;
+  std::vector<uint64_t> results_;
+
+  std::chrono::steady_clock::time_point last_collect_{};
+  double frame_ms_ = 0.0;
+  double gpu_ms_ = 0.0;
+  double latency_ms_ = 0.0;
+  double latency_average_ms_ = -1.0;
+  bool latency_displayed_ = false;
+
+  std::array<float, PROFILER_HISTORY_SIZE> frame_history_{};
+  std::array<float, PROFILER_HISTORY_SIZE> gpu_history_{};
+  uint32_t history_offset_ = 0;
+  uint32_t history_count_ = 0;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_GPU_PROFILER_H_
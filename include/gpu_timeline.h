@@ -0,0 +1,79 @@
+/**
+ * @file gpu_timeline.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief One monotonically increasing GPU timeline every graphics queue
+ * submission signals, backed by a timeline semaphore or by fences where the
+ * device has none
+ * @version 1.0
+ * @date 2023-03-26
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_GPU_TIMELINE_H_
+#define PLAYGROUND_INCLUDE_GPU_TIMELINE_H_
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+class GpuTimeline {
+ public:
+  GpuTimeline() = default;
+  GpuTimeline(const GpuTimeline&) = delete;
+  ~GpuTimeline() = default;
+
+  GpuTimeline& operator=(const GpuTimeline&) = delete;
+
+  // `timeline_semaphore`: the device has VK_KHR_timeline_semaphore (core in
+  // 1.2) enabled, otherwise every submission gets a fence
+  void Init(VkDevice device, bool timeline_semaphore);
+  // waits for everything submitted
+  void Destroy();
+
+  bool IsTimelineSemaphore() const;
+
+  // submits `submit_info` signaling the next value and returns it; queue
+  // access is synchronized by the caller, submissions through here must all
+  // go to queues that execute in submission order (the graphics queue)
+  uint64_t Submit(VkQueue queue, const VkSubmitInfo& submit_info);
+
+  // last value handed out by Submit(), 0 before the first one
+  uint64_t GetSubmittedValue() const;
+  // everything up to the returned value has finished on the GPU
+  uint64_t GetCompletedValue();
+  // never blocks, 0 is always complete
+  bool IsComplete(uint64_t value);
+  void WaitForValue(uint64_t value);
+
+ private:
+  struct PendingFence {
+    uint64_t value;
+    VkFence fence;
+  };
+
+  VkFence AcquireFence();
+  // fallback: retires signaled fences in order, caller holds `mutex_`
+  void CollectFences();
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkSemaphore semaphore_ = VK_NULL_HANDLE;
+  PFN_vkGetSemaphoreCounterValue get_counter_value_ = nullptr;
+  PFN_vkWaitSemaphores wait_semaphores_ = nullptr;
+
+  std::atomic<uint64_t> submitted_value_{0};
+  std::atomic<uint64_t> completed_value_{0};
+
+  std::mutex mutex_;
+  std::deque<PendingFence> pending_fences_;
+  std::vector<VkFence> free_fences_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_GPU_TIMELINE_H_
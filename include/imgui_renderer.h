@@ -0,0 +1,140 @@
+/**
+ * @file imgui_renderer.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Draws ImGui's draw data with its own pipeline: draw lists whose
+ * vertices and indices did not change are not copied again, the font atlas
+ * goes through the batched upload path and platform windows are only
+ * redrawn when their draw data changed
+ * @version 1.0
+ * @date 2023-03-30
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_IMGUI_RENDERER_H_
+#define PLAYGROUND_INCLUDE_IMGUI_RENDERER_H_
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <imgui.h>
+#include <vulkan/vulkan.h>
+
+#include "memory_allocator.h"
+#include "upload_context.h"
+
+namespace playground {
+
+// platform windows are redrawn at most this often, and only when changed
+const double PLATFORM_WINDOWS_MIN_INTERVAL = 1.0 / 30.0;  // s
+
+// SPIR-V, owned by the caller during the call taking them
+struct ImGuiShaders {
+  const std::vector<char>* vert = nullptr;
+  const std::vector<char>* frag = nullptr;
+};
+
+class ImGuiRenderer {
+ public:
+  ImGuiRenderer() = default;
+  ImGuiRenderer(const ImGuiRenderer&) = delete;
+  ~ImGuiRenderer() = default;
+
+  ImGuiRenderer& operator=(const ImGuiRenderer&) = delete;
+
+  // draws inside `render_pass` (subpass 0), or with dynamic rendering
+  // (VK_NULL_HANDLE) into a single `color_format` attachment
+  void Init(VkDevice device, MemoryAllocator& allocator,
+            uint32_t frames_in_flight, VkPipelineCache pipeline_cache,
+            const ImGuiShaders& shaders, VkRenderPass render_pass,
+            VkFormat color_format);
+  // the GPU must be done with every frame
+  void Destroy();
+
+  // safe from any thread after Init(), e.g. a job rebuilding it after a
+  // shader reload
+  VkPipeline CreatePipeline(VkPipelineCache pipeline_cache,
+                            const ImGuiShaders& shaders) const;
+  // not while recording, returns the replaced one
+  VkPipeline SwapPipeline(VkPipeline pipeline);
+
+  // builds the atlas of the fonts added to `io` and records its upload into
+  // the open batch of `upload_context`, drawn from once that batch was
+  // submitted; ImGui's own backend has to be initialized, it draws the
+  // platform windows with the same atlas
+  void UploadFonts(ImGuiIO& io, UploadContext& upload_context);
+
+  // inside the render pass or rendering of the inherited attachment;
+  // `frame` selects the vertex and index buffers, which the GPU must be done
+  // with
+  void Record(VkCommandBuffer command_buffer, uint32_t frame,
+              const ImDrawData* draw_data);
+
+  // after ImGui::UpdatePlatformWindows(): true when the draw data of a
+  // platform window changed since they were last rendered and they were not
+  // rendered within PLATFORM_WINDOWS_MIN_INTERVAL
+  bool ShouldRenderPlatformWindows();
+
+ private:
+  struct ListRange {
+    uint64_t hash = 0;
+    uint32_t vertex_offset = 0;
+    uint32_t vertex_count = 0;
+    uint32_t index_offset = 0;
+    uint32_t index_count = 0;
+  };
+
+  // per frame in flight, persistently mapped
+  struct FrameBuffers {
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    Allocation vertex_memory{};
+    VkDeviceSize vertex_capacity = 0;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    Allocation index_memory{};
+    VkDeviceSize index_capacity = 0;
+    // what the buffers hold, list by list
+    std::vector<ListRange> lists;
+  };
+
+  void CreateDescriptorSetLayout();
+  void CreatePipelineLayout();
+  void CreateFontSampler();
+  void CreateDescriptorSet();
+  void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                    VkBuffer& buffer, Allocation& memory);
+  void DestroyBuffer(VkBuffer& buffer, Allocation& memory);
+  // grows both buffers to at least the given sizes, forgetting the contents
+  void Reserve(FrameBuffers& buffers, VkDeviceSize vertex_size,
+               VkDeviceSize index_size);
+  void Upload(FrameBuffers& buffers, const ImDrawData* draw_data);
+  void SetupRenderState(VkCommandBuffer command_buffer,
+                        const FrameBuffers& buffers,
+                        const ImDrawData* draw_data);
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  MemoryAllocator* allocator_ = nullptr;
+  VkRenderPass render_pass_ = VK_NULL_HANDLE;
+  VkFormat color_format_ = VK_FORMAT_UNDEFINED;
+
+  VkDescriptorSetLayout descriptor_set_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
+  VkPipeline pipeline_ = VK_NULL_HANDLE;
+
+  VkSampler font_sampler_ = VK_NULL_HANDLE;
+  VkImage font_image_ = VK_NULL_HANDLE;
+  Allocation font_memory_{};
+  VkImageView font_view_ = VK_NULL_HANDLE;
+  VkDescriptorPool descriptor_pool_ = VK_NULL_HANDLE;
+  VkDescriptorSet font_set_ = VK_NULL_HANDLE;
+  // the atlas' texture id, ImGui's backend set for the same view
+  ImTextureID font_texture_id_{};
+
+  std::vector<FrameBuffers> frames_;
+
+  uint64_t platform_windows_hash_ = 0;
+  std::chrono::steady_clock::time_point platform_windows_time_{};
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_IMGUI_RENDERER_H_
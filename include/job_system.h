@@ -0,0 +1,91 @@
+/**
+ * @file job_system.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Work-stealing thread pool: every worker owns a deque, pops its own
+ * jobs LIFO and steals FIFO from the others when it runs dry
+ * @version 1.0
+ * @date 2023-03-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_JOB_SYSTEM_H_
+#define PLAYGROUND_INCLUDE_JOB_SYSTEM_H_
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace playground {
+
+// number of unfinished jobs of a group, waited on with JobSystem::Wait()
+struct JobCounter {
+  std::atomic<uint32_t> count{0};
+  // the first exception a job of the group threw, set before its count
+  // drops; the others are logged
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+
+  inline bool IsDone() const;
+};
+
+class JobSystem {
+ public:
+  using Job = std::function<void()>;
+
+  // 0 picks one worker per hardware thread minus the calling thread
+  explicit JobSystem(uint32_t thread_count = 0);
+  JobSystem(const JobSystem&) = delete;
+  ~JobSystem();
+
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // exceptions a job throws go to its counter, without one they are only
+  // logged
+  void Schedule(Job job, JobCounter* counter = nullptr);
+  // helps running jobs until the counter drops to zero, then rethrows the
+  // first exception of its jobs
+  void Wait(const JobCounter& counter);
+  // splits [0, count) into chunks and waits for all of them, rethrowing
+  // the first exception of a chunk
+  void ParallelFor(uint32_t count, uint32_t chunk_size,
+                   const std::function<void(uint32_t, uint32_t)>& function);
+
+  uint32_t ThreadCount() const;
+  // [0, ThreadCount()) on workers, ThreadCount() on any other thread
+  uint32_t ThreadIndex() const;
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+    std::deque<JobCounter*> counters;
+  };
+
+  void WorkerLoop(uint32_t index);
+  bool TryRunOne(uint32_t index);
+  bool Pop(uint32_t index, bool steal, Job& job, JobCounter*& counter);
+
+  // one queue per worker, plus one shared by external threads
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+
+  std::atomic<bool> running_{true};
+  std::atomic<uint32_t> pending_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+};
+
+bool JobCounter::IsDone() const {
+  return 0 == count.load(std::memory_order_acquire);
+}
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_JOB_SYSTEM_H_
@@ -0,0 +1,42 @@
+/**
+ * @file ktx2.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Minimal KTX2 container parsing: format, extent and the byte range
+ * of every mip level, ready to be copied into an image as is
+ * @version 1.0
+ * @date 2023-03-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_KTX2_H_
+#define PLAYGROUND_INCLUDE_KTX2_H_
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace playground {
+
+struct Ktx2Level {
+  // bytes from the start of the file
+  uint64_t offset;
+  uint64_t size;
+};
+
+struct Ktx2Texture {
+  // a VkFormat value, never VK_FORMAT_UNDEFINED
+  uint32_t vk_format = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  // largest level first; a file asking for runtime generation has just one
+  std::vector<Ktx2Level> levels;
+  bool generate_mipmaps = false;
+};
+
+// 2D, single layer, single face and not supercompressed files only,
+// throws on anything else
+Ktx2Texture ParseKtx2(const char* data, size_t size);
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_KTX2_H_
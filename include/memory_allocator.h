@@ -0,0 +1,113 @@
+/**
+ * @file memory_allocator.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Device memory allocator which sub-allocates resources from large
+ * per memory type blocks
+ * @version 1.0
+ * @date 2023-03-04
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_MEMORY_ALLOCATOR_H_
+#define PLAYGROUND_INCLUDE_MEMORY_ALLOCATOR_H_
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+const VkDeviceSize DEFAULT_MEMORY_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+struct Allocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  // persistently mapped pointer, only valid for host visible memory
+  void* mapped = nullptr;
+  uint32_t memory_type = 0;
+  uint32_t block = 0;
+};
+
+struct HeapStats {
+  VkDeviceSize heap_size = 0;
+  VkDeviceSize allocated_bytes = 0;
+  VkDeviceSize used_bytes = 0;
+  uint32_t block_count = 0;
+  uint32_t allocation_count = 0;
+};
+
+class MemoryAllocator {
+ public:
+  MemoryAllocator() = default;
+  MemoryAllocator(const MemoryAllocator&) = delete;
+  ~MemoryAllocator() = default;
+
+  MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+  void Init(VkPhysicalDevice physical_device, VkDevice device,
+            VkDeviceSize block_size = DEFAULT_MEMORY_BLOCK_SIZE);
+  void Destroy();
+
+  // linear: buffers and linear images, kept apart from optimal images so
+  // bufferImageGranularity never has to be honored inside a block
+  Allocation Allocate(const VkMemoryRequirements& requirements,
+                      VkMemoryPropertyFlags properties, bool linear);
+  // one allocation all of `requirements` can be bound to at its offset,
+  // for resources never alive on the GPU at the same time
+  Allocation AllocateAliased(
+      const std::vector<VkMemoryRequirements>& requirements,
+      VkMemoryPropertyFlags properties, bool linear);
+  void Free(Allocation& allocation);
+
+  uint32_t FindMemoryType(uint32_t type_filter,
+                          VkMemoryPropertyFlags properties) const;
+  // e.g. whether VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT is worth asking for
+  bool HasMemoryType(uint32_t type_filter,
+                     VkMemoryPropertyFlags properties) const;
+
+  std::vector<HeapStats> GetHeapStats() const;
+  void LogStats() const;
+
+ private:
+  struct Range {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  struct Block {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    VkDeviceSize used = 0;
+    void* mapped = nullptr;
+    uint32_t memory_type = 0;
+    uint32_t allocation_count = 0;
+    bool linear = true;
+    bool dedicated = false;
+    // sorted by offset, neighbours are coalesced on free
+    std::vector<Range> free_ranges;
+  };
+
+  uint32_t CreateBlock(uint32_t memory_type, VkDeviceSize size, bool linear,
+                       bool dedicated);
+  void DestroyBlock(Block& block);
+  bool AllocateFromBlock(Block& block, VkDeviceSize size,
+                         VkDeviceSize alignment, VkDeviceSize& offset);
+  VkDeviceSize PreferredBlockSize(uint32_t memory_type) const;
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkPhysicalDeviceMemoryProperties memory_properties_{};
+  VkDeviceSize block_size_ = DEFAULT_MEMORY_BLOCK_SIZE;
+  VkDeviceSize non_coherent_atom_size_ = 1;
+  uint32_t max_allocation_count_ = 0;
+  uint32_t device_allocation_count_ = 0;
+
+  std::vector<Block> blocks_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_MEMORY_ALLOCATOR_H_
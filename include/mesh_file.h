@@ -0,0 +1,60 @@
+/**
+ * @file mesh_file.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Read-only memory mapping of a .pgmesh file, sections are used in
+ * place without parsing
+ * @version 1.0
+ * @date 2023-03-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_MESH_FILE_H_
+#define PLAYGROUND_INCLUDE_MESH_FILE_H_
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mesh_format.h"
+
+namespace playground {
+
+class MeshFile {
+ public:
+  MeshFile() = default;
+  MeshFile(const MeshFile&) = delete;
+  ~MeshFile();
+
+  MeshFile& operator=(const MeshFile&) = delete;
+
+  // maps `path` and validates the header, throws on failure
+  void Open(const std::string& path);
+  void Close();
+
+  bool IsOpen() const;
+
+  const MeshFileHeader& GetHeader() const;
+
+  // pointers into the mapping, valid until Close()
+  const void* GetVertexData() const;
+  size_t GetVertexDataSize() const;
+  const void* GetIndexData() const;
+  size_t GetIndexDataSize() const;
+  const MeshLod* GetLods() const;
+  const Meshlet* GetMeshlets() const;
+
+ private:
+  const unsigned char* data_ = nullptr;
+  size_t size_ = 0;
+
+#ifdef _WIN32
+  void* file_handle_ = nullptr;
+  void* mapping_handle_ = nullptr;
+#else
+  int file_descriptor_ = -1;
+#endif
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_MESH_FILE_H_
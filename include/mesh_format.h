@@ -0,0 +1,72 @@
+/**
+ * @file mesh_format.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief On-disk layout of .pgmesh files, written by tools/meshconv and
+ * memory mapped at runtime, every section is ready to be copied to the GPU
+ * @version 1.0
+ * @date 2023-03-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_MESH_FORMAT_H_
+#define PLAYGROUND_INCLUDE_MESH_FORMAT_H_
+#include <cstdint>
+
+namespace playground {
+
+const uint32_t MESH_FILE_MAGIC = 0x534d4750;  // "PGMS"
+const uint32_t MESH_FILE_VERSION = 1;
+// every section starts at a multiple of this
+const uint32_t MESH_FILE_ALIGNMENT = 16;
+
+// same layout as Vertex
+struct MeshVertex {
+  float position[3];
+  float color[3];
+};
+
+// a contiguous range of the index section, LOD 0 is the full mesh
+struct MeshLod {
+  uint32_t first_index;
+  uint32_t index_count;
+  uint32_t first_meshlet;
+  uint32_t meshlet_count;
+};
+
+// small cluster of triangles with its own bounds, for finer culling
+struct Meshlet {
+  uint32_t first_index;
+  uint32_t index_count;
+  float center[3];
+  float radius;
+};
+
+// file layout: header, vertices, indices, lods, meshlets; offsets are in
+// bytes from the start of the file
+struct MeshFileHeader {
+  uint32_t magic;
+  uint32_t version;
+
+  uint32_t vertex_count;
+  uint32_t vertex_stride;
+  uint64_t vertex_offset;
+
+  uint32_t index_count;
+  // 2 or 4 bytes, 2 whenever every index fits
+  uint32_t index_size;
+  uint64_t index_offset;
+
+  uint32_t lod_count;
+  uint32_t meshlet_count;
+  uint64_t lod_offset;
+  uint64_t meshlet_offset;
+
+  // bounding sphere around the origin
+  float bounding_radius;
+  uint32_t reserved;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_MESH_FORMAT_H_
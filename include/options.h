@@ -0,0 +1,113 @@
+/**
+ * @file options.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Command line options
+ * @version 1.0
+ * @date 2023-03-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_OPTIONS_H_
+#define PLAYGROUND_INCLUDE_OPTIONS_H_
+#include <cstdint>
+#include <string>
+
+namespace playground {
+
+const std::string DEFAULT_TRACE_FILEPATH{"trace.json"};
+const uint32_t DEFAULT_WARMUP_FRAMES = 60;
+const uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+// upper bound of --frames-in-flight
+const uint32_t MAX_FRAMES_IN_FLIGHT = 4;
+const uint32_t DEFAULT_MSAA_SAMPLES = 4;
+// frames per second an idle on demand window still draws
+const uint32_t DEFAULT_MIN_REFRESH_RATE = 1;
+
+struct Options {
+  bool help = false;
+
+  // --trace[=path]: write the recorded CPU trace on exit, F9 writes it to
+  // the same path at any time
+  bool trace = false;
+  std::string trace_path = DEFAULT_TRACE_FILEPATH;
+
+  // --bench-frames=N: exit after N measured frames and report statistics
+  uint32_t bench_frames = 0;
+  // --warmup=M: frames rendered before measuring starts
+  uint32_t warmup_frames = DEFAULT_WARMUP_FRAMES;
+  // --bench-json=path: also write the report there, stdout always gets it
+  std::string bench_json_path;
+
+  // --present-mode=fifo|mailbox|immediate|fifo-relaxed, empty picks one
+  std::string present_mode;
+  // --frame-limiter: with fifo modes, start a frame only once the previous
+  // one was presented
+  bool frame_limiter = false;
+  // --on-demand: sleep in the event loop and draw only for input,
+  // animation or streamed in resources; ignored by benchmark runs
+  bool on_demand = false;
+  // --min-refresh=HZ: frames per second drawn on demand without a reason
+  uint32_t min_refresh_rate = DEFAULT_MIN_REFRESH_RATE;
+  // --mesh=path: .pgmesh file from tools/meshconv, a quad without it
+  std::string mesh_path;
+  // --texture=path: .ktx2 or any image stb decodes, empty picks the
+  // compressed variant the device supports
+  std::string texture_path;
+
+  // --no-bindless: per-frame fully written descriptor sets even when the
+  // device has descriptor indexing
+  bool bindless = true;
+
+  // --no-timeline: one fence per submission even when the device has
+  // timeline semaphores
+  bool timeline = true;
+
+  // --gpu=index|name: the physical device at that enumeration index, or
+  // the first whose name contains it, instead of the best scoring one
+  std::string gpu;
+  // --async-compute: a queue of a compute family without graphics next to
+  // the graphics queue, when the device has one
+  bool async_compute = false;
+
+  // --post=bloom,fxaa|none: optional passes of the post-processing chain,
+  // tonemapping always runs
+  bool bloom = true;
+  bool fxaa = true;
+
+  // --no-lighting: the unlit variant of the scene pipeline
+  bool lighting = true;
+
+  // --msaa=1|2|4|8: samples of the scene, lowered to what the device
+  // supports
+  uint32_t msaa_samples = DEFAULT_MSAA_SAMPLES;
+
+  // --no-dynamic-rendering: render passes and framebuffers even when the
+  // device has VK_KHR_dynamic_rendering
+  bool dynamic_rendering = true;
+
+  // --hot-reload: recompile edited shaders and rebuild their pipelines
+  // while running
+  bool hot_reload = false;
+
+  // --instances=N: copies of the mesh drawn with one instanced call
+  uint32_t instances = 1;
+  // --dynamic-instances: every instance spins in place, its model matrix
+  // rewritten on the CPU each frame
+  bool dynamic_instances = false;
+
+  // --frames-in-flight=N: frames the CPU may record ahead of the GPU
+  uint32_t frames_in_flight = DEFAULT_FRAMES_IN_FLIGHT;
+
+  // --resolution=WxH, 0 keeps the default window size
+  uint32_t width = 0;
+  uint32_t height = 0;
+
+  // throws on unknown arguments
+  static Options Parse(int argc, char* argv[]);
+  static void PrintUsage();
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_OPTIONS_H_
@@ -0,0 +1,65 @@
+/**
+ * @file pipeline_cache.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief VkPipelineCache persisted to disk between runs
+ * @version 1.0
+ * @date 2023-03-13
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_PIPELINE_CACHE_H_
+#define PLAYGROUND_INCLUDE_PIPELINE_CACHE_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+class PipelineCache {
+ public:
+  PipelineCache() = default;
+  PipelineCache(const PipelineCache&) = delete;
+  ~PipelineCache() = default;
+
+  PipelineCache& operator=(const PipelineCache&) = delete;
+
+  // loads `path` if it was written by the same device and driver
+  void Init(VkPhysicalDevice physical_device, VkDevice device,
+            const std::string& path);
+  void Save();
+  void Destroy();
+
+  VkPipelineCache GetHandle() const;
+  // true when the cache was seeded from disk
+  bool IsWarm() const;
+
+ private:
+  // prefixed to the driver blob so a stale file is never handed to Vulkan
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint32_t driver_version;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
+    uint64_t data_size;
+  };
+
+  bool Load(std::vector<char>& data);
+  bool IsCompatible(const FileHeader& header,
+                    const std::vector<char>& data) const;
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  VkPhysicalDeviceProperties device_properties_{};
+  VkPipelineCache pipeline_cache_ = VK_NULL_HANDLE;
+
+  std::string path_;
+  bool warm_ = false;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_PIPELINE_CACHE_H_
@@ -0,0 +1,221 @@
+/**
+ * @file post_process.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Offscreen HDR color and depth targets the scene renders into, and
+ * the chain of compute passes (bloom, tonemap, FXAA) that resolves them into
+ * the swap chain image, declared as passes of the frame's render graph
+ * @version 1.0
+ * @date 2023-03-28
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_POST_PROCESS_H_
+#define PLAYGROUND_INCLUDE_POST_PROCESS_H_
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "deletion_queue.h"
+#include "render_graph.h"
+
+namespace playground {
+
+const VkFormat HDR_COLOR_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+// tonemapped, what FXAA reads
+const VkFormat LDR_COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+// GLSL qualifiers of the two, for the shader variants declaring the format
+// they store
+const std::string HDR_COLOR_GLSL_FORMAT{"rgba16f"};
+const std::string LDR_COLOR_GLSL_FORMAT{"rgba8"};
+// half resolution first, each further one halves again
+const uint32_t MAX_BLOOM_MIPS = 6;
+
+struct PostProcessSettings {
+  // the tonemap pass always runs, these are optional
+  bool bloom = true;
+  bool fxaa = true;
+
+  float exposure = 1.0f;
+  // HDR values above the threshold bleed, the knee softens the cut
+  float bloom_threshold = 1.0f;
+  float bloom_knee = 0.5f;
+  float bloom_intensity = 0.05f;
+  // 0 keeps texture detail, 1 is the softest
+  float fxaa_subpixel = 0.75f;
+
+  // of the scene's color and depth, resolved into the HDR target by the
+  // scene pass itself; supported by the device for both
+  VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// SPIR-V of every pass, owned by the caller during the call taking them
+struct PostProcessShaders {
+  const std::vector<char>* bloom_down = nullptr;
+  const std::vector<char>* bloom_up = nullptr;
+  const std::vector<char>* tonemap = nullptr;
+  const std::vector<char>* fxaa = nullptr;
+};
+
+class PostProcessChain {
+ public:
+  // only those of the enabled passes are created
+  struct Pipelines {
+    VkPipeline bloom_down = VK_NULL_HANDLE;
+    VkPipeline bloom_up = VK_NULL_HANDLE;
+    VkPipeline tonemap = VK_NULL_HANDLE;
+    VkPipeline fxaa = VK_NULL_HANDLE;
+  };
+
+  PostProcessChain() = default;
+  PostProcessChain(const PostProcessChain&) = delete;
+  ~PostProcessChain() = default;
+
+  PostProcessChain& operator=(const PostProcessChain&) = delete;
+
+  // `shaders` either store without a format, which needs
+  // shaderStorageImageWriteWithoutFormat enabled, or are the variants
+  // declaring it: tonemap LDR_COLOR_GLSL_FORMAT with FXAA and
+  // HDR_COLOR_GLSL_FORMAT without, FXAA HDR_COLOR_GLSL_FORMAT, which only
+  // blit into the output; with `dynamic_rendering` (VK_KHR_dynamic_rendering
+  // enabled) the scene needs no render pass or framebuffers
+  void Init(VkPhysicalDevice physical_device, VkDevice device,
+            DeletionQueue& deletion_queue, VkPipelineCache pipeline_cache,
+            const PostProcessSettings& settings,
+            const PostProcessShaders& shaders, bool dynamic_rendering);
+  void Destroy();
+
+  // safe from any thread after Init(), e.g. a job rebuilding them after a
+  // shader reload
+  Pipelines CreatePipelines(VkPipelineCache pipeline_cache,
+                            const PostProcessShaders& shaders) const;
+  // not while recording, `pipelines` gets the replaced ones back
+  void SwapPipelines(Pipelines& pipelines);
+  void DestroyPipelines(Pipelines& pipelines) const;
+
+  // true if a swap chain created with VK_IMAGE_USAGE_STORAGE_BIT can be
+  // written directly by shaders storing without a format, otherwise the
+  // result is blitted into it and it needs VK_IMAGE_USAGE_TRANSFER_DST_BIT
+  // instead; callable before Init()
+  static bool CanWriteOutput(VkPhysicalDevice physical_device, VkFormat format,
+                             VkImageUsageFlags supported_usage);
+
+  // declares the HDR target of `extent`, depth and with MSAA the
+  // multisampled color as lazily allocated attachments, and the pass
+  // clearing, drawing into and resolving them; `draw_scene` executes the
+  // secondaries, the caller adds what else the scene reads. What was bound
+  // to the previous graph is retired
+  RenderGraph::Pass& AddScenePass(RenderGraph& graph, VkExtent2D extent,
+                                  RenderGraph::Record draw_scene);
+  // after AddScenePass(): bloom, tonemap and FXAA into `output`, one image
+  // per swap chain image, left in VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+  // or VK_IMAGE_LAYOUT_GENERAL for the pass after; `storage` as decided by
+  // CanWriteOutput(), otherwise the result is blitted into `output_images`
+  void AddPasses(RenderGraph& graph, RenderResource output,
+                 VkFormat output_format,
+                 const std::vector<VkImage>& output_images, bool storage);
+  // after the graph compiled, framebuffer and descriptor sets on its images
+  void Bind(const RenderGraph& graph,
+            const std::vector<VkImageView>& output_views);
+
+  // color (attachment 0), depth (attachment 1) and with MSAA the HDR target
+  // resolved into (attachment 2), both VK_NULL_HANDLE with dynamic
+  // rendering: pipelines and secondaries use the formats and samples
+  VkRenderPass GetSceneRenderPass() const;
+  VkFramebuffer GetSceneFramebuffer() const;
+  VkFormat GetDepthFormat() const;
+  VkSampleCountFlagBits GetSampleCount() const;
+
+ private:
+  struct Targets {
+    RenderResource hdr = 0;
+    RenderResource depth = 0;
+    // drawn into with MSAA, resolved into hdr
+    RenderResource msaa_color = 0;
+    RenderResource bloom = 0;
+    RenderResource ldr = 0;
+    // blit source when the swap chain cannot be written by the chain
+    RenderResource output = 0;
+    uint32_t bloom_mips = 0;
+    VkExtent2D bloom_extent{};
+
+    VkImageView hdr_view = VK_NULL_HANDLE;
+    VkImageView depth_view = VK_NULL_HANDLE;
+    VkImageView msaa_color_view = VK_NULL_HANDLE;
+    VkImage output_image = VK_NULL_HANDLE;
+
+    VkFramebuffer scene_framebuffer = VK_NULL_HANDLE;
+    VkDescriptorPool descriptor_pool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> bloom_down_sets;
+    std::vector<VkDescriptorSet> bloom_up_sets;
+    // per output image, the last pass of the chain writes into it
+    std::vector<VkDescriptorSet> tonemap_sets;
+    std::vector<VkDescriptorSet> fxaa_sets;
+
+    std::vector<VkImage> output_images;
+    VkExtent2D extent{};
+    bool storage_output = false;
+    // the output encodes to sRGB itself
+    bool linear_output = false;
+  };
+
+  struct PushConstants {
+    float texel_size[2];
+    float param0;
+    float param1;
+    uint32_t flags;
+  };
+
+  void CreateSceneRenderPass();
+  VkPipeline CreatePipeline(VkPipelineCache pipeline_cache,
+                            const std::vector<char>& code,
+                            const VkSpecializationInfo* specialization) const;
+
+  void CreateDescriptorSets(Targets& targets, const RenderGraph& graph,
+                            const std::vector<VkImageView>& output_views);
+  VkDescriptorSet WriteSet(VkDescriptorPool pool, VkImageView source,
+                           VkImageLayout source_layout, VkImageView second,
+                           VkImageLayout second_layout,
+                           VkImageView destination);
+  void DestroyTargets(Targets& targets);
+
+  // the render pass' or dynamic rendering's load and store, the graph
+  // transitions the targets around them
+  void BeginScene(VkCommandBuffer command_buffer) const;
+  void EndScene(VkCommandBuffer command_buffer) const;
+  void RecordBloomDown(VkCommandBuffer command_buffer, uint32_t mip) const;
+  void RecordBloomUp(VkCommandBuffer command_buffer, uint32_t mip) const;
+  void RecordTonemap(VkCommandBuffer command_buffer,
+                     uint32_t image_index) const;
+  void RecordFxaa(VkCommandBuffer command_buffer, uint32_t image_index) const;
+  void RecordCopy(VkCommandBuffer command_buffer, uint32_t image_index) const;
+
+  void Dispatch(VkCommandBuffer command_buffer, VkPipeline pipeline,
+                VkDescriptorSet set, const PushConstants& push_constants,
+                VkExtent2D extent) const;
+
+  VkPhysicalDevice physical_device_ = VK_NULL_HANDLE;
+  VkDevice device_ = VK_NULL_HANDLE;
+  DeletionQueue* deletion_queue_ = nullptr;
+  PostProcessSettings settings_{};
+
+  VkFormat depth_format_ = VK_FORMAT_UNDEFINED;
+  VkRenderPass scene_render_pass_ = VK_NULL_HANDLE;
+  bool dynamic_rendering_ = false;
+  PFN_vkCmdBeginRenderingKHR cmd_begin_rendering_ = nullptr;
+  PFN_vkCmdEndRenderingKHR cmd_end_rendering_ = nullptr;
+  VkSampler sampler_ = VK_NULL_HANDLE;
+
+  // one layout for every pass: two sampled sources, one storage destination
+  VkDescriptorSetLayout descriptor_set_layout_ = VK_NULL_HANDLE;
+  VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
+  Pipelines pipelines_{};
+
+  Targets targets_{};
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_POST_PROCESS_H_
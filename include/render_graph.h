@@ -0,0 +1,334 @@
+/**
+ * @file render_graph.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Passes of a frame declared with the resources they read and write,
+ * compiled once per swap chain into culled passes, merged barrier batches,
+ * aliased transient images and queue ownership transfers, then replayed
+ * every frame
+ * @version 1.0
+ * @date 2023-03-30
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_RENDER_GRAPH_H_
+#define PLAYGROUND_INCLUDE_RENDER_GRAPH_H_
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_profiler.h"
+#include "memory_allocator.h"
+
+namespace playground {
+
+using RenderResource = uint32_t;
+
+// every mip of an image
+const uint32_t ALL_MIPS = ~0u;
+
+// how a pass touches a resource, in synchronization2 terms; only bits that
+// exist in the original flags too, so barriers also work without it
+struct ResourceAccess {
+  VkPipelineStageFlags2KHR stages;
+  VkAccessFlags2KHR access;
+  // images only, the usage transient images are created with
+  VkImageLayout layout;
+  VkImageUsageFlags usage;
+};
+
+const ResourceAccess COLOR_ATTACHMENT_ACCESS{
+    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+    VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR |
+        VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR,
+    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT};
+const ResourceAccess DEPTH_ATTACHMENT_ACCESS{
+    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR |
+        VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR,
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR |
+        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR,
+    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+const ResourceAccess COMPUTE_SAMPLED_READ{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT};
+// sampled in the layout other mips of the image are written in
+const ResourceAccess COMPUTE_GENERAL_READ{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR,
+    VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_SAMPLED_BIT};
+const ResourceAccess COMPUTE_STORAGE_WRITE{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+    VK_ACCESS_2_SHADER_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL,
+    VK_IMAGE_USAGE_STORAGE_BIT};
+const ResourceAccess COMPUTE_STORAGE_READ_WRITE{
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+    VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+    VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT};
+const ResourceAccess TRANSFER_READ{
+    VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR,
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT};
+const ResourceAccess TRANSFER_WRITE{
+    VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+const ResourceAccess INDIRECT_READ{
+    VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR,
+    VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED, 0};
+const ResourceAccess VERTEX_INPUT_READ{
+    VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT_KHR,
+    VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED, 0};
+// a swap chain image as acquired, its semaphore is waited on at this stage
+const ResourceAccess ACQUIRE_ACCESS{
+    VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+    VK_ACCESS_2_NONE_KHR, VK_IMAGE_LAYOUT_UNDEFINED, 0};
+const ResourceAccess PRESENT_ACCESS{VK_PIPELINE_STAGE_2_NONE_KHR,
+                                    VK_ACCESS_2_NONE_KHR,
+                                    VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0};
+
+// where a pass executes; without a compute family of its own, async compute
+// passes run on the graphics queue like the rest
+enum class RenderQueue { GRAPHICS, ASYNC_COMPUTE };
+
+struct RenderImageDesc {
+  VkFormat format = VK_FORMAT_UNDEFINED;
+  VkExtent2D extent{};
+  uint32_t mip_levels = 1;
+  // of the views, depth only for combined depth/stencil formats
+  VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+  VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+  // attachments whose contents never leave the pass: created with
+  // VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT and backed by lazily allocated
+  // memory where the device has it, tile memory only on tilers
+  bool transient = false;
+};
+
+// what changes from one execution of the graph to the next
+struct RenderGraphFrame {
+  // frame in flight
+  uint32_t frame = 0;
+  // acquired swap chain image, picks the image of per image imports
+  uint32_t image_index = 0;
+};
+
+class RenderGraph {
+ public:
+  using Record =
+      std::function<void(VkCommandBuffer, const RenderGraphFrame& frame)>;
+
+  class Pass {
+   public:
+    // the pass depends on the contents, `mip` for images only
+    Pass& Read(RenderResource resource, const ResourceAccess& access,
+               uint32_t mip = ALL_MIPS);
+    // the pass changes the contents
+    Pass& Write(RenderResource resource, const ResourceAccess& access,
+                uint32_t mip = ALL_MIPS);
+    Pass& ReadWrite(RenderResource resource, const ResourceAccess& access,
+                    uint32_t mip = ALL_MIPS);
+    // recorded after the barriers the declared uses need
+    Pass& SetRecord(Record record);
+    // async compute passes lead the frame and use buffers only
+    Pass& SetQueue(RenderQueue queue);
+
+   private:
+    friend class RenderGraph;
+
+    struct Use {
+      RenderResource resource;
+      ResourceAccess access;
+      uint32_t mip;
+      bool read;
+      bool write;
+    };
+
+    Pass& AddUse(RenderResource resource, const ResourceAccess& access,
+                 uint32_t mip, bool read, bool write);
+
+    std::string name;
+    const char* scope = nullptr;
+    RenderQueue queue = RenderQueue::GRAPHICS;
+    std::vector<Use> uses;
+    Record record;
+  };
+
+  RenderGraph() = default;
+  RenderGraph(const RenderGraph&) = delete;
+  ~RenderGraph() = default;
+
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  // without `synchronization2` (VK_KHR_synchronization2 enabled) barriers
+  // are recorded with vkCmdPipelineBarrier, stages of a batch merged; a
+  // `compute_family` other than `graphics_family` moves the async compute
+  // passes into ExecuteAsync()
+  void Init(VkDevice device, MemoryAllocator& allocator, bool synchronization2,
+            uint32_t graphics_family, uint32_t compute_family);
+  // the transient images, not while a frame executing the graph is in
+  // flight
+  void Destroy();
+
+  // images the graph does not own, either one or one per swap chain image;
+  // a frame starts with them in `initial_access` and leaves them in
+  // `final_access`, the passes writing them are never culled
+  RenderResource ImportImage(const std::string& name,
+                             const std::vector<VkImage>& images,
+                             VkImageAspectFlags aspect,
+                             const ResourceAccess& initial_access,
+                             const ResourceAccess& final_access);
+  // created by Compile() with the usage of every access, images whose
+  // lifetimes within the frame do not overlap share memory unless they are
+  // lazily allocated
+  RenderResource CreateImage(const std::string& name,
+                             const RenderImageDesc& desc);
+  // tracked for their dependencies only, one per frame in flight whose
+  // previous use the frame's fence covers; synchronized with memory
+  // barriers, except for the ownership transfers of buffers async compute
+  // passes use, which need the `buffers` of every frame in flight
+  RenderResource CreateBuffer(const std::string& name,
+                              const std::vector<VkBuffer>& buffers = {});
+
+  // executed in the order added; consecutive passes of the same `scope`
+  // (string literal) are timed as one profiler scope
+  Pass& AddPass(const std::string& name, const char* scope = nullptr);
+
+  // culls passes no import depends on, places the barriers and allocates
+  // the transient images, no passes are added afterwards
+  void Compile();
+
+  // transient images, valid after Compile()
+  VkImage GetImage(RenderResource resource) const;
+  VkImageView GetView(RenderResource resource) const;
+  VkImageView GetMipView(RenderResource resource, uint32_t mip) const;
+
+  // valid after Compile(): the async compute passes need a submission to
+  // the compute queue, which the graphics one waits for at these stages
+  bool HasAsyncPasses() const;
+  VkPipelineStageFlags GetAsyncWaitStages() const;
+
+  // the async compute passes and the release of what they hand over, for a
+  // command buffer of the compute family; `profiler` is that queue's
+  void ExecuteAsync(VkCommandBuffer command_buffer,
+                    const RenderGraphFrame& frame,
+                    GpuProfiler& profiler) const;
+  // every other pass, starting with the acquires
+  void Execute(VkCommandBuffer command_buffer, const RenderGraphFrame& frame,
+               GpuProfiler& profiler) const;
+
+ private:
+  enum class ResourceType { IMPORTED_IMAGE, TRANSIENT_IMAGE, BUFFER };
+
+  struct Resource {
+    std::string name;
+    ResourceType type = ResourceType::BUFFER;
+    RenderImageDesc desc{};
+    std::vector<VkImage> imports;
+    // buffers, one per frame in flight
+    std::vector<VkBuffer> buffers;
+    ResourceAccess initial_access{};
+    ResourceAccess final_access{};
+
+    // transient images
+    VkImage image = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+    std::vector<VkImageView> mip_views;
+    VkImageUsageFlags usage = 0;
+    // kept passes the contents live through, inclusive
+    uint32_t first_pass = ~0u;
+    uint32_t last_pass = 0;
+    // everything the kept passes do to it, what the next image sharing its
+    // memory waits for
+    VkPipelineStageFlags2KHR stages = 0;
+    VkAccessFlags2KHR writes = 0;
+    RenderResource previous_alias = 0;
+  };
+
+  // one subresource range of an image, whole buffers merge into one
+  // memory barrier unless their queue family changes
+  struct Barrier {
+    RenderResource resource;
+    uint32_t base_mip;
+    uint32_t mip_count;
+    VkPipelineStageFlags2KHR src_stages;
+    VkAccessFlags2KHR src_access;
+    VkPipelineStageFlags2KHR dst_stages;
+    VkAccessFlags2KHR dst_access;
+    VkImageLayout old_layout;
+    VkImageLayout new_layout;
+    // ownership transfers, the release and the acquire share them
+    uint32_t src_family = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t dst_family = VK_QUEUE_FAMILY_IGNORED;
+  };
+
+  // of one subresource while the frame is simulated
+  struct State {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    // the last write or layout transition
+    VkPipelineStageFlags2KHR write_stages = 0;
+    VkAccessFlags2KHR write_access = 0;
+    // since then: reads a write has to wait for, and what already waited
+    VkPipelineStageFlags2KHR read_stages = 0;
+    VkPipelineStageFlags2KHR visible_stages = 0;
+    VkAccessFlags2KHR visible_access = 0;
+  };
+
+  uint32_t GetMipCount(const Resource& resource) const;
+  void CullPasses();
+  // the leading async compute passes, when there is a compute family
+  void AssignQueues();
+  void CreateImages();
+  // images whose lifetimes do not overlap share an allocation
+  void AllocateImages();
+  void CreateViews(Resource& resource);
+  void PlaceBarriers();
+  // releases what the async compute passes used at their end, acquires it
+  // into `batch` ahead of the first graphics pass
+  void TransferOwnership(std::vector<std::vector<State>>& states,
+                         const std::vector<bool>& async_used,
+                         std::vector<Barrier>& batch);
+  void Transition(RenderResource resource, uint32_t mip, State& state,
+                  const ResourceAccess& access, std::vector<Barrier>& batch);
+  static void MergeBarriers(std::vector<Barrier>& batch);
+
+  VkImage ResolveImage(const Resource& resource,
+                       const RenderGraphFrame& frame) const;
+  VkBuffer ResolveBuffer(const Resource& resource,
+                         const RenderGraphFrame& frame) const;
+  VkImageAspectFlags GetBarrierAspect(const Resource& resource) const;
+  void RecordBarriers(VkCommandBuffer command_buffer,
+                      const std::vector<Barrier>& batch,
+                      const RenderGraphFrame& frame) const;
+  // kept passes [begin, end) with their barriers and profiler scopes
+  void RecordPasses(VkCommandBuffer command_buffer,
+                    const RenderGraphFrame& frame, GpuProfiler& profiler,
+                    size_t begin, size_t end) const;
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  MemoryAllocator* allocator_ = nullptr;
+  PFN_vkCmdPipelineBarrier2KHR cmd_pipeline_barrier2_ = nullptr;
+  uint32_t graphics_family_ = 0;
+  uint32_t compute_family_ = 0;
+
+  std::vector<Resource> resources_;
+  // references handed out by AddPass() stay valid
+  std::deque<Pass> passes_;
+
+  // kept passes in order, each after its barriers
+  std::vector<uint32_t> order_;
+  std::vector<std::vector<Barrier>> batches_;
+  // into the final states of the imports
+  std::vector<Barrier> final_batch_;
+  // the first `async_pass_count_` of order_, then the release batch
+  size_t async_pass_count_ = 0;
+  std::vector<Barrier> release_batch_;
+  VkPipelineStageFlags2KHR async_wait_stages_ = 0;
+  std::vector<Allocation> allocations_;
+  bool compiled_ = false;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_RENDER_GRAPH_H_
@@ -0,0 +1,57 @@
+/**
+ * @file ring_space.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Byte accounting of a ring buffer: aligned allocations that never
+ * straddle its end, reclaimed by submission marker
+ * @version 1.0
+ * @date 2023-03-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_RING_SPACE_H_
+#define PLAYGROUND_INCLUDE_RING_SPACE_H_
+#include <cstdint>
+#include <deque>
+
+namespace playground {
+
+class RingSpace {
+ public:
+  RingSpace() = default;
+  RingSpace(const RingSpace&) = delete;
+  ~RingSpace() = default;
+
+  RingSpace& operator=(const RingSpace&) = delete;
+
+  // forgets every allocation
+  void Reset(uint64_t capacity);
+
+  uint64_t Capacity() const;
+  uint64_t Used() const;
+
+  // offset of `size` bytes aligned to `alignment`, false while the space
+  // is still held; an empty ring fits anything up to its capacity
+  bool TryAllocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+
+  // everything allocated since the last call belongs to submission `marker`
+  void Retire(uint64_t marker);
+  // reclaims the space of all retired submissions up to `marker`
+  void Release(uint64_t marker);
+
+ private:
+  struct Retired {
+    uint64_t marker;
+    uint64_t head;
+  };
+
+  uint64_t capacity_ = 0;
+  // monotonically increasing byte counters, wrapped by capacity on use
+  uint64_t head_ = 0;
+  uint64_t tail_ = 0;
+  std::deque<Retired> retired_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_RING_SPACE_H_
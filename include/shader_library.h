@@ -0,0 +1,141 @@
+/**
+ * @file shader_library.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief SPIR-V of every shader, loaded on the job system and optionally
+ * hot reloaded: edited GLSL is recompiled with glslc, rebuilt SPIR-V read
+ * again, so the pipelines using it can be rebuilt
+ * @version 1.0
+ * @date 2023-03-29
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_SHADER_LIBRARY_H_
+#define PLAYGROUND_INCLUDE_SHADER_LIBRARY_H_
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "asset_loader.h"
+#include "job_system.h"
+
+namespace playground {
+
+// set by CMake to the glslc it compiles the shaders with
+#ifdef PLAYGROUND_GLSLC
+const std::string GLSLC_PATH{PLAYGROUND_GLSLC};
+#else
+const std::string GLSLC_PATH{"glslc"};
+#endif
+
+// set by CMake: the build's SPIR-V output and the GLSL it is compiled from;
+// hot reload compiles into the former, the source tree stays untouched
+#ifdef PLAYGROUND_SHADER_DIR
+const std::string SHADER_DIR{PLAYGROUND_SHADER_DIR};
+#else
+const std::string SHADER_DIR{"shaders"};
+#endif
+#ifdef PLAYGROUND_SHADER_SOURCE_DIR
+const std::string SHADER_SOURCE_DIR{PLAYGROUND_SHADER_SOURCE_DIR};
+#else
+const std::string SHADER_SOURCE_DIR{"../shaders"};
+#endif
+
+// file times are checked at most this often
+const std::chrono::milliseconds SHADER_WATCH_INTERVAL{250};
+
+using ShaderId = uint32_t;
+
+// 32-bit constants of one pipeline variant, keyed by constant_id
+class SpecializationConstants {
+ public:
+  SpecializationConstants& Set(uint32_t constant_id, uint32_t value);
+  // nullptr without constants, valid until the next Set()
+  const VkSpecializationInfo* Get();
+
+ private:
+  std::vector<VkSpecializationMapEntry> entries_;
+  std::vector<uint32_t> data_;
+  VkSpecializationInfo info_{};
+};
+
+class ShaderLibrary {
+ public:
+  using Code = std::shared_ptr<const std::vector<char>>;
+
+  ShaderLibrary(JobSystem& job_system, AssetLoader& asset_loader,
+                const std::string& spv_dir = SHADER_DIR,
+                const std::string& source_dir = SHADER_SOURCE_DIR);
+  ShaderLibrary(const ShaderLibrary&) = delete;
+  ~ShaderLibrary();
+
+  ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+  // starts reading the SPIR-V of `name`, e.g. "triangle.vert": the source
+  // in the source directory, "triangle.vert.spv" in the SPIR-V one; throws
+  // if the SPIR-V is missing or older than its source. With `format`, e.g.
+  // "rgba8", the variant compiled with -DOUTPUT_FORMAT=rgba8 into
+  // "tonemap.comp.rgba8.spv", declaring the format of its storage image
+  // output for devices without shaderStorageImageWriteWithoutFormat
+  ShaderId Request(const std::string& name, const std::string& format = "");
+  // latest SPIR-V, waits for the first read and throws if it failed; safe
+  // from any thread, the code stays valid as long as it is held
+  Code Get(ShaderId id);
+  const std::string& GetPath(ShaderId id) const;
+
+  // off by default, file times are taken when it is turned on
+  void SetHotReload(bool enabled);
+  bool IsHotReload() const;
+  // one thread only: starts reloads of changed files, returns the shaders
+  // whose new code became available since the last call; failed compiles
+  // are logged and keep the old code
+  std::vector<ShaderId> Poll();
+
+ private:
+  // one recompile or reread in flight per shader
+  struct Reload {
+    bool compile = false;
+    std::vector<char> code;
+    std::string error;
+    JobCounter counter;
+  };
+
+  struct Shader {
+    std::string spv_path;
+    std::string source_path;
+    // OUTPUT_FORMAT it is compiled with, empty without
+    std::string format;
+    std::shared_ptr<Asset> asset;
+    Code code;
+    // last seen, zero when the file does not exist
+    std::filesystem::file_time_type source_time{};
+    std::filesystem::file_time_type spv_time{};
+    std::shared_ptr<Reload> reload;
+  };
+
+  static std::filesystem::file_time_type GetWriteTime(const std::string& path);
+  void StartReload(Shader& shader, bool compile);
+
+  JobSystem& job_system_;
+  AssetLoader& asset_loader_;
+  std::filesystem::path spv_dir_;
+  std::filesystem::path source_dir_;
+
+  // guards `code` of each shader, everything else belongs to the thread
+  // that requests and polls
+  mutable std::mutex mutex_;
+  std::vector<Shader> shaders_;
+
+  bool hot_reload_ = false;
+  std::chrono::steady_clock::time_point last_poll_{};
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_SHADER_LIBRARY_H_
@@ -0,0 +1,67 @@
+/**
+ * @file staging_ring.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Persistently mapped ring buffer for staging CPU data to the GPU,
+ * space is reclaimed once the submission that used it has completed
+ * @version 1.0
+ * @date 2023-03-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_STAGING_RING_H_
+#define PLAYGROUND_INCLUDE_STAGING_RING_H_
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "memory_allocator.h"
+#include "ring_space.h"
+
+namespace playground {
+
+const VkDeviceSize DEFAULT_STAGING_RING_SIZE = 32ull * 1024 * 1024;
+
+struct StagingAllocation {
+  VkBuffer buffer = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  void* mapped = nullptr;
+};
+
+class StagingRing {
+ public:
+  StagingRing() = default;
+  StagingRing(const StagingRing&) = delete;
+  ~StagingRing() = default;
+
+  StagingRing& operator=(const StagingRing&) = delete;
+
+  void Init(VkDevice device, MemoryAllocator& allocator,
+            VkDeviceSize capacity = DEFAULT_STAGING_RING_SIZE);
+  void Destroy();
+
+  VkDeviceSize Capacity() const;
+  VkDeviceSize Used() const;
+
+  // false while the space is still held, see RingSpace::TryAllocate()
+  bool TryAllocate(VkDeviceSize size, VkDeviceSize alignment,
+                   StagingAllocation& allocation);
+
+  // everything allocated since the last call belongs to submission `marker`
+  void Retire(uint64_t marker);
+  // reclaims the space of all retired submissions up to `marker`
+  void Release(uint64_t marker);
+
+ private:
+  VkDevice device_ = VK_NULL_HANDLE;
+  MemoryAllocator* allocator_ = nullptr;
+
+  VkBuffer buffer_ = VK_NULL_HANDLE;
+  Allocation memory_{};
+  RingSpace space_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_STAGING_RING_H_
@@ -0,0 +1,97 @@
+/**
+ * @file startup_graph.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Initialization steps as a dependency graph: main thread steps run
+ * in the order they were added, worker steps on the job system as soon as
+ * the steps they depend on are done, every one of them timed
+ * @version 1.0
+ * @date 2023-04-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_STARTUP_GRAPH_H_
+#define PLAYGROUND_INCLUDE_STARTUP_GRAPH_H_
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+
+namespace playground {
+
+struct StartupTiming {
+  std::string name;
+  // since Run() started
+  double start_ms = 0.0;
+  double ms = 0.0;
+  bool worker = false;
+};
+
+class StartupGraph {
+ public:
+  using Step = std::function<void()>;
+  using StepId = uint32_t;
+
+  explicit StartupGraph(JobSystem& job_system);
+  StartupGraph(const StartupGraph&) = delete;
+  ~StartupGraph() = default;
+
+  StartupGraph& operator=(const StartupGraph&) = delete;
+
+  // on the thread calling Run(), after the main thread step added before it
+  // and `dependencies`
+  StepId AddMain(const std::string& name, Step step,
+                 const std::vector<StepId>& dependencies = {});
+  // on a worker once `dependencies` are done; whatever it writes must not
+  // be touched by steps not depending on it
+  StepId AddWorker(const std::string& name, Step step,
+                   const std::vector<StepId>& dependencies = {});
+
+  // returns once every step is done; after a step threw, the ones not
+  // started yet are skipped and its exception is rethrown
+  void Run();
+
+  // in the order the steps started
+  std::vector<StartupTiming> GetTimings() const;
+
+ private:
+  struct Node {
+    std::string name;
+    // interned, the tracer keeps it past the graph's lifetime
+    const char* trace_name = nullptr;
+    Step step;
+    bool worker = false;
+    std::vector<StepId> dependencies;
+    std::vector<StepId> dependents;
+    // dependencies not done yet, worker steps are scheduled at zero
+    std::atomic<uint32_t> waiting{0};
+    // 1 until done or skipped
+    JobCounter done;
+    StartupTiming timing{};
+  };
+
+  StepId Add(const std::string& name, Step step, bool worker,
+             const std::vector<StepId>& dependencies);
+  // runs the step on the calling thread and releases its dependents
+  void Execute(StepId id);
+  void Schedule(StepId id);
+
+  JobSystem& job_system_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  std::chrono::steady_clock::time_point start_time_{};
+
+  std::atomic<bool> failed_{false};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_STARTUP_GRAPH_H_
@@ -0,0 +1,114 @@
+/**
+ * @file trace.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Scoped CPU timers recorded into per-thread rings, exported as
+ * Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+ * @version 1.0
+ * @date 2023-03-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_TRACE_H_
+#define PLAYGROUND_INCLUDE_TRACE_H_
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace playground {
+
+// events kept per thread, older ones are overwritten
+const uint32_t TRACE_EVENTS_PER_THREAD = 1 << 15;
+
+struct TraceEvent {
+  const char* name;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+};
+
+class Tracer {
+ public:
+  static Tracer& Get();
+
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  void SetEnabled(bool enabled);
+  inline bool IsEnabled() const;
+
+  // nanoseconds since the tracer was created
+  uint64_t Now() const;
+
+  // `name` must outlive the tracer: a string literal or Intern()'s result
+  void Record(const char* name, uint64_t begin_ns, uint64_t end_ns);
+  // copy of a name built at runtime, kept as long as the tracer; repeated
+  // names share one copy
+  const char* Intern(const std::string& name);
+  void SetThreadName(const std::string& name);
+
+  // writes whatever the rings hold right now, safe while other threads
+  // keep recording
+  bool Export(const std::string& path);
+
+ private:
+  // written by its owning thread only, the exporter reads up to `head`
+  struct ThreadBuffer {
+    uint32_t id = 0;
+    std::string name;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint64_t> head{0};
+  };
+
+  Tracer();
+  ~Tracer() = default;
+
+  ThreadBuffer& GetThreadBuffer();
+
+  std::atomic<bool> enabled_{true};
+  uint64_t epoch_ns_ = 0;
+
+  // only locked when a thread records its first event and on export
+  std::mutex buffers_mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  // nodes never move, so the pointers handed out stay valid
+  std::mutex names_mutex_;
+  std::unordered_set<std::string> names_;
+};
+
+// records the lifetime of the enclosing scope, `name` as for Record()
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name);
+  TraceScope(const TraceScope&) = delete;
+  ~TraceScope();
+
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name_;
+  uint64_t begin_ns_ = 0;
+};
+
+bool Tracer::IsEnabled() const {
+  return enabled_.load(std::memory_order_relaxed);
+}
+
+}  // namespace playground
+
+#define PLAYGROUND_TRACE_VAR_(line) trace_scope_##line
+#define PLAYGROUND_TRACE_VAR(line) PLAYGROUND_TRACE_VAR_(line)
+
+// compiled out entirely with -DPLAYGROUND_DISABLE_TRACE
+#ifdef PLAYGROUND_DISABLE_TRACE
+#define TRACE_SCOPE(name)
+#else
+#define TRACE_SCOPE(name) \
+  ::playground::TraceScope PLAYGROUND_TRACE_VAR(__LINE__)(name)
+#endif
+
+#endif  // PLAYGROUND_INCLUDE_TRACE_H_
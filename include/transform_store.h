@@ -0,0 +1,76 @@
+/**
+ * @file transform_store.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Instance transforms as a structure of arrays, turned into model
+ * matrices by a SIMD kernel (AVX2, SSE or NEON, whatever the build targets)
+ * writing straight into mapped instance data
+ * @version 1.0
+ * @date 2023-04-01
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_TRANSFORM_STORE_H_
+#define PLAYGROUND_INCLUDE_TRANSFORM_STORE_H_
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace playground {
+
+// every array is aligned to and padded to a multiple of the widest batch
+const uint32_t TRANSFORM_ALIGNMENT = 32;
+
+class TransformStore {
+ public:
+  TransformStore() = default;
+  TransformStore(const TransformStore&) = delete;
+  ~TransformStore() = default;
+
+  TransformStore& operator=(const TransformStore&) = delete;
+
+  // keeps the first `count` transforms, added ones are identities
+  void Resize(uint32_t count);
+  uint32_t Size() const;
+
+  void Set(uint32_t index, const glm::vec3& position,
+           const glm::quat& rotation, const glm::vec3& scale);
+
+  // disjoint ranges may be updated and written concurrently, e.g. as
+  // chunks on the job system
+
+  // rotations of [begin, end) followed by `delta` in their own frames,
+  // renormalized on the way
+  void Rotate(uint32_t begin, uint32_t end, const glm::quat& delta);
+  // translate * rotate * scale of [begin, end) as column major mat4, the one
+  // of instance i to `dst` + (i - begin) * `stride`
+  void WriteModels(uint32_t begin, uint32_t end, void* dst,
+                   size_t stride) const;
+  // the same one instance at a time with glm, what the kernel replaces
+  void WriteModelsScalar(uint32_t begin, uint32_t end, void* dst,
+                         size_t stride) const;
+
+  // "AVX2", "SSE", "NEON" or "scalar"
+  static const char* GetKernelName();
+  // instances per kernel iteration
+  static uint32_t GetKernelWidth();
+
+ private:
+  struct AlignedDelete {
+    void operator()(float* data) const;
+  };
+
+  float* Component(uint32_t component) const;
+
+  uint32_t count_ = 0;
+  uint32_t capacity_ = 0;
+  // position xyz, rotation xyzw, scale xyz, `capacity_` floats each
+  std::unique_ptr<float, AlignedDelete> data_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_TRANSFORM_STORE_H_
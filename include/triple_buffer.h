@@ -0,0 +1,87 @@
+/**
+ * @file triple_buffer.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Lock-free single producer, single consumer triple buffer: the
+ * producer always has a slot to write, the consumer always reads the latest
+ * complete one
+ * @version 1.0
+ * @date 2023-03-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_TRIPLE_BUFFER_H_
+#define PLAYGROUND_INCLUDE_TRIPLE_BUFFER_H_
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace playground {
+
+template <typename T>
+class TripleBuffer {
+ public:
+  TripleBuffer() = default;
+  TripleBuffer(const TripleBuffer&) = delete;
+  ~TripleBuffer() = default;
+
+  TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+  // producer: the slot being written, never seen by the consumer
+  T& Back();
+  // producer: the back slot becomes the latest, an unread one is recycled
+  void Publish();
+
+  // consumer: true if something was published since the last Consume()
+  bool HasNew() const;
+  // consumer: takes the latest published slot, false if there is none
+  bool Consume();
+  // consumer: the slot taken by the last successful Consume()
+  T& Front();
+
+ private:
+  // set on the shared index while it holds an unread slot
+  static constexpr uint32_t FRESH_BIT = 4;
+
+  std::array<T, 3> slots_{};
+  // only the shared index is ever exchanged between the threads
+  std::atomic<uint32_t> middle_{1};
+  uint32_t back_ = 0;
+  uint32_t front_ = 2;
+};
+
+template <typename T>
+T& TripleBuffer<T>::Back() {
+  return slots_[back_];
+}
+
+template <typename T>
+void TripleBuffer<T>::Publish() {
+  back_ = middle_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel) &
+          ~FRESH_BIT;
+}
+
+template <typename T>
+bool TripleBuffer<T>::HasNew() const {
+  return 0 != (middle_.load(std::memory_order_acquire) & FRESH_BIT);
+}
+
+template <typename T>
+bool TripleBuffer<T>::Consume() {
+  if (!HasNew()) {
+    return false;
+  }
+
+  // only the producer sets the bit, so the slot swapped in is still fresh
+  front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~FRESH_BIT;
+  return true;
+}
+
+template <typename T>
+T& TripleBuffer<T>::Front() {
+  return slots_[front_];
+}
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_TRIPLE_BUFFER_H_
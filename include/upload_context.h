@@ -0,0 +1,162 @@
+/**
+ * @file upload_context.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Batches buffer/image uploads into one submission, on a dedicated
+ * transfer queue when available, tracked on the GPU timeline instead of
+ * queue idle
+ * @version 1.0
+ * @date 2023-03-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_UPLOAD_CONTEXT_H_
+#define PLAYGROUND_INCLUDE_UPLOAD_CONTEXT_H_
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "gpu_timeline.h"
+#include "memory_allocator.h"
+#include "staging_ring.h"
+
+namespace playground {
+
+class UploadContext {
+ public:
+  UploadContext() = default;
+  UploadContext(const UploadContext&) = delete;
+  ~UploadContext() = default;
+
+  UploadContext& operator=(const UploadContext&) = delete;
+
+  // `queue_mutex` is held around every submit, the batches signal
+  // `timeline` on the graphics queue
+  void Init(VkDevice device, MemoryAllocator& allocator, GpuTimeline& timeline,
+            std::mutex& queue_mutex, uint32_t graphics_family,
+            VkQueue graphics_queue, uint32_t transfer_family,
+            VkQueue transfer_queue,
+            VkDeviceSize staging_size = DEFAULT_STAGING_RING_SIZE);
+  void Destroy();
+
+  bool HasDedicatedTransferQueue() const;
+  const StagingRing& GetStagingRing() const;
+
+  // copies `data` into the staging ring, flushing and waiting for older
+  // batches when it is full; record the copy reading the returned range
+  // before staging anything else
+  StagingAllocation Stage(const void* data, VkDeviceSize size,
+                          VkDeviceSize alignment = 16);
+  // stages `data` and records the copy into `dst_buffer`
+  void UploadBuffer(const void* data, VkDeviceSize size, VkBuffer dst_buffer,
+                    VkDeviceSize dst_offset = 0,
+                    VkPipelineStageFlags dst_stage =
+                        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                    VkAccessFlags dst_access =
+                        VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                        VK_ACCESS_INDEX_READ_BIT);
+
+  // recording, every call lands in the currently open batch
+  void CopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer,
+                  const VkBufferCopy& region,
+                  VkPipelineStageFlags dst_stage =
+                      VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                  VkAccessFlags dst_access =
+                      VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                      VK_ACCESS_INDEX_READ_BIT);
+  void TransitionImageLayout(VkImage image, VkImageLayout old_layout,
+                             VkImageLayout new_layout,
+                             const VkImageSubresourceRange& range);
+  void CopyBufferToImage(VkBuffer buffer, VkImage image,
+                         const std::vector<VkBufferImageCopy>& regions);
+  // blits every level of `image` down from level 0 on the graphics queue;
+  // all `mip_levels` must be in TRANSFER_DST_OPTIMAL with level 0 already
+  // copied, they end up in SHADER_READ_ONLY_OPTIMAL
+  void GenerateMipmaps(VkImage image, uint32_t width, uint32_t height,
+                       uint32_t mip_levels);
+
+  // run once the GPU finished the current batch, e.g. to free staging memory
+  void OnComplete(std::function<void()> callback);
+
+  // submits the open batch and returns its id, never blocks; takes the
+  // queue mutex, so not to be called while holding it
+  uint64_t Submit();
+  bool IsComplete(uint64_t batch_id);
+  void Wait(uint64_t batch_id);
+  // releases finished batches and runs their callbacks
+  void CollectCompleted();
+
+ private:
+  struct Batch {
+    uint64_t id = 0;
+    VkCommandBuffer transfer_command_buffer = VK_NULL_HANDLE;
+    VkCommandBuffer graphics_command_buffer = VK_NULL_HANDLE;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    // signaled once the batch has finished
+    uint64_t timeline_value = 0;
+    std::vector<std::function<void()>> callbacks;
+  };
+
+  struct MipChain {
+    VkImage image;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mip_levels;
+  };
+
+  void BeginBatch();
+  uint64_t SubmitBatch();
+  void RecordCopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer,
+                        const VkBufferCopy& region,
+                        VkPipelineStageFlags dst_stage,
+                        VkAccessFlags dst_access);
+  VkCommandBuffer AllocateCommandBuffer(VkCommandPool pool);
+  VkSemaphore AcquireSemaphore();
+  void ReleaseBatch(Batch& batch);
+  void FlushHandoffBarriers();
+  void RecordMipChains();
+
+  VkDevice device_ = VK_NULL_HANDLE;
+  MemoryAllocator* allocator_ = nullptr;
+  GpuTimeline* timeline_ = nullptr;
+  std::mutex* queue_mutex_ = nullptr;
+
+  StagingRing staging_ring_;
+
+  uint32_t graphics_family_ = 0;
+  uint32_t transfer_family_ = 0;
+  VkQueue graphics_queue_ = VK_NULL_HANDLE;
+  VkQueue transfer_queue_ = VK_NULL_HANDLE;
+
+  VkCommandPool graphics_pool_ = VK_NULL_HANDLE;
+  VkCommandPool transfer_pool_ = VK_NULL_HANDLE;
+
+  bool recording_ = false;
+  Batch current_{};
+  uint64_t next_batch_id_ = 1;
+  uint64_t completed_batch_id_ = 0;
+  uint64_t ring_released_id_ = 0;
+
+  // ownership release (transfer queue) and acquire (graphics queue) barriers,
+  // flushed as one batch each on submit
+  std::vector<VkBufferMemoryBarrier> buffer_releases_;
+  std::vector<VkBufferMemoryBarrier> buffer_acquires_;
+  std::vector<VkImageMemoryBarrier> image_releases_;
+  std::vector<VkImageMemoryBarrier> image_acquires_;
+  VkPipelineStageFlags acquire_dst_stages_ = 0;
+  // blitted on the graphics queue right after the acquire barriers
+  std::vector<MipChain> mip_chains_;
+
+  std::deque<Batch> pending_;
+  std::vector<VkSemaphore> free_semaphores_;
+
+  std::mutex mutex_;
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_UPLOAD_CONTEXT_H_
@@ -0,0 +1,72 @@
+/**
+ * @file usage_monitor.h
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Frame rate, process CPU time and GPU busy time over the last
+ * second and the whole run, what an idle on demand window still costs
+ * @version 1.0
+ * @date 2023-03-31
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#ifndef PLAYGROUND_INCLUDE_USAGE_MONITOR_H_
+#define PLAYGROUND_INCLUDE_USAGE_MONITOR_H_
+#include <chrono>
+#include <cstdint>
+
+namespace playground {
+
+struct Usage {
+  double seconds = 0.0;
+  double frame_rate = 0.0;
+  // of one core, all threads of the process
+  double cpu_percent = 0.0;
+  // the profiler's frame time of every drawn frame
+  double gpu_percent = 0.0;
+  // the main thread blocked on events
+  double waiting_percent = 0.0;
+};
+
+class UsageMonitor {
+ public:
+  UsageMonitor() = default;
+  UsageMonitor(const UsageMonitor&) = delete;
+  ~UsageMonitor() = default;
+
+  UsageMonitor& operator=(const UsageMonitor&) = delete;
+
+  // starts both the run and the first window
+  void Start();
+
+  void AddFrame(double gpu_ms);
+  void AddWait(double ms);
+  // closes the window once it spans a second
+  void Update();
+
+  // the last complete window
+  const Usage& GetRecent() const;
+  // since Start()
+  Usage GetTotal() const;
+
+  // user and kernel time of all threads so far, in seconds
+  static double GetProcessCpuTime();
+
+ private:
+  struct Window {
+    std::chrono::steady_clock::time_point start{};
+    double cpu_start = 0.0;
+    uint32_t frames = 0;
+    double gpu_ms = 0.0;
+    double wait_ms = 0.0;
+  };
+
+  static Usage Measure(const Window& window);
+
+  Window run_{};
+  Window window_{};
+  Usage recent_{};
+};
+
+}  // namespace playground
+
+#endif  // PLAYGROUND_INCLUDE_USAGE_MONITOR_H_
@@ -1,3 +1,13 @@
-C:\VulkanSDK\1.3.216.0\Bin\glslc.exe .\triangle.vert -o .\triangle.vert.spv
-C:\VulkanSDK\1.3.216.0\Bin\glslc.exe .\triangle.frag -o .\triangle.frag.spv
+rem The build compiles these as well, see the shaders target in CMakeLists.txt
+rem Usage: compile.bat [output directory], ..\build\shaders by default
+if not defined GLSLC set GLSLC=%VULKAN_SDK%\Bin\glslc.exe
+cd /d "%~dp0"
+set OUTPUT_DIR=%~1
+if "%OUTPUT_DIR%"=="" set OUTPUT_DIR=..\build\shaders
+if not exist "%OUTPUT_DIR%" mkdir "%OUTPUT_DIR%"
+for %%s in (*.vert *.frag *.comp) do "%GLSLC%" .\%%s -o "%OUTPUT_DIR%\%%s.spv"
+rem output format variants, as SHADER_FORMAT_VARIANTS in CMakeLists.txt
+"%GLSLC%" .\tonemap.comp -DOUTPUT_FORMAT=rgba8 -o "%OUTPUT_DIR%\tonemap.comp.rgba8.spv"
+"%GLSLC%" .\tonemap.comp -DOUTPUT_FORMAT=rgba16f -o "%OUTPUT_DIR%\tonemap.comp.rgba16f.spv"
+"%GLSLC%" .\fxaa.comp -DOUTPUT_FORMAT=rgba16f -o "%OUTPUT_DIR%\fxaa.comp.rgba16f.spv"
 pause
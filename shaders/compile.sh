@@ -1,2 +1,25 @@
-/Users/mao/Documents/Dev/VulkanSDK/1.3.231.0/macOS/bin/glslc ./triangle.vert -o ./triangle.vert.spv
-/Users/mao/Documents/Dev/VulkanSDK/1.3.231.0/macOS/bin/glslc ./triangle.frag -o ./triangle.frag.spv
\ No newline at end of file
+# The build compiles these as well, see the shaders target in CMakeLists.txt.
+# Usage: compile.sh [output directory], the build's shaders/ directory by
+# default, which is where the binary loads the SPIR-V from.
+# Uses $GLSLC, else the Vulkan SDK's glslc, else the one on PATH.
+if [ -z "$GLSLC" ]; then
+  if [ -n "$VULKAN_SDK" ] && [ -x "$VULKAN_SDK/bin/glslc" ]; then
+    GLSLC="$VULKAN_SDK/bin/glslc"
+  else
+    GLSLC=glslc
+  fi
+fi
+
+cd "$(dirname "$0")" || exit 1
+OUTPUT_DIR="${1:-../build/shaders}"
+mkdir -p "$OUTPUT_DIR" || exit 1
+for shader in *.vert *.frag *.comp; do
+  "$GLSLC" "./$shader" -o "$OUTPUT_DIR/$shader.spv" || exit 1
+done
+# output format variants, as SHADER_FORMAT_VARIANTS in CMakeLists.txt
+for variant in tonemap.comp:rgba8 tonemap.comp:rgba16f fxaa.comp:rgba16f; do
+  shader="${variant%%:*}"
+  format="${variant##*:}"
+  "$GLSLC" "./$shader" "-DOUTPUT_FORMAT=$format" \
+    -o "$OUTPUT_DIR/$shader.$format.spv" || exit 1
+done
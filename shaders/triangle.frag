@@ -1,9 +1,37 @@
 #version 450
 
+// sized to the bindless table when the pipeline is created
+layout(constant_id = 0) const uint TEXTURE_COUNT = 16;
+// pipeline variant, the unlit one skips the normal and light math
+layout(constant_id = 1) const bool LIGHTING = true;
+
+layout(set = 1, binding = 0) uniform texture2D textures[TEXTURE_COUNT];
+layout(set = 1, binding = 2) uniform sampler textureSampler;
+
+// the vertex stage reads the model matrix in front of it
+layout(push_constant) uniform Draw {
+    layout(offset = 64) uint textureIndex;
+} draw;
+
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragWorldPos;
 
 layout(location = 0) out vec4 color;
 
+// directional, world space, lights both faces
+const vec3 LIGHT_DIRECTION = vec3(0.267f, 0.535f, 0.802f);
+const float AMBIENT = 0.2f;
+
 void main() {
-  color = vec4(fragColor, 1.f);
+  vec4 texel = texture(sampler2D(textures[draw.textureIndex], textureSampler), fragTexCoord);
+  vec3 albedo = fragColor * texel.rgb;
+
+  if (LIGHTING) {
+    vec3 normal = normalize(cross(dFdx(fragWorldPos), dFdy(fragWorldPos)));
+    float diffuse = abs(dot(normal, LIGHT_DIRECTION));
+    albedo *= AMBIENT + (1.f - AMBIENT) * diffuse;
+  }
+
+  color = vec4(albedo, 1.f);
 }
\ No newline at end of file
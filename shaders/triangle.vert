@@ -1,17 +1,31 @@
 #version 450
 
-layout(location = 0) in vec2 inPosition;
+layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 
+// per instance, locations 2-5 hold the model matrix columns
+layout(location = 2) in mat4 inInstanceModel;
+layout(location = 6) in vec4 inInstanceColor;
+
 layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 projection;
+    mat4 view_projection;
 } ubo;
 
+layout(push_constant) uniform Draw {
+    mat4 model;
+} draw;
+
 layout(location = 0) out vec3 fragColor;
+// planar mapping of the model's xy, meshes are normalized to [-0.5, 0.5]
+layout(location = 1) out vec2 fragTexCoord;
+// world space, the fragment stage derives the face normal from it
+layout(location = 2) out vec3 fragWorldPos;
 
 void main () {
-  gl_Position = ubo.projection * ubo.view * ubo.model * vec4(inPosition, 0.f, 1.f);
-  fragColor = inColor;
+  // matrix-vector products only, right to left
+  vec4 world = draw.model * (inInstanceModel * vec4(inPosition, 1.f));
+  gl_Position = ubo.view_projection * world;
+  fragWorldPos = world.xyz;
+  fragColor = inColor * inInstanceColor.rgb;
+  fragTexCoord = inPosition.xy + 0.5f;
 }
\ No newline at end of file
@@ -12,15 +12,22 @@
 
 #include <algorithm>
 #include <array>
+#include <cctype>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 
 #define PLAYGROUND_IMGUI_
 #include <imgui.h>
@@ -36,12 +43,130 @@
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include "trace.h"
+
 namespace playground {
 
+static_assert(sizeof(Vertex) == sizeof(MeshVertex) &&
+                  offsetof(Vertex, color) == offsetof(MeshVertex, color),
+              "mesh files are copied to the GPU as they are");
+
+namespace {
+
+// ImGui's backend draws without a render pass since 1.89.2, older ones keep
+// dynamic rendering off
+#if IMGUI_VERSION_NUM >= 18920
+const bool IMGUI_DYNAMIC_RENDERING = true;
+#else
+const bool IMGUI_DYNAMIC_RENDERING = false;
+#endif
+
+// on demand: frames drawn after events, ImGui settles hover and focus in
+// the ones after the input
+const uint32_t IMGUI_SETTLE_FRAMES = 3;
+// on demand: how often a streaming texture is checked without drawing
+const double STREAMING_POLL_INTERVAL = 0.05;  // s
+// glfwWaitEventsTimeout() returning this much before its timeout did so for
+// events
+const double EVENT_WAKE_TOLERANCE = 0.002;  // s
+
+// a hidden or occluded window may never get its present displayed
+const uint64_t PRESENT_WAIT_TIMEOUT = 100000000;  // 100 ms
+
+// modes selectable at runtime, the surface may support fewer
+const VkPresentModeKHR LATENCY_PRESENT_MODES[] = {
+    VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+    VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+
+VkPresentModeKHR ParsePresentMode(const std::string& name) {
+  if ("immediate" == name) {
+    return VK_PRESENT_MODE_IMMEDIATE_KHR;
+  } else if ("fifo" == name) {
+    return VK_PRESENT_MODE_FIFO_KHR;
+  } else if ("fifo-relaxed" == name) {
+    return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+  }
+
+  // also what's picked when nothing is requested
+  return VK_PRESENT_MODE_MAILBOX_KHR;
+}
+
+bool IsFifo(VkPresentModeKHR present_mode) {
+  return VK_PRESENT_MODE_FIFO_KHR == present_mode ||
+         VK_PRESENT_MODE_FIFO_RELAXED_KHR == present_mode;
+}
+
+const char* PresentModeName(VkPresentModeKHR present_mode) {
+  switch (present_mode) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+      return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+      return "mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR:
+      return "fifo";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+      return "fifo-relaxed";
+    default:
+      return "other";
+  }
+}
+
+const char* DeviceTypeName(VkPhysicalDeviceType device_type) {
+  switch (device_type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+      return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+      return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+      return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+      return "cpu";
+    default:
+      return "other";
+  }
+}
+
+// VRAM of a discrete GPU, the shared system heap of an integrated one
+VkDeviceSize LargestDeviceLocalHeap(VkPhysicalDevice device) {
+  VkPhysicalDeviceMemoryProperties memory_properties{};
+  vkGetPhysicalDeviceMemoryProperties(device, &memory_properties);
+
+  VkDeviceSize largest = 0;
+  for (uint32_t i = 0; i < memory_properties.memoryHeapCount; ++i) {
+    const VkMemoryHeap& heap = memory_properties.memoryHeaps[i];
+    if (VK_MEMORY_HEAP_DEVICE_LOCAL_BIT & heap.flags) {
+      largest = std::max(largest, heap.size);
+    }
+  }
+
+  return largest;
+}
+
+// --gpu=index|name: an enumeration index or a case insensitive part of the
+// device name
+bool MatchDevice(const std::string& selector, uint32_t index,
+                 const char* device_name) {
+  if (std::all_of(selector.begin(), selector.end(),
+                  [](unsigned char c) { return std::isdigit(c); })) {
+    return std::to_string(index) == selector;
+  }
+
+  auto lower = [](std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return text;
+  };
+
+  return std::string::npos != lower(device_name).find(lower(selector));
+}
+
+}  // namespace
+
 bool QueueFamilies::IsCompleted() {
   return graphics_family.has_value() && present_family.has_value();
 }
@@ -51,94 +176,256 @@ bool SwapChainSupportDetails::IsAdequate() {
          !present_modes.empty();
 }
 
-VkVertexInputBindingDescription Vertex::GetBindingDescription() {
-  VkVertexInputBindingDescription binding_desc{};
-  binding_desc.binding = 0;
-  binding_desc.stride = sizeof(Vertex);
-  binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-  return binding_desc;
+std::array<VkVertexInputBindingDescription, 2>
+Vertex::GetBindingDescriptions() {
+  std::array<VkVertexInputBindingDescription, 2> binding_descs{};
+  binding_descs[0].binding = 0;
+  binding_descs[0].stride = sizeof(Vertex);
+  binding_descs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+  binding_descs[1].binding = 1;
+  binding_descs[1].stride = sizeof(InstanceData);
+  binding_descs[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+  return binding_descs;
 }
 
-std::array<VkVertexInputAttributeDescription, 2>
+std::array<VkVertexInputAttributeDescription, 7>
 Vertex::GetAttributeDescriptions() {
-  std::array<VkVertexInputAttributeDescription, 2> attribute_descs{};
+  std::array<VkVertexInputAttributeDescription, 7> attribute_descs{};
   attribute_descs[0].binding = 0;
   attribute_descs[0].location = 0;
-  attribute_descs[0].format = VK_FORMAT_R32G32_SFLOAT;
+  attribute_descs[0].format = VK_FORMAT_R32G32B32_SFLOAT;
   attribute_descs[0].offset = offsetof(Vertex, pos);
   attribute_descs[1].binding = 0;
   attribute_descs[1].location = 1;
   attribute_descs[1].format = VK_FORMAT_R32G32B32_SFLOAT;
   attribute_descs[1].offset = offsetof(Vertex, color);
 
+  // a mat4 attribute takes one location per column
+  for (uint32_t column = 0; column < 4; ++column) {
+    attribute_descs[2 + column].binding = 1;
+    attribute_descs[2 + column].location = 2 + column;
+    attribute_descs[2 + column].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    attribute_descs[2 + column].offset = static_cast<uint32_t>(
+        offsetof(InstanceData, model) + sizeof(glm::vec4) * column);
+  }
+  attribute_descs[6].binding = 1;
+  attribute_descs[6].location = 6;
+  attribute_descs[6].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+  attribute_descs[6].offset = offsetof(InstanceData, color);
+
   return attribute_descs;
 }
 
-Application::Application() {
-  CreateWindow();
-  CreateInstance();
+Application::Application(const Options& options)
+    : options_(options), frames_in_flight_(options.frames_in_flight) {
+  requested_present_mode_ = ParsePresentMode(options_.present_mode);
+  frame_limiter_ = options_.frame_limiter;
+
+  // main thread steps keep their order, the pipelines compile on workers
+  // while the swap chain, buffers and uploads come up
+  StartupGraph startup{job_system_};
+  auto step = [this](void (Application::*phase)()) {
+    return [this, phase]() { (this->*phase)(); };
+  };
+
+  // file reads and image decode run on workers while Vulkan comes up
+  startup.AddMain("RequestAssets", step(&Application::RequestAssets));
+
+  startup.AddMain("CreateWindow", step(&Application::CreateWindow));
+  startup.AddMain("CreateInstance", step(&Application::CreateInstance));
 
   if (ENABLE_VALIDATION_LAYER) {
-    SetupDebugMessenger();
+    startup.AddMain("SetupDebugMessenger",
+                    step(&Application::SetupDebugMessenger));
+  }
+
+  startup.AddMain("CreateSurface", step(&Application::CreateSurface));
+  startup.AddMain("PickPhysicalDevice", step(&Application::PickPhysicalDevice));
+  startup.AddMain("CreateLogicalDevice",
+                  step(&Application::CreateLogicalDevice));
+  // wait for the device to know which compressed formats it samples and
+  // whether the post process chain stores without a format
+  startup.AddMain("RequestTexture", step(&Application::RequestTexture));
+  startup.AddMain("RequestPostProcessShaders",
+                  step(&Application::RequestPostProcessShaders));
+  startup.AddMain("CreateMemoryAllocator",
+                  step(&Application::CreateMemoryAllocator));
+  StartupGraph::StepId pipeline_cache = startup.AddMain(
+      "CreatePipelineCache", step(&Application::CreatePipelineCache));
+  // needs neither the swap chain nor the allocator
+  StartupGraph::StepId post_process = startup.AddWorker(
+      "CreatePostProcess", step(&Application::CreatePostProcess),
+      {pipeline_cache});
+  startup.AddMain("CreateSwapChain", step(&Application::CreateSwapChain));
+  startup.AddMain("CreateImageViews", step(&Application::CreateImageViews));
+  startup.AddMain("CreateRenderPass", step(&Application::CreateRenderPass));
+  startup.AddMain("CreateDescriptorSetLayout",
+                  step(&Application::CreateDescriptorSetLayout));
+  StartupGraph::StepId compute_set_layout =
+      startup.AddMain("CreateComputeDescriptorSetLayout",
+                      step(&Application::CreateComputeDescriptorSetLayout));
+  startup.AddWorker("CreateComputePipeline",
+                    step(&Application::CreateComputePipeline),
+                    {compute_set_layout});
+  startup.AddMain("CreateDescriptorPool",
+                  step(&Application::CreateDescriptorPool));
+  startup.AddMain("CreateUniformBuffers",
+                  step(&Application::CreateUniformBuffers));
+  startup.AddMain("CreateDescriptorSets",
+                  step(&Application::CreateDescriptorSets));
+  startup.AddMain("CreateTextureSampler",
+                  step(&Application::CreateTextureSampler));
+  startup.AddMain("CreateBindlessTable",
+                  step(&Application::CreateBindlessTable));
+  StartupGraph::StepId pipeline_layout = startup.AddMain(
+      "CreatePipelineLayout", step(&Application::CreatePipelineLayout));
+  startup.AddWorker("CreateGraphicsPipeline",
+                    step(&Application::CreateGraphicsPipeline),
+                    {pipeline_layout, post_process});
+  startup.AddMain("CreateFrameBuffers", step(&Application::CreateFrameBuffers));
+  startup.AddMain("CreateCommandPool", step(&Application::CreateCommandPool));
+  startup.AddMain("CreateFrameCommandPools",
+                  step(&Application::CreateFrameCommandPools));
+  startup.AddMain("CreateGpuProfiler", step(&Application::CreateGpuProfiler));
+  startup.AddMain("CreateGpuTimeline", step(&Application::CreateGpuTimeline));
+  startup.AddMain("CreateUploadContext",
+                  step(&Application::CreateUploadContext));
+  startup.AddMain("CreateDefaultTexture",
+                  step(&Application::CreateDefaultTexture));
+  startup.AddMain("LoadMesh", step(&Application::LoadMesh));
+  startup.AddMain("CreateVertexBuffer", step(&Application::CreateVertexBuffer));
+  startup.AddMain("CreateIndexBuffer", [this]() {
+    CreateIndexBuffer();
+    // both buffers are staged, the mapping is no longer needed
+    mesh_file_.Close();
+  });
+  startup.AddMain("CreateInstanceBuffer",
+                  step(&Application::CreateInstanceBuffer));
+  startup.AddMain("CreateCullBuffers", step(&Application::CreateCullBuffers));
+  startup.AddMain("CreateRenderGraph", step(&Application::CreateRenderGraph),
+                  {post_process});
+  startup.AddMain("CreateComputeDescriptorSets",
+                  step(&Application::CreateComputeDescriptorSets));
+  startup.AddMain("CreateSyncObjects", step(&Application::CreateSyncObjects));
+  startup.AddMain("WatchShaders", step(&Application::WatchShaders));
+
+  // kick off every upload recorded above in a single submission
+  uint64_t uploads = 0;
+  startup.AddMain("SubmitUploads",
+                  [this, &uploads]() { uploads = upload_context_.Submit(); });
+  // the compute queue waits on nothing the upload batches signal; dynamic
+  // instances are shared by both queues
+  startup.AddMain("HandOffInstanceBuffer", [this, &uploads]() {
+    if (VK_NULL_HANDLE != compute_queue_ && !dynamic_instances_) {
+      upload_context_.Wait(uploads);
+      HandOffInstanceBuffer();
+    }
+  });
+
+  startup_time_ = std::chrono::steady_clock::now();
+  startup.Run();
+  for (const auto& timing : startup.GetTimings()) {
+    benchmark_.AddStartupPhase(timing.name, timing.start_ms, timing.ms,
+                               timing.worker);
   }
 
-  CreateSurface();
-  PickPhysicalDevice();
-  CreateLogicalDevice();
-  CreateSwapChain();
-  CreateImageViews();
-  CreateRenderPass();
-  CreateDescriptorSetLayout();
-  CreateDescriptorPool();
-  CreateUniformBuffers();
-  CreateDescriptorSets();
-  CreatePipelineLayout();
-  CreateGraphicsPipeline();
-  CreateFrameBuffers();
-  CreateCommandPool();
-  CreateCommandBuffers();
-  CreateTextureImage();
-  CreateVertexBuffer();
-  CreateIndexBuffer();
-  CreateSyncObjects();
+  std::clog << "----- Startup: " << benchmark_.GetStartupTime()
+            << " ms -----" << std::endl;
 }
 
 Application::~Application() {
+  // also when Run() throws on the main thread
+  StopRenderThread();
+
+  // rebuilds still running are installed, so the deletion queue frees what
+  // they replaced and their own pipelines go with the rest
+  for (auto& reload : pipeline_reloads_) {
+    if (reload->running) {
+      job_system_.Wait(reload->counter);
+      if (reload->install) {
+        reload->install();
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    vkDeviceWaitIdle(device_);
+  }
+
+  imgui_renderer_.Destroy();
   ImGui_ImplVulkan_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
 
+  deletion_queue_.Destroy();
+  upload_context_.Destroy();
+  gpu_timeline_.Destroy();
+
+  if (render_graph_) {
+    render_graph_->Destroy();
+  }
+  post_process_.Destroy();
   CleanupSwapChain();
 
-  vkDestroyImage(device_, texture_image_, nullptr);
-  vkFreeMemory(device_, texture_image_memory_, nullptr);
+  vkDestroyImageView(device_, texture_image_view_, nullptr);
+  DestroyImage(texture_image_, texture_image_memory_);
+  vkDestroyImageView(device_, default_texture_image_view_, nullptr);
+  DestroyImage(default_texture_image_, default_texture_image_memory_);
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-    vkDestroyBuffer(device_, uniform_buffers_[i], nullptr);
-    vkFreeMemory(device_, uniform_buffers_memory_[i], nullptr);
+  bindless_table_.Destroy();
+  vkDestroySampler(device_, texture_sampler_, nullptr);
+
+  for (size_t i = 0; i < frames_in_flight_; i++) {
+    DestroyBuffer(uniform_buffers_[i], uniform_buffers_memory_[i]);
   }
 
   vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device_, compute_descriptor_set_layout_,
+                               nullptr);
+
+  DestroyBuffer(vertex_buffer_, vertex_buffer_memory_);
+  DestroyBuffer(index_buffer_, index_buffer_memory_);
+  DestroyBuffer(instance_buffer_, instance_buffer_memory_);
+  for (size_t i = 0; i < instance_buffers_.size(); ++i) {
+    DestroyBuffer(instance_buffers_[i], instance_buffers_memory_[i]);
+  }
 
-  vkDestroyBuffer(device_, vertex_buffer_, nullptr);
-  vkFreeMemory(device_, vertex_buffer_memory_, nullptr);
-  vkDestroyBuffer(device_, index_buffer_, nullptr);
-  vkFreeMemory(device_, index_buffer_memory_, nullptr);
+  for (size_t i = 0; i < frames_in_flight_; ++i) {
+    DestroyBuffer(visible_instance_buffers_[i],
+                  visible_instance_buffers_memory_[i]);
+    DestroyBuffer(indirect_buffers_[i], indirect_buffers_memory_[i]);
+  }
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+  for (size_t i = 0; i < frames_in_flight_; ++i) {
     vkDestroySemaphore(device_, image_available_semaphores_[i], nullptr);
     vkDestroySemaphore(device_, render_finished_semaphores_[i], nullptr);
-    vkDestroyFence(device_, in_flight_fences_[i], nullptr);
+  }
+  for (auto semaphore : async_compute_semaphores_) {
+    vkDestroySemaphore(device_, semaphore, nullptr);
   }
 
   vkDestroyDescriptorPool(device_, descriptor_pool_, nullptr);
   vkDestroyCommandPool(device_, command_pool_, nullptr);
+  frame_command_pools_.Destroy();
+  compute_command_pools_.Destroy();
+
+  gpu_profiler_.Destroy();
+  async_profiler_.Destroy();
 
   vkDestroyPipeline(device_, graphics_pipeline_, nullptr);
   vkDestroyPipelineLayout(device_, pipeline_layout_, nullptr);
+  vkDestroyPipeline(device_, compute_pipeline_, nullptr);
+  vkDestroyPipelineLayout(device_, compute_pipeline_layout_, nullptr);
   vkDestroyRenderPass(device_, render_pass_, nullptr);
 
+  allocator_.LogStats();
+  allocator_.Destroy();
+
+  // also holds the imgui pipelines created in Run()
+  pipeline_cache_.Save();
+  pipeline_cache_.Destroy();
+
   vkDestroyDevice(device_, nullptr);
   vkDestroySurfaceKHR(instance_, surface_, nullptr);
 
@@ -179,15 +466,32 @@ void Application::Run() {
   init_info.Device = device_;
   init_info.QueueFamily = queue_faimlies_.graphics_family.value();
   init_info.Queue = graphics_queue_;
-  init_info.PipelineCache = VK_NULL_HANDLE;
+  init_info.PipelineCache = pipeline_cache_.GetHandle();
   init_info.DescriptorPool = descriptor_pool_;
   init_info.Allocator = nullptr;
   init_info.MinImageCount = static_cast<uint32_t>(swap_chain_images_.size());
   init_info.ImageCount = static_cast<uint32_t>(swap_chain_images_.size());
   init_info.CheckVkResultFn = nullptr;
+#if IMGUI_VERSION_NUM >= 18920
+  // its pipeline is created against the swap chain format instead
+  init_info.UseDynamicRendering = device_features_.dynamic_rendering;
+  init_info.ColorAttachmentFormat = swap_chain_image_format_;
+#endif
 
   ImGui_ImplVulkan_Init(&init_info, render_pass_);
 
+  // imgui: the main viewport's renderer, against the same target
+  {
+    auto imgui_vert = shader_library_.Get(imgui_vert_shader_);
+    auto imgui_frag = shader_library_.Get(imgui_frag_shader_);
+    imgui_renderer_.Init(device_, allocator_, frames_in_flight_,
+                         pipeline_cache_.GetHandle(),
+                         {imgui_vert.get(), imgui_frag.get()},
+                         device_features_.dynamic_rendering ? VK_NULL_HANDLE
+                                                            : render_pass_,
+                         swap_chain_image_format_);
+  }
+
   // imgui: load default font
   ImFontConfig font_config;
   font_config.FontDataOwnedByAtlas = false;
@@ -195,19 +499,402 @@ void Application::Run() {
       (void*)roboto_regular, sizeof(roboto_regular), 20.0f, &font_config);
   imgui_io.FontDefault = roboto_font;
 
-  // imgui: upload fonts to the GPU
-  VkCommandBuffer command_buffer = BeginSingleTimeCommands();
-  ImGui_ImplVulkan_CreateFontsTexture(command_buffer);
-  EndSingleTimeCommands(command_buffer);
-  ImGui_ImplVulkan_DestroyFontUploadObjects();
+  // imgui: upload fonts to the GPU with the batched uploads, submitted
+  // ahead of any frame or platform window drawing with them; nothing waits
+  imgui_renderer_.UploadFonts(imgui_io, upload_context_);
+  upload_context_.Submit();
+
+  benchmark_.Configure(options_.warmup_frames, options_.bench_frames);
+
+  // benchmarks measure back to back frames
+  on_demand_ = options_.on_demand && 0 == options_.bench_frames;
+  // a rotating scene is never idle, "Animate" resumes it
+  animate_ = !on_demand_;
+  min_refresh_rate_ = static_cast<int>(options_.min_refresh_rate);
+  streaming_texture_ = texture_asset_;
+  last_simulate_time_ = std::chrono::steady_clock::now();
+  usage_monitor_.Start();
+
+  rendering_ = true;
+  render_thread_ = std::thread(&Application::RenderLoop, this);
+
+  auto last_frame_time = std::chrono::steady_clock::now();
+  while (!glfwWindowShouldClose(window_) && rendering_) {
+    // stay a single frame ahead: the render thread has to have taken the
+    // last snapshot before the next one is built; paced, the last frame also
+    // has to be presented, input is then sampled as late as possible
+    {
+      TRACE_SCOPE("WaitForRenderThread");
+      std::unique_lock<std::mutex> lock(frame_mutex_);
+      frame_cv_.wait(lock, [this]() {
+        return !rendering_ ||
+               (consumed_frames_ == published_frames_ &&
+                (!frames_paced_ || presented_frames_ == published_frames_));
+      });
+    }
+
+    {
+      TRACE_SCOPE("PollEvents");
+      WaitForRedraw();
+    }
+    auto input_time = std::chrono::steady_clock::now();
+
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window_, &width, &height);
+    framebuffer_width_ = width;
+    framebuffer_height_ = height;
+
+    // minimized: nothing to present, sleep instead of simulating
+    if (0 == width || 0 == height) {
+      glfwWaitEvents();
+      continue;
+    }
+
+    FrameSnapshot& snapshot = snapshots_.Back();
+    snapshot.index = ++published_frames_;
+    snapshot.input_time = input_time;
+    Simulate(snapshot);
+    last_redraw_time_ = input_time;
+    if (redraw_frames_ > 0) {
+      --redraw_frames_;
+    }
+    {
+      // the hand over itself is lock-free, the lock only keeps the render
+      // thread from missing the wake up
+      std::lock_guard<std::mutex> lock(frame_mutex_);
+      snapshots_.Publish();
+    }
+    frame_cv_.notify_all();
+
+    // imgui: update and render additional Platform Windows, they submit to
+    // and wait on the graphics queue the render thread uses too; unchanged
+    // ones keep what they last presented
+    ImGuiIO& imgui_io = ImGui::GetIO();
+    if (imgui_io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
+      TRACE_SCOPE("RenderPlatformWindows");
+      {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        ImGui::UpdatePlatformWindows();
+      }
+      if (imgui_renderer_.ShouldRenderPlatformWindows()) {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        ImGui::RenderPlatformWindowsDefault();
+      }
+    }
+
+    if (trace_requested_) {
+      trace_requested_ = false;
+      Tracer::Get().Export(options_.trace_path);
+    }
+
+    // the last frame the profiler measured stands in for this one
+    usage_monitor_.AddFrame(gpu_profiler_.GetGpuTime());
+    usage_monitor_.Update();
+
+    if (options_.bench_frames > 0) {
+      auto frame_time = std::chrono::steady_clock::now();
+      benchmark_.AddFrame(std::chrono::duration<double, std::milli>(
+                              frame_time - last_frame_time)
+                              .count(),
+                          gpu_profiler_.GetGpuTime());
+      last_frame_time = frame_time;
+
+      if (benchmark_.IsDone()) {
+        glfwSetWindowShouldClose(window_, GLFW_TRUE);
+      }
+    }
+  }
+
+  StopRenderThread();
+  if (render_error_) {
+    std::rethrow_exception(render_error_);
+  }
+
+  vkDeviceWaitIdle(device_);
+
+  Usage usage = usage_monitor_.GetTotal();
+  std::clog << "----- Usage: " << usage.frame_rate << " frames/s, CPU "
+            << usage.cpu_percent << " % of a core, GPU " << usage.gpu_percent
+            << " %, waiting for events " << usage.waiting_percent
+            << " % over " << usage.seconds << " s"
+            << (on_demand_ ? " on demand" : "") << " -----" << std::endl;
+
+  if (options_.bench_frames > 0) {
+    ReportBenchmark();
+  }
+
+  if (options_.trace) {
+    Tracer::Get().Export(options_.trace_path);
+  }
+}
+
+void Application::Simulate(FrameSnapshot& snapshot) {
+  TRACE_SCOPE("Simulate");
+
+  // imgui: new frame
+  {
+    TRACE_SCOPE("ImGui NewFrame");
+    ImGui_ImplVulkan_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+  }
+  gpu_profiler_.DrawOverlay(VK_NULL_HANDLE != compute_queue_ ? &async_profiler_
+                                                            : nullptr);
+  DrawLatencyControls();
+  DrawOnDemandControls();
+  {
+    TRACE_SCOPE("ImGui Render");
+    ImGui::Render();
+    snapshot.draw_data.Capture(ImGui::GetDrawData());
+  }
+
+  // paused, the scene keeps its angle and on demand rendering can idle
+  if (animate_) {
+    animation_time_ +=
+        std::chrono::duration<float>(snapshot.input_time - last_simulate_time_)
+            .count();
+  }
+  last_simulate_time_ = snapshot.input_time;
+  snapshot.animation_time = animation_time_;
+
+  snapshot.scene_model =
+      glm::rotate(glm::mat4(1.0f), animation_time_ * glm::radians(90.0f),
+                  glm::vec3(0.0f, 0.0f, 1.0f));
+
+  // the window's size, the swap chain catches up with it on the render
+  // thread
+  glm::mat4 view =
+      glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f),
+                  glm::vec3(0.0f, 0.0f, 1.0f));
+  glm::mat4 projection = glm::perspective(
+      glm::radians(45.0f),
+      framebuffer_width_ / static_cast<float>(framebuffer_height_), 0.1f,
+      10.0f);
+  // invert Y-axis
+  projection[1][1] *= -1.f;
+
+  // multiplied once here instead of per vertex
+  snapshot.view_projection = projection * view;
+}
+
+void Application::DrawLatencyControls() {
+  ImGui::Begin("Latency");
+
+  VkPresentModeKHR requested = requested_present_mode_;
+  uint32_t supported = supported_present_modes_;
+  for (auto present_mode : LATENCY_PRESENT_MODES) {
+    if (0 == (supported & (1u << present_mode))) {
+      continue;
+    }
+
+    if (ImGui::RadioButton(PresentModeName(present_mode),
+                           present_mode == requested) &&
+        present_mode != requested) {
+      requested_present_mode_ = present_mode;
+      present_mode_changed_ = true;
+    }
+  }
+
+  bool frame_limiter = frame_limiter_;
+  if (ImGui::Checkbox("Frame limiter (fifo)", &frame_limiter)) {
+    frame_limiter_ = frame_limiter;
+  }
+  ImGui::TextDisabled(device_features_.present_wait
+                          ? "Paced on VK_KHR_present_wait"
+                          : "Paced on GPU completion");
+
+  ImGui::End();
+}
+
+void Application::WaitForRedraw() {
+  if (streaming_texture_ && streaming_texture_->IsReady()) {
+    streaming_texture_.reset();
+    // the render thread creates it before drawing the next frame
+    redraw_frames_ = std::max(redraw_frames_, 1u);
+  }
 
+  bool redraw = !on_demand_ || animate_ || redraw_frames_ > 0 ||
+                reloads_pending_;
+  if (redraw) {
+    glfwPollEvents();
+    return;
+  }
+
+  auto deadline =
+      last_redraw_time_ +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(1.0 / min_refresh_rate_));
+  bool polled = false;
   while (!glfwWindowShouldClose(window_)) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      break;
+    }
+
+    double timeout = std::chrono::duration<double>(deadline - now).count();
+    if (streaming_texture_) {
+      timeout = std::min(timeout, STREAMING_POLL_INTERVAL);
+    }
+    glfwWaitEventsTimeout(timeout);
+    polled = true;
+
+    auto woken = std::chrono::steady_clock::now();
+    double waited = std::chrono::duration<double>(woken - now).count();
+    usage_monitor_.AddWait(waited * 1000.0);
+
+    // input, resizes and exposes of any of ImGui's windows alike
+    if (waited < timeout - EVENT_WAKE_TOLERANCE) {
+      redraw_frames_ = IMGUI_SETTLE_FRAMES;
+      break;
+    }
+    if (streaming_texture_ && streaming_texture_->IsReady()) {
+      streaming_texture_.reset();
+      redraw_frames_ = 1;
+      break;
+    }
+  }
+
+  // the minimum refresh rate was already due
+  if (!polled) {
     glfwPollEvents();
+  }
+}
+
+void Application::DrawOnDemandControls() {
+  ImGui::Begin("On Demand");
+
+  ImGui::Checkbox("Draw on demand", &on_demand_);
+  ImGui::Checkbox("Animate", &animate_);
+  ImGui::SliderInt("Min refresh (Hz)", &min_refresh_rate_, 1, 60);
+
+  // of the last second, refreshed with the frames drawn
+  const Usage& usage = usage_monitor_.GetRecent();
+  ImGui::Text("%.1f frames/s", usage.frame_rate);
+  ImGui::Text("CPU %.1f %% of a core, GPU %.1f %%", usage.cpu_percent,
+              usage.gpu_percent);
+  ImGui::Text("Waiting for events %.0f %%", usage.waiting_percent);
+
+  ImGui::End();
+}
+
+void Application::RenderLoop() {
+  Tracer::Get().SetThreadName("Render");
+
+  try {
+    while (rendering_) {
+      {
+        std::unique_lock<std::mutex> lock(frame_mutex_);
+        frame_cv_.wait(
+            lock, [this]() { return !rendering_ || snapshots_.HasNew(); });
+      }
+
+      if (!snapshots_.Consume()) {
+        continue;
+      }
+      {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        consumed_frames_ = snapshots_.Front().index;
+      }
+      frame_cv_.notify_all();
+
+      ProcessLoadedAssets();
+      DrawFrame(snapshots_.Front());
+
+      // also when the frame was dropped, a paced main thread waits for it
+      {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        presented_frames_ = snapshots_.Front().index;
+      }
+      frame_cv_.notify_all();
+    }
+  } catch (...) {
+    // rethrown by Run() on the main thread
+    render_error_ = std::current_exception();
+  }
 
-    DrawFrame();
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    rendering_ = false;
   }
+  frame_cv_.notify_all();
+}
 
-  vkDeviceWaitIdle(device_);
+void Application::StopRenderThread() {
+  {
+    std::lock_guard<std::mutex> lock(frame_mutex_);
+    rendering_ = false;
+  }
+  frame_cv_.notify_all();
+
+  if (render_thread_.joinable()) {
+    render_thread_.join();
+  }
+}
+
+void Application::ReportBenchmark() {
+  VkPhysicalDeviceProperties device_properties{};
+  vkGetPhysicalDeviceProperties(physical_device_, &device_properties);
+
+  benchmark_.AddConfig("device", device_properties.deviceName);
+  benchmark_.AddConfig(
+      "device_type",
+      std::string{DeviceTypeName(device_properties.deviceType)} +
+          (options_.gpu.empty() ? "" : " (--gpu=" + options_.gpu + ")"));
+  benchmark_.AddConfig(
+      "vram",
+      std::to_string(LargestDeviceLocalHeap(physical_device_) >> 20) + " MiB");
+  benchmark_.AddConfig(
+      "async_compute",
+      VK_NULL_HANDLE != compute_queue_
+          ? "family " + std::to_string(queue_faimlies_.compute_family.value())
+          : std::string{"off"});
+  benchmark_.AddConfig("resolution",
+                       std::to_string(swap_chain_extent_.width) + "x" +
+                           std::to_string(swap_chain_extent_.height));
+  benchmark_.AddConfig("present_mode",
+                       PresentModeName(swap_chain_present_mode_));
+  benchmark_.AddConfig("frame_limiter", frames_paced_ ? "on" : "off");
+  benchmark_.AddConfig("mesh", options_.mesh_path.empty()
+                                   ? std::string{"quad"}
+                                   : options_.mesh_path);
+  benchmark_.AddConfig("texture", texture_path_);
+  benchmark_.AddConfig("descriptors",
+                       bindless_table_.IsBindless() ? "bindless" : "legacy");
+  benchmark_.AddConfig("instances", std::to_string(instance_count_));
+  benchmark_.AddConfig("instance_transforms",
+                       dynamic_instances_
+                           ? std::string{"dynamic "} +
+                                 TransformStore::GetKernelName()
+                           : std::string{"static"});
+  benchmark_.AddConfig("rendering", device_features_.dynamic_rendering
+                                        ? "dynamic"
+                                        : "render pass");
+  benchmark_.AddConfig("lighting", options_.lighting ? "on" : "off");
+  benchmark_.AddConfig(
+      "msaa", std::to_string(post_process_.GetSampleCount()) + "x");
+  benchmark_.AddConfig(
+      "post", std::string{options_.bloom ? "bloom," : ""} + "tonemap" +
+                  (options_.fxaa ? ",fxaa" : "") +
+                  (swap_chain_storage_ ? "" : " (blit)"));
+  benchmark_.AddConfig("frames_in_flight",
+                       std::to_string(frames_in_flight_));
+  benchmark_.AddConfig("validation", ENABLE_VALIDATION_LAYER ? "on" : "off");
+
+  // the render thread has stopped
+  benchmark_.SetFirstFrameTime(first_frame_ms_);
+  benchmark_.Report(std::clog);
+
+  // stdout carries nothing but the report, so CI can pipe it
+  benchmark_.WriteJson(std::cout);
+
+  if (!options_.bench_json_path.empty()) {
+    std::ofstream file(options_.bench_json_path, std::ios::trunc);
+    if (!file.is_open()) {
+      throw std::runtime_error("----- Error::File: Failed to open " +
+                               options_.bench_json_path + " -----");
+    }
+    benchmark_.WriteJson(file);
+  }
 }
 
 void Application::CreateWindow() {
@@ -215,15 +902,25 @@ void Application::CreateWindow() {
   // no api
   glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
-  window_ = glfwCreateWindow(WIDTH, HEIGHT, TITLE.c_str(), nullptr, nullptr);
+  int width = options_.width > 0 ? static_cast<int>(options_.width) : WIDTH;
+  int height =
+      options_.height > 0 ? static_cast<int>(options_.height) : HEIGHT;
+  window_ = glfwCreateWindow(width, height, TITLE.c_str(), nullptr, nullptr);
 
   if (!window_) {
     throw std::runtime_error(
         "----- Error::Window: Failed to create the GLFW window -----");
   }
 
+  // the swap chain is sized from these, only the main thread asks glfw
+  glfwGetFramebufferSize(window_, &width, &height);
+  framebuffer_width_ = width;
+  framebuffer_height_ = height;
+
   glfwSetWindowUserPointer(window_, this);
   glfwSetFramebufferSizeCallback(window_, FramebufferResizeCallback);
+  // installed before imgui, which chains to it
+  glfwSetKeyCallback(window_, KeyCallback);
 }
 
 void Application::CreateInstance() {
@@ -236,7 +933,8 @@ void Application::CreateInstance() {
   app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   app_info.pEngineName = "No Engine";
   app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  app_info.apiVersion = VK_API_VERSION_1_0;
+  // 1.2 for core descriptor indexing, older devices still get 1.0 paths
+  app_info.apiVersion = VK_API_VERSION_1_2;
 
   instance_info.pApplicationInfo = &app_info;
 
@@ -306,12 +1004,25 @@ void Application::PickPhysicalDevice() {
   vkEnumeratePhysicalDevices(instance_, &device_cnt, devices.data());
 
   std::multimap<int, VkPhysicalDevice> candidates{};
-  for (const auto& device : devices) {
-    int score = EvaluateDevice(device);
-    candidates.insert(std::make_pair(score, device));
+  for (uint32_t i = 0; i < device_cnt; ++i) {
+    int score = EvaluateDevice(devices[i]);
+    candidates.insert(std::make_pair(score, devices[i]));
+
+    VkPhysicalDeviceProperties device_properties{};
+    vkGetPhysicalDeviceProperties(devices[i], &device_properties);
+    if (!options_.gpu.empty() && VK_NULL_HANDLE == physical_device_ &&
+        score > 0 &&
+        MatchDevice(options_.gpu, i, device_properties.deviceName)) {
+      physical_device_ = devices[i];
+    }
+  }
+
+  if (!options_.gpu.empty() && VK_NULL_HANDLE == physical_device_) {
+    throw std::runtime_error("----- Error::Device: No suitable GPU matches " +
+                             options_.gpu + " -----");
   }
 
-  if (candidates.rbegin()->first > 0) {
+  if (VK_NULL_HANDLE == physical_device_ && candidates.rbegin()->first > 0) {
     physical_device_ = candidates.rbegin()->second;
   }
 
@@ -319,6 +1030,12 @@ void Application::PickPhysicalDevice() {
     throw std::runtime_error(
         "----- Error::Device: Failed to find a suitable GPU -----");
   }
+
+  VkPhysicalDeviceProperties device_properties{};
+  vkGetPhysicalDeviceProperties(physical_device_, &device_properties);
+  std::clog << "----- Physical Device: picked " << device_properties.deviceName
+            << (options_.gpu.empty() ? " (best score)" : " (--gpu)")
+            << " -----" << std::endl;
 }
 
 void Application::CreateLogicalDevice() {
@@ -331,14 +1048,41 @@ void Application::CreateLogicalDevice() {
   std::set<uint32_t> unique_queue_families{
       queue_faimlies_.graphics_family.value(),
       queue_faimlies_.present_family.value()};
+  if (queue_faimlies_.transfer_family.has_value()) {
+    unique_queue_families.insert(queue_faimlies_.transfer_family.value());
+  }
+
+  // --async-compute: its own queue, a second one when the family is shared
+  // with uploads and has it, the upload queue otherwise
+  bool async_compute =
+      options_.async_compute && queue_faimlies_.compute_family.has_value();
+  uint32_t compute_queue_index = 0;
+  if (async_compute) {
+    uint32_t compute_family = queue_faimlies_.compute_family.value();
+    unique_queue_families.insert(compute_family);
+
+    uint32_t queue_family_cnt = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical_device_,
+                                             &queue_family_cnt, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_cnt);
+    vkGetPhysicalDeviceQueueFamilyProperties(
+        physical_device_, &queue_family_cnt, queue_families.data());
+    if (queue_faimlies_.transfer_family == compute_family &&
+        queue_families[compute_family].queueCount > 1) {
+      compute_queue_index = 1;
+    }
+  }
 
-  float queue_priority = 1.f;
+  float queue_priorities[] = {1.f, 1.f};
   for (const auto& family : unique_queue_families) {
     VkDeviceQueueCreateInfo queue_info{};
     queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queue_info.queueFamilyIndex = family;
-    queue_info.queueCount = 1;
-    queue_info.pQueuePriorities = &queue_priority;
+    queue_info.queueCount =
+        async_compute && queue_faimlies_.compute_family == family
+            ? compute_queue_index + 1
+            : 1;
+    queue_info.pQueuePriorities = queue_priorities;
 
     queue_infos.push_back(queue_info);
   }
@@ -347,13 +1091,92 @@ void Application::CreateLogicalDevice() {
   device_info.pQueueCreateInfos = queue_infos.data();
 
   // physical device features
+  VkPhysicalDeviceFeatures supported_features{};
+  vkGetPhysicalDeviceFeatures(physical_device_, &supported_features);
+
   VkPhysicalDeviceFeatures physical_device_features{};
+  physical_device_features.textureCompressionBC =
+      supported_features.textureCompressionBC;
+  physical_device_features.textureCompressionASTC_LDR =
+      supported_features.textureCompressionASTC_LDR;
+  device_features_.texture_compression_bc =
+      VK_TRUE == supported_features.textureCompressionBC;
+  device_features_.texture_compression_astc =
+      VK_TRUE == supported_features.textureCompressionASTC_LDR;
+  physical_device_features.samplerAnisotropy =
+      supported_features.samplerAnisotropy;
+  // textures[] is indexed by a push constant
+  physical_device_features.shaderSampledImageArrayDynamicIndexing =
+      supported_features.shaderSampledImageArrayDynamicIndexing;
+  device_features_.sampler_anisotropy =
+      VK_TRUE == supported_features.samplerAnisotropy;
+  // lets the post process chain store into the swap chain whatever its
+  // format, without it the chain declares its formats and blits
+  physical_device_features.shaderStorageImageWriteWithoutFormat =
+      supported_features.shaderStorageImageWriteWithoutFormat;
+  device_features_.storage_image_write_without_format =
+      VK_TRUE == supported_features.shaderStorageImageWriteWithoutFormat;
 
   device_info.pEnabledFeatures = &physical_device_features;
 
   // required physical device extensions
   std::vector<const char*> required_extensions{};
   FindDeviceExtensions(physical_device_, required_extensions);
+  FindOptionalDeviceExtensions(physical_device_, required_extensions);
+
+  // only what the bindless table relies on
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{};
+  indexing_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  if (device_features_.descriptor_indexing) {
+    indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+    indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    indexing_features.pNext = const_cast<void*>(device_info.pNext);
+    device_info.pNext = &indexing_features;
+  }
+
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+  timeline_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  if (device_features_.timeline_semaphore) {
+    timeline_features.timelineSemaphore = VK_TRUE;
+    timeline_features.pNext = const_cast<void*>(device_info.pNext);
+    device_info.pNext = &timeline_features;
+  }
+
+  VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+  present_id_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+  VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+  present_wait_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+  if (device_features_.present_wait) {
+    present_id_features.presentId = VK_TRUE;
+    present_id_features.pNext = const_cast<void*>(device_info.pNext);
+    present_wait_features.presentWait = VK_TRUE;
+    present_wait_features.pNext = &present_id_features;
+    device_info.pNext = &present_wait_features;
+  }
+
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+  dynamic_rendering_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  if (device_features_.dynamic_rendering) {
+    dynamic_rendering_features.dynamicRendering = VK_TRUE;
+    dynamic_rendering_features.pNext = const_cast<void*>(device_info.pNext);
+    device_info.pNext = &dynamic_rendering_features;
+  }
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features{};
+  synchronization2_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  if (device_features_.synchronization2) {
+    synchronization2_features.synchronization2 = VK_TRUE;
+    synchronization2_features.pNext = const_cast<void*>(device_info.pNext);
+    device_info.pNext = &synchronization2_features;
+  }
 
   device_info.enabledExtensionCount =
       static_cast<uint32_t>(required_extensions.size());
@@ -382,6 +1205,67 @@ void Application::CreateLogicalDevice() {
   // present queue
   vkGetDeviceQueue(device_, queue_faimlies_.present_family.value(), 0,
                    &present_queue_);
+  // transfer queue
+  if (queue_faimlies_.transfer_family.has_value()) {
+    vkGetDeviceQueue(device_, queue_faimlies_.transfer_family.value(), 0,
+                     &transfer_queue_);
+  } else {
+    transfer_queue_ = graphics_queue_;
+  }
+  // compute queue
+  if (async_compute) {
+    vkGetDeviceQueue(device_, queue_faimlies_.compute_family.value(),
+                     compute_queue_index, &compute_queue_);
+    std::clog << "----- Async Compute: queue family "
+              << queue_faimlies_.compute_family.value()
+              << (queue_faimlies_.transfer_family ==
+                              queue_faimlies_.compute_family &&
+                          0 == compute_queue_index
+                      ? ", shared with uploads"
+                      : "")
+              << " -----" << std::endl;
+  } else if (options_.async_compute) {
+    std::clog << "----- Async Compute: no compute only queue family, off "
+                 "-----"
+              << std::endl;
+  }
+
+  if (device_features_.draw_indirect_count) {
+    cmd_draw_indexed_indirect_count_ =
+        reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+    device_features_.draw_indirect_count =
+        nullptr != cmd_draw_indexed_indirect_count_;
+  }
+
+  if (device_features_.present_wait) {
+    wait_for_present_ = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+        vkGetDeviceProcAddr(device_, "vkWaitForPresentKHR"));
+    device_features_.present_wait = nullptr != wait_for_present_;
+  }
+
+  if (device_features_.dynamic_rendering) {
+    cmd_begin_rendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+    cmd_end_rendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+    device_features_.dynamic_rendering =
+        nullptr != cmd_begin_rendering_ && nullptr != cmd_end_rendering_;
+  }
+
+  std::clog << "----- Rendering: "
+            << (device_features_.dynamic_rendering
+                    ? "VK_KHR_dynamic_rendering"
+                    : "render passes and framebuffers")
+            << " -----" << std::endl;
+}
+
+void Application::CreateMemoryAllocator() {
+  allocator_.Init(physical_device_, device_);
+}
+
+void Application::CreatePipelineCache() {
+  pipeline_cache_.Init(physical_device_, device_, PIPELINE_CACHE_FILEPATH);
 }
 
 void Application::CreateSwapChain() {
@@ -390,8 +1274,19 @@ void Application::CreateSwapChain() {
 
   VkSurfaceFormatKHR surface_format =
       ChooseSwapSurfaceFormat(swap_chain_support.formats);
+  uint32_t supported_present_modes = 0;
+  for (auto available : LATENCY_PRESENT_MODES) {
+    if (swap_chain_support.present_modes.end() !=
+        std::find(swap_chain_support.present_modes.begin(),
+                  swap_chain_support.present_modes.end(), available)) {
+      supported_present_modes |= 1u << available;
+    }
+  }
+  supported_present_modes_ = supported_present_modes;
+
   VkPresentModeKHR present_mode =
       ChooseSwapPresentMode(swap_chain_support.present_modes);
+  swap_chain_present_mode_ = present_mode;
   VkExtent2D extent = ChooseSwapExtent(swap_chain_support.capabilities);
 
   uint32_t image_count = swap_chain_support.capabilities.minImageCount + 1;
@@ -408,7 +1303,24 @@ void Application::CreateSwapChain() {
   swap_chain_info.imageColorSpace = surface_format.colorSpace;
   swap_chain_info.imageExtent = extent;
   swap_chain_info.imageArrayLayers = 1;
-  swap_chain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  // the post process chain writes the image directly when it can, else
+  // blits into it; ImGui renders on top either way
+  VkImageUsageFlags supported_usage =
+      swap_chain_support.capabilities.supportedUsageFlags;
+  swap_chain_storage_ =
+      device_features_.storage_image_write_without_format &&
+      PostProcessChain::CanWriteOutput(physical_device_, surface_format.format,
+                                       supported_usage);
+  swap_chain_info.imageUsage =
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+      (swap_chain_storage_ ? VK_IMAGE_USAGE_STORAGE_BIT
+                           : VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+  if (!swap_chain_storage_ &&
+      0 == (supported_usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Swap chain can neither be stored to nor "
+        "blitted to -----");
+  }
 
   uint32_t queue_family_indices[] = {queue_faimlies_.graphics_family.value(),
                                      queue_faimlies_.present_family.value()};
@@ -429,7 +1341,9 @@ void Application::CreateSwapChain() {
   swap_chain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
   swap_chain_info.presentMode = present_mode;
   swap_chain_info.clipped = VK_TRUE;
-  swap_chain_info.oldSwapchain = VK_NULL_HANDLE;
+  // lets the driver hand over the old images, which stay presentable until
+  // the old swap chain is destroyed
+  swap_chain_info.oldSwapchain = swap_chain_;
 
   if (VK_SUCCESS !=
       vkCreateSwapchainKHR(device_, &swap_chain_info, nullptr, &swap_chain_)) {
@@ -449,30 +1363,17 @@ void Application::CreateImageViews() {
   swap_chain_image_views_.resize(swap_chain_images_.size());
 
   for (size_t i = 0; i < swap_chain_images_.size(); i++) {
-    VkImageViewCreateInfo image_view_info{};
-    image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    image_view_info.image = swap_chain_images_[i];
-    image_view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    image_view_info.format = swap_chain_image_format_;
-    image_view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-    image_view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-    image_view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-    image_view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-    image_view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    image_view_info.subresourceRange.baseMipLevel = 0;
-    image_view_info.subresourceRange.levelCount = 1;
-    image_view_info.subresourceRange.baseArrayLayer = 0;
-    image_view_info.subresourceRange.layerCount = 1;
-
-    if (VK_SUCCESS != vkCreateImageView(device_, &image_view_info, nullptr,
-                                        &swap_chain_image_views_[i])) {
-      throw std::runtime_error(
-          "----- Error::Vulkan: Failed to create image views -----");
-    }
+    swap_chain_image_views_[i] =
+        CreateImageView(swap_chain_images_[i], swap_chain_image_format_, 1);
   }
 }
 
 void Application::CreateFrameBuffers() {
+  // the UI pass begins on the swap chain image view itself
+  if (device_features_.dynamic_rendering) {
+    return;
+  }
+
   swap_chain_framebuffers_.resize(swap_chain_image_views_.size());
 
   for (size_t i = 0; i < swap_chain_image_views_.size(); i++) {
@@ -496,15 +1397,21 @@ void Application::CreateFrameBuffers() {
 }
 
 void Application::CreateRenderPass() {
+  if (device_features_.dynamic_rendering) {
+    return;
+  }
+
   VkAttachmentDescription color_attachment{};
   color_attachment.format = swap_chain_image_format_;
   color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-  color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  // ImGui only, on top of what the post process chain left in the image
+  color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
   color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
   color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-  color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  // the render graph transitions the image around the pass
+  color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
   VkAttachmentReference color_attachment_ref{};
   color_attachment_ref.attachment = 0;
@@ -515,22 +1422,12 @@ void Application::CreateRenderPass() {
   subpass_desc.colorAttachmentCount = 1;
   subpass_desc.pColorAttachments = &color_attachment_ref;
 
-  VkSubpassDependency dependency{};
-  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-  dependency.dstSubpass = 0;
-  dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependency.srcAccessMask = 0;
-  dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
   VkRenderPassCreateInfo render_pass_info{};
   render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
   render_pass_info.attachmentCount = 1;
   render_pass_info.pAttachments = &color_attachment;
   render_pass_info.subpassCount = 1;
   render_pass_info.pSubpasses = &subpass_desc;
-  render_pass_info.dependencyCount = 1;
-  render_pass_info.pDependencies = &dependency;
 
   if (vkCreateRenderPass(device_, &render_pass_info, nullptr, &render_pass_) !=
       VK_SUCCESS) {
@@ -539,24 +1436,38 @@ void Application::CreateRenderPass() {
   }
 }
 
+void Application::CreatePostProcess() {
+  ShaderLibrary::Code bloom_down = shader_library_.Get(bloom_down_shader_);
+  ShaderLibrary::Code bloom_up = shader_library_.Get(bloom_up_shader_);
+  ShaderLibrary::Code tonemap = shader_library_.Get(tonemap_shader_);
+  ShaderLibrary::Code fxaa = shader_library_.Get(fxaa_shader_);
+  PostProcessShaders shaders{bloom_down.get(), bloom_up.get(), tonemap.get(),
+                             fxaa.get()};
+
+  PostProcessSettings settings{};
+  settings.bloom = options_.bloom;
+  settings.fxaa = options_.fxaa;
+  settings.samples = ChooseSampleCount();
+
+  // retires through the deletion queue, which is only used on resize; the
+  // targets follow with the render graph
+  post_process_.Init(physical_device_, device_, deletion_queue_,
+                     pipeline_cache_.GetHandle(), settings, shaders,
+                     device_features_.dynamic_rendering);
+}
+
 void Application::CreateDescriptorPool() {
+  // scene and cull sets per frame, plus ImGui's font and user textures;
+  // textures and buffers indexed by shaders live in the bindless table
   VkDescriptorPoolSize pool_sizes[] = {
-      {VK_DESCRIPTOR_TYPE_SAMPLER, 1000},
-      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
-      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000},
-      {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000},
-      {VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000},
-      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000},
-      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000},
-      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000},
-      {VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000}};
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * frames_in_flight_},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * frames_in_flight_},
+      {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, IMGUI_MAX_TEXTURES}};
 
   VkDescriptorPoolCreateInfo pool_info = {};
   pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
   pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-  pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
+  pool_info.maxSets = 2 * frames_in_flight_ + IMGUI_MAX_TEXTURES;
   pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
   pool_info.pPoolSizes = pool_sizes;
 
@@ -587,23 +1498,48 @@ void Application::CreateDescriptorSetLayout() {
   }
 }
 
+void Application::CreateComputeDescriptorSetLayout() {
+  // 0: scene UBO, 1: all instances, 2: visible instances, 3: indirect draw
+  std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = 0 == i ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                                        : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layout_info{};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (VK_SUCCESS !=
+      vkCreateDescriptorSetLayout(device_, &layout_info, nullptr,
+                                  &compute_descriptor_set_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create compute descriptor set layout "
+        "-----");
+  }
+}
+
 void Application::CreateDescriptorSets() {
-  std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT,
+  std::vector<VkDescriptorSetLayout> layouts(frames_in_flight_,
                                              descriptor_set_layout_);
   VkDescriptorSetAllocateInfo alloc_info{};
   alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   alloc_info.descriptorPool = descriptor_pool_;
-  alloc_info.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+  alloc_info.descriptorSetCount = frames_in_flight_;
   alloc_info.pSetLayouts = layouts.data();
 
-  descriptor_sets_.resize(MAX_FRAMES_IN_FLIGHT);
+  descriptor_sets_.resize(frames_in_flight_);
   if (vkAllocateDescriptorSets(device_, &alloc_info, descriptor_sets_.data()) !=
       VK_SUCCESS) {
     throw std::runtime_error(
         "----- Error::Vulkan: Failed to allocate descriptor sets -----");
   }
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  for (size_t i = 0; i < frames_in_flight_; i++) {
     VkDescriptorBufferInfo buffer_info{};
     buffer_info.buffer = uniform_buffers_[i];
     buffer_info.offset = 0;
@@ -624,14 +1560,73 @@ void Application::CreateDescriptorSets() {
   }
 }
 
+void Application::CreateComputeDescriptorSets() {
+  std::vector<VkDescriptorSetLayout> layouts(frames_in_flight_,
+                                             compute_descriptor_set_layout_);
+  VkDescriptorSetAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = descriptor_pool_;
+  alloc_info.descriptorSetCount = frames_in_flight_;
+  alloc_info.pSetLayouts = layouts.data();
+
+  compute_descriptor_sets_.resize(frames_in_flight_);
+  if (VK_SUCCESS != vkAllocateDescriptorSets(device_, &alloc_info,
+                                             compute_descriptor_sets_.data())) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate compute descriptor sets "
+        "-----");
+  }
+
+  VkDeviceSize instances_size = sizeof(InstanceData) * instance_count_;
+
+  for (size_t i = 0; i < frames_in_flight_; i++) {
+    std::array<VkDescriptorBufferInfo, 4> buffer_infos{};
+    buffer_infos[0] = {uniform_buffers_[i], 0, sizeof(UniformBufferObject)};
+    buffer_infos[1] = {
+        dynamic_instances_ ? instance_buffers_[i] : instance_buffer_, 0,
+        instances_size};
+    buffer_infos[2] = {visible_instance_buffers_[i], 0, instances_size};
+    buffer_infos[3] = {indirect_buffers_[i], 0,
+                       sizeof(IndirectDraw) * scene_chunk_count_};
+
+    std::array<VkWriteDescriptorSet, 4> descriptor_writes{};
+    for (uint32_t binding = 0; binding < descriptor_writes.size(); ++binding) {
+      descriptor_writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      descriptor_writes[binding].dstSet = compute_descriptor_sets_[i];
+      descriptor_writes[binding].dstBinding = binding;
+      descriptor_writes[binding].dstArrayElement = 0;
+      descriptor_writes[binding].descriptorType =
+          0 == binding ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+                       : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      descriptor_writes[binding].descriptorCount = 1;
+      descriptor_writes[binding].pBufferInfo = &buffer_infos[binding];
+    }
+
+    vkUpdateDescriptorSets(device_,
+                           static_cast<uint32_t>(descriptor_writes.size()),
+                           descriptor_writes.data(), 0, nullptr);
+  }
+}
+
 void Application::CreatePipelineLayout() {
   // pipeline layout
   VkPipelineLayoutCreateInfo pipeline_layout_info{};
   pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-  pipeline_layout_info.setLayoutCount = 1;
-  pipeline_layout_info.pSetLayouts = &descriptor_set_layout_;
-  pipeline_layout_info.pushConstantRangeCount = 0;     // Optional
-  pipeline_layout_info.pPushConstantRanges = nullptr;  // Optional
+  // set 0: per frame scene data, set 1: bindless table
+  std::array<VkDescriptorSetLayout, 2> set_layouts{
+      descriptor_set_layout_, bindless_table_.GetLayout()};
+
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags =
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(DrawPushConstants);
+
+  pipeline_layout_info.setLayoutCount =
+      static_cast<uint32_t>(set_layouts.size());
+  pipeline_layout_info.pSetLayouts = set_layouts.data();
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
 
   if (VK_SUCCESS != vkCreatePipelineLayout(device_, &pipeline_layout_info,
                                            nullptr, &pipeline_layout_)) {
@@ -641,11 +1636,15 @@ void Application::CreatePipelineLayout() {
 }
 
 void Application::CreateGraphicsPipeline() {
-  auto vert_shader_code = ReadFile(VERT_SHADER_FILEPATH);
-  auto frag_shader_code = ReadFile(FRAG_SHADER_FILEPATH);
+  graphics_pipeline_ = BuildGraphicsPipeline();
+}
+
+VkPipeline Application::BuildGraphicsPipeline() {
+  ShaderLibrary::Code vert_shader_code = shader_library_.Get(vert_shader_);
+  ShaderLibrary::Code frag_shader_code = shader_library_.Get(frag_shader_);
 
-  VkShaderModule vert_shader_moudle = CreateShaderMoudle(vert_shader_code);
-  VkShaderModule frag_shader_moudle = CreateShaderMoudle(frag_shader_code);
+  VkShaderModule vert_shader_moudle = CreateShaderMoudle(*vert_shader_code);
+  VkShaderModule frag_shader_moudle = CreateShaderMoudle(*frag_shader_code);
 
   // shader stage creation
   VkPipelineShaderStageCreateInfo vert_shader_stage_info{};
@@ -662,6 +1661,13 @@ void Application::CreateGraphicsPipeline() {
   frag_shader_stage_info.module = frag_shader_moudle;
   frag_shader_stage_info.pName = "main";
 
+  // constant_id 0 sizes the texture array to the table, 1 picks the lit or
+  // unlit variant
+  SpecializationConstants frag_constants{};
+  frag_constants.Set(0, bindless_table_.GetTextureCapacity())
+      .Set(1, options_.lighting ? VK_TRUE : VK_FALSE);
+  frag_shader_stage_info.pSpecializationInfo = frag_constants.Get();
+
   VkPipelineShaderStageCreateInfo shader_stage_infos[] = {
       vert_shader_stage_info, frag_shader_stage_info};
 
@@ -675,14 +1681,15 @@ void Application::CreateGraphicsPipeline() {
   dynamicState.pDynamicStates = dynamic_states.data();
 
   // vertex input
-  auto binding_desc = Vertex::GetBindingDescription();
+  auto binding_descs = Vertex::GetBindingDescriptions();
   auto attribute_descs = Vertex::GetAttributeDescriptions();
 
   VkPipelineVertexInputStateCreateInfo vertex_input_info{};
   vertex_input_info.sType =
       VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-  vertex_input_info.vertexBindingDescriptionCount = 1;
-  vertex_input_info.pVertexBindingDescriptions = &binding_desc;
+  vertex_input_info.vertexBindingDescriptionCount =
+      static_cast<uint32_t>(binding_descs.size());
+  vertex_input_info.pVertexBindingDescriptions = binding_descs.data();
   vertex_input_info.vertexAttributeDescriptionCount =
       static_cast<uint32_t>(attribute_descs.size());
   vertex_input_info.pVertexAttributeDescriptions = attribute_descs.data();
@@ -735,7 +1742,7 @@ void Application::CreateGraphicsPipeline() {
   multisample_state_info.sType =
       VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
   multisample_state_info.sampleShadingEnable = VK_FALSE;
-  multisample_state_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+  multisample_state_info.rasterizationSamples = post_process_.GetSampleCount();
   multisample_state_info.minSampleShading = 1.0f;           // Optional
   multisample_state_info.pSampleMask = nullptr;             // Optional
   multisample_state_info.alphaToCoverageEnable = VK_FALSE;  // Optional
@@ -768,6 +1775,16 @@ void Application::CreateGraphicsPipeline() {
   color_blend_state_info.blendConstants[2] = 0.0f;  // Optional
   color_blend_state_info.blendConstants[3] = 0.0f;  // Optional
 
+  // depth of the offscreen scene target
+  VkPipelineDepthStencilStateCreateInfo depth_stencil_state_info{};
+  depth_stencil_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+  depth_stencil_state_info.depthTestEnable = VK_TRUE;
+  depth_stencil_state_info.depthWriteEnable = VK_TRUE;
+  depth_stencil_state_info.depthCompareOp = VK_COMPARE_OP_LESS;
+  depth_stencil_state_info.depthBoundsTestEnable = VK_FALSE;
+  depth_stencil_state_info.stencilTestEnable = VK_FALSE;
+
   VkGraphicsPipelineCreateInfo pipeline_info{};
   pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
   pipeline_info.stageCount = 2;
@@ -777,23 +1794,96 @@ void Application::CreateGraphicsPipeline() {
   pipeline_info.pViewportState = &viewport_state_info;
   pipeline_info.pRasterizationState = &rasterizer_state_info;
   pipeline_info.pMultisampleState = &multisample_state_info;
-  pipeline_info.pDepthStencilState = nullptr;  // Optional
+  pipeline_info.pDepthStencilState = &depth_stencil_state_info;
   pipeline_info.pColorBlendState = &color_blend_state_info;
   pipeline_info.pDynamicState = &dynamicState;
   pipeline_info.layout = pipeline_layout_;
-  pipeline_info.renderPass = render_pass_;
+  pipeline_info.renderPass = post_process_.GetSceneRenderPass();
   pipeline_info.subpass = 0;
+
+  // without a render pass the attachment formats come from here
+  VkPipelineRenderingCreateInfoKHR rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachmentFormats = &HDR_COLOR_FORMAT;
+  rendering_info.depthAttachmentFormat = post_process_.GetDepthFormat();
+  if (device_features_.dynamic_rendering) {
+    pipeline_info.pNext = &rendering_info;
+  }
   pipeline_info.basePipelineHandle = VK_NULL_HANDLE;  // Optional
   pipeline_info.basePipelineIndex = -1;               // Optional
 
-  if (VK_SUCCESS != vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1,
-                                              &pipeline_info, nullptr,
-                                              &graphics_pipeline_)) {
-    throw std::runtime_error("failed to create graphics pipeline!");
-  }
+  auto start_time = std::chrono::high_resolution_clock::now();
 
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result =
+      vkCreateGraphicsPipelines(device_, pipeline_cache_.GetHandle(), 1,
+                                &pipeline_info, nullptr, &pipeline);
   vkDestroyShaderModule(device_, vert_shader_moudle, nullptr);
   vkDestroyShaderModule(device_, frag_shader_moudle, nullptr);
+
+  if (VK_SUCCESS != result) {
+    throw std::runtime_error("failed to create graphics pipeline!");
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  std::clog << "----- Graphics Pipeline: created in "
+            << std::chrono::duration<double, std::milli>(end_time - start_time)
+                   .count()
+            << " ms (" << (pipeline_cache_.IsWarm() ? "warm" : "cold")
+            << " pipeline cache) -----" << std::endl;
+
+  return pipeline;
+}
+
+void Application::CreateComputePipeline() {
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(CullPushConstants);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info{};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &compute_descriptor_set_layout_;
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+  if (VK_SUCCESS != vkCreatePipelineLayout(device_, &pipeline_layout_info,
+                                           nullptr,
+                                           &compute_pipeline_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create compute pipeline layout -----");
+  }
+
+  compute_pipeline_ = BuildComputePipeline();
+}
+
+VkPipeline Application::BuildComputePipeline() {
+  ShaderLibrary::Code cull_shader_code = shader_library_.Get(cull_shader_);
+  VkShaderModule cull_shader_module = CreateShaderMoudle(*cull_shader_code);
+
+  VkComputePipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = cull_shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.layout = compute_pipeline_layout_;
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result =
+      vkCreateComputePipelines(device_, pipeline_cache_.GetHandle(), 1,
+                               &pipeline_info, nullptr, &pipeline);
+  vkDestroyShaderModule(device_, cull_shader_module, nullptr);
+
+  if (VK_SUCCESS != result) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create compute pipeline -----");
+  }
+
+  return pipeline;
 }
 
 void Application::CreateCommandPool() {
@@ -809,147 +1899,725 @@ void Application::CreateCommandPool() {
   }
 }
 
-void Application::CreateCommandBuffers() {
-  command_buffers_.resize(MAX_FRAMES_IN_FLIGHT);
+void Application::CreateFrameCommandPools() {
+  // every worker records scene chunks, the render thread the primary and
+  // ImGui
+  uint32_t thread_count = job_system_.ThreadCount() + 1;
+  frame_command_pools_.Init(device_, queue_faimlies_.graphics_family.value(),
+                            frames_in_flight_, thread_count);
 
-  VkCommandBufferAllocateInfo alloc_info{};
-  alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  alloc_info.commandPool = command_pool_;
-  alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  alloc_info.commandBufferCount =
-      static_cast<uint32_t>(command_buffers_.size());
+  // only the render thread records for the compute queue
+  if (VK_NULL_HANDLE != compute_queue_) {
+    compute_command_pools_.Init(device_,
+                                queue_faimlies_.compute_family.value(),
+                                frames_in_flight_, 1);
+  }
+}
 
-  if (VK_SUCCESS !=
-      vkAllocateCommandBuffers(device_, &alloc_info, command_buffers_.data())) {
-    throw std::runtime_error(
-        "Error::Vulkan: Failed to allocate command buffers -----");
+void Application::CreateGpuProfiler() {
+  gpu_profiler_.Init(physical_device_, device_,
+                     queue_faimlies_.graphics_family.value(),
+                     frames_in_flight_);
+
+  if (VK_NULL_HANDLE != compute_queue_) {
+    async_profiler_.Init(physical_device_, device_,
+                         queue_faimlies_.compute_family.value(),
+                         frames_in_flight_);
   }
 }
 
-void Application::CreateTextureImage() {
-  int width, height, channels;
-  stbi_uc* pixels = stbi_load(TEXTURE_FILEPATH.c_str(), &width, &height,
-                              &channels, STBI_rgb_alpha);
-  VkDeviceSize image_size = width * height * 4;
+void Application::CreateTextureSampler() {
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(physical_device_, &properties);
+
+  VkSamplerCreateInfo sampler_info{};
+  sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampler_info.magFilter = VK_FILTER_LINEAR;
+  sampler_info.minFilter = VK_FILTER_LINEAR;
+  sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.anisotropyEnable =
+      device_features_.sampler_anisotropy ? VK_TRUE : VK_FALSE;
+  sampler_info.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
+  sampler_info.compareEnable = VK_FALSE;
+  sampler_info.compareOp = VK_COMPARE_OP_ALWAYS;
+  // every level the texture ends up with
+  sampler_info.minLod = 0.0f;
+  sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+  sampler_info.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+  sampler_info.unnormalizedCoordinates = VK_FALSE;
 
-  if (!pixels) {
+  if (VK_SUCCESS !=
+      vkCreateSampler(device_, &sampler_info, nullptr, &texture_sampler_)) {
     throw std::runtime_error(
-        "----- Error::stb_image: Failed to load texture image -----");
+        "----- Error::Vulkan: Failed to create texture sampler -----");
   }
+}
 
-  VkBuffer staging_buffer;
-  VkDeviceMemory staging_buffer_memory;
+void Application::CreateBindlessTable() {
+  uint32_t texture_capacity = LEGACY_TEXTURE_SLOTS;
+  uint32_t buffer_capacity = LEGACY_BUFFER_SLOTS;
+
+  if (device_features_.descriptor_indexing) {
+    VkPhysicalDeviceDescriptorIndexingProperties indexing_properties{};
+    indexing_properties.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &indexing_properties;
+    vkGetPhysicalDeviceProperties2(physical_device_, &properties);
+
+    texture_capacity = std::min(
+        {BINDLESS_MAX_TEXTURES,
+         indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+         indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages});
+    buffer_capacity = std::min(
+        {BINDLESS_MAX_BUFFERS,
+         indexing_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+         indexing_properties.maxDescriptorSetUpdateAfterBindStorageBuffers});
+  }
+
+  bindless_table_.Init(device_, texture_sampler_,
+                       device_features_.descriptor_indexing, texture_capacity,
+                       buffer_capacity, frames_in_flight_);
+
+  std::clog << "----- Descriptors: "
+            << (bindless_table_.IsBindless() ? "bindless, " : "legacy, ")
+            << texture_capacity << " texture and " << buffer_capacity
+            << " buffer slots -----" << std::endl;
+}
 
-  CreateBuffer(image_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               staging_buffer, staging_buffer_memory);
+void Application::CreateGpuTimeline() {
+  gpu_timeline_.Init(device_, device_features_.timeline_semaphore);
+  deletion_queue_.Init(gpu_timeline_);
+}
 
-  void* data;
-  vkMapMemory(device_, staging_buffer_memory, 0, image_size, 0, &data);
-  memcpy(data, pixels, static_cast<size_t>(image_size));
-  vkUnmapMemory(device_, staging_buffer_memory);
+void Application::CreateUploadContext() {
+  uint32_t graphics_family = queue_faimlies_.graphics_family.value();
+  uint32_t transfer_family =
+      queue_faimlies_.transfer_family.value_or(graphics_family);
 
-  stbi_image_free(pixels);
+  upload_context_.Init(device_, allocator_, gpu_timeline_, queue_mutex_,
+                       graphics_family, graphics_queue_, transfer_family,
+                       transfer_queue_);
 
-  CreateImage(width, height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-              VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture_image_,
-              texture_image_memory_);
-  TransitionImageLayout(texture_image_, VK_IMAGE_LAYOUT_UNDEFINED,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-  CopyBufferToImage(staging_buffer, texture_image_,
-                    static_cast<uint32_t>(width),
-                    static_cast<uint32_t>(height));
+  std::clog << "----- Upload Context: "
+            << (upload_context_.HasDedicatedTransferQueue()
+                    ? "dedicated transfer queue family "
+                    : "graphics queue family ")
+            << transfer_family << " -----" << std::endl;
+}
 
-  vkDestroyBuffer(device_, staging_buffer, nullptr);
-  vkFreeMemory(device_, staging_buffer_memory, nullptr);
+void Application::RequestAssets() {
+  vert_shader_ = shader_library_.Request(VERT_SHADER);
+  frag_shader_ = shader_library_.Request(FRAG_SHADER);
+  cull_shader_ = shader_library_.Request(CULL_SHADER);
+  bloom_down_shader_ = shader_library_.Request(BLOOM_DOWN_SHADER);
+  bloom_up_shader_ = shader_library_.Request(BLOOM_UP_SHADER);
+  imgui_vert_shader_ = shader_library_.Request(IMGUI_VERT_SHADER);
+  imgui_frag_shader_ = shader_library_.Request(IMGUI_FRAG_SHADER);
 }
 
-void Application::CreateVertexBuffer() {
-  VkDeviceSize buffer_size = sizeof(vertices_[0]) * vertices_.size();
+void Application::RequestPostProcessShaders() {
+  if (device_features_.storage_image_write_without_format) {
+    tonemap_shader_ = shader_library_.Request(TONEMAP_SHADER);
+    fxaa_shader_ = shader_library_.Request(FXAA_SHADER);
+    return;
+  }
 
-  // staging buffer: host visible
-  VkBuffer staging_buffer{};
-  VkDeviceMemory staging_buffer_memory{};
+  // the variants storing into the chain's own targets, which are blitted
+  // into the swap chain: LDR for FXAA to read, else the float blit source
+  tonemap_shader_ = shader_library_.Request(
+      TONEMAP_SHADER,
+      options_.fxaa ? LDR_COLOR_GLSL_FORMAT : HDR_COLOR_GLSL_FORMAT);
+  fxaa_shader_ = shader_library_.Request(FXAA_SHADER, HDR_COLOR_GLSL_FORMAT);
+}
 
-  CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               staging_buffer, staging_buffer_memory);
+void Application::RequestTexture() {
+  texture_path_ = ChooseTexturePath();
+  texture_asset_ = asset_loader_.LoadTexture(texture_path_);
+}
 
-  // map data memory
-  void* data;
-  vkMapMemory(device_, staging_buffer_memory, 0, buffer_size, 0, &data);
-  memcpy(data, vertices_.data(), static_cast<size_t>(buffer_size));
-  vkUnmapMemory(device_, staging_buffer_memory);
+void Application::WatchShaders() {
+  if (!options_.hot_reload) {
+    return;
+  }
 
-  // vertext buffer: device local
-  CreateBuffer(
-      buffer_size,
-      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+  AddPipelineReload("Graphics", {vert_shader_, frag_shader_}, [this]() {
+    VkPipeline pipeline = BuildGraphicsPipeline();
+    return std::function<void()>([this, pipeline]() {
+      RetirePipeline(std::exchange(graphics_pipeline_, pipeline));
+    });
+  });
+
+  AddPipelineReload("Cull", {cull_shader_}, [this]() {
+    VkPipeline pipeline = BuildComputePipeline();
+    return std::function<void()>([this, pipeline]() {
+      RetirePipeline(std::exchange(compute_pipeline_, pipeline));
+    });
+  });
+
+  AddPipelineReload(
+      "Post Process",
+      {bloom_down_shader_, bloom_up_shader_, tonemap_shader_, fxaa_shader_},
+      [this]() {
+        auto bloom_down = shader_library_.Get(bloom_down_shader_);
+        auto bloom_up = shader_library_.Get(bloom_up_shader_);
+        auto tonemap = shader_library_.Get(tonemap_shader_);
+        auto fxaa = shader_library_.Get(fxaa_shader_);
+        PostProcessShaders shaders{bloom_down.get(), bloom_up.get(),
+                                   tonemap.get(), fxaa.get()};
+
+        PostProcessChain::Pipelines pipelines = post_process_.CreatePipelines(
+            pipeline_cache_.GetHandle(), shaders);
+        return std::function<void()>([this, pipelines]() mutable {
+          post_process_.SwapPipelines(pipelines);
+          deletion_queue_.Retire([this, pipelines]() mutable {
+            post_process_.DestroyPipelines(pipelines);
+          });
+        });
+      });
+
+  AddPipelineReload(
+      "ImGui", {imgui_vert_shader_, imgui_frag_shader_}, [this]() {
+        auto imgui_vert = shader_library_.Get(imgui_vert_shader_);
+        auto imgui_frag = shader_library_.Get(imgui_frag_shader_);
+        VkPipeline pipeline = imgui_renderer_.CreatePipeline(
+            pipeline_cache_.GetHandle(), {imgui_vert.get(), imgui_frag.get()});
+        return std::function<void()>([this, pipeline]() {
+          RetirePipeline(imgui_renderer_.SwapPipeline(pipeline));
+        });
+      });
+
+  shader_library_.SetHotReload(true);
+}
+
+void Application::AddPipelineReload(
+    const std::string& name, const std::vector<ShaderId>& shaders,
+    std::function<std::function<void()>()> build) {
+  auto reload = std::make_unique<PipelineReload>();
+  reload->name = name;
+  reload->shaders = shaders;
+  reload->build = std::move(build);
+  pipeline_reloads_.push_back(std::move(reload));
+}
+
+void Application::ReloadPipelines() {
+  TRACE_SCOPE("ReloadPipelines");
+
+  std::vector<ShaderId> reloaded = shader_library_.Poll();
+
+  bool building = false;
+  for (auto& reload : pipeline_reloads_) {
+    for (auto shader : reloaded) {
+      if (reload->shaders.end() != std::find(reload->shaders.begin(),
+                                             reload->shaders.end(), shader)) {
+        reload->dirty = true;
+      }
+    }
+
+    if (reload->running) {
+      if (!reload->counter.IsDone()) {
+        building = true;
+        continue;
+      }
+      reload->running = false;
+
+      // between frames, nothing is recording with the old pipeline
+      if (reload->install) {
+        reload->install();
+        reload->install = nullptr;
+        std::clog << "----- Pipeline Reload: " << reload->name
+                  << " rebuilt -----" << std::endl;
+      } else {
+        std::clog << reload->error << std::endl;
+        std::clog << "----- Pipeline Reload: keeping the previous "
+                  << reload->name << " pipeline -----" << std::endl;
+        reload->error.clear();
+      }
+    }
+
+    // one build at a time, edits meanwhile start the next one
+    if (reload->dirty) {
+      reload->dirty = false;
+      reload->running = true;
+      building = true;
+
+      PipelineReload* pending = reload.get();
+      job_system_.Schedule(
+          [pending]() {
+            TRACE_SCOPE("RebuildPipeline");
+            try {
+              pending->install = pending->build();
+            } catch (const std::exception& e) {
+              pending->error = e.what();
+            }
+          },
+          &pending->counter);
+    }
+  }
+
+  reloads_pending_ = building;
+}
+
+void Application::RetirePipeline(VkPipeline pipeline) {
+  deletion_queue_.Retire([device = device_, pipeline]() {
+    vkDestroyPipeline(device, pipeline, nullptr);
+  });
+}
+
+void Application::ProcessLoadedAssets() {
+  TRACE_SCOPE("ProcessLoadedAssets");
+
+  // texture streams in whenever its decode finishes, frames go on meanwhile
+  if (texture_asset_ && texture_asset_->IsReady()) {
+    if (texture_asset_->Failed()) {
+      throw std::runtime_error(texture_asset_->error);
+    }
+
+    CreateTextureImage();
+    texture_asset_.reset();
+  }
+}
+
+void Application::CreateDefaultTexture() {
+  const uint32_t white = 0xffffffff;
+  StagingAllocation staging = upload_context_.Stage(&white, sizeof(white));
+
+  CreateImage(1, 1, 1, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_TILING_OPTIMAL,
+              VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, default_texture_image_,
+              default_texture_image_memory_);
+  TransitionImageLayout(default_texture_image_, VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
+  CopyBufferToImage(staging.buffer, staging.offset, default_texture_image_, 1,
+                    1, {0});
+  TransitionImageLayout(default_texture_image_,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+  default_texture_image_view_ =
+      CreateImageView(default_texture_image_, VK_FORMAT_R8G8B8A8_UNORM, 1);
+  scene_texture_index_ =
+      bindless_table_.AddTexture(default_texture_image_view_);
+}
+
+void Application::CreateTextureImage() {
+  uint32_t width = static_cast<uint32_t>(texture_asset_->width);
+  uint32_t height = static_cast<uint32_t>(texture_asset_->height);
+  const Ktx2Texture& ktx2 = texture_asset_->ktx2;
+
+  VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+  const void* texels = texture_asset_->pixels.get();
+  VkDeviceSize texels_size = VkDeviceSize{width} * height * 4;
+  std::vector<VkDeviceSize> level_offsets{0};
+
+  // KTX2: every level sits in the file ready for the GPU, staged in one go
+  if (!texture_asset_->pixels) {
+    format = static_cast<VkFormat>(ktx2.vk_format);
+    if (!IsFormatSupported(format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+      throw std::runtime_error("----- Error::Vulkan: " + texture_asset_->path +
+                               " uses a format the device can not sample "
+                               "-----");
+    }
+
+    uint64_t begin = ktx2.levels[0].offset;
+    uint64_t end = 0;
+    for (const auto& level : ktx2.levels) {
+      begin = std::min(begin, level.offset);
+      end = std::max(end, level.offset + level.size);
+    }
+
+    level_offsets.clear();
+    for (const auto& level : ktx2.levels) {
+      level_offsets.push_back(level.offset - begin);
+    }
+
+    texels = texture_asset_->bytes.data() + begin;
+    texels_size = end - begin;
+  }
+
+  // a single level is filled in by blits, if the format can be filtered
+  VkFormatFeatureFlags blit_features =
+      VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  bool generate_mipmaps = 1 == level_offsets.size() &&
+                          (texture_asset_->pixels || ktx2.generate_mipmaps) &&
+                          IsFormatSupported(format, blit_features);
+  texture_mip_levels_ =
+      generate_mipmaps
+          ? static_cast<uint32_t>(
+                std::floor(std::log2(std::max(width, height)))) + 1
+          : static_cast<uint32_t>(level_offsets.size());
+
+  // staging: persistently mapped ring, reclaimed when the upload completes;
+  // 16 bytes keeps every block compressed level offset aligned
+  StagingAllocation staging = upload_context_.Stage(texels, texels_size, 16);
+
+  // source texels are no longer needed once staged
+  texture_asset_->pixels.reset();
+  texture_asset_->bytes = std::vector<char>{};
+
+  VkImageUsageFlags usage =
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  if (generate_mipmaps) {
+    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
+
+  CreateImage(width, height, texture_mip_levels_, format,
+              VK_IMAGE_TILING_OPTIMAL, usage,
+              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture_image_,
+              texture_image_memory_);
+  TransitionImageLayout(texture_image_, VK_IMAGE_LAYOUT_UNDEFINED,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        texture_mip_levels_);
+  CopyBufferToImage(staging.buffer, staging.offset, texture_image_, width,
+                    height, level_offsets);
+
+  if (generate_mipmaps) {
+    upload_context_.GenerateMipmaps(texture_image_, width, height,
+                                    texture_mip_levels_);
+  } else {
+    TransitionImageLayout(texture_image_,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                          texture_mip_levels_);
+  }
+
+  // a new slot: frames in flight keep reading the default texture
+  texture_image_view_ =
+      CreateImageView(texture_image_, format, texture_mip_levels_);
+  scene_texture_index_ = bindless_table_.AddTexture(texture_image_view_);
+
+  std::clog << "----- Texture: " << texture_asset_->path << ", " << width
+            << "x" << height << ", " << texture_mip_levels_ << " level(s)"
+            << (generate_mipmaps ? " generated" : "") << " -----"
+            << std::endl;
+}
+
+bool Application::IsFormatSupported(VkFormat format,
+                                    VkFormatFeatureFlags features) {
+  VkFormatProperties properties{};
+  vkGetPhysicalDeviceFormatProperties(physical_device_, format, &properties);
+
+  return features == (properties.optimalTilingFeatures & features);
+}
+
+std::string Application::ChooseTexturePath() {
+  if (!options_.texture_path.empty()) {
+    return options_.texture_path;
+  }
+
+  // ASTC first where it is there (mostly mobile/integrated), then BC7
+  std::vector<std::pair<std::string, VkFormat>> candidates{};
+  if (device_features_.texture_compression_astc) {
+    candidates.push_back(
+        {TEXTURE_ASTC_FILEPATH, VK_FORMAT_ASTC_4x4_SRGB_BLOCK});
+  }
+  if (device_features_.texture_compression_bc) {
+    candidates.push_back({TEXTURE_BC7_FILEPATH, VK_FORMAT_BC7_SRGB_BLOCK});
+  }
+
+  for (const auto& candidate : candidates) {
+    if (IsFormatSupported(candidate.second,
+                          VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
+        std::ifstream(candidate.first).good()) {
+      return candidate.first;
+    }
+  }
+
+  return TEXTURE_FILEPATH;
+}
+
+void Application::LoadMesh() {
+  if (options_.mesh_path.empty()) {
+    mesh_lods_ = {{0, static_cast<uint32_t>(indices_.size()), 0, 0}};
+    index_type_ = VK_INDEX_TYPE_UINT16;
+
+    mesh_bounding_radius_ = 0.0f;
+    for (const auto& vertex : vertices_) {
+      mesh_bounding_radius_ =
+          std::max(mesh_bounding_radius_, glm::length(vertex.pos));
+    }
+    return;
+  }
+
+  mesh_file_.Open(options_.mesh_path);
+
+  const MeshFileHeader& header = mesh_file_.GetHeader();
+  mesh_lods_.assign(mesh_file_.GetLods(),
+                    mesh_file_.GetLods() + header.lod_count);
+  index_type_ =
+      2 == header.index_size ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+  mesh_bounding_radius_ = header.bounding_radius;
+
+  std::clog << "----- Mesh: " << options_.mesh_path << ", "
+            << header.vertex_count << " vertices, " << header.index_count
+            << " " << header.index_size * 8 << "-bit indices, "
+            << header.lod_count << " LOD(s), " << header.meshlet_count
+            << " meshlet(s) -----" << std::endl;
+}
+
+void Application::CreateVertexBuffer() {
+  // a mapped mesh file goes into the staging ring without any other copy
+  const void* vertex_data = vertices_.data();
+  VkDeviceSize buffer_size = sizeof(vertices_[0]) * vertices_.size();
+  if (mesh_file_.IsOpen()) {
+    vertex_data = mesh_file_.GetVertexData();
+    buffer_size = mesh_file_.GetVertexDataSize();
+  }
+
+  // vertext buffer: device local
+  CreateBuffer(
+      buffer_size,
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertex_buffer_,
       vertex_buffer_memory_);
 
-  // transfer vertex data to device local buffer
-  CopyBuffer(staging_buffer, vertex_buffer_, buffer_size);
-
-  vkDestroyBuffer(device_, staging_buffer, nullptr);
-  vkFreeMemory(device_, staging_buffer_memory, nullptr);
+  // transfer vertex data to device local buffer through the staging ring
+  upload_context_.UploadBuffer(vertex_data, buffer_size, vertex_buffer_);
 }
 
 void Application::CreateIndexBuffer() {
+  // every LOD shares this buffer, each one is a range of it
+  const void* index_data = indices_.data();
   VkDeviceSize buffer_size = sizeof(indices_[0]) * indices_.size();
-
-  VkBuffer staging_buffer;
-  VkDeviceMemory staging_buffer_memory;
-  CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               staging_buffer, staging_buffer_memory);
-
-  void* data;
-  vkMapMemory(device_, staging_buffer_memory, 0, buffer_size, 0, &data);
-  memcpy(data, indices_.data(), static_cast<size_t>(buffer_size));
-  vkUnmapMemory(device_, staging_buffer_memory);
+  if (mesh_file_.IsOpen()) {
+    index_data = mesh_file_.GetIndexData();
+    buffer_size = mesh_file_.GetIndexDataSize();
+  }
 
   CreateBuffer(
       buffer_size,
       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, index_buffer_, index_buffer_memory_);
 
-  CopyBuffer(staging_buffer, index_buffer_, buffer_size);
+  upload_context_.UploadBuffer(index_data, buffer_size, index_buffer_);
+}
 
-  vkDestroyBuffer(device_, staging_buffer, nullptr);
-  vkFreeMemory(device_, staging_buffer_memory, nullptr);
+void Application::CreateInstanceBuffer() {
+  instance_count_ = options_.instances;
+  dynamic_instances_ = options_.dynamic_instances;
+
+  // square grid covering [-1, 1] on the xy plane, one quad per cell
+  uint32_t side = static_cast<uint32_t>(
+      std::ceil(std::sqrt(static_cast<double>(instance_count_))));
+  float cell = 2.0f / static_cast<float>(side);
+
+  instance_transforms_.Resize(instance_count_);
+  std::vector<InstanceData> instances(instance_count_);
+  for (uint32_t i = 0; i < instance_count_; ++i) {
+    float u = (static_cast<float>(i % side) + 0.5f) / static_cast<float>(side);
+    float v = (static_cast<float>(i / side) + 0.5f) / static_cast<float>(side);
+
+    instance_transforms_.Set(
+        i, glm::vec3(-1.0f + 2.0f * u, -1.0f + 2.0f * v, 0.0f),
+        glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(cell * 0.5f));
+    // a single instance keeps the original vertex colors
+    instances[i].color = 1 == instance_count_
+                             ? glm::vec4(1.0f)
+                             : glm::vec4(0.25f + 0.75f * u, 0.25f + 0.75f * v,
+                                         1.0f - 0.75f * u, 1.0f);
+  }
+  instance_transforms_.WriteModels(0, instance_count_, &instances[0].model,
+                                   sizeof(InstanceData));
+  instance_animation_time_ = 0.0f;
+
+  VkDeviceSize buffer_size = sizeof(InstanceData) * instances.size();
+
+  if (dynamic_instances_) {
+    // written by the CPU every frame, the colors only here
+    instance_buffers_.resize(frames_in_flight_);
+    instance_buffers_memory_.resize(frames_in_flight_);
+    instance_buffer_times_.assign(frames_in_flight_, 0.0f);
+    for (size_t i = 0; i < frames_in_flight_; ++i) {
+      CreateBuffer(buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                   instance_buffers_[i], instance_buffers_memory_[i],
+                   VK_NULL_HANDLE != compute_queue_);
+      memcpy(instance_buffers_memory_[i].mapped, instances.data(),
+             buffer_size);
+    }
+  } else {
+    // only read by the cull pass, which copies the visible ones out
+    CreateBuffer(
+        buffer_size,
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, instance_buffer_,
+        instance_buffer_memory_);
+
+    upload_context_.UploadBuffer(instances.data(), buffer_size,
+                                 instance_buffer_, 0,
+                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_ACCESS_SHADER_READ_BIT);
+  }
+
+  std::clog << "----- Scene: " << instance_count_ << " instance(s)"
+            << (dynamic_instances_
+                    ? std::string{", dynamic with "} +
+                          TransformStore::GetKernelName()
+                    : std::string{})
+            << " -----" << std::endl;
+}
+
+void Application::CreateCullBuffers() {
+  VkDeviceSize instances_size = sizeof(InstanceData) * instance_count_;
+  // chunk c draws instances [c, c + 1) * SCENE_CHUNK_INSTANCES
+  scene_chunk_count_ =
+      (instance_count_ + SCENE_CHUNK_INSTANCES - 1) / SCENE_CHUNK_INSTANCES;
+  scene_chunk_count_ = std::max(scene_chunk_count_, 1u);
+  VkDeviceSize draws_size = sizeof(IndirectDraw) * scene_chunk_count_;
+
+  visible_instance_buffers_.resize(frames_in_flight_);
+  visible_instance_buffers_memory_.resize(frames_in_flight_);
+  indirect_buffers_.resize(frames_in_flight_);
+  indirect_buffers_memory_.resize(frames_in_flight_);
+
+  for (size_t i = 0; i < frames_in_flight_; i++) {
+    CreateBuffer(instances_size,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                 visible_instance_buffers_[i],
+                 visible_instance_buffers_memory_[i]);
+    CreateBuffer(draws_size,
+                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                     VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                     VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirect_buffers_[i],
+                 indirect_buffers_memory_[i]);
+  }
+
+  std::clog << "----- Cull: " << scene_chunk_count_ << " chunk(s), "
+            << (device_features_.draw_indirect_count
+                    ? "vkCmdDrawIndexedIndirectCountKHR"
+                    : "vkCmdDrawIndexedIndirect")
+            << " -----" << std::endl;
+}
+
+void Application::CreateRenderGraph() {
+  // frames in flight still execute the previous one
+  if (render_graph_) {
+    deletion_queue_.Retire([old = render_graph_]() { old->Destroy(); });
+  }
+  render_graph_ = std::make_shared<RenderGraph>();
+  RenderGraph& graph = *render_graph_;
+  uint32_t graphics_family = queue_faimlies_.graphics_family.value();
+  graph.Init(device_, allocator_, device_features_.synchronization2,
+             graphics_family,
+             VK_NULL_HANDLE != compute_queue_
+                 ? queue_faimlies_.compute_family.value()
+                 : graphics_family);
+
+  RenderResource swap_chain = graph.ImportImage(
+      "Swap Chain", swap_chain_images_, VK_IMAGE_ASPECT_COLOR_BIT,
+      ACQUIRE_ACCESS, PRESENT_ACCESS);
+  // one of each per frame in flight, picked by the passes
+  RenderResource draws =
+      graph.CreateBuffer("Draw Commands", indirect_buffers_);
+  RenderResource visible =
+      graph.CreateBuffer("Visible Instances", visible_instance_buffers_);
+
+  // culling of this frame overlaps the previous frame's graphics work on
+  // the compute queue, its outputs are handed over to the graphics family
+
+  // zero counts for every chunk, the shader fills in the rest of the command
+  // of chunks with visible instances
+  graph.AddPass("Cull Reset", "Cull")
+      .SetQueue(RenderQueue::ASYNC_COMPUTE)
+      .Write(draws, TRANSFER_WRITE)
+      .SetRecord([this](VkCommandBuffer command_buffer,
+                        const RenderGraphFrame& frame) {
+        vkCmdFillBuffer(command_buffer, indirect_buffers_[frame.frame], 0,
+                        VK_WHOLE_SIZE, 0);
+      });
+  // compute culling writes this frame's visible instances and draw commands
+  graph.AddPass("Cull", "Cull")
+      .SetQueue(RenderQueue::ASYNC_COMPUTE)
+      .ReadWrite(draws, COMPUTE_STORAGE_READ_WRITE)
+      .Write(visible, COMPUTE_STORAGE_WRITE)
+      .SetRecord([this](VkCommandBuffer command_buffer,
+                        const RenderGraphFrame&) {
+        RecordCullPass(command_buffer);
+      });
+
+  // in chunk order
+  post_process_
+      .AddScenePass(graph, swap_chain_extent_,
+                    [this](VkCommandBuffer command_buffer,
+                           const RenderGraphFrame&) {
+                      vkCmdExecuteCommands(
+                          command_buffer,
+                          static_cast<uint32_t>(scene_secondaries_.size()),
+                          scene_secondaries_.data());
+                    })
+      .Read(draws, INDIRECT_READ)
+      .Read(visible, VERTEX_INPUT_READ);
+
+  // bloom, tonemap and FXAA into the swap chain image
+  post_process_.AddPasses(graph, swap_chain, swap_chain_image_format_,
+                          swap_chain_images_, swap_chain_storage_);
+
+  // loads the post processed image, ImGui on top
+  graph.AddPass("ImGui")
+      .ReadWrite(swap_chain, COLOR_ATTACHMENT_ACCESS)
+      .SetRecord([this](VkCommandBuffer command_buffer,
+                        const RenderGraphFrame& frame) {
+        if (device_features_.dynamic_rendering) {
+          RecordDynamicImGuiPass(command_buffer, frame.image_index,
+                                 imgui_secondary_);
+          return;
+        }
+
+        VkRenderPassBeginInfo imgui_pass_info{};
+        imgui_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        imgui_pass_info.renderPass = render_pass_;
+        imgui_pass_info.framebuffer =
+            swap_chain_framebuffers_[frame.image_index];
+        imgui_pass_info.renderArea.offset = {0, 0};
+        imgui_pass_info.renderArea.extent = swap_chain_extent_;
+
+        vkCmdBeginRenderPass(command_buffer, &imgui_pass_info,
+                             VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        vkCmdExecuteCommands(command_buffer, 1, &imgui_secondary_);
+        vkCmdEndRenderPass(command_buffer);
+      });
+
+  graph.Compile();
+  post_process_.Bind(graph, swap_chain_image_views_);
 }
 
 void Application::CreateUniformBuffers() {
   VkDeviceSize buffer_size = sizeof(UniformBufferObject);
 
-  uniform_buffers_.resize(MAX_FRAMES_IN_FLIGHT);
-  uniform_buffers_memory_.resize(MAX_FRAMES_IN_FLIGHT);
-  uniform_buffers_mapped_.resize(MAX_FRAMES_IN_FLIGHT);
+  uniform_buffers_.resize(frames_in_flight_);
+  uniform_buffers_memory_.resize(frames_in_flight_);
+  uniform_buffers_mapped_.resize(frames_in_flight_);
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+  // the cull pass reads it on the compute queue, the draws on the graphics
+  // one, in the same frame
+  for (size_t i = 0; i < frames_in_flight_; i++) {
     CreateBuffer(buffer_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 uniform_buffers_[i], uniform_buffers_memory_[i]);
+                 uniform_buffers_[i], uniform_buffers_memory_[i],
+                 VK_NULL_HANDLE != compute_queue_);
 
-    vkMapMemory(device_, uniform_buffers_memory_[i], 0, buffer_size, 0,
-                &uniform_buffers_mapped_[i]);
+    uniform_buffers_mapped_[i] = uniform_buffers_memory_[i].mapped;
   }
 }
 
 void Application::CreateSyncObjects() {
-  image_available_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-  render_finished_semaphores_.resize(MAX_FRAMES_IN_FLIGHT);
+  image_available_semaphores_.resize(frames_in_flight_);
+  render_finished_semaphores_.resize(frames_in_flight_);
 
   VkSemaphoreCreateInfo semaphore_info{};
   semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+  for (size_t i = 0; i < frames_in_flight_; ++i) {
     if (VK_SUCCESS != vkCreateSemaphore(device_, &semaphore_info, nullptr,
                                         &image_available_semaphores_[i]) ||
         VK_SUCCESS != vkCreateSemaphore(device_, &semaphore_info, nullptr,
@@ -959,25 +2627,56 @@ void Application::CreateSyncObjects() {
     }
   }
 
-  in_flight_fences_.resize(MAX_FRAMES_IN_FLIGHT);
-
-  VkFenceCreateInfo fence_info{};
-  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-  for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-    if (VK_SUCCESS !=
-        vkCreateFence(device_, &fence_info, nullptr, &in_flight_fences_[i])) {
-      throw std::runtime_error("Error::Vulkan: Failed to create fences -----");
+  if (VK_NULL_HANDLE != compute_queue_) {
+    async_compute_semaphores_.resize(frames_in_flight_);
+    for (auto& semaphore : async_compute_semaphores_) {
+      if (VK_SUCCESS !=
+          vkCreateSemaphore(device_, &semaphore_info, nullptr, &semaphore)) {
+        throw std::runtime_error(
+            "----- Error::Vulkan: Failed to create async compute semaphores "
+            "-----");
+      }
     }
   }
+
+  // nothing submitted yet, 0 is always complete
+  frame_timeline_values_.assign(frames_in_flight_, 0);
+}
+
+void Application::HandOffInstanceBuffer() {
+  // release: the upload made it visible to compute shaders already
+  VkBufferMemoryBarrier barrier = InstanceBufferTransfer();
+  VkCommandBuffer release = BeginSingleTimeCommands();
+  vkCmdPipelineBarrier(release, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1,
+                       &barrier, 0, nullptr, 0, nullptr);
+  EndSingleTimeCommands(release);
+
+  // the CPU waited for the release, the queues need no semaphore between
+  // them for the acquire
+  instance_buffer_acquire_ = true;
+}
+
+VkBufferMemoryBarrier Application::InstanceBufferTransfer() const {
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcQueueFamilyIndex = queue_faimlies_.graphics_family.value();
+  barrier.dstQueueFamilyIndex = queue_faimlies_.compute_family.value();
+  barrier.buffer = instance_buffer_;
+  barrier.offset = 0;
+  barrier.size = VK_WHOLE_SIZE;
+
+  return barrier;
 }
 
 void Application::RecordCommandBuffer(VkCommandBuffer command_buffer,
-                                      uint32_t image_index) {
+                                      uint32_t image_index,
+                                      ImDrawData* draw_data) {
+  TRACE_SCOPE("RecordCommandBuffer");
+
   VkCommandBufferBeginInfo begin_info{};
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  begin_info.flags = 0;                   // Optional
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
   begin_info.pInheritanceInfo = nullptr;  // Optional
 
   if (VK_SUCCESS != vkBeginCommandBuffer(command_buffer, &begin_info)) {
@@ -985,20 +2684,223 @@ void Application::RecordCommandBuffer(VkCommandBuffer command_buffer,
         "----- Error::Vulkan: Failed to begin recording command buffer -----");
   }
 
-  VkRenderPassBeginInfo render_pass_info{};
-  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-  render_pass_info.renderPass = render_pass_;
-  render_pass_info.framebuffer = swap_chain_framebuffers_[image_index];
-  render_pass_info.renderArea.offset = {0, 0};
-  render_pass_info.renderArea.extent = swap_chain_extent_;
+  gpu_profiler_.BeginFrame(command_buffer, current_frame);
+  uint32_t frame_scope = gpu_profiler_.BeginScope(command_buffer, "Frame");
+
+  // the render passes only execute secondaries, timestamps go into them
+  uint32_t scene_scope = gpu_profiler_.ReserveScope("Scene");
+  uint32_t imgui_scope = gpu_profiler_.ReserveScope("ImGui");
+
+  // the scene goes to the offscreen HDR target, ImGui to the swap chain
+  // image after post processing
+  VkCommandBufferInheritanceInfo scene_inheritance{};
+  scene_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  scene_inheritance.renderPass = post_process_.GetSceneRenderPass();
+  scene_inheritance.subpass = 0;
+  scene_inheritance.framebuffer = post_process_.GetSceneFramebuffer();
+
+  VkCommandBufferInheritanceInfo imgui_inheritance{};
+  imgui_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  imgui_inheritance.renderPass = render_pass_;
+  imgui_inheritance.subpass = 0;
+
+  // dynamic rendering: the secondaries only know the attachment formats
+  VkCommandBufferInheritanceRenderingInfoKHR scene_rendering{};
+  scene_rendering.sType =
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+  scene_rendering.colorAttachmentCount = 1;
+  scene_rendering.pColorAttachmentFormats = &HDR_COLOR_FORMAT;
+  scene_rendering.depthAttachmentFormat = post_process_.GetDepthFormat();
+  scene_rendering.rasterizationSamples = post_process_.GetSampleCount();
+
+  VkCommandBufferInheritanceRenderingInfoKHR imgui_rendering{};
+  imgui_rendering.sType =
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+  imgui_rendering.colorAttachmentCount = 1;
+  imgui_rendering.pColorAttachmentFormats = &swap_chain_image_format_;
+  imgui_rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  if (device_features_.dynamic_rendering) {
+    scene_inheritance.pNext = &scene_rendering;
+    imgui_inheritance.pNext = &imgui_rendering;
+  } else {
+    imgui_inheritance.framebuffer = swap_chain_framebuffers_[image_index];
+  }
+
+  // may write the legacy set, so not from the jobs
+  VkDescriptorSet bindless_set = bindless_table_.Prepare(current_frame);
+
+  // contiguous chunk ranges, at most one per recording thread
+  uint32_t task_cnt =
+      std::min(scene_chunk_count_, job_system_.ThreadCount() + 1);
+  std::vector<VkCommandBuffer> secondaries(task_cnt, VK_NULL_HANDLE);
+  VkCommandBuffer imgui_secondary = VK_NULL_HANDLE;
+
+  JobCounter counter{};
+  for (uint32_t task = 0; task < task_cnt; ++task) {
+    job_system_.Schedule(
+        [this, &scene_inheritance, &secondaries, bindless_set, task, task_cnt,
+         scene_scope]() {
+          TRACE_SCOPE("RecordSceneChunks");
+
+          uint32_t begin = scene_chunk_count_ * task / task_cnt;
+          uint32_t end = scene_chunk_count_ * (task + 1) / task_cnt;
+
+          VkCommandBuffer secondary =
+              BeginSecondaryCommandBuffer(scene_inheritance);
+          if (0 == task) {
+            gpu_profiler_.WriteBegin(secondary, scene_scope);
+          }
+          RecordSceneChunks(secondary, bindless_set, begin, end);
+          if (task_cnt - 1 == task) {
+            gpu_profiler_.WriteEnd(secondary, scene_scope);
+          }
+
+          if (VK_SUCCESS != vkEndCommandBuffer(secondary)) {
+            throw std::runtime_error(
+                "----- Error::Vulkan: Failed to record secondary command "
+                "buffer -----");
+          }
+          secondaries[task] = secondary;
+        },
+        &counter);
+  }
+
+  // imgui: record the snapshot's draw data while the workers record the
+  // scene
+  try {
+    TRACE_SCOPE("RecordImGui");
+
+    VkCommandBuffer secondary = BeginSecondaryCommandBuffer(imgui_inheritance);
+    gpu_profiler_.WriteBegin(secondary, imgui_scope);
+    imgui_renderer_.Record(secondary, current_frame, draw_data);
+    gpu_profiler_.WriteEnd(secondary, imgui_scope);
+
+    if (VK_SUCCESS != vkEndCommandBuffer(secondary)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to record secondary command buffer "
+          "-----");
+    }
+    imgui_secondary = secondary;
+  } catch (...) {
+    // the jobs reference this stack frame
+    job_system_.Wait(counter);
+    throw;
+  }
+
+  job_system_.Wait(counter);
+
+  // jobs report their exceptions and carry on, a missing buffer is fatal
+  if (std::find(secondaries.begin(), secondaries.end(), VK_NULL_HANDLE) !=
+      secondaries.end()) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to record scene chunks -----");
+  }
 
-  VkClearValue clear_color = {{{0.0f, 0.0f, 0.0f, 1.0f}}};
-  render_pass_info.clearValueCount = 1;
-  render_pass_info.pClearValues = &clear_color;
+  // cull, scene, post process and ImGui with the barriers between them
+  scene_secondaries_ = std::move(secondaries);
+  imgui_secondary_ = imgui_secondary;
+  render_graph_->Execute(command_buffer, {current_frame, image_index},
+                         gpu_profiler_);
 
-  vkCmdBeginRenderPass(command_buffer, &render_pass_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
+  gpu_profiler_.EndScope(command_buffer, frame_scope);
+
+  if (VK_SUCCESS != vkEndCommandBuffer(command_buffer)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to record command buffer -----");
+  }
+}
+
+void Application::RecordAsyncCommandBuffer(VkCommandBuffer command_buffer,
+                                           uint32_t image_index) {
+  TRACE_SCOPE("RecordAsyncCommandBuffer");
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (VK_SUCCESS != vkBeginCommandBuffer(command_buffer, &begin_info)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to begin recording async compute "
+        "command buffer -----");
+  }
+
+  // once, ahead of the first cull pass reading the instances
+  if (instance_buffer_acquire_) {
+    VkBufferMemoryBarrier barrier = InstanceBufferTransfer();
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         1, &barrier, 0, nullptr, 0, nullptr);
+    instance_buffer_acquire_ = false;
+  }
+
+  async_profiler_.BeginFrame(command_buffer, current_frame);
+  uint32_t frame_scope =
+      async_profiler_.BeginScope(command_buffer, "Async Compute");
+
+  render_graph_->ExecuteAsync(command_buffer, {current_frame, image_index},
+                              async_profiler_);
+
+  async_profiler_.EndScope(command_buffer, frame_scope);
+
+  if (VK_SUCCESS != vkEndCommandBuffer(command_buffer)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to record async compute command buffer "
+        "-----");
+  }
+}
+
+void Application::RecordDynamicImGuiPass(VkCommandBuffer command_buffer,
+                                         uint32_t image_index,
+                                         VkCommandBuffer secondary) {
+  VkRenderingAttachmentInfoKHR color_attachment{};
+  color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+  color_attachment.imageView = swap_chain_image_views_[image_index];
+  color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+  color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+  VkRenderingInfoKHR rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+  rendering_info.flags =
+      VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+  rendering_info.renderArea.offset = {0, 0};
+  rendering_info.renderArea.extent = swap_chain_extent_;
+  rendering_info.layerCount = 1;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachments = &color_attachment;
+
+  cmd_begin_rendering_(command_buffer, &rendering_info);
+  vkCmdExecuteCommands(command_buffer, 1, &secondary);
+  cmd_end_rendering_(command_buffer);
+}
+
+VkCommandBuffer Application::BeginSecondaryCommandBuffer(
+    const VkCommandBufferInheritanceInfo& inheritance) {
+  VkCommandBuffer command_buffer = frame_command_pools_.Allocate(
+      current_frame, job_system_.ThreadIndex(),
+      VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                     VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+  begin_info.pInheritanceInfo = &inheritance;
+
+  if (VK_SUCCESS != vkBeginCommandBuffer(command_buffer, &begin_info)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to begin recording secondary command "
+        "buffer -----");
+  }
+
+  return command_buffer;
+}
 
+void Application::RecordSceneChunks(VkCommandBuffer command_buffer,
+                                    VkDescriptorSet bindless_set,
+                                    uint32_t begin, uint32_t end) {
+  // nothing is inherited from the primary but the render pass
   vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
                     graphics_pipeline_);
 
@@ -1016,45 +2918,106 @@ void Application::RecordCommandBuffer(VkCommandBuffer command_buffer,
   scissor.extent = swap_chain_extent_;
   vkCmdSetScissor(command_buffer, 0, 1, &scissor);
 
-  VkBuffer vertex_buffers[] = {vertex_buffer_};
-  VkDeviceSize offsets[] = {0};
-  vkCmdBindVertexBuffers(command_buffer, 0, 1, vertex_buffers, offsets);
-  vkCmdBindIndexBuffer(command_buffer, index_buffer_, 0, VK_INDEX_TYPE_UINT16);
+  vkCmdBindIndexBuffer(command_buffer, index_buffer_, 0, index_type_);
 
+  std::array<VkDescriptorSet, 2> descriptor_sets{
+      descriptor_sets_[current_frame], bindless_set};
   vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          pipeline_layout_, 0, 1,
-                          &descriptor_sets_[current_frame], 0, nullptr);
-
-  vkCmdDrawIndexed(command_buffer, static_cast<uint32_t>(indices_.size()), 1, 0,
-                   0, 0);
-
-  // imgui: record draw data and funcs into command buffer
-  ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), command_buffer);
-
-  vkCmdEndRenderPass(command_buffer);
-
-  if (VK_SUCCESS != vkEndCommandBuffer(command_buffer)) {
-    throw std::runtime_error(
-        "----- Error::Vulkan: Failed to record command buffer -----");
+                          pipeline_layout_, 0,
+                          static_cast<uint32_t>(descriptor_sets.size()),
+                          descriptor_sets.data(), 0, nullptr);
+
+  DrawPushConstants draw{scene_model_, scene_texture_index_};
+  vkCmdPushConstants(command_buffer, pipeline_layout_,
+                     VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                     0, sizeof(draw), &draw);
+
+  VkBuffer indirect_buffer = indirect_buffers_[current_frame];
+  for (uint32_t chunk = begin; chunk < end; ++chunk) {
+    // the chunk's visible instances start at its first slot, so every draw
+    // keeps firstInstance at 0
+    VkBuffer vertex_buffers[] = {vertex_buffer_,
+                                 visible_instance_buffers_[current_frame]};
+    VkDeviceSize offsets[] = {
+        0, sizeof(InstanceData) * SCENE_CHUNK_INSTANCES * chunk};
+    vkCmdBindVertexBuffers(command_buffer, 0, 2, vertex_buffers, offsets);
+
+    // instance count comes from the cull pass
+    VkDeviceSize draw_offset = sizeof(IndirectDraw) * chunk;
+    if (device_features_.draw_indirect_count) {
+      cmd_draw_indexed_indirect_count_(
+          command_buffer, indirect_buffer, draw_offset, indirect_buffer,
+          draw_offset + offsetof(IndirectDraw, draw_count), 1,
+          sizeof(IndirectDraw));
+    } else {
+      vkCmdDrawIndexedIndirect(command_buffer, indirect_buffer, draw_offset,
+                               1, sizeof(IndirectDraw));
+    }
   }
 }
 
+void Application::RecordCullPass(VkCommandBuffer command_buffer) {
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    compute_pipeline_);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          compute_pipeline_layout_, 0, 1,
+                          &compute_descriptor_sets_[current_frame], 0,
+                          nullptr);
+
+  // LOD 0 is the full detail mesh
+  CullPushConstants push_constants{scene_model_,
+                                   instance_count_,
+                                   mesh_bounding_radius_,
+                                   mesh_lods_[0].index_count,
+                                   mesh_lods_[0].first_index,
+                                   SCENE_CHUNK_INSTANCES};
+  vkCmdPushConstants(command_buffer, compute_pipeline_layout_,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push_constants),
+                     &push_constants);
+
+  // matches local_size_x in cull.comp
+  const uint32_t group_size = 64;
+  vkCmdDispatch(command_buffer, (instance_count_ + group_size - 1) / group_size,
+                1, 1);
+}
+
 void Application::RecreateSwapChain() {
-  int width = 0, height = 0;
-  glfwGetFramebufferSize(window_, &width, &height);
+  TRACE_SCOPE("RecreateSwapChain");
 
-  while (width == 0 || height == 0) {
-    glfwGetFramebufferSize(window_, &width, &height);
-    glfwWaitEvents();
+  // minimized, the main thread publishes nothing until the window is back
+  // and the next frame tries again
+  if (0 == framebuffer_width_ || 0 == framebuffer_height_) {
+    return;
   }
 
-  vkDeviceWaitIdle(device_);
-
-  CleanupSwapChain();
+  // frames already submitted keep using the old swap chain, it goes away
+  // once they have finished instead of draining the device here; there is
+  // no signal for the presentation engine releasing the old images, give
+  // them another round of frames in flight
+  uint64_t last_use = gpu_timeline_.GetSubmittedValue() + frames_in_flight_;
+  VkSwapchainKHR old_swap_chain = swap_chain_;
+  std::vector<VkImageView> old_image_views{};
+  old_image_views.swap(swap_chain_image_views_);
+  std::vector<VkFramebuffer> old_framebuffers{};
+  old_framebuffers.swap(swap_chain_framebuffers_);
 
   CreateSwapChain();
   CreateImageViews();
   CreateFrameBuffers();
+  CreateRenderGraph();
+
+  deletion_queue_.Retire(
+      last_use, [device = device_, old_swap_chain,
+                 old_image_views = std::move(old_image_views),
+                 old_framebuffers = std::move(old_framebuffers)]() {
+        for (auto framebuffer : old_framebuffers) {
+          vkDestroyFramebuffer(device, framebuffer, nullptr);
+        }
+        for (auto image_view : old_image_views) {
+          vkDestroyImageView(device, image_view, nullptr);
+        }
+        vkDestroySwapchainKHR(device, old_swap_chain, nullptr);
+      });
 }
 
 void Application::CleanupSwapChain() {
@@ -1069,31 +3032,45 @@ void Application::CleanupSwapChain() {
   vkDestroySwapchainKHR(device_, swap_chain_, nullptr);
 }
 
-void Application::DrawFrame() {
-  // wait for fence to be signaled
-  vkWaitForFences(device_, 1, &in_flight_fences_[current_frame], VK_TRUE,
-                  UINT64_MAX);
+void Application::DrawFrame(FrameSnapshot& snapshot) {
+  TRACE_SCOPE("DrawFrame");
 
-  // imgui: new frame
-  ImGui_ImplVulkan_NewFrame();
-  ImGui_ImplGlfw_NewFrame();
-  ImGui::NewFrame();
-  ImGui::ShowDemoWindow();
-  ImGui::Render();
+  // a new present mode only needs a new swap chain
+  if (present_mode_changed_.exchange(false)) {
+    RecreateSwapChain();
+  }
+  bool paced = frame_limiter_ && IsFifo(swap_chain_present_mode_);
+  frames_paced_ = paced;
 
-  // imgui: update and render additional Platform Windows
-  ImGuiIO& imgui_io = ImGui::GetIO();
-  (void)imgui_io;
-  if (imgui_io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
-    ImGui::UpdatePlatformWindows();
-    ImGui::RenderPlatformWindowsDefault();
+  // swaps in pipelines rebuilt from edited shaders
+  ReloadPipelines();
+
+  // wait for the frame slot's previous submission
+  {
+    TRACE_SCOPE("WaitForFrame");
+    gpu_timeline_.WaitForValue(frame_timeline_values_[current_frame]);
+  }
+
+  // release staging memory of uploads the GPU has finished
+  upload_context_.CollectCompleted();
+  // and whatever retired frames were the last to use
+  deletion_queue_.Collect();
+
+  // timestamps this frame slot wrote last time around are ready now
+  gpu_profiler_.Collect(current_frame);
+  if (VK_NULL_HANDLE != compute_queue_) {
+    async_profiler_.Collect(current_frame);
   }
 
   // grab an image from swap chain, and then signaled image available semaphore
   uint32_t image_index;
-  VkResult result = vkAcquireNextImageKHR(
-      device_, swap_chain_, UINT64_MAX,
-      image_available_semaphores_[current_frame], VK_NULL_HANDLE, &image_index);
+  VkResult result = VK_SUCCESS;
+  {
+    TRACE_SCOPE("AcquireNextImage");
+    result = vkAcquireNextImageKHR(device_, swap_chain_, UINT64_MAX,
+                                   image_available_semaphores_[current_frame],
+                                   VK_NULL_HANDLE, &image_index);
+  }
 
   if (VK_ERROR_OUT_OF_DATE_KHR == result) {
     RecreateSwapChain();
@@ -1104,40 +3081,81 @@ void Application::DrawFrame() {
   }
 
   // update UBO
-  UpdateUniformBuffer(current_frame);
-
-  // only reset fence to unsignaled if we are submitting work
-  vkResetFences(device_, 1, &in_flight_fences_[current_frame]);
-
-  // make sure command buffer is ready to use
-  vkResetCommandBuffer(command_buffers_[current_frame], 0);
-  // // create and record command buffer
-  RecordCommandBuffer(command_buffers_[current_frame], image_index);
+  UpdateUniformBuffer(current_frame, snapshot);
+  if (dynamic_instances_) {
+    UpdateInstanceTransforms(current_frame, snapshot);
+  }
+
+  // the frame's previous command buffers have retired, recycle them all;
+  // its graphics submission waited for the async compute one
+  frame_command_pools_.Reset(current_frame);
+  bool async_compute = render_graph_->HasAsyncPasses();
+  VkCommandBuffer async_command_buffer = VK_NULL_HANDLE;
+  if (async_compute) {
+    compute_command_pools_.Reset(current_frame);
+    async_command_buffer = compute_command_pools_.Allocate(
+        current_frame, 0, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    RecordAsyncCommandBuffer(async_command_buffer, image_index);
+  }
+  VkCommandBuffer command_buffer = frame_command_pools_.Allocate(
+      current_frame, job_system_.ThreadIndex(),
+      VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+  RecordCommandBuffer(command_buffer, image_index, snapshot.draw_data.Get());
 
   // wait image available semaphore, then signaled render finished semaphore
   VkSubmitInfo submit_info{};
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-  VkSemaphore wait_semaphores[] = {image_available_semaphores_[current_frame]};
+  // and for the async compute passes where the graph acquires their output
+  VkSemaphore wait_semaphores[] = {
+      image_available_semaphores_[current_frame],
+      async_compute ? async_compute_semaphores_[current_frame]
+                    : VK_NULL_HANDLE};
   VkPipelineStageFlags wait_stages[] = {
-      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submit_info.waitSemaphoreCount = 1;
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      render_graph_->GetAsyncWaitStages()};
+  submit_info.waitSemaphoreCount = async_compute ? 2 : 1;
   submit_info.pWaitSemaphores = wait_semaphores;
   submit_info.pWaitDstStageMask = wait_stages;
 
   submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_buffers_[current_frame];
+  submit_info.pCommandBuffers = &command_buffer;
 
   VkSemaphore signal_semaphores[] = {
       render_finished_semaphores_[current_frame]};
   submit_info.signalSemaphoreCount = 1;
   submit_info.pSignalSemaphores = signal_semaphores;
 
-  // submit graphics queue, then signaled fence
-  if (VK_SUCCESS != vkQueueSubmit(graphics_queue_, 1, &submit_info,
-                                  in_flight_fences_[current_frame])) {
-    throw std::runtime_error(
-        "----- Error::Vulkan: Failed to submit draw command buffer -----");
+  {
+    TRACE_SCOPE("QueueSubmit");
+
+    // flush uploads recorded during the frame, they execute ahead of it but
+    // the frame never waits for them on the CPU
+    upload_context_.Submit();
+
+    // the frame slot is free again once its value is reached
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+
+    // off the timeline: the graphics submission waits for it, so the
+    // frame's value covers both
+    if (async_compute) {
+      VkSubmitInfo async_submit_info{};
+      async_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      async_submit_info.commandBufferCount = 1;
+      async_submit_info.pCommandBuffers = &async_command_buffer;
+      async_submit_info.signalSemaphoreCount = 1;
+      async_submit_info.pSignalSemaphores =
+          &async_compute_semaphores_[current_frame];
+
+      if (VK_SUCCESS != vkQueueSubmit(compute_queue_, 1, &async_submit_info,
+                                      VK_NULL_HANDLE)) {
+        throw std::runtime_error(
+            "----- Error::Vulkan: Failed to submit async compute -----");
+      }
+    }
+
+    frame_timeline_values_[current_frame] =
+        gpu_timeline_.Submit(graphics_queue_, submit_info);
   }
 
   VkPresentInfoKHR present_info{};
@@ -1153,17 +3171,62 @@ void Application::DrawFrame() {
 
   present_info.pResults = nullptr;
 
-  result = vkQueuePresentKHR(present_queue_, &present_info);
-
+  // snapshot indices only grow, as present ids of a swap chain have to
+  uint64_t present_id = snapshot.index;
+  VkPresentIdKHR present_id_info{};
+  present_id_info.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+  present_id_info.swapchainCount = 1;
+  present_id_info.pPresentIds = &present_id;
+  if (device_features_.present_wait) {
+    present_info.pNext = &present_id_info;
+  }
+
+  {
+    TRACE_SCOPE("QueuePresent");
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    result = vkQueuePresentKHR(present_queue_, &present_info);
+  }
+
+  if (0.0 == first_frame_ms_ &&
+      (VK_SUCCESS == result || VK_SUBOPTIMAL_KHR == result)) {
+    first_frame_ms_ = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - startup_time_)
+                          .count();
+    std::clog << "----- Startup: first frame presented after "
+              << first_frame_ms_ << " ms -----" << std::endl;
+  }
+
+  // the frame limiter: the main thread samples input for the next frame
+  // once this returns
+  bool displayed = false;
+  if (paced && device_features_.present_wait &&
+      (VK_SUCCESS == result || VK_SUBOPTIMAL_KHR == result)) {
+    TRACE_SCOPE("WaitForPresent");
+    displayed = VK_SUCCESS == wait_for_present_(device_, swap_chain_,
+                                                present_id,
+                                                PRESENT_WAIT_TIMEOUT);
+  } else if (paced) {
+    // without present wait, the GPU finishing the frame is the closest
+    TRACE_SCOPE("WaitForFrame");
+    gpu_timeline_.WaitForValue(frame_timeline_values_[current_frame]);
+  }
+
+  gpu_profiler_.AddLatency(std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() -
+                               snapshot.input_time)
+                               .count(),
+                           displayed);
+
+  bool resized = framebuffer_resized.exchange(false);
   if (VK_ERROR_OUT_OF_DATE_KHR == result || VK_SUBOPTIMAL_KHR == result ||
-      framebuffer_resized) {
+      resized) {
     RecreateSwapChain();
   } else if (VK_SUCCESS != result) {
     throw std::runtime_error(
         "----- Error::Vulkan: Failed to present image -----");
   }
 
-  current_frame = (current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+  current_frame = (current_frame + 1) % frames_in_flight_;
 }
 
 void Application::FindInstanceExtensions(
@@ -1255,22 +3318,11 @@ int Application::EvaluateDevice(VkPhysicalDevice device) {
   VkPhysicalDeviceFeatures device_features{};
   vkGetPhysicalDeviceFeatures(device, &device_features);
 
-  int score = 0;
-
-  if (VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU == device_properties.deviceType) {
-    score += 1000;
-  }
-  score += device_properties.limits.maxImageDimension2D;
-
-  if (!device_features.geometryShader) {
-    score = 1;
-  }
+  // required: a device without these scores 0 and is never picked
 
   // physical device queue family support
   QueueFamilies queue_faimlies = FindQueueFaimilies(device);
-  if (!queue_faimlies.IsCompleted()) {
-    score = 0;
-  }
+  bool suitable = queue_faimlies.IsCompleted();
 
   // physical device extension support
   std::vector<const char*> required_extensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -1286,19 +3338,101 @@ int Application::EvaluateDevice(VkPhysicalDevice device) {
   vkEnumerateDeviceExtensionProperties(
       device, nullptr, &available_extension_cnt, available_extensions.data());
 
-  if (!CheckExtensionSupport(available_extensions, required_extensions)) {
-    score = 0;
+  suitable = suitable &&
+             CheckExtensionSupport(available_extensions, required_extensions);
+
+  // physical device swap chain support, queried last as it needs the
+  // extension
+  suitable = suitable && QuerySwapChainSupoort(device).IsAdequate();
+
+  // preferred: what the renderer runs faster with, chained only when the
+  // device knows the structures
+  bool core_1_2 = device_properties.apiVersion >= VK_API_VERSION_1_2;
+  std::vector<const char*> timeline_semaphore{
+      VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME};
+  std::vector<const char*> descriptor_indexing{
+      VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
+  std::vector<const char*> dynamic_rendering{
+      VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME};
+
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+  timeline_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  if (core_1_2 ||
+      CheckExtensionSupport(available_extensions, timeline_semaphore)) {
+    timeline_features.pNext = features.pNext;
+    features.pNext = &timeline_features;
+  }
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{};
+  indexing_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  if (core_1_2 ||
+      CheckExtensionSupport(available_extensions, descriptor_indexing)) {
+    indexing_features.pNext = features.pNext;
+    features.pNext = &indexing_features;
+  }
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+  dynamic_rendering_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  if (CheckExtensionSupport(available_extensions, dynamic_rendering)) {
+    dynamic_rendering_features.pNext = features.pNext;
+    features.pNext = &dynamic_rendering_features;
+  }
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  int type_score = 0;
+  if (VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU == device_properties.deviceType) {
+    type_score = 2000;
+  } else if (VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU ==
+             device_properties.deviceType) {
+    type_score = 1000;
   }
 
-  // physical device swap chain support
-  SwapChainSupportDetails details = QuerySwapChainSupoort(device);
+  int feature_score = 0;
+  if (timeline_features.timelineSemaphore) {
+    feature_score += 500;
+  }
+  if (indexing_features.descriptorBindingPartiallyBound &&
+      indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+      indexing_features.descriptorBindingStorageBufferUpdateAfterBind) {
+    feature_score += 500;
+  }
+  if (dynamic_rendering_features.dynamicRendering) {
+    feature_score += 500;
+  }
+  // the post process chain can write the swap chain instead of blitting
+  if (device_features.shaderStorageImageWriteWithoutFormat) {
+    feature_score += 250;
+  }
 
-  if (!details.IsAdequate()) {
-    score = 0;
+  // uploads and async compute that don't queue behind the frame
+  int queue_score = 0;
+  if (queue_faimlies.transfer_family.has_value()) {
+    queue_score += 250;
+  }
+  if (queue_faimlies.compute_family.has_value()) {
+    queue_score += 250;
   }
 
+  // a tie breaker between otherwise equal devices, 16 per GiB
+  VkDeviceSize heap_mib = LargestDeviceLocalHeap(device) >> 20;
+  int memory_score = static_cast<int>(heap_mib / 64);
+
+  int score =
+      suitable ? type_score + feature_score + queue_score + memory_score : 0;
+
   std::clog << "----- Physical Device: " << device_properties.deviceName
-            << ", score: " << score << " -----\n";
+            << " (" << DeviceTypeName(device_properties.deviceType) << ", "
+            << heap_mib << " MiB), score: " << score;
+  if (suitable) {
+    std::clog << " = type " << type_score << " + features " << feature_score
+              << " + queues " << queue_score << " + memory " << memory_score;
+  } else {
+    std::clog << ", missing required features";
+  }
+  std::clog << " -----\n";
 
   return score;
 }
@@ -1325,6 +3459,140 @@ void Application::FindDeviceExtensions(
   }
 }
 
+void Application::FindOptionalDeviceExtensions(
+    VkPhysicalDevice device, std::vector<const char*>& extensions) {
+  uint32_t available_extension_cnt = 0;
+  vkEnumerateDeviceExtensionProperties(device, nullptr,
+                                       &available_extension_cnt, nullptr);
+  std::vector<VkExtensionProperties> available_extensions(
+      available_extension_cnt);
+  vkEnumerateDeviceExtensionProperties(
+      device, nullptr, &available_extension_cnt, available_extensions.data());
+
+  std::vector<const char*> draw_indirect_count{
+      VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME};
+  if (CheckExtensionSupport(available_extensions, draw_indirect_count)) {
+    extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    device_features_.draw_indirect_count = true;
+  }
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(device, &properties);
+  bool core_1_2 = properties.apiVersion >= VK_API_VERSION_1_2;
+
+  // timeline semaphore: core since 1.2, an extension on older devices
+  std::vector<const char*> timeline_semaphore{
+      VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME};
+  if (options_.timeline &&
+      (core_1_2 ||
+       CheckExtensionSupport(available_extensions, timeline_semaphore))) {
+    VkPhysicalDeviceTimelineSemaphoreFeatures timeline_features{};
+    timeline_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &timeline_features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    if (timeline_features.timelineSemaphore) {
+      if (!core_1_2) {
+        extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+      }
+      device_features_.timeline_semaphore = true;
+    }
+  }
+
+  // present wait: a frame limiter that knows when an image was displayed
+  std::vector<const char*> present_wait{VK_KHR_PRESENT_ID_EXTENSION_NAME,
+                                        VK_KHR_PRESENT_WAIT_EXTENSION_NAME};
+  if (CheckExtensionSupport(available_extensions, present_wait)) {
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+    present_id_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+    present_wait_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    present_wait_features.pNext = &present_id_features;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &present_wait_features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    if (present_id_features.presentId && present_wait_features.presentWait) {
+      extensions.insert(extensions.end(), present_wait.begin(),
+                        present_wait.end());
+      device_features_.present_wait = true;
+    }
+  }
+
+  // dynamic rendering: needs VK_KHR_depth_stencil_resolve, core since 1.2
+  std::vector<const char*> dynamic_rendering{
+      VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME};
+  if (options_.dynamic_rendering && IMGUI_DYNAMIC_RENDERING && core_1_2 &&
+      CheckExtensionSupport(available_extensions, dynamic_rendering)) {
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamic_rendering_features{};
+    dynamic_rendering_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &dynamic_rendering_features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    if (dynamic_rendering_features.dynamicRendering) {
+      extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+      device_features_.dynamic_rendering = true;
+    }
+  }
+
+  // synchronization2: the render graph's barrier batches in one call
+  std::vector<const char*> synchronization2{
+      VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME};
+  if (CheckExtensionSupport(available_extensions, synchronization2)) {
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features{};
+    synchronization2_features.sType =
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &synchronization2_features;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    if (synchronization2_features.synchronization2) {
+      extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+      device_features_.synchronization2 = true;
+    }
+  }
+
+  // descriptor indexing: core since 1.2, an extension on older devices
+  bool indexing_core = core_1_2;
+  std::vector<const char*> descriptor_indexing{
+      VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
+      VK_KHR_MAINTENANCE3_EXTENSION_NAME};
+  if (!options_.bindless ||
+      (!indexing_core &&
+       !CheckExtensionSupport(available_extensions, descriptor_indexing))) {
+    return;
+  }
+
+  VkPhysicalDeviceDescriptorIndexingFeatures indexing_features{};
+  indexing_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  VkPhysicalDeviceFeatures2 features{};
+  features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features.pNext = &indexing_features;
+  vkGetPhysicalDeviceFeatures2(device, &features);
+
+  if (indexing_features.descriptorBindingPartiallyBound &&
+      indexing_features.descriptorBindingSampledImageUpdateAfterBind &&
+      indexing_features.descriptorBindingStorageBufferUpdateAfterBind &&
+      indexing_features.descriptorBindingUpdateUnusedWhilePending) {
+    if (!indexing_core) {
+      extensions.insert(extensions.end(), descriptor_indexing.begin(),
+                        descriptor_indexing.end());
+    }
+    device_features_.descriptor_indexing = true;
+  }
+}
+
 QueueFamilies Application::FindQueueFaimilies(VkPhysicalDevice device) {
   QueueFamilies indices{};
 
@@ -1337,19 +3605,42 @@ QueueFamilies Application::FindQueueFaimilies(VkPhysicalDevice device) {
 
   // get index of required queue family
   for (uint32_t i = 0; i < queue_family_cnt; ++i) {
-    if (queue_families[i].queueCount > 0 &&
-        (VK_QUEUE_GRAPHICS_BIT & queue_families[i].queueFlags)) {
+    if (0 == queue_families[i].queueCount) {
+      continue;
+    }
+
+    VkQueueFlags flags = queue_families[i].queueFlags;
+    if (!indices.graphics_family.has_value() &&
+        (VK_QUEUE_GRAPHICS_BIT & flags)) {
       indices.graphics_family = i;
     }
 
     VkBool32 present_support = false;
     vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &present_support);
-    if (queue_families[i].queueCount > 0 && present_support) {
+    if (!indices.present_family.has_value() && present_support) {
       indices.present_family = i;
     }
 
-    if (indices.IsCompleted()) {
-      break;
+    // prefer a pure transfer family (DMA engine) over async compute ones
+    if ((VK_QUEUE_TRANSFER_BIT & flags) && !(VK_QUEUE_GRAPHICS_BIT & flags)) {
+      if (!indices.transfer_family.has_value() ||
+          !(VK_QUEUE_COMPUTE_BIT & flags)) {
+        indices.transfer_family = i;
+      }
+    }
+  }
+
+  // async compute, preferably on a family uploads don't use
+  for (uint32_t i = 0; i < queue_family_cnt; ++i) {
+    VkQueueFlags flags = queue_families[i].queueFlags;
+    if (0 == queue_families[i].queueCount || !(VK_QUEUE_COMPUTE_BIT & flags) ||
+        (VK_QUEUE_GRAPHICS_BIT & flags)) {
+      continue;
+    }
+
+    if (!indices.compute_family.has_value() ||
+        indices.compute_family == indices.transfer_family) {
+      indices.compute_family = i;
     }
   }
 
@@ -1402,12 +3693,22 @@ VkSurfaceFormatKHR Application::ChooseSwapSurfaceFormat(
 
 VkPresentModeKHR Application::ChooseSwapPresentMode(
     const std::vector<VkPresentModeKHR>& available_present_modes) {
-  for (const auto& available : available_present_modes) {
-    if (available == VK_PRESENT_MODE_MAILBOX_KHR) {
-      return available;
-    }
-  }
-
+  VkPresentModeKHR requested = requested_present_mode_;
+  if (available_present_modes.end() !=
+      std::find(available_present_modes.begin(), available_present_modes.end(),
+                requested)) {
+    return requested;
+  }
+
+  // fifo is the only mode every device has to support; only a mode asked
+  // for on the command line is worth a warning, the controls offer
+  // supported ones only
+  if (!options_.present_mode.empty()) {
+    std::clog << "----- Warning::Swap Chain: Present mode "
+              << PresentModeName(requested)
+              << " is not supported, falling back to fifo -----" << std::endl;
+  }
+  requested_present_mode_ = VK_PRESENT_MODE_FIFO_KHR;
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -1417,8 +3718,8 @@ VkExtent2D Application::ChooseSwapExtent(
       std::numeric_limits<uint32_t>::max()) {
     return capabilities.currentExtent;
   } else {
-    int width, height;
-    glfwGetFramebufferSize(window_, &width, &height);
+    int width = framebuffer_width_;
+    int height = framebuffer_height_;
 
     VkExtent2D actual_extent = {static_cast<uint32_t>(width),
                                 static_cast<uint32_t>(height)};
@@ -1433,6 +3734,28 @@ VkExtent2D Application::ChooseSwapExtent(
   }
 }
 
+VkSampleCountFlagBits Application::ChooseSampleCount() {
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(physical_device_, &properties);
+  VkSampleCountFlags supported =
+      properties.limits.framebufferColorSampleCounts &
+      properties.limits.framebufferDepthSampleCounts;
+
+  uint32_t samples = options_.msaa_samples;
+  while (samples > 1 && 0 == (supported & samples)) {
+    samples >>= 1;
+  }
+
+  if (samples != options_.msaa_samples) {
+    std::clog << "----- MSAA: " << options_.msaa_samples
+              << "x is not supported, using " << samples << "x -----"
+              << std::endl;
+  }
+
+  // the flag bits are the sample counts
+  return static_cast<VkSampleCountFlagBits>(samples);
+}
+
 VkShaderModule Application::CreateShaderMoudle(const std::vector<char>& code) {
   VkShaderModuleCreateInfo shader_module_info{};
   shader_module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -1501,37 +3824,33 @@ void Application::EndSingleTimeCommands(VkCommandBuffer command_buffer) {
   submit_info.commandBufferCount = 1;
   submit_info.pCommandBuffers = &command_buffer;
 
-  vkQueueSubmit(graphics_queue_, 1, &submit_info, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphics_queue_);
-
-  vkFreeCommandBuffers(device_, command_pool_, 1, &command_buffer);
-}
-
-uint32_t Application::FindMemoryType(uint32_t type_filter,
-                                     VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties mem_properties;
-  vkGetPhysicalDeviceMemoryProperties(physical_device_, &mem_properties);
-
-  for (uint32_t i = 0; i < mem_properties.memoryTypeCount; ++i) {
-    if (type_filter & (1 << i) && (mem_properties.memoryTypes[i].propertyFlags &
-                                   properties) == properties) {
-      return i;
-    }
+  uint64_t value = 0;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    value = gpu_timeline_.Submit(graphics_queue_, submit_info);
   }
+  gpu_timeline_.WaitForValue(value);
 
-  throw std::runtime_error(
-      "----- Error::Vulkan: Failed to find suitable memory type -----");
+  vkFreeCommandBuffers(device_, command_pool_, 1, &command_buffer);
 }
 
 void Application::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
                                VkMemoryPropertyFlags properties,
-                               VkBuffer& buffer,
-                               VkDeviceMemory& buffer_memory) {
+                               VkBuffer& buffer, Allocation& buffer_memory,
+                               bool concurrent) {
+  uint32_t queue_families[] = {queue_faimlies_.graphics_family.value(),
+                               queue_faimlies_.compute_family.value_or(0)};
+
   VkBufferCreateInfo buffer_info{};
   buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_info.size = size;
   buffer_info.usage = usage;
   buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (concurrent) {
+    buffer_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    buffer_info.queueFamilyIndexCount = 2;
+    buffer_info.pQueueFamilyIndices = queue_families;
+  }
 
   if (VK_SUCCESS != vkCreateBuffer(device_, &buffer_info, nullptr, &buffer)) {
     throw std::runtime_error("Error::Vulkan: Failed to create buffer -----");
@@ -1540,68 +3859,103 @@ void Application::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
   VkMemoryRequirements mem_requirements{};
   vkGetBufferMemoryRequirements(device_, buffer, &mem_requirements);
 
-  VkMemoryAllocateInfo alloc_info{};
-  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  alloc_info.allocationSize = mem_requirements.size;
-  alloc_info.memoryTypeIndex =
-      FindMemoryType(mem_requirements.memoryTypeBits, properties);
+  buffer_memory = allocator_.Allocate(mem_requirements, properties, true);
 
-  if (VK_SUCCESS !=
-      vkAllocateMemory(device_, &alloc_info, nullptr, &buffer_memory)) {
+  if (VK_SUCCESS != vkBindBufferMemory(device_, buffer, buffer_memory.memory,
+                                       buffer_memory.offset)) {
     throw std::runtime_error(
-        "----- Error::Vulkan: Failed to allocate buffer memory -----");
+        "----- Error::Vulkan: Failed to bind buffer memory -----");
   }
+}
 
-  vkBindBufferMemory(device_, buffer, buffer_memory, 0);
+void Application::DestroyBuffer(VkBuffer& buffer, Allocation& buffer_memory) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_.Free(buffer_memory);
+  buffer = VK_NULL_HANDLE;
 }
 
-void Application::CopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer,
-                             VkDeviceSize size) {
-  VkCommandBuffer command_buffer = BeginSingleTimeCommands();
+void Application::UpdateUniformBuffer(uint32_t current_image,
+                                      const FrameSnapshot& snapshot) {
+  TRACE_SCOPE("UpdateUniformBuffer");
 
-  VkBufferCopy copy_region{};
-  copy_region.srcOffset = 0;  // Optional
-  copy_region.dstOffset = 0;  // Optional
-  copy_region.size = size;
-  vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, 1, &copy_region);
+  // pushed by the draws and the cull pass
+  scene_model_ = snapshot.scene_model;
 
-  EndSingleTimeCommands(command_buffer);
+  UniformBufferObject ubo{};
+  ubo.view_projection = snapshot.view_projection;
+  memcpy(uniform_buffers_mapped_[current_image], &ubo, sizeof(ubo));
 }
 
-void Application::UpdateUniformBuffer(uint32_t current_image) {
-  static auto start_time = std::chrono::high_resolution_clock::now();
+void Application::UpdateInstanceTransforms(uint32_t current_frame,
+                                           const FrameSnapshot& snapshot) {
+  // paused, the frame's buffer may already hold these transforms
+  if (instance_buffer_times_[current_frame] == snapshot.animation_time) {
+    return;
+  }
+  TRACE_SCOPE("UpdateInstanceTransforms");
+
+  glm::quat delta = glm::angleAxis(
+      (snapshot.animation_time - instance_animation_time_) *
+          INSTANCE_SPIN_SPEED,
+      glm::vec3(0.0f, 0.0f, 1.0f));
+  instance_animation_time_ = snapshot.animation_time;
+  instance_buffer_times_[current_frame] = snapshot.animation_time;
+
+  // the GPU is done with the frame's buffer; colors stay as written
+  InstanceData* instances = static_cast<InstanceData*>(
+      instance_buffers_memory_[current_frame].mapped);
+  auto update = [this, &delta, instances](uint32_t begin, uint32_t end) {
+    instance_transforms_.Rotate(begin, end, delta);
+    instance_transforms_.WriteModels(begin, end, &instances[begin].model,
+                                     sizeof(InstanceData));
+  };
+
+  if (instance_count_ <= INSTANCE_UPDATE_CHUNK) {
+    update(0, instance_count_);
+  } else {
+    job_system_.ParallelFor(instance_count_, INSTANCE_UPDATE_CHUNK, update);
+  }
+}
 
-  auto current_time = std::chrono::high_resolution_clock::now();
-  float delta_time = std::chrono::duration<float, std::chrono::seconds::period>(
-                         current_time - start_time)
-                         .count();
+VkImageView Application::CreateImageView(VkImage image, VkFormat format,
+                                         uint32_t mip_levels) {
+  VkImageViewCreateInfo image_view_info{};
+  image_view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  image_view_info.image = image;
+  image_view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  image_view_info.format = format;
+  image_view_info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+  image_view_info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+  image_view_info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+  image_view_info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+  image_view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  image_view_info.subresourceRange.baseMipLevel = 0;
+  image_view_info.subresourceRange.levelCount = mip_levels;
+  image_view_info.subresourceRange.baseArrayLayer = 0;
+  image_view_info.subresourceRange.layerCount = 1;
+
+  VkImageView image_view;
+  if (VK_SUCCESS !=
+      vkCreateImageView(device_, &image_view_info, nullptr, &image_view)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create image views -----");
+  }
 
-  UniformBufferObject ubo{};
-  ubo.model = glm::rotate(glm::mat4(1.0f), delta_time * glm::radians(90.0f),
-                          glm::vec3(0.0f, 0.0f, 1.0f));
-  ubo.view =
-      glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f),
-                  glm::vec3(0.0f, 0.0f, 1.0f));
-  ubo.projection = glm::perspective(
-      glm::radians(45.0f),
-      swap_chain_extent_.width / static_cast<float>(swap_chain_extent_.height),
-      0.1f, 10.0f);
-  // invert Y-axis
-  ubo.projection[1][1] *= -1.f;
-  memcpy(uniform_buffers_mapped_[current_image], &ubo, sizeof(ubo));
+  return image_view;
 }
 
-void Application::CreateImage(uint32_t width, uint32_t height, VkFormat format,
+void Application::CreateImage(uint32_t width, uint32_t height,
+                              uint32_t mip_levels, VkFormat format,
                               VkImageTiling tiling, VkImageUsageFlags usage,
                               VkMemoryPropertyFlags properties, VkImage& image,
-                              VkDeviceMemory& image_memory) {
+                              Allocation& image_memory) {
   VkImageCreateInfo image_info{};
   image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   image_info.imageType = VK_IMAGE_TYPE_2D;
   image_info.extent.width = static_cast<uint32_t>(width);
   image_info.extent.height = static_cast<uint32_t>(height);
   image_info.extent.depth = 1;
-  image_info.mipLevels = 1;
+  image_info.mipLevels = mip_levels;
   image_info.arrayLayers = 1;
   image_info.format = format;
   image_info.tiling = tiling;
@@ -1619,84 +3973,61 @@ void Application::CreateImage(uint32_t width, uint32_t height, VkFormat format,
   VkMemoryRequirements mem_requirements;
   vkGetImageMemoryRequirements(device_, image, &mem_requirements);
 
-  VkMemoryAllocateInfo alloc_nfo{};
-  alloc_nfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  alloc_nfo.allocationSize = mem_requirements.size;
-  alloc_nfo.memoryTypeIndex =
-      FindMemoryType(mem_requirements.memoryTypeBits, properties);
+  image_memory = allocator_.Allocate(mem_requirements, properties,
+                                     VK_IMAGE_TILING_LINEAR == tiling);
 
-  if (vkAllocateMemory(device_, &alloc_nfo, nullptr, &image_memory) !=
-      VK_SUCCESS) {
+  if (VK_SUCCESS != vkBindImageMemory(device_, image, image_memory.memory,
+                                      image_memory.offset)) {
     throw std::runtime_error(
-        "----- Error::Vulkan: Failed to allocate image memory -----");
+        "----- Error::Vulkan: Failed to bind image memory -----");
   }
+}
 
-  vkBindImageMemory(device_, image, image_memory, 0);
+void Application::DestroyImage(VkImage& image, Allocation& image_memory) {
+  vkDestroyImage(device_, image, nullptr);
+  allocator_.Free(image_memory);
+  image = VK_NULL_HANDLE;
 }
 
 void Application::TransitionImageLayout(VkImage image, VkImageLayout old_layout,
-                                        VkImageLayout new_layout) {
-  VkCommandBuffer command_buffer = BeginSingleTimeCommands();
-
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = old_layout;
-  barrier.newLayout = new_layout;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = image;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-
-  VkPipelineStageFlags source_stage;
-  VkPipelineStageFlags destination_stage;
-
-  if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
-      new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    source_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    destination_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-  } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-             new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destination_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  } else {
-    throw std::invalid_argument("unsupported layout transition!");
-  }
-
-  vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0,
-                       nullptr, 0, nullptr, 1, &barrier);
-
-  EndSingleTimeCommands(command_buffer);
+                                        VkImageLayout new_layout,
+                                        uint32_t mip_levels) {
+  VkImageSubresourceRange range{};
+  range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  range.baseMipLevel = 0;
+  range.levelCount = mip_levels;
+  range.baseArrayLayer = 0;
+  range.layerCount = 1;
+
+  upload_context_.TransitionImageLayout(image, old_layout, new_layout, range);
 }
 
-void Application::CopyBufferToImage(VkBuffer buffer, VkImage image,
-                                    uint32_t width, uint32_t height) {
-  VkCommandBuffer command_buffer = BeginSingleTimeCommands();
+void Application::CopyBufferToImage(
+    VkBuffer buffer, VkDeviceSize buffer_offset, VkImage image, uint32_t width,
+    uint32_t height, const std::vector<VkDeviceSize>& level_offsets) {
+  std::vector<VkBufferImageCopy> regions{};
 
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {width, height, 1};
+  for (size_t i = 0; i < level_offsets.size(); ++i) {
+    uint32_t level = static_cast<uint32_t>(i);
 
-  vkCmdCopyBufferToImage(command_buffer, buffer, image,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    VkBufferImageCopy region{};
+    region.bufferOffset = buffer_offset + level_offsets[i];
+    // tightly packed, in texels or blocks
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = level;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {std::max(width >> level, 1u),
+                          std::max(height >> level, 1u), 1};
+
+    regions.push_back(region);
+  }
 
-  EndSingleTimeCommands(command_buffer);
+  // one vkCmdCopyBufferToImage for the whole chain
+  upload_context_.CopyBufferToImage(buffer, image, regions);
 }
 
 void Application::FramebufferResizeCallback(GLFWwindow* window, int width,
@@ -1704,9 +4035,23 @@ void Application::FramebufferResizeCallback(GLFWwindow* window, int width,
   std::clog << "----- Window resized with width: " << width
             << ", height: " << height << std::endl;
   auto app = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+  app->framebuffer_width_ = width;
+  app->framebuffer_height_ = height;
   app->framebuffer_resized = true;
 }
 
+void Application::KeyCallback(GLFWwindow* window, int key, int scancode,
+                              int action, int mods) {
+  (void)scancode;
+  (void)mods;
+
+  auto app = reinterpret_cast<Application*>(glfwGetWindowUserPointer(window));
+  if (GLFW_KEY_F9 == key && GLFW_PRESS == action) {
+    // written from the run loop, not from inside event polling
+    app->trace_requested_ = true;
+  }
+}
+
 VKAPI_ATTR VkBool32 VKAPI_CALL Application::DebugCallBack(
     VkDebugUtilsMessageSeverityFlagBitsEXT message_severity,
     VkDebugUtilsMessageTypeFlagsEXT message_type,
@@ -1723,22 +4068,4 @@ VKAPI_ATTR VkBool32 VKAPI_CALL Application::DebugCallBack(
   return VK_FALSE;
 }
 
-std::vector<char> Application::ReadFile(const std::string& filename) {
-  std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-  if (!file.is_open()) {
-    throw std::runtime_error("----- Error::File: Failed to open file -----");
-  }
-
-  size_t file_size = static_cast<size_t>(file.tellg());
-  std::vector<char> buffer(file_size);
-
-  file.seekg(0);
-  file.read(buffer.data(), file_size);
-
-  file.close();
-
-  return buffer;
-}
-
 }  // namespace playground
@@ -0,0 +1,122 @@
+/**
+ * @file asset_loader.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "asset_loader.h"
+
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+
+#include <stb_image.h>
+
+#include "trace.h"
+
+namespace playground {
+
+void StbiDeleter::operator()(unsigned char* pixels) const {
+  stbi_image_free(pixels);
+}
+
+AssetLoader::AssetLoader(JobSystem& job_system) : job_system_(job_system) {}
+
+std::shared_ptr<Asset> AssetLoader::LoadFile(const std::string& path) {
+  auto asset = std::make_shared<Asset>();
+  asset->path = path;
+
+  job_system_.Schedule(
+      [asset]() {
+        TRACE_SCOPE("ReadFile");
+        try {
+          asset->bytes = ReadFile(asset->path);
+        } catch (const std::exception& e) {
+          asset->error = e.what();
+        }
+      },
+      &asset->counter);
+
+  return asset;
+}
+
+std::shared_ptr<Asset> AssetLoader::LoadImage(const std::string& path) {
+  auto asset = std::make_shared<Asset>();
+  asset->path = path;
+
+  job_system_.Schedule(
+      [asset]() {
+        TRACE_SCOPE("DecodeImage");
+        int channels = 0;
+        asset->pixels.reset(stbi_load(asset->path.c_str(), &asset->width,
+                                      &asset->height, &channels,
+                                      STBI_rgb_alpha));
+        if (!asset->pixels) {
+          asset->error =
+              "----- Error::stb_image: Failed to load texture image -----";
+        }
+      },
+      &asset->counter);
+
+  return asset;
+}
+
+std::shared_ptr<Asset> AssetLoader::LoadTexture(const std::string& path) {
+  const std::string extension{".ktx2"};
+  if (path.size() < extension.size() ||
+      0 != path.compare(path.size() - extension.size(), extension.size(),
+                        extension)) {
+    return LoadImage(path);
+  }
+
+  auto asset = std::make_shared<Asset>();
+  asset->path = path;
+
+  job_system_.Schedule(
+      [asset]() {
+        TRACE_SCOPE("ReadTexture");
+        try {
+          asset->bytes = ReadFile(asset->path);
+          asset->ktx2 = ParseKtx2(asset->bytes.data(), asset->bytes.size());
+          asset->width = static_cast<int>(asset->ktx2.width);
+          asset->height = static_cast<int>(asset->ktx2.height);
+        } catch (const std::exception& e) {
+          asset->error = e.what();
+        }
+      },
+      &asset->counter);
+
+  return asset;
+}
+
+void AssetLoader::Wait(const Asset& asset) {
+  job_system_.Wait(asset.counter);
+
+  if (!asset.error.empty()) {
+    throw std::runtime_error(asset.error);
+  }
+}
+
+std::vector<char> AssetLoader::ReadFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+  if (!file.is_open()) {
+    throw std::runtime_error("----- Error::File: Failed to open file -----");
+  }
+
+  size_t file_size = static_cast<size_t>(file.tellg());
+  std::vector<char> buffer(file_size);
+
+  file.seekg(0);
+  file.read(buffer.data(), file_size);
+
+  file.close();
+
+  return buffer;
+}
+
+}  // namespace playground
@@ -0,0 +1,225 @@
+/**
+ * @file benchmark.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-17
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <numeric>
+
+namespace playground {
+
+namespace {
+
+// nearest rank on sorted samples
+double Percentile(const std::vector<double>& sorted, double percentile) {
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(sorted.size())));
+  return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// quoted and escaped: device names, paths (on Windows full of
+// backslashes) and startup step names are arbitrary text
+void WriteJsonString(std::ostream& out, const std::string& text) {
+  out << '"';
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\b':
+        out << "\\b";
+        break;
+      case '\f':
+        out << "\\f";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\r':
+        out << "\\r";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char escaped[8];
+          std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                        static_cast<unsigned>(c));
+          out << escaped;
+        } else {
+          out << c;
+        }
+        break;
+    }
+  }
+  out << '"';
+}
+
+void WriteStatsJson(std::ostream& out, const FrameTimeStats& stats) {
+  out << "{\"min\":" << stats.min << ",\"avg\":" << stats.average
+      << ",\"p50\":" << stats.p50 << ",\"p95\":" << stats.p95
+      << ",\"p99\":" << stats.p99 << ",\"max\":" << stats.max << "}";
+}
+
+void WriteStatsRow(std::ostream& out, const std::string& name,
+                   const FrameTimeStats& stats) {
+  out << "  " << std::left << std::setw(6) << name << std::right
+      << " min " << std::setw(8) << stats.min << "  avg " << std::setw(8)
+      << stats.average << "  p50 " << std::setw(8) << stats.p50 << "  p95 "
+      << std::setw(8) << stats.p95 << "  p99 " << std::setw(8) << stats.p99
+      << "  max " << std::setw(8) << stats.max << " ms\n";
+}
+
+}  // namespace
+
+void Benchmark::Configure(uint32_t warmup, uint32_t frames) {
+  warmup_ = warmup;
+  frames_ = frames;
+
+  cpu_frame_times_.reserve(frames_);
+  gpu_frame_times_.reserve(frames_);
+}
+
+void Benchmark::AddConfig(const std::string& key, const std::string& value) {
+  config_.emplace_back(key, value);
+}
+
+void Benchmark::AddStartupPhase(const std::string& name, double start_ms,
+                                double ms, bool worker) {
+  startup_phases_.push_back({name, start_ms, ms, worker});
+}
+
+double Benchmark::GetStartupTime() const {
+  double end = 0.0;
+  for (const auto& phase : startup_phases_) {
+    end = std::max(end, phase.start_ms + phase.ms);
+  }
+
+  return end;
+}
+
+void Benchmark::SetFirstFrameTime(double ms) { first_frame_ms_ = ms; }
+
+void Benchmark::AddFrame(double cpu_ms, double gpu_ms) {
+  if (frame_cnt_++ < warmup_) {
+    return;
+  }
+
+  cpu_frame_times_.push_back(cpu_ms);
+  gpu_frame_times_.push_back(gpu_ms);
+}
+
+bool Benchmark::IsDone() const {
+  return frames_ > 0 && frame_cnt_ >= warmup_ + frames_;
+}
+
+FrameTimeStats Benchmark::ComputeStats(std::vector<double> samples) {
+  FrameTimeStats stats{};
+  if (samples.empty()) {
+    return stats;
+  }
+
+  std::sort(samples.begin(), samples.end());
+
+  stats.min = samples.front();
+  stats.max = samples.back();
+  stats.average = std::accumulate(samples.begin(), samples.end(), 0.0) /
+                  static_cast<double>(samples.size());
+  stats.p50 = Percentile(samples, 50.0);
+  stats.p95 = Percentile(samples, 95.0);
+  stats.p99 = Percentile(samples, 99.0);
+
+  return stats;
+}
+
+void Benchmark::Report(std::ostream& out) const {
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(3);
+
+  out << "----- Benchmark -----\n";
+  for (const auto& [key, value] : config_) {
+    out << "  " << key << ": " << value << "\n";
+  }
+
+  out << "  startup phases:" << std::setw(29) << "start" << std::setw(10)
+      << "duration" << "\n";
+  for (const auto& phase : startup_phases_) {
+    out << "    " << std::left << std::setw(32) << phase.name << std::right
+        << std::setw(10) << phase.start_ms << std::setw(10) << phase.ms
+        << " ms" << (phase.worker ? " (worker)" : "") << "\n";
+  }
+  out << "    " << std::left << std::setw(32) << "total" << std::right
+      << std::setw(20) << GetStartupTime() << " ms\n";
+  out << "    " << std::left << std::setw(32) << "first frame" << std::right
+      << std::setw(20) << first_frame_ms_ << " ms\n";
+
+  out << "  " << cpu_frame_times_.size() << " frames after " << warmup_
+      << " warmup frames:\n";
+  WriteStatsRow(out, "cpu", ComputeStats(cpu_frame_times_));
+  WriteStatsRow(out, "gpu", ComputeStats(gpu_frame_times_));
+  out << std::flush;
+
+  out.flags(flags);
+}
+
+void Benchmark::WriteJson(std::ostream& out) const {
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(4);
+
+  out << "{\"config\":{";
+  for (size_t i = 0; i < config_.size(); ++i) {
+    out << (i > 0 ? "," : "");
+    WriteJsonString(out, config_[i].first);
+    out << ":";
+    WriteJsonString(out, config_[i].second);
+  }
+
+  out << "},\"startup_ms\":{";
+  for (size_t i = 0; i < startup_phases_.size(); ++i) {
+    out << (i > 0 ? "," : "");
+    WriteJsonString(out, startup_phases_[i].name);
+    out << ":" << startup_phases_[i].ms;
+  }
+  out << "},\"startup_start_ms\":{";
+  for (size_t i = 0; i < startup_phases_.size(); ++i) {
+    out << (i > 0 ? "," : "");
+    WriteJsonString(out, startup_phases_[i].name);
+    out << ":" << startup_phases_[i].start_ms;
+  }
+  out << "},\"startup_workers\":[";
+  bool first = true;
+  for (const auto& phase : startup_phases_) {
+    if (phase.worker) {
+      out << (first ? "" : ",");
+      WriteJsonString(out, phase.name);
+      first = false;
+    }
+  }
+  out << "],\"startup_total_ms\":" << GetStartupTime()
+      << ",\"first_frame_ms\":" << first_frame_ms_;
+
+  out << ",\"warmup_frames\":" << warmup_
+      << ",\"frames\":" << cpu_frame_times_.size() << ",\"cpu_frame_ms\":";
+  WriteStatsJson(out, ComputeStats(cpu_frame_times_));
+  out << ",\"gpu_frame_ms\":";
+  WriteStatsJson(out, ComputeStats(gpu_frame_times_));
+  out << "}" << std::endl;
+
+  out.flags(flags);
+}
+
+}  // namespace playground
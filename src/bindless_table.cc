@@ -0,0 +1,260 @@
+/**
+ * @file bindless_table.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-22
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "bindless_table.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+void BindlessTable::Init(VkDevice device, VkSampler sampler, bool bindless,
+                         uint32_t texture_capacity, uint32_t buffer_capacity,
+                         uint32_t frames_in_flight) {
+  device_ = device;
+  bindless_ = bindless;
+  texture_capacity_ = texture_capacity;
+  buffer_capacity_ = buffer_capacity;
+
+  std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+  bindings[0].binding = 0;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  bindings[0].descriptorCount = texture_capacity_;
+  bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  bindings[1].binding = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[1].descriptorCount = buffer_capacity_;
+  bindings[1].stageFlags =
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  bindings[2].binding = 2;
+  bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+  bindings[2].descriptorCount = 1;
+  bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  bindings[2].pImmutableSamplers = &sampler;
+
+  // slots may stay empty and be filled while the set is bound
+  VkDescriptorBindingFlags array_flags =
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+  std::array<VkDescriptorBindingFlags, 3> binding_flags{array_flags,
+                                                        array_flags, 0};
+
+  VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{};
+  binding_flags_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+  binding_flags_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  binding_flags_info.pBindingFlags = binding_flags.data();
+
+  VkDescriptorSetLayoutCreateInfo layout_info{};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+  if (bindless_) {
+    layout_info.pNext = &binding_flags_info;
+    layout_info.flags =
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  }
+
+  if (VK_SUCCESS !=
+      vkCreateDescriptorSetLayout(device_, &layout_info, nullptr, &layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create bindless set layout -----");
+  }
+
+  uint32_t set_cnt = bindless_ ? 1 : frames_in_flight;
+
+  std::array<VkDescriptorPoolSize, 3> pool_sizes{};
+  pool_sizes[0] = {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                   texture_capacity_ * set_cnt};
+  pool_sizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                   buffer_capacity_ * set_cnt};
+  pool_sizes[2] = {VK_DESCRIPTOR_TYPE_SAMPLER, set_cnt};
+
+  VkDescriptorPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.flags =
+      bindless_ ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT : 0;
+  pool_info.maxSets = set_cnt;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+
+  if (VK_SUCCESS !=
+      vkCreateDescriptorPool(device_, &pool_info, nullptr, &pool_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create bindless descriptor pool -----");
+  }
+
+  std::vector<VkDescriptorSetLayout> layouts(set_cnt, layout_);
+  VkDescriptorSetAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = pool_;
+  alloc_info.descriptorSetCount = set_cnt;
+  alloc_info.pSetLayouts = layouts.data();
+
+  sets_.resize(set_cnt);
+  if (VK_SUCCESS !=
+      vkAllocateDescriptorSets(device_, &alloc_info, sets_.data())) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate bindless descriptor sets "
+        "-----");
+  }
+
+  set_versions_.assign(set_cnt, 0);
+}
+
+void BindlessTable::Destroy() {
+  if (VK_NULL_HANDLE != pool_) {
+    vkDestroyDescriptorPool(device_, pool_, nullptr);
+    pool_ = VK_NULL_HANDLE;
+  }
+  if (VK_NULL_HANDLE != layout_) {
+    vkDestroyDescriptorSetLayout(device_, layout_, nullptr);
+    layout_ = VK_NULL_HANDLE;
+  }
+  sets_.clear();
+}
+
+bool BindlessTable::IsBindless() const { return bindless_; }
+
+uint32_t BindlessTable::GetTextureCapacity() const { return texture_capacity_; }
+
+uint32_t BindlessTable::GetBufferCapacity() const { return buffer_capacity_; }
+
+VkDescriptorSetLayout BindlessTable::GetLayout() const { return layout_; }
+
+uint32_t BindlessTable::AddTexture(VkImageView image_view) {
+  if (textures_.size() >= texture_capacity_) {
+    throw std::runtime_error(
+        "----- Error::Bindless: Out of texture slots -----");
+  }
+
+  uint32_t slot = static_cast<uint32_t>(textures_.size());
+  textures_.push_back(
+      {VK_NULL_HANDLE, image_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+
+  // never read by a pending frame yet, so it is written right away
+  if (bindless_) {
+    WriteTexture(sets_[0], slot, textures_.back());
+  } else {
+    ++version_;
+  }
+
+  return slot;
+}
+
+uint32_t BindlessTable::AddBuffer(VkBuffer buffer, VkDeviceSize range) {
+  if (buffers_.size() >= buffer_capacity_) {
+    throw std::runtime_error(
+        "----- Error::Bindless: Out of buffer slots -----");
+  }
+
+  uint32_t slot = static_cast<uint32_t>(buffers_.size());
+  buffers_.push_back({buffer, 0, range});
+
+  if (bindless_) {
+    WriteBuffer(sets_[0], slot, buffers_.back());
+  } else {
+    ++version_;
+  }
+
+  return slot;
+}
+
+VkDescriptorSet BindlessTable::Prepare(uint32_t frame) {
+  if (bindless_) {
+    return sets_[0];
+  }
+
+  // the frame's previous submission has retired, its set is free to update
+  if (set_versions_[frame] != version_) {
+    WriteAll(sets_[frame]);
+    set_versions_[frame] = version_;
+  }
+
+  return sets_[frame];
+}
+
+void BindlessTable::WriteTexture(VkDescriptorSet set, uint32_t slot,
+                                 const VkDescriptorImageInfo& info) {
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = set;
+  write.dstBinding = 0;
+  write.dstArrayElement = slot;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  write.descriptorCount = 1;
+  write.pImageInfo = &info;
+
+  vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+}
+
+void BindlessTable::WriteBuffer(VkDescriptorSet set, uint32_t slot,
+                                const VkDescriptorBufferInfo& info) {
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = set;
+  write.dstBinding = 1;
+  write.dstArrayElement = slot;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  write.descriptorCount = 1;
+  write.pBufferInfo = &info;
+
+  vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+}
+
+void BindlessTable::WriteAll(VkDescriptorSet set) {
+  // without partially bound arrays every slot must be valid: empty ones
+  // repeat slot 0
+  std::vector<VkDescriptorImageInfo> textures{};
+  std::vector<VkDescriptorBufferInfo> buffers{};
+  if (!textures_.empty()) {
+    textures.assign(texture_capacity_, textures_[0]);
+    std::copy(textures_.begin(), textures_.end(), textures.begin());
+  }
+  if (!buffers_.empty()) {
+    buffers.assign(buffer_capacity_, buffers_[0]);
+    std::copy(buffers_.begin(), buffers_.end(), buffers.begin());
+  }
+
+  std::vector<VkWriteDescriptorSet> writes{};
+
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = set;
+  write.dstArrayElement = 0;
+
+  if (!textures.empty()) {
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.descriptorCount = texture_capacity_;
+    write.pImageInfo = textures.data();
+    writes.push_back(write);
+  }
+
+  if (!buffers.empty()) {
+    write.dstBinding = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = buffer_capacity_;
+    write.pImageInfo = nullptr;
+    write.pBufferInfo = buffers.data();
+    writes.push_back(write);
+  }
+
+  vkUpdateDescriptorSets(device_, static_cast<uint32_t>(writes.size()),
+                         writes.data(), 0, nullptr);
+}
+
+}  // namespace playground
@@ -0,0 +1,70 @@
+/**
+ * @file deletion_queue.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-27
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "deletion_queue.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace playground {
+
+void DeletionQueue::Init(GpuTimeline& timeline) { timeline_ = &timeline; }
+
+void DeletionQueue::Destroy() {
+  std::deque<Entry> entries{};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries.swap(entries_);
+  }
+
+  if (entries.empty()) {
+    return;
+  }
+
+  // values past the last submission never get signaled
+  timeline_->WaitForValue(
+      std::min(entries.back().value, timeline_->GetSubmittedValue()));
+  for (auto& entry : entries) {
+    entry.destroy();
+  }
+}
+
+void DeletionQueue::Retire(uint64_t value, std::function<void()> destroy) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // values mostly arrive in order, this is then an append
+  auto position = std::upper_bound(
+      entries_.begin(), entries_.end(), value,
+      [](uint64_t value, const Entry& entry) { return value < entry.value; });
+  entries_.insert(position, {value, std::move(destroy)});
+}
+
+void DeletionQueue::Retire(std::function<void()> destroy) {
+  Retire(timeline_->GetSubmittedValue(), std::move(destroy));
+}
+
+void DeletionQueue::Collect() {
+  std::vector<std::function<void()>> completed{};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!entries_.empty() && timeline_->IsComplete(entries_.front().value)) {
+      completed.push_back(std::move(entries_.front().destroy));
+      entries_.pop_front();
+    }
+  }
+
+  // outside the lock, destroying may retire something else
+  for (auto& destroy : completed) {
+    destroy();
+  }
+}
+
+}  // namespace playground
@@ -0,0 +1,93 @@
+/**
+ * @file frame_command_pools.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-24
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "frame_command_pools.h"
+
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+void FrameCommandPools::Init(VkDevice device, uint32_t queue_family,
+                             uint32_t frames_in_flight,
+                             uint32_t thread_count) {
+  device_ = device;
+  thread_count_ = thread_count;
+  pools_.resize(frames_in_flight * thread_count);
+
+  // buffers are never reset one by one, so no RESET_COMMAND_BUFFER bit
+  VkCommandPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pool_info.queueFamilyIndex = queue_family;
+
+  for (auto& pool : pools_) {
+    if (VK_SUCCESS !=
+        vkCreateCommandPool(device_, &pool_info, nullptr, &pool.pool)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create frame command pool -----");
+    }
+  }
+}
+
+void FrameCommandPools::Destroy() {
+  for (auto& pool : pools_) {
+    // frees the pool's command buffers too
+    vkDestroyCommandPool(device_, pool.pool, nullptr);
+  }
+  pools_.clear();
+}
+
+void FrameCommandPools::Reset(uint32_t frame) {
+  for (uint32_t thread = 0; thread < thread_count_; ++thread) {
+    Pool& pool = pools_[frame * thread_count_ + thread];
+    if (0 == pool.used_primaries && 0 == pool.used_secondaries) {
+      continue;
+    }
+
+    if (VK_SUCCESS != vkResetCommandPool(device_, pool.pool, 0)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to reset frame command pool -----");
+    }
+    pool.used_primaries = 0;
+    pool.used_secondaries = 0;
+  }
+}
+
+VkCommandBuffer FrameCommandPools::Allocate(uint32_t frame, uint32_t thread,
+                                            VkCommandBufferLevel level) {
+  Pool& pool = pools_[frame * thread_count_ + thread];
+
+  bool primary = VK_COMMAND_BUFFER_LEVEL_PRIMARY == level;
+  std::vector<VkCommandBuffer>& buffers =
+      primary ? pool.primaries : pool.secondaries;
+  size_t& used = primary ? pool.used_primaries : pool.used_secondaries;
+
+  if (used == buffers.size()) {
+    VkCommandBufferAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    alloc_info.commandPool = pool.pool;
+    alloc_info.level = level;
+    alloc_info.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if (VK_SUCCESS !=
+        vkAllocateCommandBuffers(device_, &alloc_info, &command_buffer)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to allocate frame command buffer -----");
+    }
+    buffers.push_back(command_buffer);
+  }
+
+  return buffers[used++];
+}
+
+}  // namespace playground
@@ -0,0 +1,62 @@
+/**
+ * @file frame_snapshot.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-25
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "frame_snapshot.h"
+
+#include <imgui.h>
+
+namespace playground {
+
+DrawDataSnapshot::~DrawDataSnapshot() {
+  for (ImDrawList* list : lists_) {
+    IM_DELETE(list);
+  }
+}
+
+void DrawDataSnapshot::Capture(const ImDrawData* source) {
+  size_t list_cnt = static_cast<size_t>(source->CmdListsCount);
+
+  for (size_t i = 0; i < list_cnt; ++i) {
+    const ImDrawList* list = source->CmdLists[static_cast<int>(i)];
+    if (i == lists_.size()) {
+      lists_.push_back(list->CloneOutput());
+      continue;
+    }
+
+    // same as CloneOutput(), but keeps the vectors' capacity
+    lists_[i]->CmdBuffer = list->CmdBuffer;
+    lists_[i]->IdxBuffer = list->IdxBuffer;
+    lists_[i]->VtxBuffer = list->VtxBuffer;
+    lists_[i]->Flags = list->Flags;
+  }
+
+  draw_data_.Valid = source->Valid;
+  draw_data_.CmdListsCount = source->CmdListsCount;
+  draw_data_.TotalIdxCount = source->TotalIdxCount;
+  draw_data_.TotalVtxCount = source->TotalVtxCount;
+  draw_data_.DisplayPos = source->DisplayPos;
+  draw_data_.DisplaySize = source->DisplaySize;
+  draw_data_.FramebufferScale = source->FramebufferScale;
+  draw_data_.OwnerViewport = source->OwnerViewport;
+
+  // CmdLists turned from a raw array into an ImVector in 1.89.8
+#if IMGUI_VERSION_NUM >= 18980
+  draw_data_.CmdLists.resize(0);
+  for (size_t i = 0; i < list_cnt; ++i) {
+    draw_data_.CmdLists.push_back(lists_[i]);
+  }
+#else
+  draw_data_.CmdLists = lists_.data();
+#endif
+}
+
+ImDrawData* DrawDataSnapshot::Get() { return &draw_data_; }
+
+}  // namespace playground
@@ -0,0 +1,346 @@
+/**
+ * @file gpu_profiler.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-15
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#include <imgui.h>
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+const uint32_t QUERIES_PER_FRAME = MAX_PROFILER_SCOPES * 2;
+const uint32_t INVALID_SCOPE = std::numeric_limits<uint32_t>::max();
+
+// weight of the newest sample in the per scope running average
+const double AVERAGE_WEIGHT = 0.05;
+
+}  // namespace
+
+void GpuProfiler::Init(VkPhysicalDevice physical_device, VkDevice device,
+                       uint32_t queue_family, uint32_t frames_in_flight) {
+  device_ = device;
+  frames_.resize(frames_in_flight);
+  results_.resize(QUERIES_PER_FRAME);
+
+  VkPhysicalDeviceProperties properties{};
+  vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+  uint32_t queue_family_cnt = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_cnt,
+                                           nullptr);
+  std::vector<VkQueueFamilyProperties> queue_families(queue_family_cnt);
+  vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_cnt,
+                                           queue_families.data());
+
+  uint32_t valid_bits = queue_families[queue_family].timestampValidBits;
+  if (0 == valid_bits || 0.0f == properties.limits.timestampPeriod) {
+    std::clog << "----- GPU Profiler: timestamps are not supported on queue "
+                 "family "
+              << queue_family << " -----" << std::endl;
+    return;
+  }
+
+  timestamp_period_ = properties.limits.timestampPeriod;
+  timestamp_mask_ = valid_bits >= 64 ? std::numeric_limits<uint64_t>::max()
+                                     : (uint64_t{1} << valid_bits) - 1;
+
+  // one range of QUERIES_PER_FRAME queries per frame in flight
+  VkQueryPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_info.queryCount = QUERIES_PER_FRAME * frames_in_flight;
+
+  if (VK_SUCCESS !=
+      vkCreateQueryPool(device_, &pool_info, nullptr, &query_pool_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create timestamp query pool -----");
+  }
+}
+
+void GpuProfiler::Destroy() {
+  if (VK_NULL_HANDLE != query_pool_) {
+    vkDestroyQueryPool(device_, query_pool_, nullptr);
+    query_pool_ = VK_NULL_HANDLE;
+  }
+}
+
+bool GpuProfiler::IsSupported() const { return VK_NULL_HANDLE != query_pool_; }
+
+void GpuProfiler::Collect(uint32_t frame) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::steady_clock::time_point{} != last_collect_) {
+    frame_ms_ =
+        std::chrono::duration<double, std::milli>(now - last_collect_).count();
+  }
+  last_collect_ = now;
+
+  FrameQueries& queries = frames_[frame];
+  if (IsSupported() && queries.pending && !queries.scopes.empty()) {
+    uint32_t query_cnt = static_cast<uint32_t>(queries.scopes.size()) * 2;
+
+    // no WAIT bit: the frame's timeline value is reached, if the results are
+    // not there the frame is skipped instead of stalling the CPU
+    VkResult result = vkGetQueryPoolResults(
+        device_, query_pool_, frame * QUERIES_PER_FRAME, query_cnt,
+        query_cnt * sizeof(uint64_t), results_.data(), sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+
+    if (VK_SUCCESS == result) {
+      UpdateStats(queries);
+    }
+  }
+  queries.pending = false;
+
+  PushHistory(static_cast<float>(frame_ms_), static_cast<float>(gpu_ms_));
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer command_buffer, uint32_t frame) {
+  recording_frame_ = frame;
+  open_depth_ = 0;
+
+  FrameQueries& queries = frames_[frame];
+  queries.scopes.clear();
+
+  if (!IsSupported()) {
+    return;
+  }
+
+  vkCmdResetQueryPool(command_buffer, query_pool_, frame * QUERIES_PER_FRAME,
+                      QUERIES_PER_FRAME);
+  queries.pending = true;
+}
+
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer command_buffer,
+                                 const char* name) {
+  uint32_t scope = ReserveScope(name);
+  if (INVALID_SCOPE == scope) {
+    return INVALID_SCOPE;
+  }
+
+  ++open_depth_;
+  WriteBegin(command_buffer, scope);
+
+  return scope;
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer command_buffer, uint32_t scope) {
+  if (INVALID_SCOPE == scope) {
+    return;
+  }
+
+  --open_depth_;
+  WriteEnd(command_buffer, scope);
+}
+
+uint32_t GpuProfiler::ReserveScope(const char* name) {
+  FrameQueries& queries = frames_[recording_frame_];
+  if (!IsSupported() || queries.scopes.size() >= MAX_PROFILER_SCOPES) {
+    return INVALID_SCOPE;
+  }
+
+  uint32_t scope = static_cast<uint32_t>(queries.scopes.size());
+  queries.scopes.push_back({name, open_depth_});
+
+  return scope;
+}
+
+void GpuProfiler::WriteBegin(VkCommandBuffer command_buffer,
+                             uint32_t scope) const {
+  if (INVALID_SCOPE == scope) {
+    return;
+  }
+
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                      query_pool_,
+                      recording_frame_ * QUERIES_PER_FRAME + scope * 2);
+}
+
+void GpuProfiler::WriteEnd(VkCommandBuffer command_buffer,
+                           uint32_t scope) const {
+  if (INVALID_SCOPE == scope) {
+    return;
+  }
+
+  vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                      query_pool_,
+                      recording_frame_ * QUERIES_PER_FRAME + scope * 2 + 1);
+}
+
+void GpuProfiler::DrawOverlay(const GpuProfiler* async_compute) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+
+  ImGui::Begin("Profiler");
+
+  ImGui::Text("Frame: %.2f ms (%.0f FPS)", frame_ms_,
+              frame_ms_ > 0.0 ? 1000.0 / frame_ms_ : 0.0);
+  if (IsSupported()) {
+    ImGui::Text("GPU:   %.2f ms", gpu_ms_);
+  } else {
+    ImGui::TextDisabled("GPU timestamps are not supported");
+  }
+
+  // oldest sample first once the ring has wrapped
+  int values_offset = PROFILER_HISTORY_SIZE == history_count_
+                          ? static_cast<int>(history_offset_)
+                          : 0;
+  int values_count = static_cast<int>(history_count_);
+
+  if (latency_average_ms_ >= 0.0) {
+    ImGui::Text("Input: %.2f ms (avg %.2f) to %s", latency_ms_,
+                latency_average_ms_,
+                latency_displayed_ ? "display" : "present");
+  }
+
+  ImGui::PlotLines("Frame (ms)", frame_history_.data(), values_count,
+                   values_offset, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+  if (IsSupported()) {
+    ImGui::PlotLines("GPU (ms)", gpu_history_.data(), values_count,
+                     values_offset, nullptr, 0.0f, FLT_MAX,
+                     ImVec2(0.0f, 60.0f));
+  }
+
+  DrawScopes("scopes");
+
+  if (nullptr != async_compute) {
+    std::lock_guard<std::mutex> async_lock(async_compute->stats_mutex_);
+
+    ImGui::Separator();
+    if (async_compute->IsSupported()) {
+      // its own timestamps, not comparable with the graphics queue's
+      ImGui::Text("Async compute: %.2f ms alongside %.2f ms of graphics",
+                  async_compute->gpu_ms_, gpu_ms_);
+      ImGui::PlotLines("Async (ms)", async_compute->gpu_history_.data(),
+                       static_cast<int>(async_compute->history_count_),
+                       PROFILER_HISTORY_SIZE == async_compute->history_count_
+                           ? static_cast<int>(async_compute->history_offset_)
+                           : 0,
+                       nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+      async_compute->DrawScopes("async_scopes");
+    } else {
+      ImGui::TextDisabled("Async compute timestamps are not supported");
+    }
+  }
+
+  ImGui::End();
+}
+
+void GpuProfiler::DrawScopes(const char* table_id) const {
+  ImGuiTableFlags table_flags =
+      ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV;
+  if (!stats_.empty() && ImGui::BeginTable(table_id, 3, table_flags)) {
+    ImGui::TableSetupColumn("Scope");
+    ImGui::TableSetupColumn("Last (ms)");
+    ImGui::TableSetupColumn("Avg (ms)");
+    ImGui::TableHeadersRow();
+
+    for (const auto& stats : stats_) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%*s%s", static_cast<int>(stats.depth * 2), "", stats.name);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.last_ms);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", stats.average_ms);
+    }
+
+    ImGui::EndTable();
+  }
+}
+
+void GpuProfiler::AddLatency(double ms, bool displayed) {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+
+  // measured to a different point, restart the average
+  if (displayed != latency_displayed_) {
+    latency_average_ms_ = -1.0;
+  }
+
+  latency_ms_ = ms;
+  latency_average_ms_ =
+      latency_average_ms_ < 0.0
+          ? ms
+          : latency_average_ms_ + (ms - latency_average_ms_) * AVERAGE_WEIGHT;
+  latency_displayed_ = displayed;
+}
+
+double GpuProfiler::GetGpuTime() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return gpu_ms_;
+}
+
+double GpuProfiler::GetFrameTime() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return frame_ms_;
+}
+
+double GpuProfiler::GetLatency() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return latency_average_ms_ < 0.0 ? 0.0 : latency_average_ms_;
+}
+
+void GpuProfiler::UpdateStats(const FrameQueries& queries) {
+  // scope layout changed, restart the averages
+  bool same_layout = stats_.size() == queries.scopes.size();
+  for (size_t i = 0; same_layout && i < stats_.size(); ++i) {
+    same_layout = stats_[i].name == queries.scopes[i].name;
+  }
+  if (!same_layout) {
+    stats_.clear();
+    for (const auto& scope : queries.scopes) {
+      stats_.push_back({scope.name, scope.depth, 0.0, -1.0});
+    }
+  }
+
+  uint64_t frame_begin = std::numeric_limits<uint64_t>::max();
+  uint64_t frame_end = 0;
+
+  for (size_t i = 0; i < queries.scopes.size(); ++i) {
+    uint64_t begin = results_[i * 2] & timestamp_mask_;
+    uint64_t end = results_[i * 2 + 1] & timestamp_mask_;
+
+    frame_begin = std::min(frame_begin, begin);
+    frame_end = std::max(frame_end, end);
+
+    // masked subtraction survives the counter wrapping around
+    double ms =
+        ((end - begin) & timestamp_mask_) * timestamp_period_ / 1000000.0;
+
+    ScopeStats& stats = stats_[i];
+    stats.last_ms = ms;
+    stats.average_ms = stats.average_ms < 0.0
+                           ? ms
+                           : stats.average_ms +
+                                 (ms - stats.average_ms) * AVERAGE_WEIGHT;
+  }
+
+  gpu_ms_ = frame_end > frame_begin
+                ? (frame_end - frame_begin) * timestamp_period_ / 1000000.0
+                : 0.0;
+}
+
+void GpuProfiler::PushHistory(float frame_ms, float gpu_ms) {
+  frame_history_[history_offset_] = frame_ms;
+  gpu_history_[history_offset_] = gpu_ms;
+
+  history_offset_ = (history_offset_ + 1) % PROFILER_HISTORY_SIZE;
+  history_count_ = std::min(history_count_ + 1, PROFILER_HISTORY_SIZE);
+}
+
+}  // namespace playground
@@ -0,0 +1,229 @@
+/**
+ * @file gpu_timeline.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-26
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "gpu_timeline.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+// core name on 1.2 devices, the KHR alias when only the extension is there
+PFN_vkVoidFunction GetDeviceFunction(VkDevice device, const char* name,
+                                     const char* khr_name) {
+  PFN_vkVoidFunction function = vkGetDeviceProcAddr(device, name);
+  return function ? function : vkGetDeviceProcAddr(device, khr_name);
+}
+
+}  // namespace
+
+void GpuTimeline::Init(VkDevice device, bool timeline_semaphore) {
+  device_ = device;
+
+  if (timeline_semaphore) {
+    get_counter_value_ = reinterpret_cast<PFN_vkGetSemaphoreCounterValue>(
+        GetDeviceFunction(device_, "vkGetSemaphoreCounterValue",
+                          "vkGetSemaphoreCounterValueKHR"));
+    wait_semaphores_ = reinterpret_cast<PFN_vkWaitSemaphores>(
+        GetDeviceFunction(device_, "vkWaitSemaphores", "vkWaitSemaphoresKHR"));
+  }
+
+  if (!get_counter_value_ || !wait_semaphores_) {
+    std::clog << "----- GPU Timeline: fence per submission -----" << std::endl;
+    return;
+  }
+
+  VkSemaphoreTypeCreateInfo type_info{};
+  type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  type_info.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphore_info{};
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphore_info.pNext = &type_info;
+
+  if (VK_SUCCESS !=
+      vkCreateSemaphore(device_, &semaphore_info, nullptr, &semaphore_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create timeline semaphore -----");
+  }
+
+  std::clog << "----- GPU Timeline: timeline semaphore -----" << std::endl;
+}
+
+void GpuTimeline::Destroy() {
+  WaitForValue(GetSubmittedValue());
+
+  if (VK_NULL_HANDLE != semaphore_) {
+    vkDestroySemaphore(device_, semaphore_, nullptr);
+    semaphore_ = VK_NULL_HANDLE;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto fence : free_fences_) {
+    vkDestroyFence(device_, fence, nullptr);
+  }
+  free_fences_.clear();
+}
+
+bool GpuTimeline::IsTimelineSemaphore() const {
+  return VK_NULL_HANDLE != semaphore_;
+}
+
+uint64_t GpuTimeline::Submit(VkQueue queue, const VkSubmitInfo& submit_info) {
+  // values have to reach the queue in increasing order
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  uint64_t value = submitted_value_.load(std::memory_order_relaxed) + 1;
+
+  VkSubmitInfo info = submit_info;
+  std::vector<VkSemaphore> signal_semaphores{};
+  std::vector<uint64_t> signal_values{};
+  VkTimelineSemaphoreSubmitInfo timeline_info{};
+  VkFence fence = VK_NULL_HANDLE;
+
+  if (IsTimelineSemaphore()) {
+    signal_semaphores.assign(
+        info.pSignalSemaphores,
+        info.pSignalSemaphores + info.signalSemaphoreCount);
+    signal_semaphores.push_back(semaphore_);
+    // binary semaphores ignore their value
+    signal_values.assign(signal_semaphores.size(), 0);
+    signal_values.back() = value;
+
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.pNext = info.pNext;
+    timeline_info.signalSemaphoreValueCount =
+        static_cast<uint32_t>(signal_values.size());
+    timeline_info.pSignalSemaphoreValues = signal_values.data();
+
+    info.pNext = &timeline_info;
+    info.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+    info.pSignalSemaphores = signal_semaphores.data();
+  } else {
+    fence = AcquireFence();
+  }
+
+  if (VK_SUCCESS != vkQueueSubmit(queue, 1, &info, fence)) {
+    if (VK_NULL_HANDLE != fence) {
+      free_fences_.push_back(fence);
+    }
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to submit to the GPU timeline -----");
+  }
+
+  if (VK_NULL_HANDLE != fence) {
+    pending_fences_.push_back({value, fence});
+  }
+  submitted_value_.store(value, std::memory_order_release);
+
+  return value;
+}
+
+uint64_t GpuTimeline::GetSubmittedValue() const {
+  return submitted_value_.load(std::memory_order_acquire);
+}
+
+uint64_t GpuTimeline::GetCompletedValue() {
+  if (IsTimelineSemaphore()) {
+    uint64_t value = 0;
+    if (VK_SUCCESS != get_counter_value_(device_, semaphore_, &value)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to read the timeline semaphore -----");
+    }
+    completed_value_.store(value, std::memory_order_release);
+    return value;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  CollectFences();
+  return completed_value_.load(std::memory_order_acquire);
+}
+
+bool GpuTimeline::IsComplete(uint64_t value) {
+  if (value <= completed_value_.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  return value <= GetCompletedValue();
+}
+
+void GpuTimeline::WaitForValue(uint64_t value) {
+  if (IsComplete(value)) {
+    return;
+  }
+
+  if (IsTimelineSemaphore()) {
+    VkSemaphoreWaitInfo wait_info{};
+    wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &semaphore_;
+    wait_info.pValues = &value;
+
+    if (VK_SUCCESS != wait_semaphores_(device_, &wait_info, UINT64_MAX)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to wait for the timeline semaphore "
+          "-----");
+    }
+    GetCompletedValue();
+    return;
+  }
+
+  // fences retire in order, waiting on the one holding `value` covers the
+  // ones before it; held locked so the fence is not recycled meanwhile
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto pending = std::find_if(
+      pending_fences_.begin(), pending_fences_.end(),
+      [value](const PendingFence& fence) { return fence.value >= value; });
+  if (pending != pending_fences_.end()) {
+    vkWaitForFences(device_, 1, &pending->fence, VK_TRUE, UINT64_MAX);
+  }
+  CollectFences();
+}
+
+VkFence GpuTimeline::AcquireFence() {
+  if (!free_fences_.empty()) {
+    VkFence fence = free_fences_.back();
+    free_fences_.pop_back();
+    vkResetFences(device_, 1, &fence);
+    return fence;
+  }
+
+  VkFenceCreateInfo fence_info{};
+  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+  VkFence fence;
+  if (VK_SUCCESS != vkCreateFence(device_, &fence_info, nullptr, &fence)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create timeline fence -----");
+  }
+
+  return fence;
+}
+
+void GpuTimeline::CollectFences() {
+  while (!pending_fences_.empty()) {
+    const PendingFence& pending = pending_fences_.front();
+    if (VK_SUCCESS != vkGetFenceStatus(device_, pending.fence)) {
+      break;
+    }
+
+    completed_value_.store(pending.value, std::memory_order_release);
+    free_fences_.push_back(pending.fence);
+    pending_fences_.pop_front();
+  }
+}
+
+}  // namespace playground
@@ -0,0 +1,708 @@
+/**
+ * @file imgui_renderer.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-30
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "imgui_renderer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <imgui.h>
+#include <imgui_impl_vulkan.h>
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+const uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+const uint64_t HASH_MULTIPLIER = 0x9e3779b97f4a7c15ull;
+
+// 'scale' and 'translate' of imgui.vert
+struct PushConstants {
+  float scale[2];
+  float translate[2];
+};
+
+uint64_t HashWord(uint64_t hash, uint64_t word) {
+  hash = (hash ^ word) * HASH_MULTIPLIER;
+  return hash ^ (hash >> 29);
+}
+
+// eight bytes a step, only has to tell a changed draw list from the last one
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = HashWord(hash, word);
+  }
+
+  uint64_t tail = 0;
+  if (i < size) {
+    std::memcpy(&tail, bytes + i, size - i);
+  }
+  return HashWord(hash, tail ^ size);
+}
+
+uint64_t HashDrawList(uint64_t hash, const ImDrawList* draw_list) {
+  hash = HashBytes(hash, draw_list->VtxBuffer.Data,
+                   draw_list->VtxBuffer.Size * sizeof(ImDrawVert));
+  return HashBytes(hash, draw_list->IdxBuffer.Data,
+                   draw_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+}
+
+}  // namespace
+
+void ImGuiRenderer::Init(VkDevice device, MemoryAllocator& allocator,
+                         uint32_t frames_in_flight,
+                         VkPipelineCache pipeline_cache,
+                         const ImGuiShaders& shaders, VkRenderPass render_pass,
+                         VkFormat color_format) {
+  device_ = device;
+  allocator_ = &allocator;
+  render_pass_ = render_pass;
+  color_format_ = color_format;
+
+  CreateDescriptorSetLayout();
+  CreatePipelineLayout();
+  CreateFontSampler();
+  CreateDescriptorSet();
+  pipeline_ = CreatePipeline(pipeline_cache, shaders);
+
+  frames_.resize(frames_in_flight);
+}
+
+void ImGuiRenderer::Destroy() {
+  if (VK_NULL_HANDLE == device_) {
+    return;
+  }
+
+  for (auto& buffers : frames_) {
+    DestroyBuffer(buffers.vertex_buffer, buffers.vertex_memory);
+    DestroyBuffer(buffers.index_buffer, buffers.index_memory);
+  }
+  frames_.clear();
+
+  vkDestroyImageView(device_, font_view_, nullptr);
+  if (VK_NULL_HANDLE != font_image_) {
+    vkDestroyImage(device_, font_image_, nullptr);
+    allocator_->Free(font_memory_);
+  }
+  vkDestroyDescriptorPool(device_, descriptor_pool_, nullptr);
+  vkDestroySampler(device_, font_sampler_, nullptr);
+
+  vkDestroyPipeline(device_, pipeline_, nullptr);
+  vkDestroyPipelineLayout(device_, pipeline_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, nullptr);
+}
+
+VkPipeline ImGuiRenderer::CreatePipeline(VkPipelineCache pipeline_cache,
+                                         const ImGuiShaders& shaders) const {
+  const std::vector<char>* codes[] = {shaders.vert, shaders.frag};
+  VkShaderModule shader_modules[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
+  for (size_t i = 0; i < 2; ++i) {
+    VkShaderModuleCreateInfo shader_module_info{};
+    shader_module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_module_info.codeSize = codes[i]->size();
+    shader_module_info.pCode =
+        reinterpret_cast<const uint32_t*>(codes[i]->data());
+
+    if (VK_SUCCESS != vkCreateShaderModule(device_, &shader_module_info,
+                                           nullptr, &shader_modules[i])) {
+      vkDestroyShaderModule(device_, shader_modules[0], nullptr);
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create ImGui shader module -----");
+    }
+  }
+
+  VkPipelineShaderStageCreateInfo shader_stage_infos[2]{};
+  shader_stage_infos[0].sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shader_stage_infos[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+  shader_stage_infos[0].module = shader_modules[0];
+  shader_stage_infos[0].pName = "main";
+  shader_stage_infos[1].sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  shader_stage_infos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+  shader_stage_infos[1].module = shader_modules[1];
+  shader_stage_infos[1].pName = "main";
+
+  VkVertexInputBindingDescription binding_desc{};
+  binding_desc.binding = 0;
+  binding_desc.stride = sizeof(ImDrawVert);
+  binding_desc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+  VkVertexInputAttributeDescription attribute_descs[3]{};
+  attribute_descs[0].location = 0;
+  attribute_descs[0].format = VK_FORMAT_R32G32_SFLOAT;
+  attribute_descs[0].offset = offsetof(ImDrawVert, pos);
+  attribute_descs[1].location = 1;
+  attribute_descs[1].format = VK_FORMAT_R32G32_SFLOAT;
+  attribute_descs[1].offset = offsetof(ImDrawVert, uv);
+  attribute_descs[2].location = 2;
+  attribute_descs[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+  attribute_descs[2].offset = offsetof(ImDrawVert, col);
+
+  VkPipelineVertexInputStateCreateInfo vertex_input_info{};
+  vertex_input_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+  vertex_input_info.vertexBindingDescriptionCount = 1;
+  vertex_input_info.pVertexBindingDescriptions = &binding_desc;
+  vertex_input_info.vertexAttributeDescriptionCount = 3;
+  vertex_input_info.pVertexAttributeDescriptions = attribute_descs;
+
+  VkPipelineInputAssemblyStateCreateInfo input_assembly_info{};
+  input_assembly_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+  input_assembly_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+  // both set per draw data
+  VkPipelineViewportStateCreateInfo viewport_state_info{};
+  viewport_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+  viewport_state_info.viewportCount = 1;
+  viewport_state_info.scissorCount = 1;
+
+  VkPipelineRasterizationStateCreateInfo rasterizer_state_info{};
+  rasterizer_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+  rasterizer_state_info.polygonMode = VK_POLYGON_MODE_FILL;
+  rasterizer_state_info.cullMode = VK_CULL_MODE_NONE;
+  rasterizer_state_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+  rasterizer_state_info.lineWidth = 1.0f;
+
+  VkPipelineMultisampleStateCreateInfo multisample_state_info{};
+  multisample_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+  multisample_state_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+  // over what post processing left in the swap chain image
+  VkPipelineColorBlendAttachmentState color_blend_attachment{};
+  color_blend_attachment.blendEnable = VK_TRUE;
+  color_blend_attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+  color_blend_attachment.dstColorBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  color_blend_attachment.colorBlendOp = VK_BLEND_OP_ADD;
+  color_blend_attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+  color_blend_attachment.dstAlphaBlendFactor =
+      VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+  color_blend_attachment.alphaBlendOp = VK_BLEND_OP_ADD;
+  color_blend_attachment.colorWriteMask =
+      VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+  VkPipelineColorBlendStateCreateInfo color_blend_state_info{};
+  color_blend_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+  color_blend_state_info.attachmentCount = 1;
+  color_blend_state_info.pAttachments = &color_blend_attachment;
+
+  VkPipelineDepthStencilStateCreateInfo depth_stencil_state_info{};
+  depth_stencil_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+
+  VkDynamicState dynamic_states[] = {VK_DYNAMIC_STATE_VIEWPORT,
+                                     VK_DYNAMIC_STATE_SCISSOR};
+  VkPipelineDynamicStateCreateInfo dynamic_state_info{};
+  dynamic_state_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+  dynamic_state_info.dynamicStateCount = 2;
+  dynamic_state_info.pDynamicStates = dynamic_states;
+
+  VkGraphicsPipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+  pipeline_info.stageCount = 2;
+  pipeline_info.pStages = shader_stage_infos;
+  pipeline_info.pVertexInputState = &vertex_input_info;
+  pipeline_info.pInputAssemblyState = &input_assembly_info;
+  pipeline_info.pViewportState = &viewport_state_info;
+  pipeline_info.pRasterizationState = &rasterizer_state_info;
+  pipeline_info.pMultisampleState = &multisample_state_info;
+  pipeline_info.pDepthStencilState = &depth_stencil_state_info;
+  pipeline_info.pColorBlendState = &color_blend_state_info;
+  pipeline_info.pDynamicState = &dynamic_state_info;
+  pipeline_info.layout = pipeline_layout_;
+  pipeline_info.renderPass = render_pass_;
+  pipeline_info.subpass = 0;
+
+  // without a render pass the attachment format comes from here
+  VkPipelineRenderingCreateInfoKHR rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachmentFormats = &color_format_;
+  if (VK_NULL_HANDLE == render_pass_) {
+    pipeline_info.pNext = &rendering_info;
+  }
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result = vkCreateGraphicsPipelines(device_, pipeline_cache, 1,
+                                              &pipeline_info, nullptr,
+                                              &pipeline);
+  vkDestroyShaderModule(device_, shader_modules[0], nullptr);
+  vkDestroyShaderModule(device_, shader_modules[1], nullptr);
+
+  if (VK_SUCCESS != result) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui pipeline -----");
+  }
+
+  return pipeline;
+}
+
+VkPipeline ImGuiRenderer::SwapPipeline(VkPipeline pipeline) {
+  std::swap(pipeline_, pipeline);
+  return pipeline;
+}
+
+void ImGuiRenderer::UploadFonts(ImGuiIO& io, UploadContext& upload_context) {
+  unsigned char* pixels = nullptr;
+  int width = 0, height = 0;
+  io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+  VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+
+  StagingAllocation staging = upload_context.Stage(pixels, size, 16);
+
+  VkImageCreateInfo image_info{};
+  image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  image_info.imageType = VK_IMAGE_TYPE_2D;
+  image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+  image_info.extent.width = static_cast<uint32_t>(width);
+  image_info.extent.height = static_cast<uint32_t>(height);
+  image_info.extent.depth = 1;
+  image_info.mipLevels = 1;
+  image_info.arrayLayers = 1;
+  image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+  image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+  image_info.usage =
+      VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  if (VK_SUCCESS !=
+      vkCreateImage(device_, &image_info, nullptr, &font_image_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui font image -----");
+  }
+
+  VkMemoryRequirements requirements{};
+  vkGetImageMemoryRequirements(device_, font_image_, &requirements);
+  font_memory_ = allocator_->Allocate(
+      requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+  if (VK_SUCCESS != vkBindImageMemory(device_, font_image_,
+                                      font_memory_.memory,
+                                      font_memory_.offset)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to bind ImGui font image memory -----");
+  }
+
+  VkImageSubresourceRange range{};
+  range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  range.levelCount = 1;
+  range.layerCount = 1;
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = staging.offset;
+  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.imageSubresource.layerCount = 1;
+  region.imageExtent = {image_info.extent.width, image_info.extent.height, 1};
+
+  // lands in the open batch next to the frame's other uploads
+  upload_context.TransitionImageLayout(font_image_, VK_IMAGE_LAYOUT_UNDEFINED,
+                                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                       range);
+  upload_context.CopyBufferToImage(staging.buffer, font_image_, {region});
+  upload_context.TransitionImageLayout(
+      font_image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
+
+  VkImageViewCreateInfo view_info{};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.image = font_image_;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+  view_info.subresourceRange = range;
+
+  if (VK_SUCCESS !=
+      vkCreateImageView(device_, &view_info, nullptr, &font_view_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui font image view -----");
+  }
+
+  VkDescriptorImageInfo descriptor_image_info{};
+  descriptor_image_info.sampler = font_sampler_;
+  descriptor_image_info.imageView = font_view_;
+  descriptor_image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  VkWriteDescriptorSet write{};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = font_set_;
+  write.dstBinding = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  write.pImageInfo = &descriptor_image_info;
+  vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+
+  // the backend binds its texture ids with its own layout, Record() maps
+  // this one back to the set above
+  VkDescriptorSet backend_set = ImGui_ImplVulkan_AddTexture(
+      font_sampler_, font_view_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  font_texture_id_ = (ImTextureID)backend_set;
+  io.Fonts->SetTexID(font_texture_id_);
+}
+
+void ImGuiRenderer::Record(VkCommandBuffer command_buffer, uint32_t frame,
+                           const ImDrawData* draw_data) {
+  if (nullptr == draw_data || 0 == draw_data->TotalVtxCount) {
+    return;
+  }
+
+  // in framebuffer pixels, minimized windows have none
+  float width = draw_data->DisplaySize.x * draw_data->FramebufferScale.x;
+  float height = draw_data->DisplaySize.y * draw_data->FramebufferScale.y;
+  if (width <= 0.0f || height <= 0.0f) {
+    return;
+  }
+
+  FrameBuffers& buffers = frames_[frame];
+  Upload(buffers, draw_data);
+  SetupRenderState(command_buffer, buffers, draw_data);
+
+  ImVec2 clip_offset = draw_data->DisplayPos;
+  ImVec2 clip_scale = draw_data->FramebufferScale;
+
+  VkDescriptorSet bound_set = VK_NULL_HANDLE;
+  uint32_t vertex_offset = 0;
+  uint32_t index_offset = 0;
+  for (int i = 0; i < draw_data->CmdListsCount; ++i) {
+    const ImDrawList* draw_list = draw_data->CmdLists[i];
+
+    for (const ImDrawCmd& draw_cmd : draw_list->CmdBuffer) {
+      if (nullptr != draw_cmd.UserCallback) {
+        if (ImDrawCallback_ResetRenderState == draw_cmd.UserCallback) {
+          SetupRenderState(command_buffer, buffers, draw_data);
+          bound_set = VK_NULL_HANDLE;
+        } else {
+          draw_cmd.UserCallback(draw_list, &draw_cmd);
+        }
+        continue;
+      }
+
+      float min_x = (draw_cmd.ClipRect.x - clip_offset.x) * clip_scale.x;
+      float min_y = (draw_cmd.ClipRect.y - clip_offset.y) * clip_scale.y;
+      float max_x = (draw_cmd.ClipRect.z - clip_offset.x) * clip_scale.x;
+      float max_y = (draw_cmd.ClipRect.w - clip_offset.y) * clip_scale.y;
+      min_x = std::max(min_x, 0.0f);
+      min_y = std::max(min_y, 0.0f);
+      max_x = std::min(max_x, width);
+      max_y = std::min(max_y, height);
+      if (max_x <= min_x || max_y <= min_y) {
+        continue;
+      }
+
+      VkRect2D scissor{};
+      scissor.offset.x = static_cast<int32_t>(min_x);
+      scissor.offset.y = static_cast<int32_t>(min_y);
+      scissor.extent.width = static_cast<uint32_t>(max_x - min_x);
+      scissor.extent.height = static_cast<uint32_t>(max_y - min_y);
+      vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+      // user textures are sets allocated by the backend
+      VkDescriptorSet set = font_texture_id_ == draw_cmd.TextureId
+                                ? font_set_
+                                : (VkDescriptorSet)draw_cmd.TextureId;
+      if (set != bound_set) {
+        vkCmdBindDescriptorSets(command_buffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipeline_layout_, 0, 1, &set, 0, nullptr);
+        bound_set = set;
+      }
+
+      vkCmdDrawIndexed(command_buffer, draw_cmd.ElemCount, 1,
+                       draw_cmd.IdxOffset + index_offset,
+                       static_cast<int32_t>(draw_cmd.VtxOffset +
+                                            vertex_offset),
+                       0);
+    }
+
+    vertex_offset += static_cast<uint32_t>(draw_list->VtxBuffer.Size);
+    index_offset += static_cast<uint32_t>(draw_list->IdxBuffer.Size);
+  }
+}
+
+bool ImGuiRenderer::ShouldRenderPlatformWindows() {
+  // the main viewport is drawn by Record(), the others are what
+  // RenderPlatformWindowsDefault() renders and presents
+  ImGuiPlatformIO& platform_io = ImGui::GetPlatformIO();
+  uint64_t hash = HASH_SEED;
+  for (int i = 1; i < platform_io.Viewports.Size; ++i) {
+    const ImGuiViewport* viewport = platform_io.Viewports[i];
+    if (viewport->Flags & ImGuiViewportFlags_Minimized) {
+      continue;
+    }
+
+    hash = HashWord(hash, viewport->ID);
+    hash = HashBytes(hash, &viewport->Pos, sizeof(viewport->Pos));
+    hash = HashBytes(hash, &viewport->Size, sizeof(viewport->Size));
+
+    const ImDrawData* draw_data = viewport->DrawData;
+    if (nullptr == draw_data) {
+      continue;
+    }
+    for (int j = 0; j < draw_data->CmdListsCount; ++j) {
+      const ImDrawList* draw_list = draw_data->CmdLists[j];
+      hash = HashDrawList(hash, draw_list);
+      // clip rects and textures
+      hash = HashBytes(hash, draw_list->CmdBuffer.Data,
+                       draw_list->CmdBuffer.Size * sizeof(ImDrawCmd));
+    }
+  }
+
+  if (hash == platform_windows_hash_) {
+    return false;
+  }
+
+  // the change is picked up by a later frame
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - platform_windows_time_).count() <
+      PLATFORM_WINDOWS_MIN_INTERVAL) {
+    return false;
+  }
+
+  platform_windows_hash_ = hash;
+  platform_windows_time_ = now;
+  return true;
+}
+
+void ImGuiRenderer::CreateDescriptorSetLayout() {
+  VkDescriptorSetLayoutBinding binding{};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  binding.descriptorCount = 1;
+  binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+  VkDescriptorSetLayoutCreateInfo layout_info{};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = 1;
+  layout_info.pBindings = &binding;
+
+  if (VK_SUCCESS != vkCreateDescriptorSetLayout(device_, &layout_info, nullptr,
+                                                &descriptor_set_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui descriptor set layout "
+        "-----");
+  }
+}
+
+void ImGuiRenderer::CreatePipelineLayout() {
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(PushConstants);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info{};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout_;
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+  if (VK_SUCCESS != vkCreatePipelineLayout(device_, &pipeline_layout_info,
+                                           nullptr, &pipeline_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui pipeline layout -----");
+  }
+}
+
+void ImGuiRenderer::CreateFontSampler() {
+  VkSamplerCreateInfo sampler_info{};
+  sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampler_info.magFilter = VK_FILTER_LINEAR;
+  sampler_info.minFilter = VK_FILTER_LINEAR;
+  sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+  sampler_info.minLod = -1000.0f;
+  sampler_info.maxLod = 1000.0f;
+  sampler_info.maxAnisotropy = 1.0f;
+
+  if (VK_SUCCESS !=
+      vkCreateSampler(device_, &sampler_info, nullptr, &font_sampler_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui font sampler -----");
+  }
+}
+
+void ImGuiRenderer::CreateDescriptorSet() {
+  VkDescriptorPoolSize pool_size{};
+  pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_size.descriptorCount = 1;
+
+  VkDescriptorPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.maxSets = 1;
+  pool_info.poolSizeCount = 1;
+  pool_info.pPoolSizes = &pool_size;
+
+  if (VK_SUCCESS != vkCreateDescriptorPool(device_, &pool_info, nullptr,
+                                           &descriptor_pool_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui descriptor pool -----");
+  }
+
+  VkDescriptorSetAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = descriptor_pool_;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+  if (VK_SUCCESS != vkAllocateDescriptorSets(device_, &alloc_info,
+                                             &font_set_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate ImGui descriptor set -----");
+  }
+}
+
+void ImGuiRenderer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                 VkBuffer& buffer, Allocation& memory) {
+  VkBufferCreateInfo buffer_info{};
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.size = size;
+  buffer_info.usage = usage;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  if (VK_SUCCESS != vkCreateBuffer(device_, &buffer_info, nullptr, &buffer)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create ImGui buffer -----");
+  }
+
+  VkMemoryRequirements requirements{};
+  vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+  memory = allocator_->Allocate(requirements,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                true);
+
+  if (VK_SUCCESS !=
+      vkBindBufferMemory(device_, buffer, memory.memory, memory.offset)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to bind ImGui buffer memory -----");
+  }
+}
+
+void ImGuiRenderer::DestroyBuffer(VkBuffer& buffer, Allocation& memory) {
+  if (VK_NULL_HANDLE == buffer) {
+    return;
+  }
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_->Free(memory);
+  buffer = VK_NULL_HANDLE;
+}
+
+void ImGuiRenderer::Reserve(FrameBuffers& buffers, VkDeviceSize vertex_size,
+                            VkDeviceSize index_size) {
+  // the frame's previous submission has finished, nothing to retire; grown
+  // with headroom so a growing window does not reallocate every frame
+  if (vertex_size > buffers.vertex_capacity) {
+    DestroyBuffer(buffers.vertex_buffer, buffers.vertex_memory);
+    buffers.vertex_capacity =
+        std::max(vertex_size, buffers.vertex_capacity * 2);
+    CreateBuffer(buffers.vertex_capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                 buffers.vertex_buffer, buffers.vertex_memory);
+    buffers.lists.clear();
+  }
+
+  if (index_size > buffers.index_capacity) {
+    DestroyBuffer(buffers.index_buffer, buffers.index_memory);
+    buffers.index_capacity = std::max(index_size, buffers.index_capacity * 2);
+    CreateBuffer(buffers.index_capacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                 buffers.index_buffer, buffers.index_memory);
+    buffers.lists.clear();
+  }
+}
+
+void ImGuiRenderer::Upload(FrameBuffers& buffers,
+                           const ImDrawData* draw_data) {
+  Reserve(buffers,
+          VkDeviceSize{sizeof(ImDrawVert)} *
+              static_cast<uint32_t>(draw_data->TotalVtxCount),
+          VkDeviceSize{sizeof(ImDrawIdx)} *
+              static_cast<uint32_t>(draw_data->TotalIdxCount));
+
+  auto vertices = static_cast<ImDrawVert*>(buffers.vertex_memory.mapped);
+  auto indices = static_cast<ImDrawIdx*>(buffers.index_memory.mapped);
+
+  // a list is copied unless this frame's buffers already hold it in the same
+  // place, e.g. panels that did not change since the frame was last drawn
+  uint32_t list_cnt = static_cast<uint32_t>(draw_data->CmdListsCount);
+  std::vector<ListRange>& lists = buffers.lists;
+  lists.resize(list_cnt);
+
+  ListRange range{};
+  for (uint32_t i = 0; i < list_cnt; ++i) {
+    const ImDrawList* draw_list = draw_data->CmdLists[i];
+    range.vertex_count = static_cast<uint32_t>(draw_list->VtxBuffer.Size);
+    range.index_count = static_cast<uint32_t>(draw_list->IdxBuffer.Size);
+    range.hash = HashDrawList(HASH_SEED, draw_list);
+
+    bool held = lists[i].hash == range.hash &&
+                lists[i].vertex_offset == range.vertex_offset &&
+                lists[i].vertex_count == range.vertex_count &&
+                lists[i].index_offset == range.index_offset &&
+                lists[i].index_count == range.index_count;
+    if (!held && 0 != range.vertex_count) {
+      std::memcpy(vertices + range.vertex_offset, draw_list->VtxBuffer.Data,
+                  range.vertex_count * sizeof(ImDrawVert));
+      std::memcpy(indices + range.index_offset, draw_list->IdxBuffer.Data,
+                  range.index_count * sizeof(ImDrawIdx));
+    }
+    lists[i] = range;
+
+    range.vertex_offset += range.vertex_count;
+    range.index_offset += range.index_count;
+  }
+}
+
+void ImGuiRenderer::SetupRenderState(VkCommandBuffer command_buffer,
+                                     const FrameBuffers& buffers,
+                                     const ImDrawData* draw_data) {
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                    pipeline_);
+
+  VkDeviceSize offset = 0;
+  vkCmdBindVertexBuffers(command_buffer, 0, 1, &buffers.vertex_buffer,
+                         &offset);
+  vkCmdBindIndexBuffer(command_buffer, buffers.index_buffer, 0,
+                       sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16
+                                              : VK_INDEX_TYPE_UINT32);
+
+  VkViewport viewport{};
+  viewport.width = draw_data->DisplaySize.x * draw_data->FramebufferScale.x;
+  viewport.height = draw_data->DisplaySize.y * draw_data->FramebufferScale.y;
+  viewport.minDepth = 0.0f;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+
+  // display space to clip space
+  PushConstants constants{};
+  constants.scale[0] = 2.0f / draw_data->DisplaySize.x;
+  constants.scale[1] = 2.0f / draw_data->DisplaySize.y;
+  constants.translate[0] = -1.0f - draw_data->DisplayPos.x * constants.scale[0];
+  constants.translate[1] = -1.0f - draw_data->DisplayPos.y * constants.scale[1];
+  vkCmdPushConstants(command_buffer, pipeline_layout_,
+                     VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants),
+                     &constants);
+}
+
+}  // namespace playground
@@ -0,0 +1,205 @@
+/**
+ * @file job_system.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-11
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "job_system.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <utility>
+
+#include "trace.h"
+
+namespace playground {
+
+namespace {
+
+thread_local const JobSystem* t_owner = nullptr;
+thread_local uint32_t t_index = 0;
+
+// jobs nobody waits on for their result
+void LogError(std::exception_ptr error) {
+  try {
+    std::rethrow_exception(error);
+  } catch (const std::exception& e) {
+    std::cerr << "----- Error::Job: " << e.what() << " -----" << std::endl;
+  } catch (...) {
+    std::cerr << "----- Error::Job: unknown exception -----" << std::endl;
+  }
+}
+
+}  // namespace
+
+JobSystem::JobSystem(uint32_t thread_count) {
+  if (0 == thread_count) {
+    uint32_t hardware_threads = std::thread::hardware_concurrency();
+    thread_count = std::max(1u, hardware_threads > 1 ? hardware_threads - 1
+                                                     : hardware_threads);
+  }
+
+  for (uint32_t i = 0; i <= thread_count; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(&JobSystem::WorkerLoop, this, i);
+  }
+
+  std::clog << "----- Job System: " << thread_count << " worker thread(s) -----"
+            << std::endl;
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void JobSystem::Schedule(Job job, JobCounter* counter) {
+  if (counter) {
+    counter->count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Queue& queue = *queues_[ThreadIndex()];
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+    queue.counters.push_back(counter);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    pending_.fetch_add(1, std::memory_order_release);
+  }
+  wake_.notify_one();
+}
+
+void JobSystem::Wait(const JobCounter& counter) {
+  uint32_t index = ThreadIndex();
+
+  while (!counter.IsDone()) {
+    if (!TryRunOne(index)) {
+      std::this_thread::yield();
+    }
+  }
+
+  if (counter.error) {
+    std::rethrow_exception(counter.error);
+  }
+}
+
+void JobSystem::ParallelFor(
+    uint32_t count, uint32_t chunk_size,
+    const std::function<void(uint32_t, uint32_t)>& function) {
+  chunk_size = std::max(1u, chunk_size);
+
+  JobCounter counter{};
+  for (uint32_t begin = 0; begin < count; begin += chunk_size) {
+    uint32_t end = std::min(count, begin + chunk_size);
+    Schedule([&function, begin, end]() { function(begin, end); }, &counter);
+  }
+
+  Wait(counter);
+}
+
+uint32_t JobSystem::ThreadCount() const {
+  return static_cast<uint32_t>(threads_.size());
+}
+
+uint32_t JobSystem::ThreadIndex() const {
+  return this == t_owner ? t_index : ThreadCount();
+}
+
+void JobSystem::WorkerLoop(uint32_t index) {
+  t_owner = this;
+  t_index = index;
+
+  Tracer::Get().SetThreadName("Worker " + std::to_string(index));
+
+  while (running_) {
+    if (TryRunOne(index)) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    wake_.wait(lock, [this]() {
+      return !running_ || pending_.load(std::memory_order_acquire) > 0;
+    });
+  }
+}
+
+bool JobSystem::TryRunOne(uint32_t index) {
+  Job job{};
+  JobCounter* counter = nullptr;
+
+  // own queue first (LIFO keeps caches warm), then steal from the others
+  bool found = Pop(index, false, job, counter);
+  for (size_t i = 1; !found && i < queues_.size(); ++i) {
+    found = Pop(static_cast<uint32_t>((index + i) % queues_.size()), true, job,
+                counter);
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  pending_.fetch_sub(1, std::memory_order_acq_rel);
+
+  try {
+    TRACE_SCOPE("Job");
+    job();
+  } catch (...) {
+    // published to Wait() by the count dropping below
+    if (counter && !counter->failed.exchange(true, std::memory_order_relaxed)) {
+      counter->error = std::current_exception();
+    } else {
+      LogError(std::current_exception());
+    }
+  }
+
+  if (counter) {
+    counter->count.fetch_sub(1, std::memory_order_release);
+  }
+
+  return true;
+}
+
+bool JobSystem::Pop(uint32_t index, bool steal, Job& job,
+                    JobCounter*& counter) {
+  Queue& queue = *queues_[index];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+
+  if (queue.jobs.empty()) {
+    return false;
+  }
+
+  if (steal) {
+    job = std::move(queue.jobs.front());
+    counter = queue.counters.front();
+    queue.jobs.pop_front();
+    queue.counters.pop_front();
+  } else {
+    job = std::move(queue.jobs.back());
+    counter = queue.counters.back();
+    queue.jobs.pop_back();
+    queue.counters.pop_back();
+  }
+
+  return true;
+}
+
+}  // namespace playground
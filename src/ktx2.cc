@@ -0,0 +1,211 @@
+/**
+ * @file ktx2.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-21
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+const unsigned char KTX2_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58,
+                                           0x20, 0x32, 0x30, 0xBB,
+                                           0x0D, 0x0A, 0x1A, 0x0A};
+
+// follows the identifier, see the KTX 2.0 specification
+struct Ktx2Header {
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t layer_count;
+  uint32_t face_count;
+  uint32_t level_count;
+  uint32_t supercompression_scheme;
+};
+
+// data format, key/value and supercompression data, unused here
+struct Ktx2Index {
+  uint32_t dfd_byte_offset;
+  uint32_t dfd_byte_length;
+  uint32_t kvd_byte_offset;
+  uint32_t kvd_byte_length;
+  uint64_t sgd_byte_offset;
+  uint64_t sgd_byte_length;
+};
+
+struct Ktx2LevelIndex {
+  uint64_t byte_offset;
+  uint64_t byte_length;
+  uint64_t uncompressed_byte_length;
+};
+
+// texels per block and its size in bytes, 1x1 for uncompressed formats
+struct FormatBlock {
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytes;
+};
+
+// zero sized for formats the loader cannot check the levels of
+FormatBlock GetFormatBlock(uint32_t vk_format) {
+  switch (static_cast<VkFormat>(vk_format)) {
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SRGB:
+      return {1, 1, 1};
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SRGB:
+      return {1, 1, 2};
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+      return {1, 1, 4};
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+      return {1, 1, 8};
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+      return {1, 1, 16};
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:
+      return {4, 4, 8};
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC2_SRGB_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC3_SRGB_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_BC7_SRGB_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:
+      return {4, 4, 16};
+    default:
+      break;
+  }
+
+  // ASTC LDR: UNORM and SRGB of each footprint in turn, 16 bytes each
+  const uint32_t ASTC_FOOTPRINTS[][2] = {
+      {4, 4},  {5, 4},  {5, 5},  {6, 5},   {6, 6},   {8, 5},   {8, 6},
+      {8, 8},  {10, 5}, {10, 6}, {10, 8},  {10, 10}, {12, 10}, {12, 12}};
+  if (vk_format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK &&
+      vk_format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK) {
+    const uint32_t* footprint =
+        ASTC_FOOTPRINTS[(vk_format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+    return {footprint[0], footprint[1], 16};
+  }
+
+  return {0, 0, 0};
+}
+
+}  // namespace
+
+Ktx2Texture ParseKtx2(const char* data, size_t size) {
+  // the level index follows the header and index, packed without padding
+  size_t index_offset =
+      sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header) + sizeof(Ktx2Index);
+
+  Ktx2Header header{};
+  if (size < index_offset ||
+      0 != memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER))) {
+    throw std::runtime_error("----- Error::KTX2: Not a KTX2 file -----");
+  }
+  memcpy(&header, data + sizeof(KTX2_IDENTIFIER), sizeof(header));
+
+  if (0 == header.vk_format) {
+    throw std::runtime_error(
+        "----- Error::KTX2: Basis Universal textures are not supported -----");
+  }
+  if (0 != header.supercompression_scheme) {
+    throw std::runtime_error(
+        "----- Error::KTX2: Supercompressed textures are not supported -----");
+  }
+  if (0 == header.pixel_width || 0 == header.pixel_height ||
+      header.pixel_depth > 1 || header.layer_count > 1 ||
+      1 != header.face_count) {
+    throw std::runtime_error(
+        "----- Error::KTX2: Only single 2D images are supported -----");
+  }
+
+  // a level count of 0 asks the loader to generate the chain
+  Ktx2Texture texture{};
+  texture.vk_format = header.vk_format;
+  texture.width = header.pixel_width;
+  texture.height = header.pixel_height;
+  texture.generate_mipmaps = 0 == header.level_count;
+
+  FormatBlock block = GetFormatBlock(header.vk_format);
+  if (0 == block.bytes) {
+    throw std::runtime_error("----- Error::KTX2: Unsupported format " +
+                             std::to_string(header.vk_format) + " -----");
+  }
+
+  // down to 1x1, become the image's mipLevels
+  uint32_t max_level_count = 1;
+  while (std::max(header.pixel_width, header.pixel_height) >>
+         max_level_count) {
+    ++max_level_count;
+  }
+  uint32_t level_count = std::max(header.level_count, 1u);
+  if (level_count > max_level_count) {
+    throw std::runtime_error("----- Error::KTX2: " +
+                             std::to_string(level_count) +
+                             " mip levels, the extent allows " +
+                             std::to_string(max_level_count) + " -----");
+  }
+  if ((size - index_offset) / sizeof(Ktx2LevelIndex) < level_count) {
+    throw std::runtime_error("----- Error::KTX2: Truncated level index -----");
+  }
+
+  for (uint32_t i = 0; i < level_count; ++i) {
+    Ktx2LevelIndex level{};
+    memcpy(&level, data + index_offset + i * sizeof(level), sizeof(level));
+
+    if (0 == level.byte_length || level.byte_offset > size ||
+        level.byte_length > size - level.byte_offset) {
+      throw std::runtime_error(
+          "----- Error::KTX2: Mip level outside of the file -----");
+    }
+
+    // the copy into the image reads whole blocks of the level's extent
+    uint64_t width = std::max(header.pixel_width >> i, 1u);
+    uint64_t height = std::max(header.pixel_height >> i, 1u);
+    uint64_t needed = (width + block.width - 1) / block.width *
+                      ((height + block.height - 1) / block.height) *
+                      block.bytes;
+    if (level.byte_length < needed) {
+      throw std::runtime_error(
+          "----- Error::KTX2: Mip level " + std::to_string(i) + " has " +
+          std::to_string(level.byte_length) + " bytes, its extent needs " +
+          std::to_string(needed) + " -----");
+    }
+    texture.levels.push_back({level.byte_offset, level.byte_length});
+  }
+
+  return texture;
+}
+
+}  // namespace playground
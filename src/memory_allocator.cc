@@ -0,0 +1,392 @@
+/**
+ * @file memory_allocator.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-04
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "memory_allocator.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+double ToMiB(VkDeviceSize bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+void MemoryAllocator::Init(VkPhysicalDevice physical_device, VkDevice device,
+                           VkDeviceSize block_size) {
+  device_ = device;
+  block_size_ = block_size;
+
+  vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties_);
+
+  VkPhysicalDeviceProperties device_properties{};
+  vkGetPhysicalDeviceProperties(physical_device, &device_properties);
+  non_coherent_atom_size_ =
+      std::max<VkDeviceSize>(device_properties.limits.nonCoherentAtomSize, 1);
+  max_allocation_count_ = device_properties.limits.maxMemoryAllocationCount;
+}
+
+void MemoryAllocator::Destroy() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (auto& block : blocks_) {
+    if (block.allocation_count > 0) {
+      std::clog << "----- Warning::Memory: Block of memory type "
+                << block.memory_type << " destroyed with "
+                << block.allocation_count << " live allocation(s) -----"
+                << std::endl;
+    }
+    DestroyBlock(block);
+  }
+  blocks_.clear();
+}
+
+Allocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements,
+                                     VkMemoryPropertyFlags properties,
+                                     bool linear) {
+  uint32_t memory_type =
+      FindMemoryType(requirements.memoryTypeBits, properties);
+
+  VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+  VkMemoryPropertyFlags type_flags =
+      memory_properties_.memoryTypes[memory_type].propertyFlags;
+  if ((type_flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+      !(type_flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+    // keep flush/invalidate ranges from touching neighbouring allocations
+    alignment = std::max(alignment, non_coherent_atom_size_);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Allocation allocation{};
+  allocation.memory_type = memory_type;
+  allocation.size = requirements.size;
+
+  VkDeviceSize preferred_block_size = PreferredBlockSize(memory_type);
+
+  // large resources get a block of their own
+  if (requirements.size > preferred_block_size / 2) {
+    uint32_t index =
+        CreateBlock(memory_type, requirements.size, linear, true);
+    Block& block = blocks_[index];
+    block.free_ranges.clear();
+    block.used = requirements.size;
+    block.allocation_count = 1;
+
+    allocation.memory = block.memory;
+    allocation.offset = 0;
+    allocation.mapped = block.mapped;
+    allocation.block = index;
+
+    return allocation;
+  }
+
+  for (uint32_t i = 0; i < blocks_.size(); ++i) {
+    Block& block = blocks_[i];
+    if (VK_NULL_HANDLE == block.memory || block.dedicated ||
+        block.memory_type != memory_type || block.linear != linear) {
+      continue;
+    }
+
+    VkDeviceSize offset = 0;
+    if (AllocateFromBlock(block, requirements.size, alignment, offset)) {
+      allocation.memory = block.memory;
+      allocation.offset = offset;
+      allocation.mapped =
+          block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+      allocation.block = i;
+
+      return allocation;
+    }
+  }
+
+  uint32_t index =
+      CreateBlock(memory_type, preferred_block_size, linear, false);
+  Block& block = blocks_[index];
+
+  VkDeviceSize offset = 0;
+  if (!AllocateFromBlock(block, requirements.size, alignment, offset)) {
+    throw std::runtime_error(
+        "----- Error::Memory: Failed to sub-allocate from a new block -----");
+  }
+
+  allocation.memory = block.memory;
+  allocation.offset = offset;
+  allocation.mapped =
+      block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+  allocation.block = index;
+
+  return allocation;
+}
+
+Allocation MemoryAllocator::AllocateAliased(
+    const std::vector<VkMemoryRequirements>& requirements,
+    VkMemoryPropertyFlags properties, bool linear) {
+  VkMemoryRequirements combined{};
+  combined.alignment = 1;
+  combined.memoryTypeBits = ~0u;
+  for (const auto& member : requirements) {
+    combined.size = std::max(combined.size, member.size);
+    combined.alignment = std::max(combined.alignment, member.alignment);
+    combined.memoryTypeBits &= member.memoryTypeBits;
+  }
+
+  if (requirements.empty() || 0 == combined.memoryTypeBits) {
+    throw std::runtime_error(
+        "----- Error::Memory: Aliased resources share no memory type -----");
+  }
+
+  // alignments are powers of two, the largest satisfies every member
+  return Allocate(combined, properties, linear);
+}
+
+void MemoryAllocator::Free(Allocation& allocation) {
+  if (VK_NULL_HANDLE == allocation.memory) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Block& block = blocks_[allocation.block];
+  if (block.memory != allocation.memory) {
+    throw std::runtime_error(
+        "----- Error::Memory: Freed allocation does not belong to its block "
+        "-----");
+  }
+
+  if (block.dedicated) {
+    DestroyBlock(block);
+    allocation = Allocation{};
+    return;
+  }
+
+  Range range{allocation.offset, allocation.size};
+  auto next = std::lower_bound(
+      block.free_ranges.begin(), block.free_ranges.end(), range,
+      [](const Range& a, const Range& b) { return a.offset < b.offset; });
+  next = block.free_ranges.insert(next, range);
+
+  // merge with the following range
+  auto after = next + 1;
+  if (after != block.free_ranges.end() &&
+      next->offset + next->size == after->offset) {
+    next->size += after->size;
+    block.free_ranges.erase(after);
+  }
+
+  // merge with the preceding range
+  if (next != block.free_ranges.begin()) {
+    auto before = next - 1;
+    if (before->offset + before->size == next->offset) {
+      before->size += next->size;
+      block.free_ranges.erase(next);
+    }
+  }
+
+  block.used -= allocation.size;
+  --block.allocation_count;
+
+  allocation = Allocation{};
+}
+
+uint32_t MemoryAllocator::FindMemoryType(
+    uint32_t type_filter, VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+    if (type_filter & (1 << i) &&
+        (memory_properties_.memoryTypes[i].propertyFlags & properties) ==
+            properties) {
+      return i;
+    }
+  }
+
+  throw std::runtime_error(
+      "----- Error::Vulkan: Failed to find suitable memory type -----");
+}
+
+bool MemoryAllocator::HasMemoryType(uint32_t type_filter,
+                                    VkMemoryPropertyFlags properties) const {
+  for (uint32_t i = 0; i < memory_properties_.memoryTypeCount; ++i) {
+    if (type_filter & (1 << i) &&
+        (memory_properties_.memoryTypes[i].propertyFlags & properties) ==
+            properties) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::vector<HeapStats> MemoryAllocator::GetHeapStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<HeapStats> stats(memory_properties_.memoryHeapCount);
+  for (uint32_t i = 0; i < memory_properties_.memoryHeapCount; ++i) {
+    stats[i].heap_size = memory_properties_.memoryHeaps[i].size;
+  }
+
+  for (const auto& block : blocks_) {
+    if (VK_NULL_HANDLE == block.memory) {
+      continue;
+    }
+
+    uint32_t heap = memory_properties_.memoryTypes[block.memory_type].heapIndex;
+    stats[heap].allocated_bytes += block.size;
+    stats[heap].used_bytes += block.used;
+    stats[heap].block_count += 1;
+    stats[heap].allocation_count += block.allocation_count;
+  }
+
+  return stats;
+}
+
+void MemoryAllocator::LogStats() const {
+  std::vector<HeapStats> stats = GetHeapStats();
+
+  std::ios format_state(nullptr);
+  format_state.copyfmt(std::clog);
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    std::clog << "----- Memory Heap " << i << ": " << stats[i].block_count
+              << " block(s), " << stats[i].allocation_count
+              << " allocation(s), " << std::fixed << std::setprecision(2)
+              << ToMiB(stats[i].used_bytes) << " / "
+              << ToMiB(stats[i].allocated_bytes) << " MiB used, heap size "
+              << ToMiB(stats[i].heap_size) << " MiB -----" << std::endl;
+  }
+
+  std::clog.copyfmt(format_state);
+}
+
+uint32_t MemoryAllocator::CreateBlock(uint32_t memory_type, VkDeviceSize size,
+                                      bool linear, bool dedicated) {
+  if (max_allocation_count_ > 0 &&
+      device_allocation_count_ >= max_allocation_count_) {
+    throw std::runtime_error(
+        "----- Error::Memory: Reached maxMemoryAllocationCount -----");
+  }
+
+  Block block{};
+  block.size = size;
+  block.memory_type = memory_type;
+  block.linear = linear;
+  block.dedicated = dedicated;
+  block.free_ranges.push_back({0, size});
+
+  VkMemoryAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = size;
+  alloc_info.memoryTypeIndex = memory_type;
+
+  if (VK_SUCCESS !=
+      vkAllocateMemory(device_, &alloc_info, nullptr, &block.memory)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate device memory block -----");
+  }
+  ++device_allocation_count_;
+
+  if (memory_properties_.memoryTypes[memory_type].propertyFlags &
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (VK_SUCCESS !=
+        vkMapMemory(device_, block.memory, 0, VK_WHOLE_SIZE, 0,
+                    &block.mapped)) {
+      // the block never reaches blocks_, nothing else would free it
+      vkFreeMemory(device_, block.memory, nullptr);
+      --device_allocation_count_;
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to map device memory block -----");
+    }
+  }
+
+  // reuse slots left behind by freed dedicated blocks
+  for (uint32_t i = 0; i < blocks_.size(); ++i) {
+    if (VK_NULL_HANDLE == blocks_[i].memory) {
+      blocks_[i] = std::move(block);
+      return i;
+    }
+  }
+
+  blocks_.push_back(std::move(block));
+
+  return static_cast<uint32_t>(blocks_.size() - 1);
+}
+
+void MemoryAllocator::DestroyBlock(Block& block) {
+  if (VK_NULL_HANDLE == block.memory) {
+    return;
+  }
+
+  if (block.mapped) {
+    vkUnmapMemory(device_, block.memory);
+  }
+  vkFreeMemory(device_, block.memory, nullptr);
+  --device_allocation_count_;
+
+  block = Block{};
+}
+
+bool MemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size,
+                                        VkDeviceSize alignment,
+                                        VkDeviceSize& offset) {
+  // first fit
+  for (size_t i = 0; i < block.free_ranges.size(); ++i) {
+    Range range = block.free_ranges[i];
+    VkDeviceSize aligned = AlignUp(range.offset, alignment);
+    VkDeviceSize padding = aligned - range.offset;
+
+    if (padding + size > range.size) {
+      continue;
+    }
+
+    VkDeviceSize tail = range.size - padding - size;
+    block.free_ranges.erase(block.free_ranges.begin() + i);
+    if (tail > 0) {
+      block.free_ranges.insert(block.free_ranges.begin() + i,
+                               {aligned + size, tail});
+    }
+    if (padding > 0) {
+      block.free_ranges.insert(block.free_ranges.begin() + i,
+                               {range.offset, padding});
+    }
+
+    block.used += size;
+    ++block.allocation_count;
+    offset = aligned;
+
+    return true;
+  }
+
+  return false;
+}
+
+VkDeviceSize MemoryAllocator::PreferredBlockSize(uint32_t memory_type) const {
+  uint32_t heap = memory_properties_.memoryTypes[memory_type].heapIndex;
+  VkDeviceSize heap_size = memory_properties_.memoryHeaps[heap].size;
+
+  // small heaps (e.g. the 256 MiB BAR heap) get smaller blocks
+  if (heap_size <= 1024ull * 1024 * 1024) {
+    return std::min(block_size_, heap_size / 8);
+  }
+
+  return block_size_;
+}
+
+}  // namespace playground
@@ -0,0 +1,200 @@
+/**
+ * @file mesh_file.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "mesh_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace playground {
+
+namespace {
+
+bool IsSectionValid(uint64_t offset, uint64_t size, size_t file_size) {
+  return 0 == offset % MESH_FILE_ALIGNMENT && offset <= file_size &&
+         size <= file_size - offset;
+}
+
+bool IsRangeValid(uint32_t first, uint32_t count, uint32_t total) {
+  return uint64_t{first} + count <= total;
+}
+
+// every range the draws and the cull pass read stays inside the index
+// section, the GPU does not check
+bool AreRangesValid(const MeshFileHeader& header, const MeshLod* lods,
+                    const Meshlet* meshlets) {
+  for (uint32_t i = 0; i < header.lod_count; ++i) {
+    if (!IsRangeValid(lods[i].first_index, lods[i].index_count,
+                      header.index_count) ||
+        !IsRangeValid(lods[i].first_meshlet, lods[i].meshlet_count,
+                      header.meshlet_count)) {
+      return false;
+    }
+  }
+
+  for (uint32_t i = 0; i < header.meshlet_count; ++i) {
+    if (!IsRangeValid(meshlets[i].first_index, meshlets[i].index_count,
+                      header.index_count)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+MeshFile::~MeshFile() { Close(); }
+
+void MeshFile::Open(const std::string& path) {
+  Close();
+
+#ifdef _WIN32
+  file_handle_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+  if (INVALID_HANDLE_VALUE == file_handle_) {
+    file_handle_ = nullptr;
+    throw std::runtime_error("----- Error::Mesh: Failed to open " + path +
+                             " -----");
+  }
+
+  LARGE_INTEGER file_size{};
+  GetFileSizeEx(file_handle_, &file_size);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+
+  mapping_handle_ = CreateFileMappingA(file_handle_, nullptr, PAGE_READONLY, 0,
+                                       0, nullptr);
+  if (mapping_handle_) {
+    data_ = static_cast<const unsigned char*>(
+        MapViewOfFile(mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+  }
+#else
+  file_descriptor_ = open(path.c_str(), O_RDONLY);
+  if (file_descriptor_ < 0) {
+    throw std::runtime_error("----- Error::Mesh: Failed to open " + path +
+                             " -----");
+  }
+
+  struct stat file_stat {};
+  fstat(file_descriptor_, &file_stat);
+  size_ = static_cast<size_t>(file_stat.st_size);
+
+  void* mapping =
+      size_ > 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE,
+                       file_descriptor_, 0)
+                : MAP_FAILED;
+  if (MAP_FAILED != mapping) {
+    data_ = static_cast<const unsigned char*>(mapping);
+    // read front to back once, straight into the staging ring
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+  }
+#endif
+
+  if (!data_) {
+    Close();
+    throw std::runtime_error("----- Error::Mesh: Failed to map " + path +
+                             " -----");
+  }
+
+  const MeshFileHeader& header = GetHeader();
+  bool valid =
+      size_ >= sizeof(MeshFileHeader) && MESH_FILE_MAGIC == header.magic &&
+      MESH_FILE_VERSION == header.version &&
+      sizeof(MeshVertex) == header.vertex_stride &&
+      (2 == header.index_size || 4 == header.index_size) &&
+      // Vulkan buffers cannot be empty
+      header.vertex_count > 0 && header.index_count > 0 &&
+      header.lod_count > 0 &&
+      IsSectionValid(header.vertex_offset, GetVertexDataSize(), size_) &&
+      IsSectionValid(header.index_offset, GetIndexDataSize(), size_) &&
+      IsSectionValid(header.lod_offset,
+                     uint64_t{header.lod_count} * sizeof(MeshLod), size_) &&
+      IsSectionValid(header.meshlet_offset,
+                     uint64_t{header.meshlet_count} * sizeof(Meshlet), size_) &&
+      AreRangesValid(header, GetLods(), GetMeshlets());
+
+  if (!valid) {
+    Close();
+    throw std::runtime_error("----- Error::Mesh: " + path +
+                             " is not a valid mesh file -----");
+  }
+}
+
+void MeshFile::Close() {
+#ifdef _WIN32
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_handle_) {
+    CloseHandle(mapping_handle_);
+    mapping_handle_ = nullptr;
+  }
+  if (file_handle_) {
+    CloseHandle(file_handle_);
+    file_handle_ = nullptr;
+  }
+#else
+  if (data_) {
+    munmap(const_cast<unsigned char*>(data_), size_);
+  }
+  if (file_descriptor_ >= 0) {
+    close(file_descriptor_);
+    file_descriptor_ = -1;
+  }
+#endif
+
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool MeshFile::IsOpen() const { return nullptr != data_; }
+
+const MeshFileHeader& MeshFile::GetHeader() const {
+  return *reinterpret_cast<const MeshFileHeader*>(data_);
+}
+
+const void* MeshFile::GetVertexData() const {
+  return data_ + GetHeader().vertex_offset;
+}
+
+size_t MeshFile::GetVertexDataSize() const {
+  return static_cast<size_t>(GetHeader().vertex_count) *
+         GetHeader().vertex_stride;
+}
+
+const void* MeshFile::GetIndexData() const {
+  return data_ + GetHeader().index_offset;
+}
+
+size_t MeshFile::GetIndexDataSize() const {
+  return static_cast<size_t>(GetHeader().index_count) *
+         GetHeader().index_size;
+}
+
+const MeshLod* MeshFile::GetLods() const {
+  return reinterpret_cast<const MeshLod*>(data_ + GetHeader().lod_offset);
+}
+
+const Meshlet* MeshFile::GetMeshlets() const {
+  return reinterpret_cast<const Meshlet*>(data_ + GetHeader().meshlet_offset);
+}
+
+}  // namespace playground
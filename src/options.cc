@@ -0,0 +1,218 @@
+/**
+ * @file options.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "options.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+namespace playground {
+
+namespace {
+
+// matches "--name" and "--name=value", `value` is left empty for the former
+bool MatchOption(const std::string& argument, const std::string& name,
+                 std::string& value) {
+  if (argument == name) {
+    value.clear();
+    return true;
+  }
+
+  if (0 == argument.compare(0, name.size() + 1, name + "=")) {
+    value = argument.substr(name.size() + 1);
+    return true;
+  }
+
+  return false;
+}
+
+uint32_t ParseCount(const std::string& argument, const std::string& value) {
+  try {
+    size_t parsed = 0;
+    unsigned long count = std::stoul(value, &parsed);
+    if (parsed == value.size() && count <= UINT32_MAX) {
+      return static_cast<uint32_t>(count);
+    }
+  } catch (const std::exception&) {
+  }
+
+  throw std::runtime_error("----- Error::Options: Invalid value in " +
+                           argument + " -----");
+}
+
+}  // namespace
+
+Options Options::Parse(int argc, char* argv[]) {
+  Options options{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    std::string value{};
+
+    if (MatchOption(argument, "--help", value)) {
+      options.help = true;
+    } else if (MatchOption(argument, "--trace", value)) {
+      options.trace = true;
+      if (!value.empty()) {
+        options.trace_path = value;
+      }
+    } else if (MatchOption(argument, "--bench-frames", value)) {
+      options.bench_frames = ParseCount(argument, value);
+    } else if (MatchOption(argument, "--warmup", value)) {
+      options.warmup_frames = ParseCount(argument, value);
+    } else if (MatchOption(argument, "--bench-json", value)) {
+      options.bench_json_path = value;
+    } else if (MatchOption(argument, "--present-mode", value)) {
+      if ("fifo" != value && "mailbox" != value && "immediate" != value &&
+          "fifo-relaxed" != value) {
+        PrintUsage();
+        throw std::runtime_error("----- Error::Options: Unknown present mode " +
+                                 value + " -----");
+      }
+      options.present_mode = value;
+    } else if (MatchOption(argument, "--frame-limiter", value)) {
+      options.frame_limiter = true;
+    } else if (MatchOption(argument, "--on-demand", value)) {
+      options.on_demand = true;
+    } else if (MatchOption(argument, "--min-refresh", value)) {
+      options.min_refresh_rate = ParseCount(argument, value);
+      if (0 == options.min_refresh_rate) {
+        throw std::runtime_error(
+            "----- Error::Options: Minimum refresh rate must not be zero "
+            "-----");
+      }
+    } else if (MatchOption(argument, "--mesh", value)) {
+      options.mesh_path = value;
+    } else if (MatchOption(argument, "--texture", value)) {
+      options.texture_path = value;
+    } else if (MatchOption(argument, "--no-bindless", value)) {
+      options.bindless = false;
+    } else if (MatchOption(argument, "--no-timeline", value)) {
+      options.timeline = false;
+    } else if (MatchOption(argument, "--gpu", value)) {
+      if (value.empty()) {
+        throw std::runtime_error(
+            "----- Error::Options: Expected --gpu=index|name -----");
+      }
+      options.gpu = value;
+    } else if (MatchOption(argument, "--async-compute", value)) {
+      options.async_compute = true;
+    } else if (MatchOption(argument, "--post", value)) {
+      options.bloom = false;
+      options.fxaa = false;
+      size_t begin = 0;
+      while ("none" != value && begin <= value.size()) {
+        size_t end = std::min(value.find(',', begin), value.size());
+        std::string pass = value.substr(begin, end - begin);
+        if ("bloom" == pass) {
+          options.bloom = true;
+        } else if ("fxaa" == pass) {
+          options.fxaa = true;
+        } else {
+          PrintUsage();
+          throw std::runtime_error(
+              "----- Error::Options: Unknown post process pass " + pass +
+              " -----");
+        }
+        begin = end + 1;
+      }
+    } else if (MatchOption(argument, "--no-lighting", value)) {
+      options.lighting = false;
+    } else if (MatchOption(argument, "--msaa", value)) {
+      options.msaa_samples = ParseCount(argument, value);
+      if (1 != options.msaa_samples && 2 != options.msaa_samples &&
+          4 != options.msaa_samples && 8 != options.msaa_samples) {
+        throw std::runtime_error(
+            "----- Error::Options: MSAA samples must be 1, 2, 4 or 8 -----");
+      }
+    } else if (MatchOption(argument, "--no-dynamic-rendering", value)) {
+      options.dynamic_rendering = false;
+    } else if (MatchOption(argument, "--hot-reload", value)) {
+      options.hot_reload = true;
+    } else if (MatchOption(argument, "--instances", value)) {
+      options.instances = ParseCount(argument, value);
+      if (0 == options.instances) {
+        throw std::runtime_error(
+            "----- Error::Options: Instance count must not be zero -----");
+      }
+    } else if (MatchOption(argument, "--dynamic-instances", value)) {
+      options.dynamic_instances = true;
+    } else if (MatchOption(argument, "--frames-in-flight", value)) {
+      options.frames_in_flight = ParseCount(argument, value);
+      if (0 == options.frames_in_flight ||
+          options.frames_in_flight > MAX_FRAMES_IN_FLIGHT) {
+        throw std::runtime_error(
+            "----- Error::Options: Frames in flight must be in [1, " +
+            std::to_string(MAX_FRAMES_IN_FLIGHT) + "] -----");
+      }
+    } else if (MatchOption(argument, "--resolution", value)) {
+      size_t separator = value.find('x');
+      if (std::string::npos == separator) {
+        throw std::runtime_error(
+            "----- Error::Options: Expected --resolution=WxH -----");
+      }
+      options.width = ParseCount(argument, value.substr(0, separator));
+      options.height = ParseCount(argument, value.substr(separator + 1));
+      if (0 == options.width || 0 == options.height) {
+        throw std::runtime_error(
+            "----- Error::Options: Resolution must not be zero -----");
+      }
+    } else {
+      PrintUsage();
+      throw std::runtime_error("----- Error::Options: Unknown argument " +
+                               argument + " -----");
+    }
+  }
+
+  return options;
+}
+
+void Options::PrintUsage() {
+  std::clog << "Usage: playground [options]\n"
+            << "  --help                  show this message\n"
+            << "  --trace[=path]          write a Chrome trace on exit ("
+            << DEFAULT_TRACE_FILEPATH << ")\n"
+            << "  --bench-frames=N        measure N frames, report and exit\n"
+            << "  --warmup=M              frames skipped before measuring ("
+            << DEFAULT_WARMUP_FRAMES << ")\n"
+            << "  --bench-json=path       also write the JSON report to path\n"
+            << "  --present-mode=MODE     fifo, mailbox, immediate or "
+               "fifo-relaxed\n"
+            << "  --frame-limiter         pace fifo frames to presentation\n"
+            << "  --on-demand             draw only when something changed\n"
+            << "  --min-refresh=HZ        on demand frames per second ("
+            << DEFAULT_MIN_REFRESH_RATE << ")\n"
+            << "  --mesh=path             .pgmesh file made by meshconv\n"
+            << "  --texture=path          .ktx2 texture or image file\n"
+            << "  --no-bindless           use the legacy descriptor path\n"
+            << "  --no-timeline           use fences instead of a timeline "
+               "semaphore\n"
+            << "  --gpu=index|name        use this GPU, not the best scoring\n"
+            << "  --async-compute         create a dedicated compute queue\n"
+            << "  --post=bloom,fxaa|none  post processing passes (bloom,fxaa)\n"
+            << "  --no-lighting           draw the scene unlit\n"
+            << "  --msaa=N                scene samples, 1, 2, 4 or 8 ("
+            << DEFAULT_MSAA_SAMPLES << ")\n"
+            << "  --no-dynamic-rendering  use render passes and framebuffers\n"
+            << "  --hot-reload            rebuild pipelines of edited shaders\n"
+            << "  --instances=N           meshes drawn per frame (1)\n"
+            << "  --dynamic-instances     update instance transforms each "
+               "frame\n"
+            << "  --frames-in-flight=N    frames recorded ahead of the GPU ("
+            << DEFAULT_FRAMES_IN_FLIGHT << ")\n"
+            << "  --resolution=WxH        window size\n"
+            << "Press F9 at any time to write the recent trace events."
+            << std::endl;
+}
+
+}  // namespace playground
@@ -0,0 +1,182 @@
+/**
+ * @file pipeline_cache.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-13
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "pipeline_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+namespace {
+
+const uint32_t PIPELINE_CACHE_MAGIC = 0x43505950;  // "PYPC"
+const uint32_t PIPELINE_CACHE_VERSION = 1;
+
+}  // namespace
+
+void PipelineCache::Init(VkPhysicalDevice physical_device, VkDevice device,
+                         const std::string& path) {
+  device_ = device;
+  path_ = path;
+  vkGetPhysicalDeviceProperties(physical_device, &device_properties_);
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+
+  std::vector<char> data{};
+  warm_ = Load(data);
+
+  VkPipelineCacheCreateInfo cache_info{};
+  cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cache_info.initialDataSize = warm_ ? data.size() : 0;
+  cache_info.pInitialData = warm_ ? data.data() : nullptr;
+
+  if (VK_SUCCESS != vkCreatePipelineCache(device_, &cache_info, nullptr,
+                                          &pipeline_cache_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create pipeline cache -----");
+  }
+
+  auto end_time = std::chrono::high_resolution_clock::now();
+  std::clog << "----- Pipeline Cache: "
+            << (warm_ ? "warm start, loaded " : "cold start, ")
+            << (warm_ ? std::to_string(data.size()) + " bytes " : "")
+            << "in "
+            << std::chrono::duration<double, std::milli>(end_time - start_time)
+                   .count()
+            << " ms -----" << std::endl;
+}
+
+void PipelineCache::Save() {
+  size_t data_size = 0;
+  vkGetPipelineCacheData(device_, pipeline_cache_, &data_size, nullptr);
+
+  std::vector<char> data(data_size);
+  if (VK_SUCCESS != vkGetPipelineCacheData(device_, pipeline_cache_,
+                                           &data_size, data.data())) {
+    std::clog << "----- Warning::Pipeline Cache: Failed to read cache data "
+                 "-----"
+              << std::endl;
+    return;
+  }
+
+  FileHeader header{};
+  header.magic = PIPELINE_CACHE_MAGIC;
+  header.version = PIPELINE_CACHE_VERSION;
+  header.vendor_id = device_properties_.vendorID;
+  header.device_id = device_properties_.deviceID;
+  header.driver_version = device_properties_.driverVersion;
+  memcpy(header.pipeline_cache_uuid, device_properties_.pipelineCacheUUID,
+         VK_UUID_SIZE);
+  header.data_size = data_size;
+
+  // write next to the target and rename, a crash never leaves half a file
+  std::string temp_path = path_ + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      std::clog << "----- Warning::Pipeline Cache: Failed to open " << temp_path
+                << " -----" << std::endl;
+      return;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), data_size);
+  }
+
+  std::remove(path_.c_str());
+  if (0 != std::rename(temp_path.c_str(), path_.c_str())) {
+    std::clog << "----- Warning::Pipeline Cache: Failed to write " << path_
+              << " -----" << std::endl;
+    return;
+  }
+
+  std::clog << "----- Pipeline Cache: Saved " << data_size << " bytes to "
+            << path_ << " -----" << std::endl;
+}
+
+void PipelineCache::Destroy() {
+  vkDestroyPipelineCache(device_, pipeline_cache_, nullptr);
+  pipeline_cache_ = VK_NULL_HANDLE;
+}
+
+VkPipelineCache PipelineCache::GetHandle() const { return pipeline_cache_; }
+
+bool PipelineCache::IsWarm() const { return warm_; }
+
+bool PipelineCache::Load(std::vector<char>& data) {
+  std::ifstream file(path_, std::ios::ate | std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  size_t file_size = static_cast<size_t>(file.tellg());
+  if (file_size < sizeof(FileHeader)) {
+    return false;
+  }
+
+  FileHeader header{};
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (header.data_size != file_size - sizeof(FileHeader)) {
+    std::clog << "----- Pipeline Cache: " << path_
+              << " is truncated, ignoring -----" << std::endl;
+    return false;
+  }
+
+  data.resize(static_cast<size_t>(header.data_size));
+  file.read(data.data(), data.size());
+
+  if (!IsCompatible(header, data)) {
+    std::clog << "----- Pipeline Cache: " << path_
+              << " was written by another device or driver, ignoring -----"
+              << std::endl;
+    data.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool PipelineCache::IsCompatible(const FileHeader& header,
+                                 const std::vector<char>& data) const {
+  if (PIPELINE_CACHE_MAGIC != header.magic ||
+      PIPELINE_CACHE_VERSION != header.version ||
+      device_properties_.vendorID != header.vendor_id ||
+      device_properties_.deviceID != header.device_id ||
+      device_properties_.driverVersion != header.driver_version ||
+      0 != memcmp(device_properties_.pipelineCacheUUID,
+                  header.pipeline_cache_uuid, VK_UUID_SIZE)) {
+    return false;
+  }
+
+  // the driver blob starts with its own header, check it as well
+  VkPipelineCacheHeaderVersionOne driver_header{};
+  if (data.size() < sizeof(driver_header)) {
+    return false;
+  }
+  memcpy(&driver_header, data.data(), sizeof(driver_header));
+
+  return driver_header.headerSize >= sizeof(driver_header) &&
+         VK_PIPELINE_CACHE_HEADER_VERSION_ONE == driver_header.headerVersion &&
+         device_properties_.vendorID == driver_header.vendorID &&
+         device_properties_.deviceID == driver_header.deviceID &&
+         0 == memcmp(device_properties_.pipelineCacheUUID,
+                     driver_header.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+}  // namespace playground
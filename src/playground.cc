@@ -13,6 +13,8 @@
 #include <stdexcept>
 
 #include "application.h"
+#include "options.h"
+#include "trace.h"
 
 int main(int argc, char* argv[]) {
   std::clog << "----- Playground: Starting -----" << std::endl;
@@ -22,8 +24,16 @@ int main(int argc, char* argv[]) {
     std::clog << "----- Arguments No." << i + 1 << ": " << argv[i] << std::endl;
   }
 
+  playground::Tracer::Get().SetThreadName("Main");
+
   try {
-    playground::Application app{};
+    playground::Options options = playground::Options::Parse(argc, argv);
+    if (options.help) {
+      playground::Options::PrintUsage();
+      return EXIT_SUCCESS;
+    }
+
+    playground::Application app{options};
     app.Run();
   } catch (const std::exception& e) {
     std::cerr << e.what() << std::endl;
@@ -0,0 +1,825 @@
+/**
+ * @file post_process.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-28
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "post_process.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <vulkan/vulkan.h>
+
+#include "shader_library.h"
+
+namespace playground {
+
+namespace {
+
+// bloom_down.comp
+const uint32_t PREFILTER_FLAG = 1;
+// tonemap.comp, fxaa.comp
+const uint32_t LINEAR_OUTPUT_FLAG = 2;
+// tonemap.comp, compiled out without bloom
+const uint32_t BLOOM_CONSTANT_ID = 0;
+
+const uint32_t WORKGROUP_SIZE = 8;
+
+const VkClearColorValue SCENE_CLEAR_COLOR{{0.0f, 0.0f, 0.0f, 1.0f}};
+
+bool IsSrgb(VkFormat format) {
+  return VK_FORMAT_B8G8R8A8_SRGB == format ||
+         VK_FORMAT_R8G8B8A8_SRGB == format ||
+         VK_FORMAT_A8B8G8R8_SRGB_PACK32 == format;
+}
+
+VkExtent2D MipExtent(VkExtent2D extent, uint32_t mip) {
+  return {std::max(extent.width >> mip, 1u),
+          std::max(extent.height >> mip, 1u)};
+}
+
+}  // namespace
+
+void PostProcessChain::Init(VkPhysicalDevice physical_device, VkDevice device,
+                            DeletionQueue& deletion_queue,
+                            VkPipelineCache pipeline_cache,
+                            const PostProcessSettings& settings,
+                            const PostProcessShaders& shaders,
+                            bool dynamic_rendering) {
+  physical_device_ = physical_device;
+  device_ = device;
+  deletion_queue_ = &deletion_queue;
+  settings_ = settings;
+  dynamic_rendering_ = dynamic_rendering;
+
+  // written by the scene only, never sampled
+  const VkFormat depth_candidates[] = {VK_FORMAT_D32_SFLOAT,
+                                       VK_FORMAT_D32_SFLOAT_S8_UINT,
+                                       VK_FORMAT_D24_UNORM_S8_UINT};
+  for (auto candidate : depth_candidates) {
+    VkFormatProperties properties{};
+    vkGetPhysicalDeviceFormatProperties(physical_device_, candidate,
+                                        &properties);
+    if (properties.optimalTilingFeatures &
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+      depth_format_ = candidate;
+      break;
+    }
+  }
+  if (VK_FORMAT_UNDEFINED == depth_format_) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to find a depth format -----");
+  }
+
+  if (dynamic_rendering_) {
+    cmd_begin_rendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+    cmd_end_rendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+    if (nullptr == cmd_begin_rendering_ || nullptr == cmd_end_rendering_) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to load vkCmdBeginRenderingKHR -----");
+    }
+  } else {
+    CreateSceneRenderPass();
+  }
+
+  VkSamplerCreateInfo sampler_info{};
+  sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+  sampler_info.magFilter = VK_FILTER_LINEAR;
+  sampler_info.minFilter = VK_FILTER_LINEAR;
+  sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+  sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  sampler_info.maxLod = 0.0f;
+
+  if (VK_SUCCESS !=
+      vkCreateSampler(device_, &sampler_info, nullptr, &sampler_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process sampler -----");
+  }
+
+  std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+  for (uint32_t i = 0; i < bindings.size(); ++i) {
+    bindings[i].binding = i;
+    bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[i].descriptorCount = 1;
+    bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  }
+  bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+
+  VkDescriptorSetLayoutCreateInfo layout_info{};
+  layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layout_info.bindingCount = static_cast<uint32_t>(bindings.size());
+  layout_info.pBindings = bindings.data();
+
+  if (VK_SUCCESS != vkCreateDescriptorSetLayout(device_, &layout_info,
+                                                nullptr,
+                                                &descriptor_set_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process descriptor set "
+        "layout -----");
+  }
+
+  VkPushConstantRange push_constant_range{};
+  push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  push_constant_range.offset = 0;
+  push_constant_range.size = sizeof(PushConstants);
+
+  VkPipelineLayoutCreateInfo pipeline_layout_info{};
+  pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipeline_layout_info.setLayoutCount = 1;
+  pipeline_layout_info.pSetLayouts = &descriptor_set_layout_;
+  pipeline_layout_info.pushConstantRangeCount = 1;
+  pipeline_layout_info.pPushConstantRanges = &push_constant_range;
+
+  if (VK_SUCCESS != vkCreatePipelineLayout(device_, &pipeline_layout_info,
+                                           nullptr, &pipeline_layout_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process pipeline layout "
+        "-----");
+  }
+
+  pipelines_ = CreatePipelines(pipeline_cache, shaders);
+
+  std::clog << "----- Post Process: " << settings_.samples << "x MSAA, "
+            << (settings_.bloom ? "bloom, " : "") << "tonemap"
+            << (settings_.fxaa ? ", fxaa" : "") << " -----" << std::endl;
+}
+
+void PostProcessChain::Destroy() {
+  DestroyTargets(targets_);
+
+  DestroyPipelines(pipelines_);
+  vkDestroyPipelineLayout(device_, pipeline_layout_, nullptr);
+  vkDestroyDescriptorSetLayout(device_, descriptor_set_layout_, nullptr);
+  vkDestroySampler(device_, sampler_, nullptr);
+  vkDestroyRenderPass(device_, scene_render_pass_, nullptr);
+
+  pipeline_layout_ = VK_NULL_HANDLE;
+  descriptor_set_layout_ = VK_NULL_HANDLE;
+  sampler_ = VK_NULL_HANDLE;
+  scene_render_pass_ = VK_NULL_HANDLE;
+}
+
+PostProcessChain::Pipelines PostProcessChain::CreatePipelines(
+    VkPipelineCache pipeline_cache, const PostProcessShaders& shaders) const {
+  Pipelines pipelines{};
+
+  try {
+    if (settings_.bloom) {
+      pipelines.bloom_down =
+          CreatePipeline(pipeline_cache, *shaders.bloom_down, nullptr);
+      pipelines.bloom_up =
+          CreatePipeline(pipeline_cache, *shaders.bloom_up, nullptr);
+    }
+
+    SpecializationConstants tonemap_constants{};
+    tonemap_constants.Set(BLOOM_CONSTANT_ID, settings_.bloom ? VK_TRUE
+                                                             : VK_FALSE);
+    pipelines.tonemap = CreatePipeline(pipeline_cache, *shaders.tonemap,
+                                       tonemap_constants.Get());
+
+    if (settings_.fxaa) {
+      pipelines.fxaa = CreatePipeline(pipeline_cache, *shaders.fxaa, nullptr);
+    }
+  } catch (...) {
+    // a failed reload keeps the chain as it is
+    DestroyPipelines(pipelines);
+    throw;
+  }
+
+  return pipelines;
+}
+
+void PostProcessChain::SwapPipelines(Pipelines& pipelines) {
+  std::swap(pipelines_, pipelines);
+}
+
+void PostProcessChain::DestroyPipelines(Pipelines& pipelines) const {
+  for (VkPipeline* pipeline : {&pipelines.bloom_down, &pipelines.bloom_up,
+                               &pipelines.tonemap, &pipelines.fxaa}) {
+    vkDestroyPipeline(device_, *pipeline, nullptr);
+    *pipeline = VK_NULL_HANDLE;
+  }
+}
+
+bool PostProcessChain::CanWriteOutput(VkPhysicalDevice physical_device,
+                                      VkFormat format,
+                                      VkImageUsageFlags supported_usage) {
+  if (0 == (supported_usage & VK_IMAGE_USAGE_STORAGE_BIT)) {
+    return false;
+  }
+
+  VkFormatProperties properties{};
+  vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+
+  return 0 != (properties.optimalTilingFeatures &
+               VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT);
+}
+
+RenderGraph::Pass& PostProcessChain::AddScenePass(
+    RenderGraph& graph, VkExtent2D extent, RenderGraph::Record draw_scene) {
+  // frames in flight may still use the sets of the previous graph
+  if (VK_NULL_HANDLE != targets_.descriptor_pool) {
+    deletion_queue_->Retire(
+        [this, old = targets_]() mutable { DestroyTargets(old); });
+  }
+  targets_ = Targets{};
+  targets_.extent = extent;
+
+  targets_.hdr = graph.CreateImage("HDR", {HDR_COLOR_FORMAT, extent});
+  // dead after the pass, never leaves tile memory on tilers
+  targets_.depth = graph.CreateImage(
+      "Depth", {depth_format_, extent, 1, VK_IMAGE_ASPECT_DEPTH_BIT,
+                settings_.samples, true});
+
+  RenderGraph::Pass& pass = graph.AddPass("Scene");
+  pass.Write(targets_.hdr, COLOR_ATTACHMENT_ACCESS)
+      .Write(targets_.depth, DEPTH_ATTACHMENT_ACCESS);
+
+  // the samples are dropped by the resolve at the end of the pass
+  if (VK_SAMPLE_COUNT_1_BIT != settings_.samples) {
+    targets_.msaa_color = graph.CreateImage(
+        "MSAA Color", {HDR_COLOR_FORMAT, extent, 1, VK_IMAGE_ASPECT_COLOR_BIT,
+                       settings_.samples, true});
+    pass.Write(targets_.msaa_color, COLOR_ATTACHMENT_ACCESS);
+  }
+
+  return pass.SetRecord([this, draw_scene = std::move(draw_scene)](
+                     VkCommandBuffer command_buffer,
+                     const RenderGraphFrame& frame) {
+        BeginScene(command_buffer);
+        draw_scene(command_buffer, frame);
+        EndScene(command_buffer);
+      });
+}
+
+void PostProcessChain::AddPasses(RenderGraph& graph, RenderResource output,
+                                 VkFormat output_format,
+                                 const std::vector<VkImage>& output_images,
+                                 bool storage) {
+  Targets& targets = targets_;
+  targets.storage_output = storage;
+  targets.linear_output = IsSrgb(output_format);
+  targets.output_images = output_images;
+
+  if (settings_.bloom) {
+    targets.bloom_extent = MipExtent(targets.extent, 1);
+    uint32_t mip_levels = 1;
+    while (mip_levels < MAX_BLOOM_MIPS &&
+           (std::min(targets.bloom_extent.width,
+                     targets.bloom_extent.height) >>
+            mip_levels) > 0) {
+      ++mip_levels;
+    }
+    targets.bloom_mips = mip_levels;
+    targets.bloom = graph.CreateImage(
+        "Bloom", {HDR_COLOR_FORMAT, targets.bloom_extent, mip_levels});
+
+    // down the mip chain, the first step keeps only what is bright enough
+    for (uint32_t mip = 0; mip < mip_levels; ++mip) {
+      RenderGraph::Pass& pass =
+          graph.AddPass("Bloom Down " + std::to_string(mip), "Post");
+      if (0 == mip) {
+        pass.Read(targets.hdr, COMPUTE_SAMPLED_READ);
+      } else {
+        pass.Read(targets.bloom, COMPUTE_GENERAL_READ, mip - 1);
+      }
+      pass.Write(targets.bloom, COMPUTE_STORAGE_WRITE, mip)
+          .SetRecord([this, mip](VkCommandBuffer command_buffer,
+                                 const RenderGraphFrame&) {
+            RecordBloomDown(command_buffer, mip);
+          });
+    }
+
+    // and back up, each mip accumulates everything below it
+    for (uint32_t mip = mip_levels - 1; mip > 0; --mip) {
+      graph.AddPass("Bloom Up " + std::to_string(mip), "Post")
+          .Read(targets.bloom, COMPUTE_GENERAL_READ, mip)
+          .ReadWrite(targets.bloom, COMPUTE_STORAGE_READ_WRITE, mip - 1)
+          .SetRecord([this, mip](VkCommandBuffer command_buffer,
+                                 const RenderGraphFrame&) {
+            RecordBloomUp(command_buffer, mip);
+          });
+    }
+  }
+
+  // float, so the blit can sRGB encode into the swap chain without banding
+  RenderResource destination = output;
+  if (!storage) {
+    targets.output = graph.CreateImage(
+        "Post Output", {HDR_COLOR_FORMAT, targets.extent});
+    destination = targets.output;
+  }
+
+  RenderGraph::Pass& tonemap = graph.AddPass("Tonemap", "Post");
+  tonemap.Read(targets.hdr, COMPUTE_SAMPLED_READ)
+      .SetRecord([this](VkCommandBuffer command_buffer,
+                        const RenderGraphFrame& frame) {
+        RecordTonemap(command_buffer, frame.image_index);
+      });
+  if (settings_.bloom) {
+    tonemap.Read(targets.bloom, COMPUTE_GENERAL_READ, 0);
+  }
+
+  if (settings_.fxaa) {
+    targets.ldr =
+        graph.CreateImage("LDR", {LDR_COLOR_FORMAT, targets.extent});
+    tonemap.Write(targets.ldr, COMPUTE_STORAGE_WRITE);
+
+    graph.AddPass("FXAA", "Post")
+        .Read(targets.ldr, COMPUTE_GENERAL_READ)
+        .Write(destination, COMPUTE_STORAGE_WRITE)
+        .SetRecord([this](VkCommandBuffer command_buffer,
+                          const RenderGraphFrame& frame) {
+          RecordFxaa(command_buffer, frame.image_index);
+        });
+  } else {
+    tonemap.Write(destination, COMPUTE_STORAGE_WRITE);
+  }
+
+  // the swap chain cannot be a storage image, copy into it instead
+  if (!storage) {
+    graph.AddPass("Copy", "Post")
+        .Read(targets.output, TRANSFER_READ)
+        .Write(output, TRANSFER_WRITE)
+        .SetRecord([this](VkCommandBuffer command_buffer,
+                          const RenderGraphFrame& frame) {
+          RecordCopy(command_buffer, frame.image_index);
+        });
+  }
+}
+
+void PostProcessChain::Bind(const RenderGraph& graph,
+                            const std::vector<VkImageView>& output_views) {
+  Targets& targets = targets_;
+  targets.hdr_view = graph.GetView(targets.hdr);
+  targets.depth_view = graph.GetView(targets.depth);
+  bool msaa = VK_SAMPLE_COUNT_1_BIT != settings_.samples;
+  if (msaa) {
+    targets.msaa_color_view = graph.GetView(targets.msaa_color);
+  }
+  if (!targets.storage_output) {
+    targets.output_image = graph.GetImage(targets.output);
+  }
+
+  // dynamic rendering takes the views as they are
+  if (!dynamic_rendering_) {
+    std::array<VkImageView, 3> attachments{
+        msaa ? targets.msaa_color_view : targets.hdr_view, targets.depth_view,
+        targets.hdr_view};
+
+    VkFramebufferCreateInfo framebuffer_info{};
+    framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebuffer_info.renderPass = scene_render_pass_;
+    framebuffer_info.attachmentCount = msaa ? 3 : 2;
+    framebuffer_info.pAttachments = attachments.data();
+    framebuffer_info.width = targets.extent.width;
+    framebuffer_info.height = targets.extent.height;
+    framebuffer_info.layers = 1;
+
+    if (VK_SUCCESS != vkCreateFramebuffer(device_, &framebuffer_info, nullptr,
+                                          &targets.scene_framebuffer)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create scene framebuffer -----");
+    }
+  }
+
+  CreateDescriptorSets(targets, graph, output_views);
+}
+
+VkRenderPass PostProcessChain::GetSceneRenderPass() const {
+  return scene_render_pass_;
+}
+
+VkFramebuffer PostProcessChain::GetSceneFramebuffer() const {
+  return targets_.scene_framebuffer;
+}
+
+VkFormat PostProcessChain::GetDepthFormat() const { return depth_format_; }
+
+VkSampleCountFlagBits PostProcessChain::GetSampleCount() const {
+  return settings_.samples;
+}
+
+void PostProcessChain::BeginScene(VkCommandBuffer command_buffer) const {
+  const Targets& targets = targets_;
+
+  if (!dynamic_rendering_) {
+    VkRenderPassBeginInfo pass_info{};
+    pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    pass_info.renderPass = scene_render_pass_;
+    pass_info.framebuffer = targets.scene_framebuffer;
+    pass_info.renderArea.offset = {0, 0};
+    pass_info.renderArea.extent = targets.extent;
+
+    // the resolve attachment is not cleared
+    std::array<VkClearValue, 2> clear_values{};
+    clear_values[0].color = SCENE_CLEAR_COLOR;
+    clear_values[1].depthStencil = {1.0f, 0};
+    pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
+    pass_info.pClearValues = clear_values.data();
+
+    vkCmdBeginRenderPass(command_buffer, &pass_info,
+                         VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    return;
+  }
+
+  VkRenderingAttachmentInfoKHR color_attachment{};
+  color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+  color_attachment.imageView = targets.hdr_view;
+  color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+  color_attachment.clearValue.color = SCENE_CLEAR_COLOR;
+  if (VK_SAMPLE_COUNT_1_BIT != settings_.samples) {
+    color_attachment.imageView = targets.msaa_color_view;
+    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color_attachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+    color_attachment.resolveImageView = targets.hdr_view;
+    color_attachment.resolveImageLayout =
+        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  }
+
+  VkRenderingAttachmentInfoKHR depth_attachment{};
+  depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+  depth_attachment.imageView = targets.depth_view;
+  depth_attachment.imageLayout =
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  depth_attachment.clearValue.depthStencil = {1.0f, 0};
+
+  VkRenderingInfoKHR rendering_info{};
+  rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+  rendering_info.flags =
+      VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+  rendering_info.renderArea.offset = {0, 0};
+  rendering_info.renderArea.extent = targets.extent;
+  rendering_info.layerCount = 1;
+  rendering_info.colorAttachmentCount = 1;
+  rendering_info.pColorAttachments = &color_attachment;
+  rendering_info.pDepthAttachment = &depth_attachment;
+
+  cmd_begin_rendering_(command_buffer, &rendering_info);
+}
+
+void PostProcessChain::EndScene(VkCommandBuffer command_buffer) const {
+  if (dynamic_rendering_) {
+    cmd_end_rendering_(command_buffer);
+  } else {
+    vkCmdEndRenderPass(command_buffer);
+  }
+}
+
+void PostProcessChain::RecordBloomDown(VkCommandBuffer command_buffer,
+                                       uint32_t mip) const {
+  const Targets& targets = targets_;
+
+  VkExtent2D source_extent =
+      0 == mip ? targets.extent : MipExtent(targets.bloom_extent, mip - 1);
+  PushConstants push_constants{};
+  push_constants.texel_size[0] = 1.0f / source_extent.width;
+  push_constants.texel_size[1] = 1.0f / source_extent.height;
+  push_constants.param0 = settings_.bloom_threshold;
+  push_constants.param1 = settings_.bloom_knee;
+  push_constants.flags = 0 == mip ? PREFILTER_FLAG : 0;
+
+  Dispatch(command_buffer, pipelines_.bloom_down, targets.bloom_down_sets[mip],
+           push_constants, MipExtent(targets.bloom_extent, mip));
+}
+
+void PostProcessChain::RecordBloomUp(VkCommandBuffer command_buffer,
+                                     uint32_t mip) const {
+  const Targets& targets = targets_;
+
+  VkExtent2D source_extent = MipExtent(targets.bloom_extent, mip);
+  PushConstants push_constants{};
+  push_constants.texel_size[0] = 1.0f / source_extent.width;
+  push_constants.texel_size[1] = 1.0f / source_extent.height;
+  push_constants.param0 = 1.0f;
+  push_constants.param1 = 0.0f;
+  push_constants.flags = 0;
+
+  Dispatch(command_buffer, pipelines_.bloom_up, targets.bloom_up_sets[mip - 1],
+           push_constants, MipExtent(targets.bloom_extent, mip - 1));
+}
+
+void PostProcessChain::RecordTonemap(VkCommandBuffer command_buffer,
+                                     uint32_t image_index) const {
+  const Targets& targets = targets_;
+
+  PushConstants push_constants{};
+  push_constants.texel_size[0] = 1.0f / targets.extent.width;
+  push_constants.texel_size[1] = 1.0f / targets.extent.height;
+  push_constants.param0 = settings_.exposure;
+  push_constants.param1 = settings_.bloom_intensity;
+  push_constants.flags =
+      !settings_.fxaa && targets.linear_output ? LINEAR_OUTPUT_FLAG : 0;
+
+  Dispatch(command_buffer, pipelines_.tonemap,
+           targets.tonemap_sets[image_index], push_constants, targets.extent);
+}
+
+void PostProcessChain::RecordFxaa(VkCommandBuffer command_buffer,
+                                  uint32_t image_index) const {
+  const Targets& targets = targets_;
+
+  PushConstants push_constants{};
+  push_constants.texel_size[0] = 1.0f / targets.extent.width;
+  push_constants.texel_size[1] = 1.0f / targets.extent.height;
+  push_constants.param0 = settings_.fxaa_subpixel;
+  push_constants.param1 = 0.0f;
+  push_constants.flags = targets.linear_output ? LINEAR_OUTPUT_FLAG : 0;
+
+  Dispatch(command_buffer, pipelines_.fxaa, targets.fxaa_sets[image_index],
+           push_constants, targets.extent);
+}
+
+void PostProcessChain::RecordCopy(VkCommandBuffer command_buffer,
+                                  uint32_t image_index) const {
+  const Targets& targets = targets_;
+
+  // blit, not copy: converts to the swap chain's format and encoding
+  VkImageBlit blit{};
+  blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  blit.srcSubresource.layerCount = 1;
+  blit.srcOffsets[1] = {static_cast<int32_t>(targets.extent.width),
+                        static_cast<int32_t>(targets.extent.height), 1};
+  blit.dstSubresource = blit.srcSubresource;
+  blit.dstOffsets[1] = blit.srcOffsets[1];
+
+  vkCmdBlitImage(command_buffer, targets.output_image,
+                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 targets.output_images[image_index],
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                 VK_FILTER_NEAREST);
+}
+
+void PostProcessChain::CreateSceneRenderPass() {
+  bool msaa = VK_SAMPLE_COUNT_1_BIT != settings_.samples;
+
+  // the render graph moves every one in and out of the attachment layouts
+  // and orders the pass against everything around it
+  std::array<VkAttachmentDescription, 3> attachments{};
+
+  // sampled by bloom and tonemap afterwards, unless it is resolved
+  attachments[0].format = HDR_COLOR_FORMAT;
+  attachments[0].samples = settings_.samples;
+  attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[0].storeOp =
+      msaa ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+  attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[0].initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  attachments[0].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  attachments[1].format = depth_format_;
+  attachments[1].samples = settings_.samples;
+  attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  attachments[1].initialLayout =
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  // the HDR target with MSAA, fully overwritten by the resolve
+  attachments[2] = attachments[0];
+  attachments[2].samples = VK_SAMPLE_COUNT_1_BIT;
+  attachments[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  attachments[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+  VkAttachmentReference color_attachment_ref{};
+  color_attachment_ref.attachment = 0;
+  color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference depth_attachment_ref{};
+  depth_attachment_ref.attachment = 1;
+  depth_attachment_ref.layout =
+      VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+  VkAttachmentReference resolve_attachment_ref{};
+  resolve_attachment_ref.attachment = 2;
+  resolve_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  VkSubpassDescription subpass_desc{};
+  subpass_desc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+  subpass_desc.colorAttachmentCount = 1;
+  subpass_desc.pColorAttachments = &color_attachment_ref;
+  subpass_desc.pResolveAttachments = msaa ? &resolve_attachment_ref : nullptr;
+  subpass_desc.pDepthStencilAttachment = &depth_attachment_ref;
+
+  VkRenderPassCreateInfo render_pass_info{};
+  render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+  render_pass_info.attachmentCount = msaa ? 3 : 2;
+  render_pass_info.pAttachments = attachments.data();
+  render_pass_info.subpassCount = 1;
+  render_pass_info.pSubpasses = &subpass_desc;
+
+  if (VK_SUCCESS != vkCreateRenderPass(device_, &render_pass_info, nullptr,
+                                       &scene_render_pass_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create scene render pass -----");
+  }
+}
+
+VkPipeline PostProcessChain::CreatePipeline(
+    VkPipelineCache pipeline_cache, const std::vector<char>& code,
+    const VkSpecializationInfo* specialization) const {
+  VkShaderModuleCreateInfo shader_module_info{};
+  shader_module_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  shader_module_info.codeSize = code.size();
+  shader_module_info.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+  VkShaderModule shader_module = VK_NULL_HANDLE;
+  if (VK_SUCCESS != vkCreateShaderModule(device_, &shader_module_info, nullptr,
+                                         &shader_module)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process shader module "
+        "-----");
+  }
+
+  VkComputePipelineCreateInfo pipeline_info{};
+  pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipeline_info.stage.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipeline_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipeline_info.stage.module = shader_module;
+  pipeline_info.stage.pName = "main";
+  pipeline_info.stage.pSpecializationInfo = specialization;
+  pipeline_info.layout = pipeline_layout_;
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult result = vkCreateComputePipelines(device_, pipeline_cache, 1,
+                                             &pipeline_info, nullptr,
+                                             &pipeline);
+  vkDestroyShaderModule(device_, shader_module, nullptr);
+
+  if (VK_SUCCESS != result) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process pipeline -----");
+  }
+
+  return pipeline;
+}
+
+void PostProcessChain::CreateDescriptorSets(
+    Targets& targets, const RenderGraph& graph,
+    const std::vector<VkImageView>& output_views) {
+  uint32_t output_cnt = static_cast<uint32_t>(output_views.size());
+  uint32_t bloom_mips = targets.bloom_mips;
+  uint32_t set_cnt = bloom_mips * 2 + output_cnt * 2;
+
+  std::array<VkDescriptorPoolSize, 2> pool_sizes{};
+  pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  pool_sizes[0].descriptorCount = set_cnt * 2;
+  pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  pool_sizes[1].descriptorCount = set_cnt;
+
+  VkDescriptorPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = set_cnt;
+
+  if (VK_SUCCESS != vkCreateDescriptorPool(device_, &pool_info, nullptr,
+                                           &targets.descriptor_pool)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create post process descriptor pool "
+        "-----");
+  }
+
+  VkDescriptorPool pool = targets.descriptor_pool;
+
+  for (uint32_t mip = 0; mip < bloom_mips; ++mip) {
+    VkImageView source = 0 == mip ? targets.hdr_view
+                                  : graph.GetMipView(targets.bloom, mip - 1);
+    VkImageLayout source_layout = 0 == mip
+                                      ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                      : VK_IMAGE_LAYOUT_GENERAL;
+    targets.bloom_down_sets.push_back(WriteSet(
+        pool, source, source_layout, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED,
+        graph.GetMipView(targets.bloom, mip)));
+  }
+
+  for (uint32_t mip = 0; mip + 1 < bloom_mips; ++mip) {
+    targets.bloom_up_sets.push_back(WriteSet(
+        pool, graph.GetMipView(targets.bloom, mip + 1),
+        VK_IMAGE_LAYOUT_GENERAL, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED,
+        graph.GetMipView(targets.bloom, mip)));
+  }
+
+  // without bloom the tonemap shader still declares the binding
+  VkImageView bloom_view = settings_.bloom
+                               ? graph.GetMipView(targets.bloom, 0)
+                               : targets.hdr_view;
+  VkImageLayout bloom_layout = settings_.bloom
+                                   ? VK_IMAGE_LAYOUT_GENERAL
+                                   : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  VkImageView ldr_view =
+      settings_.fxaa ? graph.GetView(targets.ldr) : VK_NULL_HANDLE;
+
+  for (uint32_t i = 0; i < output_cnt; ++i) {
+    VkImageView output = targets.storage_output
+                             ? output_views[i]
+                             : graph.GetView(targets.output);
+
+    targets.tonemap_sets.push_back(WriteSet(
+        pool, targets.hdr_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        bloom_view, bloom_layout, settings_.fxaa ? ldr_view : output));
+
+    if (settings_.fxaa) {
+      targets.fxaa_sets.push_back(WriteSet(pool, ldr_view,
+                                           VK_IMAGE_LAYOUT_GENERAL,
+                                           VK_NULL_HANDLE,
+                                           VK_IMAGE_LAYOUT_UNDEFINED, output));
+    }
+  }
+}
+
+VkDescriptorSet PostProcessChain::WriteSet(VkDescriptorPool pool,
+                                           VkImageView source,
+                                           VkImageLayout source_layout,
+                                           VkImageView second,
+                                           VkImageLayout second_layout,
+                                           VkImageView destination) {
+  VkDescriptorSetAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  alloc_info.descriptorPool = pool;
+  alloc_info.descriptorSetCount = 1;
+  alloc_info.pSetLayouts = &descriptor_set_layout_;
+
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  if (VK_SUCCESS != vkAllocateDescriptorSets(device_, &alloc_info, &set)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate post process descriptor set "
+        "-----");
+  }
+
+  std::array<VkDescriptorImageInfo, 3> image_infos{};
+  image_infos[0] = {sampler_, source, source_layout};
+  image_infos[1] = {sampler_, second, second_layout};
+  image_infos[2] = {VK_NULL_HANDLE, destination, VK_IMAGE_LAYOUT_GENERAL};
+
+  std::vector<VkWriteDescriptorSet> writes{};
+  for (uint32_t binding = 0; binding < image_infos.size(); ++binding) {
+    // bindings the pass does not read stay unwritten
+    if (VK_NULL_HANDLE == image_infos[binding].imageView) {
+      continue;
+    }
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = 2 == binding
+                               ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+                               : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_infos[binding];
+    writes.push_back(write);
+  }
+
+  vkUpdateDescriptorSets(device_, static_cast<uint32_t>(writes.size()),
+                         writes.data(), 0, nullptr);
+
+  return set;
+}
+
+void PostProcessChain::DestroyTargets(Targets& targets) {
+  // the images belong to the render graph
+  vkDestroyFramebuffer(device_, targets.scene_framebuffer, nullptr);
+  // frees the sets with it
+  vkDestroyDescriptorPool(device_, targets.descriptor_pool, nullptr);
+
+  targets = Targets{};
+}
+
+void PostProcessChain::Dispatch(VkCommandBuffer command_buffer,
+                                VkPipeline pipeline, VkDescriptorSet set,
+                                const PushConstants& push_constants,
+                                VkExtent2D extent) const {
+  vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+  vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline_layout_, 0, 1, &set, 0, nullptr);
+  vkCmdPushConstants(command_buffer, pipeline_layout_,
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants),
+                     &push_constants);
+  vkCmdDispatch(command_buffer,
+                (extent.width + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE,
+                (extent.height + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1);
+}
+
+}  // namespace playground
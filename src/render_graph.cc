@@ -0,0 +1,925 @@
+/**
+ * @file render_graph.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-30
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "render_graph.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace playground {
+
+namespace {
+
+// a use with any of these orders after everything before it
+const VkAccessFlags2KHR WRITE_ACCESS =
+    VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+    VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR |
+    VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR | VK_ACCESS_2_HOST_WRITE_BIT_KHR |
+    VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+bool HasStencil(VkFormat format) {
+  return VK_FORMAT_D32_SFLOAT_S8_UINT == format ||
+         VK_FORMAT_D24_UNORM_S8_UINT == format ||
+         VK_FORMAT_D16_UNORM_S8_UINT == format;
+}
+
+bool SameScope(const char* a, const char* b) {
+  if (nullptr == a || nullptr == b) {
+    return a == b;
+  }
+
+  return 0 == std::strcmp(a, b);
+}
+
+double ToMiB(VkDeviceSize bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+}  // namespace
+
+RenderGraph::Pass& RenderGraph::Pass::Read(RenderResource resource,
+                                           const ResourceAccess& access,
+                                           uint32_t mip) {
+  return AddUse(resource, access, mip, true, false);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::Write(RenderResource resource,
+                                            const ResourceAccess& access,
+                                            uint32_t mip) {
+  return AddUse(resource, access, mip, false, true);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::ReadWrite(RenderResource resource,
+                                                const ResourceAccess& access,
+                                                uint32_t mip) {
+  return AddUse(resource, access, mip, true, true);
+}
+
+RenderGraph::Pass& RenderGraph::Pass::SetRecord(Record record) {
+  this->record = std::move(record);
+  return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::SetQueue(RenderQueue queue) {
+  this->queue = queue;
+  return *this;
+}
+
+RenderGraph::Pass& RenderGraph::Pass::AddUse(RenderResource resource,
+                                             const ResourceAccess& access,
+                                             uint32_t mip, bool read,
+                                             bool write) {
+  uses.push_back({resource, access, mip, read, write});
+  return *this;
+}
+
+void RenderGraph::Init(VkDevice device, MemoryAllocator& allocator,
+                       bool synchronization2, uint32_t graphics_family,
+                       uint32_t compute_family) {
+  device_ = device;
+  allocator_ = &allocator;
+  graphics_family_ = graphics_family;
+  compute_family_ = compute_family;
+
+  if (synchronization2) {
+    cmd_pipeline_barrier2_ = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdPipelineBarrier2KHR"));
+  }
+}
+
+void RenderGraph::Destroy() {
+  for (auto& resource : resources_) {
+    for (auto view : resource.mip_views) {
+      vkDestroyImageView(device_, view, nullptr);
+    }
+    vkDestroyImageView(device_, resource.view, nullptr);
+    vkDestroyImage(device_, resource.image, nullptr);
+
+    resource.mip_views.clear();
+    resource.view = VK_NULL_HANDLE;
+    resource.image = VK_NULL_HANDLE;
+  }
+
+  for (auto& allocation : allocations_) {
+    allocator_->Free(allocation);
+  }
+  allocations_.clear();
+}
+
+RenderResource RenderGraph::ImportImage(const std::string& name,
+                                        const std::vector<VkImage>& images,
+                                        VkImageAspectFlags aspect,
+                                        const ResourceAccess& initial_access,
+                                        const ResourceAccess& final_access) {
+  Resource resource{};
+  resource.name = name;
+  resource.type = ResourceType::IMPORTED_IMAGE;
+  resource.desc.aspect = aspect;
+  resource.imports = images;
+  resource.initial_access = initial_access;
+  resource.final_access = final_access;
+  resources_.push_back(std::move(resource));
+
+  return static_cast<RenderResource>(resources_.size() - 1);
+}
+
+RenderResource RenderGraph::CreateImage(const std::string& name,
+                                        const RenderImageDesc& desc) {
+  Resource resource{};
+  resource.name = name;
+  resource.type = ResourceType::TRANSIENT_IMAGE;
+  resource.desc = desc;
+  resources_.push_back(std::move(resource));
+
+  return static_cast<RenderResource>(resources_.size() - 1);
+}
+
+RenderResource RenderGraph::CreateBuffer(const std::string& name,
+                                         const std::vector<VkBuffer>& buffers) {
+  Resource resource{};
+  resource.name = name;
+  resource.type = ResourceType::BUFFER;
+  resource.buffers = buffers;
+  resources_.push_back(std::move(resource));
+
+  return static_cast<RenderResource>(resources_.size() - 1);
+}
+
+RenderGraph::Pass& RenderGraph::AddPass(const std::string& name,
+                                        const char* scope) {
+  if (compiled_) {
+    throw std::runtime_error("----- Error::RenderGraph: " + name +
+                             " added after Compile() -----");
+  }
+
+  passes_.emplace_back();
+  Pass& pass = passes_.back();
+  pass.name = name;
+  pass.scope = scope;
+
+  return pass;
+}
+
+void RenderGraph::Compile() {
+  CullPasses();
+  AssignQueues();
+  CreateImages();
+  AllocateImages();
+  for (auto& resource : resources_) {
+    if (VK_NULL_HANDLE != resource.image) {
+      CreateViews(resource);
+    }
+  }
+  PlaceBarriers();
+  compiled_ = true;
+
+  size_t barrier_cnt = final_batch_.size() + release_batch_.size();
+  size_t batch_cnt =
+      (final_batch_.empty() ? 0 : 1) + (release_batch_.empty() ? 0 : 1);
+  for (const auto& batch : batches_) {
+    barrier_cnt += batch.size();
+    batch_cnt += batch.empty() ? 0 : 1;
+  }
+
+  std::clog << "----- Render Graph: " << order_.size() << " pass(es), "
+            << passes_.size() - order_.size() << " culled, "
+            << async_pass_count_ << " on async compute, " << barrier_cnt
+            << " barrier(s) in " << batch_cnt << " batch(es), "
+            << release_batch_.size() << " queue transfer(s)"
+            << (cmd_pipeline_barrier2_ ? " with synchronization2" : "")
+            << " -----" << std::endl;
+}
+
+VkImage RenderGraph::GetImage(RenderResource resource) const {
+  return resources_.at(resource).image;
+}
+
+VkImageView RenderGraph::GetView(RenderResource resource) const {
+  return resources_.at(resource).view;
+}
+
+VkImageView RenderGraph::GetMipView(RenderResource resource,
+                                    uint32_t mip) const {
+  const Resource& image = resources_.at(resource);
+  return image.mip_views.empty() ? image.view : image.mip_views.at(mip);
+}
+
+bool RenderGraph::HasAsyncPasses() const { return 0 != async_pass_count_; }
+
+VkPipelineStageFlags RenderGraph::GetAsyncWaitStages() const {
+  // nothing handed over, the semaphore still has to be waited on
+  return 0 != async_wait_stages_
+             ? static_cast<VkPipelineStageFlags>(async_wait_stages_)
+             : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+}
+
+void RenderGraph::ExecuteAsync(VkCommandBuffer command_buffer,
+                               const RenderGraphFrame& frame,
+                               GpuProfiler& profiler) const {
+  RecordPasses(command_buffer, frame, profiler, 0, async_pass_count_);
+  RecordBarriers(command_buffer, release_batch_, frame);
+}
+
+void RenderGraph::Execute(VkCommandBuffer command_buffer,
+                          const RenderGraphFrame& frame,
+                          GpuProfiler& profiler) const {
+  RecordPasses(command_buffer, frame, profiler, async_pass_count_,
+               order_.size());
+  RecordBarriers(command_buffer, final_batch_, frame);
+}
+
+void RenderGraph::RecordPasses(VkCommandBuffer command_buffer,
+                               const RenderGraphFrame& frame,
+                               GpuProfiler& profiler, size_t begin,
+                               size_t end) const {
+  const char* scope = nullptr;
+  uint32_t scope_id = 0;
+
+  for (size_t i = begin; i < end; ++i) {
+    const Pass& pass = passes_[order_[i]];
+    if (!SameScope(scope, pass.scope)) {
+      if (nullptr != scope) {
+        profiler.EndScope(command_buffer, scope_id);
+      }
+      scope = pass.scope;
+      if (nullptr != scope) {
+        scope_id = profiler.BeginScope(command_buffer, scope);
+      }
+    }
+
+    RecordBarriers(command_buffer, batches_[i], frame);
+    if (pass.record) {
+      pass.record(command_buffer, frame);
+    }
+  }
+
+  if (nullptr != scope) {
+    profiler.EndScope(command_buffer, scope_id);
+  }
+}
+
+uint32_t RenderGraph::GetMipCount(const Resource& resource) const {
+  return ResourceType::TRANSIENT_IMAGE == resource.type
+             ? resource.desc.mip_levels
+             : 1;
+}
+
+void RenderGraph::CullPasses() {
+  // backwards from the imports: a pass is kept if it writes something a
+  // kept pass or the caller reads
+  std::vector<bool> needed(resources_.size(), false);
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    needed[i] = ResourceType::IMPORTED_IMAGE == resources_[i].type;
+  }
+
+  std::vector<bool> kept(passes_.size(), false);
+  for (size_t i = passes_.size(); i-- > 0;) {
+    const Pass& pass = passes_[i];
+    kept[i] = std::any_of(pass.uses.begin(), pass.uses.end(),
+                          [&needed](const Pass::Use& use) {
+                            return use.write && needed[use.resource];
+                          });
+    if (!kept[i]) {
+      std::clog << "----- Render Graph: culled " << pass.name << " -----"
+                << std::endl;
+      continue;
+    }
+
+    for (const auto& use : pass.uses) {
+      if (use.read) {
+        needed[use.resource] = true;
+      }
+    }
+  }
+
+  order_.clear();
+  for (uint32_t i = 0; i < passes_.size(); ++i) {
+    if (!kept[i]) {
+      continue;
+    }
+
+    uint32_t position = static_cast<uint32_t>(order_.size());
+    order_.push_back(i);
+
+    for (const auto& use : passes_[i].uses) {
+      Resource& resource = resources_.at(use.resource);
+      if (ResourceType::TRANSIENT_IMAGE != resource.type) {
+        continue;
+      }
+
+      resource.first_pass = std::min(resource.first_pass, position);
+      resource.last_pass = std::max(resource.last_pass, position);
+      resource.usage |= use.access.usage;
+      resource.stages |= use.access.stages;
+      resource.writes |= use.access.access & WRITE_ACCESS;
+    }
+  }
+}
+
+void RenderGraph::AssignQueues() {
+  // one submission ahead of the graphics one, which waits for it; nothing
+  // flows back within the frame
+  async_pass_count_ = 0;
+  if (graphics_family_ == compute_family_) {
+    return;
+  }
+
+  bool graphics = false;
+  for (auto index : order_) {
+    const Pass& pass = passes_[index];
+    if (RenderQueue::ASYNC_COMPUTE != pass.queue) {
+      graphics = true;
+      continue;
+    }
+
+    if (graphics) {
+      throw std::runtime_error("----- Error::RenderGraph: " + pass.name +
+                               " runs on async compute after graphics "
+                               "passes -----");
+    }
+    // images would need their layouts handed over too
+    for (const auto& use : pass.uses) {
+      const Resource& resource = resources_.at(use.resource);
+      if (ResourceType::BUFFER != resource.type || resource.buffers.empty()) {
+        throw std::runtime_error("----- Error::RenderGraph: " + pass.name +
+                                 " on async compute uses " + resource.name +
+                                 ", only buffers with handles -----");
+      }
+    }
+    ++async_pass_count_;
+  }
+}
+
+void RenderGraph::CreateImages() {
+  for (auto& resource : resources_) {
+    // only used by culled passes
+    if (ResourceType::TRANSIENT_IMAGE != resource.type || 0 == resource.usage) {
+      continue;
+    }
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = resource.desc.extent.width;
+    image_info.extent.height = resource.desc.extent.height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = resource.desc.mip_levels;
+    image_info.arrayLayers = 1;
+    image_info.format = resource.desc.format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = resource.usage;
+    if (resource.desc.transient) {
+      image_info.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    }
+    image_info.samples = resource.desc.samples;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (VK_SUCCESS !=
+        vkCreateImage(device_, &image_info, nullptr, &resource.image)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create render graph image " +
+          resource.name + " -----");
+    }
+  }
+}
+
+void RenderGraph::AllocateImages() {
+  struct Group {
+    uint32_t last_pass;
+    uint32_t memory_type_bits;
+    std::vector<RenderResource> images;
+    std::vector<VkMemoryRequirements> requirements;
+  };
+
+  std::vector<RenderResource> sorted{};
+  for (RenderResource i = 0; i < resources_.size(); ++i) {
+    if (VK_NULL_HANDLE != resources_[i].image) {
+      sorted.push_back(i);
+    }
+  }
+  std::stable_sort(sorted.begin(), sorted.end(),
+                   [this](RenderResource a, RenderResource b) {
+                     return resources_[a].first_pass <
+                            resources_[b].first_pass;
+                   });
+
+  // first fit: join the first group that is done before the image starts
+  std::vector<Group> groups{};
+  VkDeviceSize requested_bytes = 0;
+  uint32_t lazy_cnt = 0;
+  for (auto id : sorted) {
+    Resource& resource = resources_[id];
+    VkMemoryRequirements requirements{};
+    vkGetImageMemoryRequirements(device_, resource.image, &requirements);
+
+    // never committed to main memory, nothing to share; without such
+    // memory it aliases like the rest
+    const VkMemoryPropertyFlags lazy = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                       VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    if (resource.desc.transient &&
+        allocator_->HasMemoryType(requirements.memoryTypeBits, lazy)) {
+      Allocation allocation = allocator_->Allocate(requirements, lazy, false);
+      vkBindImageMemory(device_, resource.image, allocation.memory,
+                        allocation.offset);
+      resource.previous_alias = id;
+      allocations_.push_back(allocation);
+      ++lazy_cnt;
+      continue;
+    }
+    requested_bytes += requirements.size;
+
+    auto group = std::find_if(
+        groups.begin(), groups.end(), [&](const Group& candidate) {
+          return candidate.last_pass < resource.first_pass &&
+                 0 != (candidate.memory_type_bits &
+                       requirements.memoryTypeBits);
+        });
+    if (groups.end() == group) {
+      groups.push_back({0, ~0u, {}, {}});
+      group = groups.end() - 1;
+    }
+
+    group->last_pass = resource.last_pass;
+    group->memory_type_bits &= requirements.memoryTypeBits;
+    group->images.push_back(id);
+    group->requirements.push_back(requirements);
+  }
+
+  VkDeviceSize allocated_bytes = 0;
+  for (const auto& group : groups) {
+    Allocation allocation = allocator_->AllocateAliased(
+        group.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    allocated_bytes += allocation.size;
+
+    for (size_t i = 0; i < group.images.size(); ++i) {
+      Resource& resource = resources_[group.images[i]];
+      vkBindImageMemory(device_, resource.image, allocation.memory,
+                        allocation.offset);
+      // the one before in the frame, or the last one of the previous frame
+      resource.previous_alias =
+          group.images[(i + group.images.size() - 1) % group.images.size()];
+    }
+    allocations_.push_back(allocation);
+  }
+
+  std::ios format_state(nullptr);
+  format_state.copyfmt(std::clog);
+  std::clog << "----- Render Graph: " << sorted.size() - lazy_cnt
+            << " image(s) in " << groups.size() << " allocation(s), "
+            << std::fixed << std::setprecision(2) << ToMiB(allocated_bytes)
+            << " / " << ToMiB(requested_bytes) << " MiB, " << lazy_cnt
+            << " lazily allocated -----" << std::endl;
+  std::clog.copyfmt(format_state);
+}
+
+void RenderGraph::CreateViews(Resource& resource) {
+  VkImageViewCreateInfo view_info{};
+  view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  view_info.image = resource.image;
+  view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  view_info.format = resource.desc.format;
+  view_info.subresourceRange.aspectMask = resource.desc.aspect;
+  view_info.subresourceRange.levelCount = resource.desc.mip_levels;
+  view_info.subresourceRange.layerCount = 1;
+
+  if (VK_SUCCESS !=
+      vkCreateImageView(device_, &view_info, nullptr, &resource.view)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create render graph view " +
+        resource.name + " -----");
+  }
+
+  if (1 == resource.desc.mip_levels) {
+    return;
+  }
+
+  resource.mip_views.resize(resource.desc.mip_levels, VK_NULL_HANDLE);
+  for (uint32_t mip = 0; mip < resource.desc.mip_levels; ++mip) {
+    view_info.subresourceRange.baseMipLevel = mip;
+    view_info.subresourceRange.levelCount = 1;
+
+    if (VK_SUCCESS != vkCreateImageView(device_, &view_info, nullptr,
+                                        &resource.mip_views[mip])) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create render graph view " +
+          resource.name + " -----");
+    }
+  }
+}
+
+void RenderGraph::PlaceBarriers() {
+  std::vector<std::vector<State>> states(resources_.size());
+  std::vector<bool> started(resources_.size(), false);
+  for (size_t i = 0; i < resources_.size(); ++i) {
+    const Resource& resource = resources_[i];
+    states[i].resize(GetMipCount(resource));
+
+    if (ResourceType::IMPORTED_IMAGE == resource.type) {
+      State& state = states[i][0];
+      state.layout = resource.initial_access.layout;
+      state.write_stages = resource.initial_access.stages;
+      state.write_access = resource.initial_access.access & WRITE_ACCESS;
+    }
+  }
+
+  batches_.clear();
+  std::vector<bool> async_used(resources_.size(), false);
+  for (size_t position = 0; position < order_.size(); ++position) {
+    const Pass& pass = passes_[order_[position]];
+
+    std::vector<Barrier> batch{};
+    if (0 != async_pass_count_ && async_pass_count_ == position) {
+      TransferOwnership(states, async_used, batch);
+    }
+
+    // a subresource used twice by the pass is used once with both
+    std::map<std::pair<RenderResource, uint32_t>, ResourceAccess> accesses{};
+    for (const auto& use : pass.uses) {
+      uint32_t mip_cnt = GetMipCount(resources_.at(use.resource));
+      uint32_t begin = ALL_MIPS == use.mip ? 0 : use.mip;
+      uint32_t end = ALL_MIPS == use.mip ? mip_cnt : use.mip + 1;
+      if (end > mip_cnt) {
+        throw std::runtime_error("----- Error::RenderGraph: " + pass.name +
+                                 " uses a missing mip of " +
+                                 resources_[use.resource].name + " -----");
+      }
+
+      for (uint32_t mip = begin; mip < end; ++mip) {
+        auto entry = accesses.emplace(std::make_pair(use.resource, mip),
+                                      use.access);
+        ResourceAccess& access = entry.first->second;
+        if (entry.second) {
+          continue;
+        }
+
+        if (access.layout != use.access.layout) {
+          throw std::runtime_error("----- Error::RenderGraph: " + pass.name +
+                                   " uses " + resources_[use.resource].name +
+                                   " in two layouts -----");
+        }
+        access.stages |= use.access.stages;
+        access.access |= use.access.access;
+      }
+    }
+
+    for (const auto& entry : accesses) {
+      RenderResource id = entry.first.first;
+      if (position < async_pass_count_) {
+        async_used[id] = true;
+      }
+      const Resource& resource = resources_[id];
+
+      // memory handed over from the image aliased before it, contents
+      // discarded
+      if (ResourceType::TRANSIENT_IMAGE == resource.type && !started[id]) {
+        const Resource& previous = resources_[resource.previous_alias];
+        for (auto& state : states[id]) {
+          state = State{};
+          state.write_stages = previous.stages;
+          state.write_access = previous.writes;
+        }
+        started[id] = true;
+      }
+
+      Transition(id, entry.first.second, states[id][entry.first.second],
+                 entry.second, batch);
+    }
+
+    MergeBarriers(batch);
+    batches_.push_back(std::move(batch));
+  }
+
+  final_batch_.clear();
+  for (RenderResource id = 0; id < resources_.size(); ++id) {
+    const Resource& resource = resources_[id];
+    if (ResourceType::IMPORTED_IMAGE == resource.type) {
+      Transition(id, 0, states[id][0], resource.final_access, final_batch_);
+    }
+  }
+}
+
+void RenderGraph::TransferOwnership(std::vector<std::vector<State>>& states,
+                                    const std::vector<bool>& async_used,
+                                    std::vector<Barrier>& batch) {
+  release_batch_.clear();
+  async_wait_stages_ = 0;
+
+  for (RenderResource id = 0; id < resources_.size(); ++id) {
+    if (!async_used[id]) {
+      continue;
+    }
+
+    // everything the graphics passes do with it, contents the async passes
+    // do not need back are never returned
+    VkPipelineStageFlags2KHR dst_stages = 0;
+    VkAccessFlags2KHR dst_access = 0;
+    for (size_t i = async_pass_count_; i < order_.size(); ++i) {
+      for (const auto& use : passes_[order_[i]].uses) {
+        if (id == use.resource) {
+          dst_stages |= use.access.stages;
+          dst_access |= use.access.access;
+        }
+      }
+    }
+    if (0 == dst_stages) {
+      continue;
+    }
+
+    State& state = states[id][0];
+    Barrier barrier{};
+    barrier.resource = id;
+    barrier.base_mip = 0;
+    barrier.mip_count = 1;
+    barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.src_family = compute_family_;
+    barrier.dst_family = graphics_family_;
+
+    // the release waits for the async passes, its destination is ignored
+    barrier.src_stages = state.write_stages | state.read_stages;
+    barrier.src_access = state.write_access;
+    barrier.dst_stages = 0;
+    barrier.dst_access = 0;
+    release_batch_.push_back(barrier);
+
+    // the acquire comes after the semaphore, its source is ignored
+    barrier.src_stages = 0;
+    barrier.src_access = 0;
+    barrier.dst_stages = dst_stages;
+    barrier.dst_access = dst_access;
+    batch.push_back(barrier);
+
+    async_wait_stages_ |= dst_stages;
+    // visible to every graphics use, following writes only wait for reads
+    state = State{};
+  }
+}
+
+void RenderGraph::Transition(RenderResource resource, uint32_t mip,
+                             State& state, const ResourceAccess& access,
+                             std::vector<Barrier>& batch) {
+  bool image = ResourceType::BUFFER != resources_[resource].type;
+  bool layout_change = image && access.layout != state.layout;
+
+  Barrier barrier{};
+  barrier.resource = resource;
+  barrier.base_mip = mip;
+  barrier.mip_count = 1;
+  barrier.dst_stages = access.stages;
+  barrier.dst_access = access.access;
+  barrier.old_layout = state.layout;
+  barrier.new_layout = image ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+
+  if (layout_change || 0 != (access.access & WRITE_ACCESS)) {
+    // after the last write and every read since
+    barrier.src_stages = state.write_stages | state.read_stages;
+    barrier.src_access = state.write_access;
+
+    bool write = 0 != (access.access & WRITE_ACCESS);
+    state.layout = barrier.new_layout;
+    state.write_stages = access.stages;
+    state.write_access = access.access & WRITE_ACCESS;
+    state.read_stages = 0;
+    // a transition is visible to the access it was made for, a write to
+    // nothing until the next barrier
+    state.visible_stages = write ? 0 : access.stages;
+    state.visible_access = write ? 0 : access.access;
+
+    if (!layout_change && 0 == barrier.src_stages) {
+      return;
+    }
+  } else {
+    bool visible = 0 == (access.stages & ~state.visible_stages) &&
+                   0 == (access.access & ~state.visible_access);
+    state.read_stages |= access.stages;
+    if (0 == state.write_stages || visible) {
+      return;
+    }
+
+    barrier.src_stages = state.write_stages;
+    barrier.src_access = state.write_access;
+    state.visible_stages |= access.stages;
+    state.visible_access |= access.access;
+  }
+
+  batch.push_back(barrier);
+}
+
+void RenderGraph::MergeBarriers(std::vector<Barrier>& batch) {
+  std::sort(batch.begin(), batch.end(),
+            [](const Barrier& a, const Barrier& b) {
+              return std::make_pair(a.resource, a.base_mip) <
+                     std::make_pair(b.resource, b.base_mip);
+            });
+
+  // neighbouring mips with the same transition become one range
+  std::vector<Barrier> merged{};
+  for (const auto& barrier : batch) {
+    if (!merged.empty()) {
+      Barrier& last = merged.back();
+      if (last.resource == barrier.resource &&
+          last.base_mip + last.mip_count == barrier.base_mip &&
+          last.src_stages == barrier.src_stages &&
+          last.src_access == barrier.src_access &&
+          last.dst_stages == barrier.dst_stages &&
+          last.dst_access == barrier.dst_access &&
+          last.old_layout == barrier.old_layout &&
+          last.new_layout == barrier.new_layout) {
+        ++last.mip_count;
+        continue;
+      }
+    }
+    merged.push_back(barrier);
+  }
+
+  batch.swap(merged);
+}
+
+VkImage RenderGraph::ResolveImage(const Resource& resource,
+                                  const RenderGraphFrame& frame) const {
+  if (ResourceType::TRANSIENT_IMAGE == resource.type) {
+    return resource.image;
+  }
+
+  return 1 == resource.imports.size() ? resource.imports[0]
+                                      : resource.imports.at(frame.image_index);
+}
+
+VkBuffer RenderGraph::ResolveBuffer(const Resource& resource,
+                                    const RenderGraphFrame& frame) const {
+  return 1 == resource.buffers.size() ? resource.buffers[0]
+                                      : resource.buffers.at(frame.frame);
+}
+
+VkImageAspectFlags RenderGraph::GetBarrierAspect(
+    const Resource& resource) const {
+  // layouts of combined formats are those of both aspects
+  VkImageAspectFlags aspect = resource.desc.aspect;
+  if ((aspect & VK_IMAGE_ASPECT_DEPTH_BIT) &&
+      HasStencil(resource.desc.format)) {
+    aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+  }
+
+  return aspect;
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer command_buffer,
+                                 const std::vector<Barrier>& batch,
+                                 const RenderGraphFrame& frame) const {
+  if (batch.empty()) {
+    return;
+  }
+
+  if (nullptr != cmd_pipeline_barrier2_) {
+    // buffers are whole, one memory barrier covers all of them
+    VkMemoryBarrier2KHR memory_barrier{};
+    memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    std::vector<VkBufferMemoryBarrier2KHR> buffer_barriers{};
+    std::vector<VkImageMemoryBarrier2KHR> image_barriers{};
+    image_barriers.reserve(batch.size());
+
+    for (const auto& barrier : batch) {
+      const Resource& resource = resources_[barrier.resource];
+      if (ResourceType::BUFFER == resource.type &&
+          barrier.src_family != barrier.dst_family) {
+        VkBufferMemoryBarrier2KHR buffer_barrier{};
+        buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+        buffer_barrier.srcStageMask = barrier.src_stages;
+        buffer_barrier.srcAccessMask = barrier.src_access;
+        buffer_barrier.dstStageMask = barrier.dst_stages;
+        buffer_barrier.dstAccessMask = barrier.dst_access;
+        buffer_barrier.srcQueueFamilyIndex = barrier.src_family;
+        buffer_barrier.dstQueueFamilyIndex = barrier.dst_family;
+        buffer_barrier.buffer = ResolveBuffer(resource, frame);
+        buffer_barrier.offset = 0;
+        buffer_barrier.size = VK_WHOLE_SIZE;
+        buffer_barriers.push_back(buffer_barrier);
+        continue;
+      }
+      if (ResourceType::BUFFER == resource.type) {
+        memory_barrier.srcStageMask |= barrier.src_stages;
+        memory_barrier.srcAccessMask |= barrier.src_access;
+        memory_barrier.dstStageMask |= barrier.dst_stages;
+        memory_barrier.dstAccessMask |= barrier.dst_access;
+        continue;
+      }
+
+      VkImageMemoryBarrier2KHR image_barrier{};
+      image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+      image_barrier.srcStageMask = barrier.src_stages;
+      image_barrier.srcAccessMask = barrier.src_access;
+      image_barrier.dstStageMask = barrier.dst_stages;
+      image_barrier.dstAccessMask = barrier.dst_access;
+      image_barrier.oldLayout = barrier.old_layout;
+      image_barrier.newLayout = barrier.new_layout;
+      image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier.image = ResolveImage(resource, frame);
+      image_barrier.subresourceRange.aspectMask = GetBarrierAspect(resource);
+      image_barrier.subresourceRange.baseMipLevel = barrier.base_mip;
+      image_barrier.subresourceRange.levelCount = barrier.mip_count;
+      image_barrier.subresourceRange.layerCount = 1;
+      image_barriers.push_back(image_barrier);
+    }
+
+    bool has_memory_barrier = 0 != memory_barrier.srcStageMask ||
+                              0 != memory_barrier.dstStageMask;
+
+    VkDependencyInfoKHR dependency_info{};
+    dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    dependency_info.memoryBarrierCount = has_memory_barrier ? 1 : 0;
+    dependency_info.pMemoryBarriers = &memory_barrier;
+    dependency_info.bufferMemoryBarrierCount =
+        static_cast<uint32_t>(buffer_barriers.size());
+    dependency_info.pBufferMemoryBarriers = buffer_barriers.data();
+    dependency_info.imageMemoryBarrierCount =
+        static_cast<uint32_t>(image_barriers.size());
+    dependency_info.pImageMemoryBarriers = image_barriers.data();
+
+    cmd_pipeline_barrier2_(command_buffer, &dependency_info);
+    return;
+  }
+
+  // the original barriers take one stage mask for all of them
+  VkPipelineStageFlags src_stages = 0;
+  VkPipelineStageFlags dst_stages = 0;
+  VkMemoryBarrier memory_barrier{};
+  memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  bool has_memory_barrier = false;
+  std::vector<VkBufferMemoryBarrier> buffer_barriers{};
+  std::vector<VkImageMemoryBarrier> image_barriers{};
+  image_barriers.reserve(batch.size());
+
+  for (const auto& barrier : batch) {
+    src_stages |= static_cast<VkPipelineStageFlags>(barrier.src_stages);
+    dst_stages |= static_cast<VkPipelineStageFlags>(barrier.dst_stages);
+
+    const Resource& resource = resources_[barrier.resource];
+    if (ResourceType::BUFFER == resource.type &&
+        barrier.src_family != barrier.dst_family) {
+      VkBufferMemoryBarrier buffer_barrier{};
+      buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      buffer_barrier.srcAccessMask =
+          static_cast<VkAccessFlags>(barrier.src_access);
+      buffer_barrier.dstAccessMask =
+          static_cast<VkAccessFlags>(barrier.dst_access);
+      buffer_barrier.srcQueueFamilyIndex = barrier.src_family;
+      buffer_barrier.dstQueueFamilyIndex = barrier.dst_family;
+      buffer_barrier.buffer = ResolveBuffer(resource, frame);
+      buffer_barrier.offset = 0;
+      buffer_barrier.size = VK_WHOLE_SIZE;
+      buffer_barriers.push_back(buffer_barrier);
+      continue;
+    }
+    if (ResourceType::BUFFER == resource.type) {
+      memory_barrier.srcAccessMask |=
+          static_cast<VkAccessFlags>(barrier.src_access);
+      memory_barrier.dstAccessMask |=
+          static_cast<VkAccessFlags>(barrier.dst_access);
+      has_memory_barrier = true;
+      continue;
+    }
+
+    VkImageMemoryBarrier image_barrier{};
+    image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    image_barrier.srcAccessMask =
+        static_cast<VkAccessFlags>(barrier.src_access);
+    image_barrier.dstAccessMask =
+        static_cast<VkAccessFlags>(barrier.dst_access);
+    image_barrier.oldLayout = barrier.old_layout;
+    image_barrier.newLayout = barrier.new_layout;
+    image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    image_barrier.image = ResolveImage(resource, frame);
+    image_barrier.subresourceRange.aspectMask = GetBarrierAspect(resource);
+    image_barrier.subresourceRange.baseMipLevel = barrier.base_mip;
+    image_barrier.subresourceRange.levelCount = barrier.mip_count;
+    image_barrier.subresourceRange.layerCount = 1;
+    image_barriers.push_back(image_barrier);
+  }
+
+  vkCmdPipelineBarrier(
+      command_buffer,
+      0 != src_stages ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      0 != dst_stages ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+      has_memory_barrier ? 1 : 0, &memory_barrier,
+      static_cast<uint32_t>(buffer_barriers.size()), buffer_barriers.data(),
+      static_cast<uint32_t>(image_barriers.size()), image_barriers.data());
+}
+
+}  // namespace playground
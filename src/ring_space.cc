@@ -0,0 +1,77 @@
+/**
+ * @file ring_space.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "ring_space.h"
+
+namespace playground {
+
+void RingSpace::Reset(uint64_t capacity) {
+  capacity_ = capacity;
+  head_ = 0;
+  tail_ = 0;
+  retired_.clear();
+}
+
+uint64_t RingSpace::Capacity() const { return capacity_; }
+
+uint64_t RingSpace::Used() const { return head_ - tail_; }
+
+bool RingSpace::TryAllocate(uint64_t size, uint64_t alignment,
+                            uint64_t& offset) {
+  if (0 == capacity_ || size > capacity_) {
+    return false;
+  }
+
+  // nothing is held, start over at the beginning: padding to the end would
+  // keep anything larger than the rest of the ring from ever fitting
+  if (head_ == tail_) {
+    head_ = (head_ + capacity_ - 1) / capacity_ * capacity_;
+    tail_ = head_;
+  }
+
+  uint64_t head = head_;
+  uint64_t position = head % capacity_;
+
+  uint64_t padding = (alignment - position % alignment) % alignment;
+  // never let an allocation straddle the end of the ring
+  if (position + padding + size > capacity_) {
+    head += capacity_ - position;
+    position = 0;
+    padding = 0;
+  }
+  head += padding;
+
+  if (head + size - tail_ > capacity_) {
+    return false;
+  }
+
+  offset = position + padding;
+  head_ = head + size;
+
+  return true;
+}
+
+void RingSpace::Retire(uint64_t marker) {
+  uint64_t last_head = retired_.empty() ? tail_ : retired_.back().head;
+  if (last_head == head_) {
+    return;
+  }
+
+  retired_.push_back({marker, head_});
+}
+
+void RingSpace::Release(uint64_t marker) {
+  while (!retired_.empty() && retired_.front().marker <= marker) {
+    tail_ = retired_.front().head;
+    retired_.pop_front();
+  }
+}
+
+}  // namespace playground
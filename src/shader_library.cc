@@ -0,0 +1,272 @@
+/**
+ * @file shader_library.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-29
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "shader_library.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#include "trace.h"
+
+namespace playground {
+
+namespace {
+
+const std::string SPV_EXTENSION{".spv"};
+
+// same invocation as shaders/compile.sh, glslc reports errors on stderr
+void Compile(const std::string& source_path, const std::string& spv_path,
+             const std::string& format) {
+  // a fresh build may not have compiled any shader yet
+  std::error_code error{};
+  std::filesystem::create_directories(
+      std::filesystem::path(spv_path).parent_path(), error);
+
+  std::string command = "\"" + GLSLC_PATH + "\" \"" + source_path +
+                        "\" -o \"" + spv_path + "\"";
+  if (!format.empty()) {
+    command += " -DOUTPUT_FORMAT=" + format;
+  }
+#ifdef _WIN32
+  // cmd.exe strips the outermost quotes of a command starting with one
+  command = "\"" + command + "\"";
+#endif
+
+  if (0 != std::system(command.c_str())) {
+    throw std::runtime_error("----- Error::Shader: Failed to compile " +
+                             source_path + " -----");
+  }
+}
+
+}  // namespace
+
+SpecializationConstants& SpecializationConstants::Set(uint32_t constant_id,
+                                                      uint32_t value) {
+  auto entry = std::find_if(entries_.begin(), entries_.end(),
+                            [constant_id](const VkSpecializationMapEntry& e) {
+                              return e.constantID == constant_id;
+                            });
+  if (entries_.end() != entry) {
+    data_[entry->offset / sizeof(uint32_t)] = value;
+    return *this;
+  }
+
+  entries_.push_back({constant_id,
+                      static_cast<uint32_t>(data_.size() * sizeof(uint32_t)),
+                      sizeof(uint32_t)});
+  data_.push_back(value);
+
+  return *this;
+}
+
+const VkSpecializationInfo* SpecializationConstants::Get() {
+  if (entries_.empty()) {
+    return nullptr;
+  }
+
+  info_.mapEntryCount = static_cast<uint32_t>(entries_.size());
+  info_.pMapEntries = entries_.data();
+  info_.dataSize = data_.size() * sizeof(uint32_t);
+  info_.pData = data_.data();
+
+  return &info_;
+}
+
+ShaderLibrary::ShaderLibrary(JobSystem& job_system, AssetLoader& asset_loader,
+                             const std::string& spv_dir,
+                             const std::string& source_dir)
+    : job_system_(job_system),
+      asset_loader_(asset_loader),
+      spv_dir_(spv_dir),
+      source_dir_(source_dir) {}
+
+ShaderLibrary::~ShaderLibrary() {
+  // a compile still running would write into a file nobody reads
+  for (const auto& shader : shaders_) {
+    if (shader.reload) {
+      job_system_.Wait(shader.reload->counter);
+    }
+  }
+}
+
+ShaderId ShaderLibrary::Request(const std::string& name,
+                                const std::string& format) {
+  Shader shader{};
+  std::string variant = format.empty() ? name : name + "." + format;
+  shader.spv_path = (spv_dir_ / (variant + SPV_EXTENSION)).string();
+  shader.source_path = (source_dir_ / name).string();
+  shader.format = format;
+
+  // SPIR-V left over from another revision fails much later, at pipeline
+  // creation, with mismatched inputs or push constants; zero times are
+  // missing files, not early ones
+  const std::filesystem::file_time_type missing{};
+  auto source_time = GetWriteTime(shader.source_path);
+  auto spv_time = GetWriteTime(shader.spv_path);
+  if (missing == spv_time ||
+      (missing != source_time && spv_time < source_time)) {
+    throw std::runtime_error("----- Error::Shader: " + shader.spv_path +
+                             " is missing or older than " +
+                             shader.source_path +
+                             ", build the shaders target -----");
+  }
+
+  shader.asset = asset_loader_.LoadFile(shader.spv_path);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shaders_.push_back(std::move(shader));
+
+  return static_cast<ShaderId>(shaders_.size() - 1);
+}
+
+ShaderLibrary::Code ShaderLibrary::Get(ShaderId id) {
+  std::shared_ptr<Asset> asset{};
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Shader& shader = shaders_.at(id);
+    if (shader.code) {
+      return shader.code;
+    }
+    asset = shader.asset;
+  }
+
+  asset_loader_.Wait(*asset);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  Shader& shader = shaders_[id];
+  if (!shader.code) {
+    shader.code = std::make_shared<const std::vector<char>>(asset->bytes);
+  }
+
+  return shader.code;
+}
+
+const std::string& ShaderLibrary::GetPath(ShaderId id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return shaders_.at(id).spv_path;
+}
+
+void ShaderLibrary::SetHotReload(bool enabled) {
+  hot_reload_ = enabled;
+  if (!hot_reload_) {
+    return;
+  }
+
+  for (auto& shader : shaders_) {
+    shader.source_time = GetWriteTime(shader.source_path);
+    shader.spv_time = GetWriteTime(shader.spv_path);
+  }
+  last_poll_ = std::chrono::steady_clock::now();
+
+  std::clog << "----- Shader Library: watching " << shaders_.size()
+            << " shader(s) in " << source_dir_.string() << ", compiling into "
+            << spv_dir_.string() << " with " << GLSLC_PATH << " -----"
+            << std::endl;
+}
+
+bool ShaderLibrary::IsHotReload() const { return hot_reload_; }
+
+std::vector<ShaderId> ShaderLibrary::Poll() {
+  std::vector<ShaderId> reloaded{};
+  if (!hot_reload_) {
+    return reloaded;
+  }
+
+  for (ShaderId id = 0; id < shaders_.size(); ++id) {
+    Shader& shader = shaders_[id];
+    if (!shader.reload || !shader.reload->counter.IsDone()) {
+      continue;
+    }
+
+    if (shader.reload->error.empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shader.code = std::make_shared<const std::vector<char>>(
+          std::move(shader.reload->code));
+      reloaded.push_back(id);
+      std::clog << "----- Shader Library: reloaded " << shader.spv_path
+                << " -----" << std::endl;
+    } else {
+      std::clog << shader.reload->error << std::endl;
+      std::clog << "----- Shader Library: keeping the previous "
+                << shader.spv_path << " -----" << std::endl;
+    }
+
+    // a compile rewrote the binary, which must not trigger another reload
+    shader.source_time = GetWriteTime(shader.source_path);
+    shader.spv_time = GetWriteTime(shader.spv_path);
+    shader.reload.reset();
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_poll_ < SHADER_WATCH_INTERVAL) {
+    return reloaded;
+  }
+  last_poll_ = now;
+
+  for (auto& shader : shaders_) {
+    if (shader.reload) {
+      continue;
+    }
+
+    // the source wins, its binary is rebuilt from it
+    if (GetWriteTime(shader.source_path) != shader.source_time) {
+      StartReload(shader, true);
+    } else if (GetWriteTime(shader.spv_path) != shader.spv_time) {
+      StartReload(shader, false);
+    }
+  }
+
+  return reloaded;
+}
+
+std::filesystem::file_time_type ShaderLibrary::GetWriteTime(
+    const std::string& path) {
+  if (path.empty()) {
+    return std::filesystem::file_time_type{};
+  }
+
+  std::error_code error{};
+  auto time = std::filesystem::last_write_time(path, error);
+  return error ? std::filesystem::file_time_type{} : time;
+}
+
+void ShaderLibrary::StartReload(Shader& shader, bool compile) {
+  auto reload = std::make_shared<Reload>();
+  reload->compile = compile;
+  shader.reload = reload;
+
+  // no reference to the library, the job may outlive a failed frame
+  job_system_.Schedule(
+      [reload, source_path = shader.source_path, spv_path = shader.spv_path,
+       format = shader.format]() {
+        TRACE_SCOPE("ReloadShader");
+        try {
+          if (reload->compile) {
+            Compile(source_path, spv_path, format);
+          }
+
+          reload->code = AssetLoader::ReadFile(spv_path);
+          if (reload->code.empty() ||
+              0 != reload->code.size() % sizeof(uint32_t)) {
+            throw std::runtime_error("----- Error::Shader: Invalid SPIR-V in " +
+                                     spv_path + " -----");
+          }
+        } catch (const std::exception& e) {
+          reload->error = e.what();
+        }
+      },
+      &reload->counter);
+}
+
+}  // namespace playground
@@ -0,0 +1,82 @@
+/**
+ * @file staging_ring.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "staging_ring.h"
+
+#include <stdexcept>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+void StagingRing::Init(VkDevice device, MemoryAllocator& allocator,
+                       VkDeviceSize capacity) {
+  device_ = device;
+  allocator_ = &allocator;
+  space_.Reset(capacity);
+
+  VkBufferCreateInfo buffer_info{};
+  buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_info.size = capacity;
+  buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+  buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  if (VK_SUCCESS != vkCreateBuffer(device_, &buffer_info, nullptr, &buffer_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create staging ring buffer -----");
+  }
+
+  VkMemoryRequirements mem_requirements{};
+  vkGetBufferMemoryRequirements(device_, buffer_, &mem_requirements);
+
+  memory_ = allocator_->Allocate(mem_requirements,
+                                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                 true);
+
+  if (VK_SUCCESS !=
+      vkBindBufferMemory(device_, buffer_, memory_.memory, memory_.offset)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to bind staging ring memory -----");
+  }
+}
+
+void StagingRing::Destroy() {
+  vkDestroyBuffer(device_, buffer_, nullptr);
+  allocator_->Free(memory_);
+  buffer_ = VK_NULL_HANDLE;
+
+  space_.Reset(0);
+}
+
+VkDeviceSize StagingRing::Capacity() const { return space_.Capacity(); }
+
+VkDeviceSize StagingRing::Used() const { return space_.Used(); }
+
+bool StagingRing::TryAllocate(VkDeviceSize size, VkDeviceSize alignment,
+                              StagingAllocation& allocation) {
+  uint64_t offset = 0;
+  if (!space_.TryAllocate(size, alignment, offset)) {
+    return false;
+  }
+
+  allocation.buffer = buffer_;
+  allocation.offset = offset;
+  allocation.size = size;
+  allocation.mapped = static_cast<char*>(memory_.mapped) + offset;
+
+  return true;
+}
+
+void StagingRing::Retire(uint64_t marker) { space_.Retire(marker); }
+
+void StagingRing::Release(uint64_t marker) { space_.Release(marker); }
+
+}  // namespace playground
@@ -0,0 +1,154 @@
+/**
+ * @file startup_graph.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-04-02
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "startup_graph.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "trace.h"
+
+namespace playground {
+
+StartupGraph::StartupGraph(JobSystem& job_system) : job_system_(job_system) {}
+
+StartupGraph::StepId StartupGraph::AddMain(
+    const std::string& name, Step step,
+    const std::vector<StepId>& dependencies) {
+  return Add(name, std::move(step), false, dependencies);
+}
+
+StartupGraph::StepId StartupGraph::AddWorker(
+    const std::string& name, Step step,
+    const std::vector<StepId>& dependencies) {
+  return Add(name, std::move(step), true, dependencies);
+}
+
+void StartupGraph::Run() {
+  start_time_ = std::chrono::steady_clock::now();
+
+  for (StepId id = 0; id < nodes_.size(); ++id) {
+    if (nodes_[id]->worker && nodes_[id]->dependencies.empty()) {
+      Schedule(id);
+    }
+  }
+
+  // helping with worker steps while a main thread step waits for them
+  for (StepId id = 0; id < nodes_.size(); ++id) {
+    Node& node = *nodes_[id];
+    if (node.worker) {
+      continue;
+    }
+
+    for (StepId dependency : node.dependencies) {
+      job_system_.Wait(nodes_[dependency]->done);
+    }
+    Execute(id);
+  }
+
+  for (const auto& node : nodes_) {
+    job_system_.Wait(node->done);
+  }
+
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+}
+
+std::vector<StartupTiming> StartupGraph::GetTimings() const {
+  std::vector<StartupTiming> timings{};
+  for (const auto& node : nodes_) {
+    if (!node->timing.name.empty()) {
+      timings.push_back(node->timing);
+    }
+  }
+
+  std::stable_sort(timings.begin(), timings.end(),
+                   [](const StartupTiming& a, const StartupTiming& b) {
+                     return a.start_ms < b.start_ms;
+                   });
+  return timings;
+}
+
+StartupGraph::StepId StartupGraph::Add(
+    const std::string& name, Step step, bool worker,
+    const std::vector<StepId>& dependencies) {
+  StepId id = static_cast<StepId>(nodes_.size());
+  for (StepId dependency : dependencies) {
+    if (dependency >= id) {
+      throw std::runtime_error(
+          "----- Error::Startup: " + name +
+          " depends on a step added after it -----");
+    }
+  }
+
+  auto node = std::make_unique<Node>();
+  node->name = name;
+  node->trace_name = Tracer::Get().Intern(name);
+  node->step = std::move(step);
+  node->worker = worker;
+  node->dependencies = dependencies;
+  node->waiting.store(static_cast<uint32_t>(dependencies.size()));
+  node->done.count.store(1);
+
+  for (StepId dependency : dependencies) {
+    nodes_[dependency]->dependents.push_back(id);
+  }
+  nodes_.push_back(std::move(node));
+
+  return id;
+}
+
+void StartupGraph::Execute(StepId id) {
+  Node& node = *nodes_[id];
+
+  if (!failed_.load(std::memory_order_acquire)) {
+    TRACE_SCOPE(node.trace_name);
+
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+      node.step();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+      failed_.store(true, std::memory_order_release);
+    }
+    auto end_time = std::chrono::steady_clock::now();
+
+    node.timing.name = node.name;
+    node.timing.start_ms =
+        std::chrono::duration<double, std::milli>(start_time - start_time_)
+            .count();
+    node.timing.ms =
+        std::chrono::duration<double, std::milli>(end_time - start_time)
+            .count();
+    node.timing.worker = node.worker;
+  }
+
+  // main thread steps only wait on `done`, they start in order
+  for (StepId dependent : node.dependents) {
+    Node& next = *nodes_[dependent];
+    if (1 == next.waiting.fetch_sub(1, std::memory_order_acq_rel) &&
+        next.worker) {
+      Schedule(dependent);
+    }
+  }
+
+  node.done.count.store(0, std::memory_order_release);
+}
+
+void StartupGraph::Schedule(StepId id) {
+  job_system_.Schedule([this, id]() { Execute(id); });
+}
+
+}  // namespace playground
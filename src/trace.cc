@@ -0,0 +1,165 @@
+/**
+ * @file trace.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-16
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace playground {
+
+namespace {
+
+thread_local void* t_buffer = nullptr;
+
+uint64_t SteadyNanoseconds() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void WriteEscaped(std::ostream& out, const std::string& text) {
+  for (char c : text) {
+    if ('"' == c || '\\' == c) {
+      out << '\\';
+    }
+    out << c;
+  }
+}
+
+}  // namespace
+
+Tracer& Tracer::Get() {
+  static Tracer tracer{};
+  return tracer;
+}
+
+Tracer::Tracer() : epoch_ns_(SteadyNanoseconds()) {}
+
+void Tracer::SetEnabled(bool enabled) {
+  enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::Now() const { return SteadyNanoseconds() - epoch_ns_; }
+
+void Tracer::Record(const char* name, uint64_t begin_ns, uint64_t end_ns) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+
+  uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.events[head % TRACE_EVENTS_PER_THREAD] = {name, begin_ns, end_ns};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+const char* Tracer::Intern(const std::string& name) {
+  std::lock_guard<std::mutex> lock(names_mutex_);
+  return names_.insert(name).first->c_str();
+}
+
+void Tracer::SetThreadName(const std::string& name) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  buffer.name = name;
+}
+
+bool Tracer::Export(const std::string& path) {
+  std::ofstream file(path, std::ios::trunc);
+  if (!file.is_open()) {
+    std::clog << "----- Warning::Trace: Failed to open " << path << " -----"
+              << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  file << std::fixed << std::setprecision(3);
+
+  bool first = true;
+  size_t event_cnt = 0;
+  std::vector<TraceEvent> events{};
+
+  for (const auto& buffer : buffers_) {
+    file << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\","
+         << "\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":\"";
+    WriteEscaped(file, buffer->name);
+    file << "\"}}";
+    first = false;
+
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t begin =
+        head > TRACE_EVENTS_PER_THREAD ? head - TRACE_EVENTS_PER_THREAD : 0;
+
+    events.clear();
+    for (uint64_t i = begin; i < head; ++i) {
+      events.push_back(buffer->events[i % TRACE_EVENTS_PER_THREAD]);
+    }
+
+    // slots the owner overwrote (or is overwriting) while we copied
+    uint64_t now_head = buffer->head.load(std::memory_order_acquire);
+    uint64_t valid_begin = now_head >= TRACE_EVENTS_PER_THREAD
+                               ? now_head - TRACE_EVENTS_PER_THREAD + 1
+                               : 0;
+
+    for (uint64_t i = std::max(begin, valid_begin); i < head; ++i) {
+      const TraceEvent& event = events[i - begin];
+      file << ",{\"name\":\"";
+      WriteEscaped(file, event.name);
+      file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+           << ",\"ts\":" << event.begin_ns / 1000.0
+           << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+      ++event_cnt;
+    }
+  }
+
+  file << "]}" << std::endl;
+
+  std::clog << "----- Trace: Wrote " << event_cnt << " events to " << path
+            << " -----" << std::endl;
+
+  return true;
+}
+
+Tracer::ThreadBuffer& Tracer::GetThreadBuffer() {
+  if (t_buffer) {
+    return *static_cast<ThreadBuffer*>(t_buffer);
+  }
+
+  auto buffer = std::make_unique<ThreadBuffer>();
+  buffer->events = std::make_unique<TraceEvent[]>(TRACE_EVENTS_PER_THREAD);
+
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  buffer->id = static_cast<uint32_t>(buffers_.size());
+  buffer->name = "Thread " + std::to_string(buffer->id);
+  t_buffer = buffer.get();
+  buffers_.push_back(std::move(buffer));
+
+  return *static_cast<ThreadBuffer*>(t_buffer);
+}
+
+TraceScope::TraceScope(const char* name) : name_(name) {
+  if (Tracer::Get().IsEnabled()) {
+    begin_ns_ = Tracer::Get().Now();
+  } else {
+    name_ = nullptr;
+  }
+}
+
+TraceScope::~TraceScope() {
+  if (name_) {
+    Tracer::Get().Record(name_, begin_ns_, Tracer::Get().Now());
+  }
+}
+
+}  // namespace playground
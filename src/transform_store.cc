@@ -0,0 +1,353 @@
+/**
+ * @file transform_store.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-04-01
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "transform_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PLAYGROUND_TRANSFORM_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define PLAYGROUND_TRANSFORM_SSE
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PLAYGROUND_TRANSFORM_NEON
+#endif
+
+namespace playground {
+
+namespace {
+
+const uint32_t POSITION_X = 0;
+const uint32_t ROTATION_X = 3;
+const uint32_t SCALE_X = 7;
+const uint32_t COMPONENT_COUNT = 10;
+
+// the kernel's registers, one lane per instance, and the few operations it
+// needs of them
+#if defined(PLAYGROUND_TRANSFORM_AVX2)
+using Lanes = __m256;
+const uint32_t LANES = 8;
+const char* const KERNEL_NAME = "AVX2";
+
+inline Lanes Load(const float* data) { return _mm256_loadu_ps(data); }
+inline void Store(float* data, Lanes value) { _mm256_storeu_ps(data, value); }
+inline Lanes Splat(float value) { return _mm256_set1_ps(value); }
+inline Lanes Add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes Div(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+inline Lanes Sqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+
+void StoreColumns128(__m128 x, __m128 y, __m128 z, __m128 w, char* dst,
+                     size_t stride) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst), x);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + stride), y);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + 2 * stride), z);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + 3 * stride), w);
+}
+
+// the same column of every lane's matrix, `stride` bytes apart
+void StoreColumns(Lanes x, Lanes y, Lanes z, Lanes w, char* dst,
+                  size_t stride) {
+  StoreColumns128(_mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+                  _mm256_castps256_ps128(z), _mm256_castps256_ps128(w), dst,
+                  stride);
+  StoreColumns128(_mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1),
+                  _mm256_extractf128_ps(z, 1), _mm256_extractf128_ps(w, 1),
+                  dst + 4 * stride, stride);
+}
+#elif defined(PLAYGROUND_TRANSFORM_SSE)
+using Lanes = __m128;
+const uint32_t LANES = 4;
+const char* const KERNEL_NAME = "SSE";
+
+inline Lanes Load(const float* data) { return _mm_loadu_ps(data); }
+inline void Store(float* data, Lanes value) { _mm_storeu_ps(data, value); }
+inline Lanes Splat(float value) { return _mm_set1_ps(value); }
+inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes Div(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+inline Lanes Sqrt(Lanes a) { return _mm_sqrt_ps(a); }
+
+void StoreColumns(Lanes x, Lanes y, Lanes z, Lanes w, char* dst,
+                  size_t stride) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst), x);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + stride), y);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + 2 * stride), z);
+  _mm_storeu_ps(reinterpret_cast<float*>(dst + 3 * stride), w);
+}
+#elif defined(PLAYGROUND_TRANSFORM_NEON)
+using Lanes = float32x4_t;
+const uint32_t LANES = 4;
+const char* const KERNEL_NAME = "NEON";
+
+inline Lanes Load(const float* data) { return vld1q_f32(data); }
+inline void Store(float* data, Lanes value) { vst1q_f32(data, value); }
+inline Lanes Splat(float value) { return vdupq_n_f32(value); }
+inline Lanes Add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+inline Lanes Sqrt(Lanes a) {
+  // AArch64 has it, 32-bit NEON only the estimate and its refinement
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return vsqrtq_f32(a);
+#else
+  Lanes estimate = vrsqrteq_f32(a);
+  estimate = vmulq_f32(estimate,
+                       vrsqrtsq_f32(vmulq_f32(a, estimate), estimate));
+  estimate = vmulq_f32(estimate,
+                       vrsqrtsq_f32(vmulq_f32(a, estimate), estimate));
+  return vmulq_f32(a, estimate);
+#endif
+}
+inline Lanes Div(Lanes a, Lanes b) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return vdivq_f32(a, b);
+#else
+  Lanes estimate = vrecpeq_f32(b);
+  estimate = vmulq_f32(estimate, vrecpsq_f32(b, estimate));
+  estimate = vmulq_f32(estimate, vrecpsq_f32(b, estimate));
+  return vmulq_f32(a, estimate);
+#endif
+}
+
+void StoreColumns(Lanes x, Lanes y, Lanes z, Lanes w, char* dst,
+                  size_t stride) {
+  float32x4x2_t xy = vtrnq_f32(x, y);
+  float32x4x2_t zw = vtrnq_f32(z, w);
+  vst1q_f32(reinterpret_cast<float*>(dst),
+            vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(zw.val[0])));
+  vst1q_f32(reinterpret_cast<float*>(dst + stride),
+            vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(zw.val[1])));
+  vst1q_f32(reinterpret_cast<float*>(dst + 2 * stride),
+            vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(zw.val[0])));
+  vst1q_f32(reinterpret_cast<float*>(dst + 3 * stride),
+            vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(zw.val[1])));
+}
+#else
+using Lanes = float;
+const uint32_t LANES = 1;
+const char* const KERNEL_NAME = "scalar";
+
+inline Lanes Load(const float* data) { return *data; }
+inline void Store(float* data, Lanes value) { *data = value; }
+inline Lanes Splat(float value) { return value; }
+inline Lanes Add(Lanes a, Lanes b) { return a + b; }
+inline Lanes Sub(Lanes a, Lanes b) { return a - b; }
+inline Lanes Mul(Lanes a, Lanes b) { return a * b; }
+inline Lanes Div(Lanes a, Lanes b) { return a / b; }
+inline Lanes Sqrt(Lanes a) { return std::sqrt(a); }
+
+void StoreColumns(Lanes x, Lanes y, Lanes z, Lanes w, char* dst,
+                  size_t stride) {
+  (void)stride;
+  float column[4] = {x, y, z, w};
+  std::memcpy(dst, column, sizeof(column));
+}
+#endif
+
+}  // namespace
+
+void TransformStore::Resize(uint32_t count) {
+  const uint32_t batch = TRANSFORM_ALIGNMENT / sizeof(float);
+  uint32_t capacity = (count + batch - 1) / batch * batch;
+
+  std::unique_ptr<float, AlignedDelete> data;
+  if (capacity > 0) {
+    size_t bytes = sizeof(float) * capacity * COMPONENT_COUNT;
+    data.reset(static_cast<float*>(
+        ::operator new(bytes, std::align_val_t{TRANSFORM_ALIGNMENT})));
+  }
+
+  // identities, also what pads the arrays
+  uint32_t kept = std::min(count_, count);
+  for (uint32_t component = 0; component < COMPONENT_COUNT; ++component) {
+    float* array = data.get() + capacity * component;
+    float identity = ROTATION_X + 3 == component || SCALE_X <= component
+                         ? 1.0f
+                         : 0.0f;
+    if (kept > 0) {
+      std::memcpy(array, Component(component), sizeof(float) * kept);
+    }
+    std::fill(array + kept, array + capacity, identity);
+  }
+
+  data_ = std::move(data);
+  count_ = count;
+  capacity_ = capacity;
+}
+
+uint32_t TransformStore::Size() const { return count_; }
+
+void TransformStore::Set(uint32_t index, const glm::vec3& position,
+                         const glm::quat& rotation, const glm::vec3& scale) {
+  Component(POSITION_X)[index] = position.x;
+  Component(POSITION_X + 1)[index] = position.y;
+  Component(POSITION_X + 2)[index] = position.z;
+  Component(ROTATION_X)[index] = rotation.x;
+  Component(ROTATION_X + 1)[index] = rotation.y;
+  Component(ROTATION_X + 2)[index] = rotation.z;
+  Component(ROTATION_X + 3)[index] = rotation.w;
+  Component(SCALE_X)[index] = scale.x;
+  Component(SCALE_X + 1)[index] = scale.y;
+  Component(SCALE_X + 2)[index] = scale.z;
+}
+
+void TransformStore::Rotate(uint32_t begin, uint32_t end,
+                            const glm::quat& delta) {
+  float* qx = Component(ROTATION_X);
+  float* qy = Component(ROTATION_X + 1);
+  float* qz = Component(ROTATION_X + 2);
+  float* qw = Component(ROTATION_X + 3);
+
+  Lanes dx = Splat(delta.x);
+  Lanes dy = Splat(delta.y);
+  Lanes dz = Splat(delta.z);
+  Lanes dw = Splat(delta.w);
+  Lanes one = Splat(1.0f);
+
+  uint32_t i = begin;
+  for (; i + LANES <= end; i += LANES) {
+    Lanes x = Load(qx + i);
+    Lanes y = Load(qy + i);
+    Lanes z = Load(qz + i);
+    Lanes w = Load(qw + i);
+
+    // q * delta
+    Lanes rx = Sub(Add(Add(Mul(w, dx), Mul(x, dw)), Mul(y, dz)), Mul(z, dy));
+    Lanes ry = Add(Add(Sub(Mul(w, dy), Mul(x, dz)), Mul(y, dw)), Mul(z, dx));
+    Lanes rz = Add(Sub(Add(Mul(w, dz), Mul(x, dy)), Mul(y, dx)), Mul(z, dw));
+    Lanes rw = Sub(Sub(Sub(Mul(w, dw), Mul(x, dx)), Mul(y, dy)), Mul(z, dz));
+
+    // keeps repeated small rotations from drifting off unit length
+    Lanes length = Sqrt(Add(Add(Mul(rx, rx), Mul(ry, ry)),
+                            Add(Mul(rz, rz), Mul(rw, rw))));
+    Lanes inverse = Div(one, length);
+    Store(qx + i, Mul(rx, inverse));
+    Store(qy + i, Mul(ry, inverse));
+    Store(qz + i, Mul(rz, inverse));
+    Store(qw + i, Mul(rw, inverse));
+  }
+
+  for (; i < end; ++i) {
+    glm::quat q = glm::normalize(glm::quat(qw[i], qx[i], qy[i], qz[i]) * delta);
+    qx[i] = q.x;
+    qy[i] = q.y;
+    qz[i] = q.z;
+    qw[i] = q.w;
+  }
+}
+
+void TransformStore::WriteModels(uint32_t begin, uint32_t end, void* dst,
+                                 size_t stride) const {
+  const float* px = Component(POSITION_X);
+  const float* py = Component(POSITION_X + 1);
+  const float* pz = Component(POSITION_X + 2);
+  const float* qx = Component(ROTATION_X);
+  const float* qy = Component(ROTATION_X + 1);
+  const float* qz = Component(ROTATION_X + 2);
+  const float* qw = Component(ROTATION_X + 3);
+  const float* sx = Component(SCALE_X);
+  const float* sy = Component(SCALE_X + 1);
+  const float* sz = Component(SCALE_X + 2);
+
+  Lanes zero = Splat(0.0f);
+  Lanes one = Splat(1.0f);
+  Lanes two = Splat(2.0f);
+  char* out = static_cast<char*>(dst);
+  const size_t column = 4 * sizeof(float);
+
+  uint32_t i = begin;
+  for (; i + LANES <= end; i += LANES, out += LANES * stride) {
+    Lanes x = Load(qx + i);
+    Lanes y = Load(qy + i);
+    Lanes z = Load(qz + i);
+    Lanes w = Load(qw + i);
+
+    // glm::mat3_cast() of a unit quaternion
+    Lanes x2 = Mul(two, x);
+    Lanes y2 = Mul(two, y);
+    Lanes z2 = Mul(two, z);
+    Lanes xx = Mul(x, x2);
+    Lanes yy = Mul(y, y2);
+    Lanes zz = Mul(z, z2);
+    Lanes xy = Mul(x, y2);
+    Lanes xz = Mul(x, z2);
+    Lanes yz = Mul(y, z2);
+    Lanes wx = Mul(w, x2);
+    Lanes wy = Mul(w, y2);
+    Lanes wz = Mul(w, z2);
+
+    // each rotation column times its axis' scale
+    Lanes scale_x = Load(sx + i);
+    Lanes scale_y = Load(sy + i);
+    Lanes scale_z = Load(sz + i);
+    StoreColumns(Mul(Sub(one, Add(yy, zz)), scale_x),
+                 Mul(Add(xy, wz), scale_x), Mul(Sub(xz, wy), scale_x), zero,
+                 out, stride);
+    StoreColumns(Mul(Sub(xy, wz), scale_y),
+                 Mul(Sub(one, Add(xx, zz)), scale_y),
+                 Mul(Add(yz, wx), scale_y), zero, out + column, stride);
+    StoreColumns(Mul(Add(xz, wy), scale_z), Mul(Sub(yz, wx), scale_z),
+                 Mul(Sub(one, Add(xx, yy)), scale_z), zero, out + 2 * column,
+                 stride);
+    StoreColumns(Load(px + i), Load(py + i), Load(pz + i), one,
+                 out + 3 * column, stride);
+  }
+
+  WriteModelsScalar(i, end, out, stride);
+}
+
+void TransformStore::WriteModelsScalar(uint32_t begin, uint32_t end,
+                                       void* dst, size_t stride) const {
+  char* out = static_cast<char*>(dst);
+  for (uint32_t i = begin; i < end; ++i, out += stride) {
+    glm::vec3 position(Component(POSITION_X)[i], Component(POSITION_X + 1)[i],
+                       Component(POSITION_X + 2)[i]);
+    glm::quat rotation(Component(ROTATION_X + 3)[i], Component(ROTATION_X)[i],
+                       Component(ROTATION_X + 1)[i],
+                       Component(ROTATION_X + 2)[i]);
+    glm::vec3 scale(Component(SCALE_X)[i], Component(SCALE_X + 1)[i],
+                    Component(SCALE_X + 2)[i]);
+
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position) *
+                      glm::mat4_cast(rotation) *
+                      glm::scale(glm::mat4(1.0f), scale);
+    std::memcpy(out, &model, sizeof(model));
+  }
+}
+
+const char* TransformStore::GetKernelName() { return KERNEL_NAME; }
+
+uint32_t TransformStore::GetKernelWidth() { return LANES; }
+
+void TransformStore::AlignedDelete::operator()(float* data) const {
+  ::operator delete(data, std::align_val_t{TRANSFORM_ALIGNMENT});
+}
+
+float* TransformStore::Component(uint32_t component) const {
+  return data_.get() + capacity_ * component;
+}
+
+}  // namespace playground
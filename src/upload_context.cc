@@ -0,0 +1,641 @@
+/**
+ * @file upload_context.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-06
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "upload_context.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include <vulkan/vulkan.h>
+
+namespace playground {
+
+void UploadContext::Init(VkDevice device, MemoryAllocator& allocator,
+                         GpuTimeline& timeline, std::mutex& queue_mutex,
+                         uint32_t graphics_family, VkQueue graphics_queue,
+                         uint32_t transfer_family, VkQueue transfer_queue,
+                         VkDeviceSize staging_size) {
+  device_ = device;
+  allocator_ = &allocator;
+  timeline_ = &timeline;
+  queue_mutex_ = &queue_mutex;
+  graphics_family_ = graphics_family;
+  graphics_queue_ = graphics_queue;
+  transfer_family_ = transfer_family;
+  transfer_queue_ = transfer_queue;
+
+  VkCommandPoolCreateInfo pool_info{};
+  pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pool_info.queueFamilyIndex = graphics_family_;
+
+  if (VK_SUCCESS !=
+      vkCreateCommandPool(device_, &pool_info, nullptr, &graphics_pool_)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create upload command pool -----");
+  }
+
+  if (HasDedicatedTransferQueue()) {
+    pool_info.queueFamilyIndex = transfer_family_;
+
+    if (VK_SUCCESS !=
+        vkCreateCommandPool(device_, &pool_info, nullptr, &transfer_pool_)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create transfer command pool -----");
+    }
+  }
+
+  staging_ring_.Init(device_, allocator, staging_size);
+}
+
+void UploadContext::Destroy() {
+  if (recording_) {
+    Submit();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pending_.empty()) {
+      timeline_->WaitForValue(pending_.back().timeline_value);
+    }
+  }
+  CollectCompleted();
+
+  for (auto semaphore : free_semaphores_) {
+    vkDestroySemaphore(device_, semaphore, nullptr);
+  }
+  free_semaphores_.clear();
+
+  staging_ring_.Destroy();
+
+  if (VK_NULL_HANDLE != transfer_pool_) {
+    vkDestroyCommandPool(device_, transfer_pool_, nullptr);
+    transfer_pool_ = VK_NULL_HANDLE;
+  }
+  vkDestroyCommandPool(device_, graphics_pool_, nullptr);
+  graphics_pool_ = VK_NULL_HANDLE;
+}
+
+bool UploadContext::HasDedicatedTransferQueue() const {
+  return transfer_family_ != graphics_family_;
+}
+
+const StagingRing& UploadContext::GetStagingRing() const {
+  return staging_ring_;
+}
+
+StagingAllocation UploadContext::Stage(const void* data, VkDeviceSize size,
+                                       VkDeviceSize alignment) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  StagingAllocation allocation{};
+
+  if (size > staging_ring_.Capacity()) {
+    // too large for the ring, use a one-off buffer freed with the batch
+    VkBufferCreateInfo buffer_info{};
+    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_info.size = size;
+    buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    if (VK_SUCCESS != vkCreateBuffer(device_, &buffer_info, nullptr, &buffer)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to create staging buffer -----");
+    }
+
+    VkMemoryRequirements mem_requirements{};
+    vkGetBufferMemoryRequirements(device_, buffer, &mem_requirements);
+    Allocation memory = allocator_->Allocate(
+        mem_requirements,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        true);
+    vkBindBufferMemory(device_, buffer, memory.memory, memory.offset);
+
+    allocation.buffer = buffer;
+    allocation.offset = 0;
+    allocation.size = size;
+    allocation.mapped = memory.mapped;
+
+    MemoryAllocator* allocator = allocator_;
+    VkDevice device = device_;
+    current_.callbacks.push_back([allocator, device, buffer, memory]() mutable {
+      vkDestroyBuffer(device, buffer, nullptr);
+      allocator->Free(memory);
+    });
+  } else {
+    while (!staging_ring_.TryAllocate(size, alignment, allocation)) {
+      // ring is full: wait for the oldest batch still holding ring space,
+      // flushing the open one first if nothing else is in flight
+      auto oldest = std::find_if(
+          pending_.begin(), pending_.end(),
+          [this](const Batch& batch) { return batch.id > ring_released_id_; });
+      if (oldest == pending_.end()) {
+        SubmitBatch();
+        BeginBatch();
+        continue;
+      }
+
+      timeline_->WaitForValue(oldest->timeline_value);
+      staging_ring_.Release(oldest->id);
+      ring_released_id_ = oldest->id;
+    }
+  }
+
+  if (data) {
+    memcpy(allocation.mapped, data, static_cast<size_t>(size));
+  }
+
+  return allocation;
+}
+
+void UploadContext::UploadBuffer(const void* data, VkDeviceSize size,
+                                 VkBuffer dst_buffer, VkDeviceSize dst_offset,
+                                 VkPipelineStageFlags dst_stage,
+                                 VkAccessFlags dst_access) {
+  StagingAllocation staging = Stage(data, size);
+
+  VkBufferCopy region{};
+  region.srcOffset = staging.offset;
+  region.dstOffset = dst_offset;
+  region.size = size;
+
+  CopyBuffer(staging.buffer, dst_buffer, region, dst_stage, dst_access);
+}
+
+void UploadContext::CopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer,
+                               const VkBufferCopy& region,
+                               VkPipelineStageFlags dst_stage,
+                               VkAccessFlags dst_access) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  RecordCopyBuffer(src_buffer, dst_buffer, region, dst_stage, dst_access);
+}
+
+void UploadContext::RecordCopyBuffer(VkBuffer src_buffer, VkBuffer dst_buffer,
+                                     const VkBufferCopy& region,
+                                     VkPipelineStageFlags dst_stage,
+                                     VkAccessFlags dst_access) {
+  VkCommandBuffer command_buffer = HasDedicatedTransferQueue()
+                                       ? current_.transfer_command_buffer
+                                       : current_.graphics_command_buffer;
+  vkCmdCopyBuffer(command_buffer, src_buffer, dst_buffer, 1, &region);
+
+  VkBufferMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = dst_access;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.buffer = dst_buffer;
+  barrier.offset = region.dstOffset;
+  barrier.size = region.size;
+
+  if (HasDedicatedTransferQueue()) {
+    // queue family ownership transfer: release, then acquire
+    barrier.srcQueueFamilyIndex = transfer_family_;
+    barrier.dstQueueFamilyIndex = graphics_family_;
+
+    VkBufferMemoryBarrier release = barrier;
+    release.dstAccessMask = 0;
+    buffer_releases_.push_back(release);
+
+    VkBufferMemoryBarrier acquire = barrier;
+    acquire.srcAccessMask = 0;
+    buffer_acquires_.push_back(acquire);
+  } else {
+    buffer_acquires_.push_back(barrier);
+  }
+
+  acquire_dst_stages_ |= dst_stage;
+}
+
+void UploadContext::TransitionImageLayout(
+    VkImage image, VkImageLayout old_layout, VkImageLayout new_layout,
+    const VkImageSubresourceRange& range) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = range;
+
+  if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
+      new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    VkCommandBuffer command_buffer = HasDedicatedTransferQueue()
+                                         ? current_.transfer_command_buffer
+                                         : current_.graphics_command_buffer;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+  } else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+             new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    if (HasDedicatedTransferQueue()) {
+      barrier.srcQueueFamilyIndex = transfer_family_;
+      barrier.dstQueueFamilyIndex = graphics_family_;
+
+      VkImageMemoryBarrier release = barrier;
+      release.dstAccessMask = 0;
+      image_releases_.push_back(release);
+
+      VkImageMemoryBarrier acquire = barrier;
+      acquire.srcAccessMask = 0;
+      image_acquires_.push_back(acquire);
+    } else {
+      image_acquires_.push_back(barrier);
+    }
+
+    acquire_dst_stages_ |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+  } else {
+    throw std::invalid_argument("unsupported layout transition!");
+  }
+}
+
+void UploadContext::CopyBufferToImage(
+    VkBuffer buffer, VkImage image,
+    const std::vector<VkBufferImageCopy>& regions) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  VkCommandBuffer command_buffer = HasDedicatedTransferQueue()
+                                       ? current_.transfer_command_buffer
+                                       : current_.graphics_command_buffer;
+  vkCmdCopyBufferToImage(command_buffer, buffer, image,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<uint32_t>(regions.size()),
+                         regions.data());
+}
+
+void UploadContext::GenerateMipmaps(VkImage image, uint32_t width,
+                                    uint32_t height, uint32_t mip_levels) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  // level 0 is read and the others written by the blits, which need a
+  // graphics queue: hand the whole image over without changing its layout
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask =
+      VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.baseMipLevel = 0;
+  barrier.subresourceRange.levelCount = mip_levels;
+  barrier.subresourceRange.baseArrayLayer = 0;
+  barrier.subresourceRange.layerCount = 1;
+
+  if (HasDedicatedTransferQueue()) {
+    barrier.srcQueueFamilyIndex = transfer_family_;
+    barrier.dstQueueFamilyIndex = graphics_family_;
+
+    VkImageMemoryBarrier release = barrier;
+    release.dstAccessMask = 0;
+    image_releases_.push_back(release);
+
+    VkImageMemoryBarrier acquire = barrier;
+    acquire.srcAccessMask = 0;
+    image_acquires_.push_back(acquire);
+  } else {
+    image_acquires_.push_back(barrier);
+  }
+
+  acquire_dst_stages_ |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+  mip_chains_.push_back({image, width, height, mip_levels});
+}
+
+void UploadContext::OnComplete(std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  BeginBatch();
+
+  current_.callbacks.push_back(std::move(callback));
+}
+
+uint64_t UploadContext::Submit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return SubmitBatch();
+}
+
+uint64_t UploadContext::SubmitBatch() {
+  if (!recording_) {
+    return next_batch_id_ - 1;
+  }
+
+  FlushHandoffBarriers();
+
+  std::lock_guard<std::mutex> queue_lock(*queue_mutex_);
+
+  if (HasDedicatedTransferQueue()) {
+    vkEndCommandBuffer(current_.transfer_command_buffer);
+    vkEndCommandBuffer(current_.graphics_command_buffer);
+
+    current_.semaphore = AcquireSemaphore();
+
+    VkSubmitInfo transfer_submit_info{};
+    transfer_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transfer_submit_info.commandBufferCount = 1;
+    transfer_submit_info.pCommandBuffers = &current_.transfer_command_buffer;
+    transfer_submit_info.signalSemaphoreCount = 1;
+    transfer_submit_info.pSignalSemaphores = &current_.semaphore;
+
+    if (VK_SUCCESS != vkQueueSubmit(transfer_queue_, 1, &transfer_submit_info,
+                                    VK_NULL_HANDLE)) {
+      throw std::runtime_error(
+          "----- Error::Vulkan: Failed to submit transfer command buffer "
+          "-----");
+    }
+
+    // graphics queue takes ownership once the copies are done
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo graphics_submit_info{};
+    graphics_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    graphics_submit_info.waitSemaphoreCount = 1;
+    graphics_submit_info.pWaitSemaphores = &current_.semaphore;
+    graphics_submit_info.pWaitDstStageMask = &wait_stage;
+    graphics_submit_info.commandBufferCount = 1;
+    graphics_submit_info.pCommandBuffers = &current_.graphics_command_buffer;
+
+    current_.timeline_value =
+        timeline_->Submit(graphics_queue_, graphics_submit_info);
+  } else {
+    vkEndCommandBuffer(current_.graphics_command_buffer);
+
+    VkSubmitInfo submit_info{};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &current_.graphics_command_buffer;
+
+    current_.timeline_value = timeline_->Submit(graphics_queue_, submit_info);
+  }
+
+  uint64_t id = current_.id;
+  staging_ring_.Retire(id);
+  pending_.push_back(std::move(current_));
+  current_ = Batch{};
+  recording_ = false;
+
+  return id;
+}
+
+bool UploadContext::IsComplete(uint64_t batch_id) {
+  CollectCompleted();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return batch_id <= completed_batch_id_;
+}
+
+void UploadContext::Wait(uint64_t batch_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // the newest batch up to `batch_id` covers every older one
+    uint64_t value = 0;
+    for (const auto& batch : pending_) {
+      if (batch.id <= batch_id) {
+        value = batch.timeline_value;
+      }
+    }
+    timeline_->WaitForValue(value);
+  }
+
+  CollectCompleted();
+}
+
+void UploadContext::CollectCompleted() {
+  std::vector<Batch> finished{};
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // every batch ends on the graphics queue, so they retire in order
+    while (!pending_.empty() &&
+           timeline_->IsComplete(pending_.front().timeline_value)) {
+      completed_batch_id_ = pending_.front().id;
+      finished.push_back(std::move(pending_.front()));
+      pending_.pop_front();
+    }
+  }
+
+  for (auto& batch : finished) {
+    for (auto& callback : batch.callbacks) {
+      callback();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& batch : finished) {
+    staging_ring_.Release(batch.id);
+    ring_released_id_ = std::max(ring_released_id_, batch.id);
+    ReleaseBatch(batch);
+  }
+}
+
+void UploadContext::BeginBatch() {
+  if (recording_) {
+    return;
+  }
+
+  current_.id = next_batch_id_++;
+
+  VkCommandBufferBeginInfo begin_info{};
+  begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  current_.graphics_command_buffer = AllocateCommandBuffer(graphics_pool_);
+  vkBeginCommandBuffer(current_.graphics_command_buffer, &begin_info);
+
+  if (HasDedicatedTransferQueue()) {
+    current_.transfer_command_buffer = AllocateCommandBuffer(transfer_pool_);
+    vkBeginCommandBuffer(current_.transfer_command_buffer, &begin_info);
+  }
+
+  recording_ = true;
+}
+
+VkCommandBuffer UploadContext::AllocateCommandBuffer(VkCommandPool pool) {
+  VkCommandBufferAllocateInfo alloc_info{};
+  alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  alloc_info.commandPool = pool;
+  alloc_info.commandBufferCount = 1;
+
+  VkCommandBuffer command_buffer;
+  if (VK_SUCCESS !=
+      vkAllocateCommandBuffers(device_, &alloc_info, &command_buffer)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to allocate upload command buffer -----");
+  }
+
+  return command_buffer;
+}
+
+VkSemaphore UploadContext::AcquireSemaphore() {
+  if (!free_semaphores_.empty()) {
+    VkSemaphore semaphore = free_semaphores_.back();
+    free_semaphores_.pop_back();
+    return semaphore;
+  }
+
+  VkSemaphoreCreateInfo semaphore_info{};
+  semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+  VkSemaphore semaphore;
+  if (VK_SUCCESS !=
+      vkCreateSemaphore(device_, &semaphore_info, nullptr, &semaphore)) {
+    throw std::runtime_error(
+        "----- Error::Vulkan: Failed to create upload semaphore -----");
+  }
+
+  return semaphore;
+}
+
+void UploadContext::ReleaseBatch(Batch& batch) {
+  vkFreeCommandBuffers(device_, graphics_pool_, 1,
+                       &batch.graphics_command_buffer);
+  if (VK_NULL_HANDLE != batch.transfer_command_buffer) {
+    vkFreeCommandBuffers(device_, transfer_pool_, 1,
+                         &batch.transfer_command_buffer);
+  }
+
+  if (VK_NULL_HANDLE != batch.semaphore) {
+    free_semaphores_.push_back(batch.semaphore);
+  }
+
+  batch = Batch{};
+}
+
+void UploadContext::FlushHandoffBarriers() {
+  if (HasDedicatedTransferQueue() &&
+      (!buffer_releases_.empty() || !image_releases_.empty())) {
+    vkCmdPipelineBarrier(current_.transfer_command_buffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         static_cast<uint32_t>(buffer_releases_.size()),
+                         buffer_releases_.data(),
+                         static_cast<uint32_t>(image_releases_.size()),
+                         image_releases_.data());
+  }
+
+  if (!buffer_acquires_.empty() || !image_acquires_.empty()) {
+    VkPipelineStageFlags src_stage = HasDedicatedTransferQueue()
+                                         ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                         : VK_PIPELINE_STAGE_TRANSFER_BIT;
+    vkCmdPipelineBarrier(current_.graphics_command_buffer, src_stage,
+                         acquire_dst_stages_, 0, 0, nullptr,
+                         static_cast<uint32_t>(buffer_acquires_.size()),
+                         buffer_acquires_.data(),
+                         static_cast<uint32_t>(image_acquires_.size()),
+                         image_acquires_.data());
+  }
+
+  RecordMipChains();
+
+  buffer_releases_.clear();
+  buffer_acquires_.clear();
+  image_releases_.clear();
+  image_acquires_.clear();
+  acquire_dst_stages_ = 0;
+  mip_chains_.clear();
+}
+
+void UploadContext::RecordMipChains() {
+  VkCommandBuffer command_buffer = current_.graphics_command_buffer;
+
+  for (const auto& chain : mip_chains_) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = chain.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    int32_t mip_width = static_cast<int32_t>(chain.width);
+    int32_t mip_height = static_cast<int32_t>(chain.height);
+
+    for (uint32_t level = 1; level < chain.mip_levels; ++level) {
+      // the previous level becomes the blit source
+      barrier.subresourceRange.baseMipLevel = level - 1;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                           nullptr, 1, &barrier);
+
+      int32_t next_width = std::max(mip_width / 2, 1);
+      int32_t next_height = std::max(mip_height / 2, 1);
+
+      VkImageBlit blit{};
+      blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      blit.srcSubresource.mipLevel = level - 1;
+      blit.srcSubresource.baseArrayLayer = 0;
+      blit.srcSubresource.layerCount = 1;
+      blit.srcOffsets[0] = {0, 0, 0};
+      blit.srcOffsets[1] = {mip_width, mip_height, 1};
+      blit.dstSubresource = blit.srcSubresource;
+      blit.dstSubresource.mipLevel = level;
+      blit.dstOffsets[0] = {0, 0, 0};
+      blit.dstOffsets[1] = {next_width, next_height, 1};
+
+      vkCmdBlitImage(command_buffer, chain.image,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, chain.image,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                     VK_FILTER_LINEAR);
+
+      // done as a source, ready for sampling
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+                           nullptr, 0, nullptr, 1, &barrier);
+
+      mip_width = next_width;
+      mip_height = next_height;
+    }
+
+    // the smallest level is only ever written
+    barrier.subresourceRange.baseMipLevel = chain.mip_levels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+  }
+}
+
+}  // namespace playground
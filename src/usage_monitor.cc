@@ -0,0 +1,113 @@
+/**
+ * @file usage_monitor.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief
+ * @version 1.0
+ * @date 2023-03-31
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include "usage_monitor.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <sys/time.h>
+#endif
+
+namespace playground {
+
+namespace {
+
+const double WINDOW_SECONDS = 1.0;
+
+}  // namespace
+
+void UsageMonitor::Start() {
+  run_ = Window{};
+  run_.start = std::chrono::steady_clock::now();
+  run_.cpu_start = GetProcessCpuTime();
+  window_ = run_;
+  recent_ = Usage{};
+}
+
+void UsageMonitor::AddFrame(double gpu_ms) {
+  ++run_.frames;
+  ++window_.frames;
+  run_.gpu_ms += gpu_ms;
+  window_.gpu_ms += gpu_ms;
+}
+
+void UsageMonitor::AddWait(double ms) {
+  run_.wait_ms += ms;
+  window_.wait_ms += ms;
+}
+
+void UsageMonitor::Update() {
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - window_.start).count() <
+      WINDOW_SECONDS) {
+    return;
+  }
+
+  recent_ = Measure(window_);
+  window_ = Window{};
+  window_.start = now;
+  window_.cpu_start = GetProcessCpuTime();
+}
+
+const Usage& UsageMonitor::GetRecent() const { return recent_; }
+
+Usage UsageMonitor::GetTotal() const { return Measure(run_); }
+
+double UsageMonitor::GetProcessCpuTime() {
+#ifdef _WIN32
+  FILETIME creation_time{}, exit_time{}, kernel_time{}, user_time{};
+  if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time,
+                       &kernel_time, &user_time)) {
+    return 0.0;
+  }
+  // 100 ns ticks
+  auto seconds = [](const FILETIME& time) {
+    ULARGE_INTEGER ticks{};
+    ticks.LowPart = time.dwLowDateTime;
+    ticks.HighPart = time.dwHighDateTime;
+    return static_cast<double>(ticks.QuadPart) * 1e-7;
+  };
+  return seconds(kernel_time) + seconds(user_time);
+#else
+  rusage usage{};
+  if (0 != getrusage(RUSAGE_SELF, &usage)) {
+    return 0.0;
+  }
+  auto seconds = [](const timeval& time) {
+    return static_cast<double>(time.tv_sec) +
+           static_cast<double>(time.tv_usec) * 1e-6;
+  };
+  return seconds(usage.ru_utime) + seconds(usage.ru_stime);
+#endif
+}
+
+Usage UsageMonitor::Measure(const Window& window) {
+  Usage usage{};
+  usage.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - window.start)
+                      .count();
+  if (usage.seconds <= 0.0) {
+    return usage;
+  }
+
+  double ms = usage.seconds * 1000.0;
+  usage.frame_rate = window.frames / usage.seconds;
+  usage.cpu_percent =
+      (GetProcessCpuTime() - window.cpu_start) / usage.seconds * 100.0;
+  usage.gpu_percent = window.gpu_ms / ms * 100.0;
+  usage.waiting_percent = window.wait_ms / ms * 100.0;
+  return usage;
+}
+
+}  // namespace playground
@@ -0,0 +1,101 @@
+/**
+ * @file ring_space_test.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Allocation, wrap and reclaim cases of RingSpace, run by ctest
+ * @version 1.0
+ * @date 2023-03-08
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <cstdint>
+#include <iostream>
+
+#include "ring_space.h"
+
+namespace {
+
+int failures = 0;
+
+void Check(bool condition, const char* what) {
+  if (!condition) {
+    std::cerr << "----- Error::Test: " << what << " -----" << std::endl;
+    ++failures;
+  }
+}
+
+void TestAlignment() {
+  playground::RingSpace space{};
+  space.Reset(1024);
+
+  uint64_t offset = 0;
+  Check(space.TryAllocate(10, 1, offset) && 0 == offset, "first at 0");
+  Check(space.TryAllocate(16, 16, offset) && 16 == offset, "aligned to 16");
+  Check(26 + 6 == space.Used(), "padding counts as used");
+}
+
+void TestFullUntilReleased() {
+  playground::RingSpace space{};
+  space.Reset(1024);
+
+  uint64_t offset = 0;
+  Check(space.TryAllocate(768, 1, offset), "three quarters fit");
+  space.Retire(1);
+  Check(!space.TryAllocate(512, 1, offset), "held space is not reused");
+
+  space.Release(1);
+  Check(space.TryAllocate(512, 1, offset) && 0 == offset,
+        "released space is reused");
+}
+
+void TestWrap() {
+  playground::RingSpace space{};
+  space.Reset(1024);
+
+  uint64_t offset = 0;
+  space.TryAllocate(256, 1, offset);
+  space.Retire(1);
+  space.TryAllocate(512, 1, offset);
+  space.Retire(2);
+  space.Release(1);
+
+  // 256 free at the end and 256 at the beginning, never straddled
+  Check(!space.TryAllocate(384, 1, offset), "no straddling the end");
+  Check(space.TryAllocate(256, 1, offset) && 768 == offset, "end fits");
+  Check(space.TryAllocate(256, 1, offset) && 0 == offset, "wraps to 0");
+}
+
+void TestEmptyWithHeadMidRing() {
+  playground::RingSpace space{};
+  space.Reset(1024);
+
+  // e.g. the vertex and index buffers, staged and retired first
+  uint64_t offset = 0;
+  space.TryAllocate(300, 1, offset);
+  space.Retire(1);
+  space.Release(1);
+  Check(0 == space.Used(), "empty after release");
+
+  // larger than what is left past the head, at most the capacity
+  Check(space.TryAllocate(1024, 4, offset) && 0 == offset,
+        "an empty ring fits its capacity");
+  space.Retire(2);
+  space.Release(2);
+  Check(space.TryAllocate(800, 4, offset) && 0 == offset,
+        "an empty ring starts over at 0");
+}
+
+}  // namespace
+
+int main() {
+  TestAlignment();
+  TestFullUntilReleased();
+  TestWrap();
+  TestEmptyWithHeadMidRing();
+
+  if (0 != failures) {
+    return 1;
+  }
+  std::cout << "----- Test: RingSpace passed -----" << std::endl;
+  return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/sh
+# Runs a bisect step with SPIR-V matching the checked out revision.
+# Revisions before the build compiled shaders (CMakeLists.txt without
+# PLAYGROUND_SHADER_DIR) load shaders/*.spv from the source tree, and
+# those files were not regenerated with every GLSL change; this compiles
+# them in place, runs the step and puts the tracked ones back, so the
+# next checkout is clean. Copy it out of the tree first, older revisions
+# do not have it:
+#   cp tools/bisect_shaders.sh /tmp/
+#   git bisect run /tmp/bisect_shaders.sh <build and test command>
+# Uses $GLSLC, else the Vulkan SDK's glslc, else the one on PATH.
+if [ -z "$GLSLC" ]; then
+  if [ -n "$VULKAN_SDK" ] && [ -x "$VULKAN_SDK/bin/glslc" ]; then
+    GLSLC="$VULKAN_SDK/bin/glslc"
+  else
+    GLSLC=glslc
+  fi
+fi
+
+ROOT="$(git rev-parse --show-toplevel)" || exit 128
+cd "$ROOT" || exit 128
+
+COMPILED=0
+if ! grep -q PLAYGROUND_SHADER_DIR CMakeLists.txt; then
+  for shader in shaders/*.vert shaders/*.frag shaders/*.comp; do
+    [ -e "$shader" ] || continue
+    # 125 tells git bisect to skip a revision it cannot judge
+    "$GLSLC" "$shader" -o "$shader.spv" || exit 125
+  done
+  COMPILED=1
+fi
+
+"$@"
+STATUS=$?
+
+if [ "$COMPILED" = 1 ]; then
+  git checkout -q -- shaders/
+  git clean -fqx -- 'shaders/*.spv'
+fi
+
+exit "$STATUS"
@@ -0,0 +1,463 @@
+/**
+ * @file meshconv.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Offline converter from Wavefront OBJ to the .pgmesh binary format
+ * @version 1.0
+ * @date 2023-03-20
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "mesh_format.h"
+
+namespace {
+
+using playground::Meshlet;
+using playground::MeshLod;
+using playground::MeshVertex;
+
+// limits commonly used by mesh shading hardware
+const uint32_t MESHLET_MAX_VERTICES = 64;
+const uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// grid cells per axis of LOD 1, halved for every further LOD
+const uint32_t LOD_BASE_GRID = 64;
+
+struct Options {
+  std::string input_path;
+  std::string output_path;
+  uint32_t lod_count = 3;
+  bool normalize = true;
+};
+
+struct Mesh {
+  std::vector<MeshVertex> vertices;
+  // LOD 0 triangles
+  std::vector<uint32_t> indices;
+};
+
+void PrintUsage() {
+  std::clog << "Usage: meshconv [options] input.obj output.pgmesh\n"
+            << "  --lods=N        levels of detail to generate (3)\n"
+            << "  --no-normalize  keep the original position and scale,\n"
+            << "                  otherwise the mesh is centered and fit\n"
+            << "                  into a sphere of radius 0.5" << std::endl;
+}
+
+Options ParseOptions(int argc, char* argv[]) {
+  Options options{};
+  std::vector<std::string> paths{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (0 == argument.compare(0, 7, "--lods=")) {
+      options.lod_count = static_cast<uint32_t>(
+          std::max(1, std::atoi(argument.c_str() + 7)));
+    } else if ("--no-normalize" == argument) {
+      options.normalize = false;
+    } else if (0 == argument.compare(0, 2, "--")) {
+      throw std::runtime_error("unknown option " + argument);
+    } else {
+      paths.push_back(argument);
+    }
+  }
+
+  if (2 != paths.size()) {
+    throw std::runtime_error("expected an input and an output path");
+  }
+  options.input_path = paths[0];
+  options.output_path = paths[1];
+
+  return options;
+}
+
+// OBJ indices are 1-based, negative ones count back from the end
+int ResolveIndex(int index, size_t count) {
+  return index < 0 ? static_cast<int>(count) + index : index - 1;
+}
+
+Mesh LoadObj(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open " + path);
+  }
+
+  std::vector<std::array<float, 3>> positions{};
+  std::vector<std::array<float, 3>> colors{};
+  std::vector<std::array<float, 3>> normals{};
+  bool has_colors = false;
+
+  Mesh mesh{};
+  // (position, normal) pairs already emitted as a vertex
+  std::map<std::pair<int, int>, uint32_t> vertex_lookup{};
+
+  std::string line{};
+  while (std::getline(file, line)) {
+    std::istringstream stream(line);
+    std::string keyword{};
+    stream >> keyword;
+
+    if ("v" == keyword) {
+      std::array<float, 3> position{};
+      std::array<float, 3> color{1.0f, 1.0f, 1.0f};
+      stream >> position[0] >> position[1] >> position[2];
+      // common extension: "v x y z r g b"
+      if (stream >> color[0] >> color[1] >> color[2]) {
+        has_colors = true;
+      }
+      positions.push_back(position);
+      colors.push_back(color);
+    } else if ("vn" == keyword) {
+      std::array<float, 3> normal{};
+      stream >> normal[0] >> normal[1] >> normal[2];
+      normals.push_back(normal);
+    } else if ("f" == keyword) {
+      std::vector<uint32_t> face{};
+      std::string corner{};
+
+      while (stream >> corner) {
+        // v, v/vt, v//vn or v/vt/vn
+        int position_index = std::atoi(corner.c_str());
+        int normal_index = 0;
+        size_t first_slash = corner.find('/');
+        if (std::string::npos != first_slash) {
+          size_t second_slash = corner.find('/', first_slash + 1);
+          if (std::string::npos != second_slash) {
+            normal_index = std::atoi(corner.c_str() + second_slash + 1);
+          }
+        }
+
+        int position = ResolveIndex(position_index, positions.size());
+        int normal =
+            0 == normal_index ? -1 : ResolveIndex(normal_index, normals.size());
+        if (position < 0 || position >= static_cast<int>(positions.size()) ||
+            normal >= static_cast<int>(normals.size())) {
+          throw std::runtime_error("face index out of range in " + line);
+        }
+
+        auto key = std::make_pair(position, normal);
+        auto found = vertex_lookup.find(key);
+        if (vertex_lookup.end() == found) {
+          MeshVertex vertex{};
+          memcpy(vertex.position, positions[position].data(),
+                 sizeof(vertex.position));
+
+          // vertex colors if present, else normals visualized as colors
+          if (has_colors || normal < 0) {
+            memcpy(vertex.color, colors[position].data(), sizeof(vertex.color));
+          } else {
+            for (int i = 0; i < 3; ++i) {
+              vertex.color[i] = normals[normal][i] * 0.5f + 0.5f;
+            }
+          }
+
+          found = vertex_lookup
+                      .emplace(key, static_cast<uint32_t>(mesh.vertices.size()))
+                      .first;
+          mesh.vertices.push_back(vertex);
+        }
+        face.push_back(found->second);
+      }
+
+      // triangle fan for quads and polygons
+      for (size_t i = 2; i < face.size(); ++i) {
+        mesh.indices.push_back(face[0]);
+        mesh.indices.push_back(face[i - 1]);
+        mesh.indices.push_back(face[i]);
+      }
+    }
+  }
+
+  if (mesh.indices.empty()) {
+    throw std::runtime_error(path + " has no faces");
+  }
+
+  return mesh;
+}
+
+void Normalize(Mesh& mesh) {
+  std::array<float, 3> min_corner{mesh.vertices[0].position[0],
+                                  mesh.vertices[0].position[1],
+                                  mesh.vertices[0].position[2]};
+  std::array<float, 3> max_corner = min_corner;
+  for (const auto& vertex : mesh.vertices) {
+    for (int i = 0; i < 3; ++i) {
+      min_corner[i] = std::min(min_corner[i], vertex.position[i]);
+      max_corner[i] = std::max(max_corner[i], vertex.position[i]);
+    }
+  }
+
+  std::array<float, 3> center{};
+  for (int i = 0; i < 3; ++i) {
+    center[i] = (min_corner[i] + max_corner[i]) * 0.5f;
+  }
+
+  float radius = 0.0f;
+  for (auto& vertex : mesh.vertices) {
+    float length_squared = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+      vertex.position[i] -= center[i];
+      length_squared += vertex.position[i] * vertex.position[i];
+    }
+    radius = std::max(radius, std::sqrt(length_squared));
+  }
+
+  float scale = radius > 0.0f ? 0.5f / radius : 1.0f;
+  for (auto& vertex : mesh.vertices) {
+    for (int i = 0; i < 3; ++i) {
+      vertex.position[i] *= scale;
+    }
+  }
+}
+
+float BoundingRadius(const std::vector<MeshVertex>& vertices) {
+  float radius = 0.0f;
+  for (const auto& vertex : vertices) {
+    float length_squared = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+      length_squared += vertex.position[i] * vertex.position[i];
+    }
+    radius = std::max(radius, std::sqrt(length_squared));
+  }
+
+  return radius;
+}
+
+// vertex clustering: every vertex snaps to the first vertex of its grid cell,
+// triangles that collapse are dropped; indices still refer to LOD 0 vertices
+std::vector<uint32_t> SimplifyByClustering(const Mesh& mesh, uint32_t grid) {
+  std::array<float, 3> min_corner{mesh.vertices[0].position[0],
+                                  mesh.vertices[0].position[1],
+                                  mesh.vertices[0].position[2]};
+  std::array<float, 3> extent{};
+  {
+    std::array<float, 3> max_corner = min_corner;
+    for (const auto& vertex : mesh.vertices) {
+      for (int i = 0; i < 3; ++i) {
+        min_corner[i] = std::min(min_corner[i], vertex.position[i]);
+        max_corner[i] = std::max(max_corner[i], vertex.position[i]);
+      }
+    }
+    for (int i = 0; i < 3; ++i) {
+      extent[i] = std::max(max_corner[i] - min_corner[i], 1e-6f);
+    }
+  }
+
+  std::unordered_map<uint64_t, uint32_t> cells{};
+  std::vector<uint32_t> remap(mesh.vertices.size());
+  for (uint32_t v = 0; v < mesh.vertices.size(); ++v) {
+    uint64_t cell = 0;
+    for (int i = 0; i < 3; ++i) {
+      float t = (mesh.vertices[v].position[i] - min_corner[i]) / extent[i];
+      uint64_t coordinate = std::min<uint64_t>(
+          grid - 1, static_cast<uint64_t>(t * static_cast<float>(grid)));
+      cell = cell * grid + coordinate;
+    }
+    remap[v] = cells.emplace(cell, v).first->second;
+  }
+
+  std::vector<uint32_t> indices{};
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    uint32_t a = remap[mesh.indices[i]];
+    uint32_t b = remap[mesh.indices[i + 1]];
+    uint32_t c = remap[mesh.indices[i + 2]];
+    if (a != b && b != c && a != c) {
+      indices.insert(indices.end(), {a, b, c});
+    }
+  }
+
+  return indices;
+}
+
+// greedy split of a triangle list into meshlets, in index order
+void BuildMeshlets(const std::vector<MeshVertex>& vertices,
+                   const std::vector<uint32_t>& indices, uint32_t first_index,
+                   std::vector<Meshlet>& meshlets) {
+  std::unordered_set<uint32_t> meshlet_vertices{};
+  Meshlet meshlet{};
+  meshlet.first_index = first_index;
+
+  auto finish = [&]() {
+    if (0 == meshlet.index_count) {
+      return;
+    }
+
+    std::array<float, 3> min_corner{1e30f, 1e30f, 1e30f};
+    std::array<float, 3> max_corner{-1e30f, -1e30f, -1e30f};
+    for (uint32_t v : meshlet_vertices) {
+      for (int i = 0; i < 3; ++i) {
+        min_corner[i] = std::min(min_corner[i], vertices[v].position[i]);
+        max_corner[i] = std::max(max_corner[i], vertices[v].position[i]);
+      }
+    }
+    for (int i = 0; i < 3; ++i) {
+      meshlet.center[i] = (min_corner[i] + max_corner[i]) * 0.5f;
+    }
+
+    meshlet.radius = 0.0f;
+    for (uint32_t v : meshlet_vertices) {
+      float length_squared = 0.0f;
+      for (int i = 0; i < 3; ++i) {
+        float d = vertices[v].position[i] - meshlet.center[i];
+        length_squared += d * d;
+      }
+      meshlet.radius = std::max(meshlet.radius, std::sqrt(length_squared));
+    }
+
+    meshlets.push_back(meshlet);
+    meshlet.first_index += meshlet.index_count;
+    meshlet.index_count = 0;
+    meshlet_vertices.clear();
+  };
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+    uint32_t new_vertices = 0;
+    for (size_t j = i; j < i + 3; ++j) {
+      new_vertices += meshlet_vertices.count(indices[j]) ? 0 : 1;
+    }
+
+    if (meshlet_vertices.size() + new_vertices > MESHLET_MAX_VERTICES ||
+        meshlet.index_count / 3 + 1 > MESHLET_MAX_TRIANGLES) {
+      finish();
+    }
+
+    meshlet_vertices.insert(indices.begin() + i, indices.begin() + i + 3);
+    meshlet.index_count += 3;
+  }
+  finish();
+}
+
+uint64_t Align(uint64_t offset) {
+  return (offset + playground::MESH_FILE_ALIGNMENT - 1) /
+         playground::MESH_FILE_ALIGNMENT * playground::MESH_FILE_ALIGNMENT;
+}
+
+void WriteSection(std::ofstream& file, uint64_t offset, const void* data,
+                  size_t size) {
+  // zero padding up to the aligned section start
+  static const char padding[playground::MESH_FILE_ALIGNMENT] = {};
+  uint64_t position = static_cast<uint64_t>(file.tellp());
+  file.write(padding, static_cast<std::streamsize>(offset - position));
+  file.write(static_cast<const char*>(data),
+             static_cast<std::streamsize>(size));
+}
+
+void WriteMesh(const std::string& path, const Mesh& mesh,
+               const std::vector<uint32_t>& indices,
+               const std::vector<MeshLod>& lods,
+               const std::vector<Meshlet>& meshlets) {
+  playground::MeshFileHeader header{};
+  header.magic = playground::MESH_FILE_MAGIC;
+  header.version = playground::MESH_FILE_VERSION;
+  header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+  header.vertex_stride = sizeof(MeshVertex);
+  header.index_count = static_cast<uint32_t>(indices.size());
+  // 0xffff stays free, it is the primitive restart value
+  header.index_size = mesh.vertices.size() < 0xffff ? 2 : 4;
+  header.lod_count = static_cast<uint32_t>(lods.size());
+  header.meshlet_count = static_cast<uint32_t>(meshlets.size());
+  header.bounding_radius = BoundingRadius(mesh.vertices);
+
+  size_t vertex_size = mesh.vertices.size() * sizeof(MeshVertex);
+  size_t index_size = indices.size() * header.index_size;
+  size_t lod_size = lods.size() * sizeof(MeshLod);
+
+  header.vertex_offset = Align(sizeof(header));
+  header.index_offset = Align(header.vertex_offset + vertex_size);
+  header.lod_offset = Align(header.index_offset + index_size);
+  header.meshlet_offset = Align(header.lod_offset + lod_size);
+
+  std::vector<uint16_t> short_indices{};
+  const void* index_data = indices.data();
+  if (2 == header.index_size) {
+    short_indices.assign(indices.begin(), indices.end());
+    index_data = short_indices.data();
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    throw std::runtime_error("failed to open " + path);
+  }
+
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  WriteSection(file, header.vertex_offset, mesh.vertices.data(), vertex_size);
+  WriteSection(file, header.index_offset, index_data, index_size);
+  WriteSection(file, header.lod_offset, lods.data(), lod_size);
+  WriteSection(file, header.meshlet_offset, meshlets.data(),
+               meshlets.size() * sizeof(Meshlet));
+
+  if (!file) {
+    throw std::runtime_error("failed to write " + path);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  try {
+    Options options = ParseOptions(argc, argv);
+
+    Mesh mesh = LoadObj(options.input_path);
+    if (options.normalize) {
+      Normalize(mesh);
+    }
+
+    // every LOD is appended to one shared index section
+    std::vector<uint32_t> indices{};
+    std::vector<MeshLod> lods{};
+    std::vector<Meshlet> meshlets{};
+
+    for (uint32_t lod = 0; lod < options.lod_count; ++lod) {
+      std::vector<uint32_t> lod_indices =
+          0 == lod ? mesh.indices
+                   : SimplifyByClustering(
+                         mesh, std::max(2u, LOD_BASE_GRID >> (lod - 1)));
+      if (lod_indices.empty()) {
+        break;
+      }
+
+      MeshLod mesh_lod{};
+      mesh_lod.first_index = static_cast<uint32_t>(indices.size());
+      mesh_lod.index_count = static_cast<uint32_t>(lod_indices.size());
+      mesh_lod.first_meshlet = static_cast<uint32_t>(meshlets.size());
+      BuildMeshlets(mesh.vertices, lod_indices, mesh_lod.first_index,
+                    meshlets);
+      mesh_lod.meshlet_count =
+          static_cast<uint32_t>(meshlets.size()) - mesh_lod.first_meshlet;
+
+      indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+      lods.push_back(mesh_lod);
+
+      std::clog << "LOD " << lod << ": " << lod_indices.size() / 3
+                << " triangles, " << mesh_lod.meshlet_count << " meshlets"
+                << std::endl;
+    }
+
+    WriteMesh(options.output_path, mesh, indices, lods, meshlets);
+
+    std::clog << options.output_path << ": " << mesh.vertices.size()
+              << " vertices, " << indices.size() << " indices" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "meshconv: " << e.what() << std::endl;
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file transform_bench.cc
+ * @author Mao Zhang (mao.zhang233@gmail.com)
+ * @brief Micro-benchmark of the instance transform update: glm one matrix
+ * at a time against the SIMD kernel, alone and split across the job system
+ * @version 1.0
+ * @date 2023-04-01
+ *
+ * @copyright Copyright (c) 2023
+ *
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "job_system.h"
+#include "transform_store.h"
+
+namespace {
+
+using playground::JobSystem;
+using playground::TransformStore;
+
+// what the kernel's output may differ from glm, in matrix entries
+const float MAX_DIFFERENCE = 1e-4f;
+
+// instances per job, a multiple of every kernel width
+const uint32_t CHUNK_SIZE = 4096;
+
+// the application's per instance layout, 80 bytes
+struct Instance {
+  float model[16];
+  float color[4];
+};
+
+struct Options {
+  uint32_t instance_count = 100000;
+  uint32_t iterations = 200;
+  uint32_t thread_count = 0;
+};
+
+void PrintUsage() {
+  std::clog << "Usage: transform_bench [options]\n"
+            << "  --instances=N   transforms updated per iteration (100000)\n"
+            << "  --iterations=N  iterations timed per variant (200)\n"
+            << "  --threads=N     job system workers, 0 for one per\n"
+            << "                  hardware thread minus one (0)" << std::endl;
+}
+
+uint32_t ParseCount(const std::string& argument, size_t prefix) {
+  int value = std::atoi(argument.c_str() + prefix);
+  if (value < 0) {
+    throw std::runtime_error("invalid value of " + argument);
+  }
+  return static_cast<uint32_t>(value);
+}
+
+Options ParseOptions(int argc, char* argv[]) {
+  Options options{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument{argv[i]};
+    if (0 == argument.compare(0, 12, "--instances=")) {
+      options.instance_count = std::max(1u, ParseCount(argument, 12));
+    } else if (0 == argument.compare(0, 13, "--iterations=")) {
+      options.iterations = std::max(1u, ParseCount(argument, 13));
+    } else if (0 == argument.compare(0, 10, "--threads=")) {
+      options.thread_count = ParseCount(argument, 10);
+    } else {
+      throw std::runtime_error("unknown option " + argument);
+    }
+  }
+
+  return options;
+}
+
+// the application's default grid, every instance turned a little further
+void Fill(TransformStore& store, uint32_t count) {
+  store.Resize(count);
+
+  uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(count)));
+  for (uint32_t i = 0; i < count; ++i) {
+    glm::vec3 position(static_cast<float>(i % side),
+                       static_cast<float>(i / side % side),
+                       static_cast<float>(i / (side * side)));
+    glm::quat rotation = glm::angleAxis(
+        0.001f * static_cast<float>(i),
+        glm::normalize(glm::vec3(1.0f, 2.0f, 3.0f)));
+    store.Set(i, position, rotation, glm::vec3(0.5f));
+  }
+}
+
+// ms per iteration
+double Time(uint32_t iterations, const std::function<void()>& update) {
+  // warms the caches and the workers up
+  update();
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    update();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+float MaxDifference(const std::vector<Instance>& a,
+                    const std::vector<Instance>& b) {
+  float difference = 0.0f;
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (uint32_t j = 0; j < 16; ++j) {
+      difference =
+          std::max(difference, std::abs(a[i].model[j] - b[i].model[j]));
+    }
+  }
+  return difference;
+}
+
+void Report(const std::string& name, double ms, double baseline_ms) {
+  std::clog << std::left << std::setw(16) << name << std::right
+            << std::setw(10) << std::fixed << std::setprecision(3) << ms
+            << " ms" << std::setw(9) << std::setprecision(2)
+            << baseline_ms / ms << "x" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  try {
+    Options options = ParseOptions(argc, argv);
+    uint32_t count = options.instance_count;
+
+    TransformStore store{};
+    Fill(store, count);
+    JobSystem job_system{options.thread_count};
+
+    std::vector<Instance> expected(count);
+    std::vector<Instance> instances(count);
+    const glm::quat spin = glm::angleAxis(0.01f, glm::vec3(0.0f, 0.0f, 1.0f));
+
+    std::clog << count << " instances, " << options.iterations
+              << " iterations, " << TransformStore::GetKernelName() << " x"
+              << TransformStore::GetKernelWidth() << ", "
+              << job_system.ThreadCount() << " workers" << std::endl;
+
+    double scalar_ms = Time(options.iterations, [&]() {
+      store.WriteModelsScalar(0, count, expected.data(), sizeof(Instance));
+    });
+    double kernel_ms = Time(options.iterations, [&]() {
+      store.WriteModels(0, count, instances.data(), sizeof(Instance));
+    });
+    float difference = MaxDifference(expected, instances);
+
+    double jobs_ms = Time(options.iterations, [&]() {
+      job_system.ParallelFor(count, CHUNK_SIZE,
+                             [&](uint32_t begin, uint32_t end) {
+                               store.WriteModels(begin, end,
+                                                 &instances[begin],
+                                                 sizeof(Instance));
+                             });
+    });
+    difference = std::max(difference, MaxDifference(expected, instances));
+
+    // what a spinning frame costs: rotations advanced, then written
+    double rotate_ms = Time(options.iterations, [&]() {
+      store.Rotate(0, count, spin);
+      store.WriteModels(0, count, instances.data(), sizeof(Instance));
+    });
+    double rotate_jobs_ms = Time(options.iterations, [&]() {
+      job_system.ParallelFor(count, CHUNK_SIZE,
+                             [&](uint32_t begin, uint32_t end) {
+                               store.Rotate(begin, end, spin);
+                               store.WriteModels(begin, end,
+                                                 &instances[begin],
+                                                 sizeof(Instance));
+                             });
+    });
+
+    Report("glm", scalar_ms, scalar_ms);
+    Report(TransformStore::GetKernelName(), kernel_ms, scalar_ms);
+    Report("jobs", jobs_ms, scalar_ms);
+    Report("rotate", rotate_ms, scalar_ms);
+    Report("rotate jobs", rotate_jobs_ms, scalar_ms);
+    std::clog << "max difference " << std::scientific << difference
+              << std::endl;
+
+    if (!(difference <= MAX_DIFFERENCE)) {
+      throw std::runtime_error("kernel does not match glm");
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "transform_bench: " << e.what() << std::endl;
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}